@@ -28,6 +28,8 @@
 //   "tcp-large-transfer-$n-$i.pcap" where n and i represent node and interface
 // numbers respectively
 //  Usage (e.g.): ./waf --run tcp-large-transfer
+//  Add --scatterGather=1 to let the TCP buffers and the segments refer
+//  to the bytes of the application writes instead of copying them.
 
 #include <iostream>
 #include <fstream>
@@ -75,9 +77,16 @@ int main (int argc, char *argv[])
   //  LogComponentEnable("PacketSink", LOG_LEVEL_ALL);
   //  LogComponentEnable("TcpLargeTransfer", LOG_LEVEL_ALL);
 
+  bool scatterGather = false;
   CommandLine cmd;
+  cmd.AddValue ("scatterGather", "Refer to the bytes of the written data instead of copying them", scatterGather);
   cmd.Parse (argc, argv);
 
+  if (scatterGather)
+    {
+      Packet::EnableScatterGather ();
+    }
+
   // initialize the tx buffer.
   for(uint32_t i = 0; i < writeSize; ++i)
     {
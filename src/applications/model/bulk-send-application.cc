@@ -29,6 +29,8 @@
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/tcp-socket-factory.h"
+#include "ns3/boolean.h"
+#include "ns3/packet-pool.h"
 #include "bulk-send-application.h"
 
 namespace ns3 {
@@ -64,6 +66,13 @@ BulkSendApplication::GetTypeId (void)
                    TypeIdValue (TcpSocketFactory::GetTypeId ()),
                    MakeTypeIdAccessor (&BulkSendApplication::m_tid),
                    MakeTypeIdChecker ())
+    .AddAttribute ("UsePacketPool",
+                   "If true, take the packets to send from a PacketPool, "
+                   "which reuses them once they have been delivered or dropped, "
+                   "instead of creating a new packet for each send.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BulkSendApplication::m_usePacketPool),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&BulkSendApplication::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -75,7 +84,8 @@ BulkSendApplication::GetTypeId (void)
 BulkSendApplication::BulkSendApplication ()
   : m_socket (0),
     m_connected (false),
-    m_totBytes (0)
+    m_totBytes (0),
+    m_usePacketPool (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -105,6 +115,7 @@ BulkSendApplication::DoDispose (void)
   NS_LOG_FUNCTION (this);
 
   m_socket = 0;
+  m_packetPool = 0;
   // chain up
   Application::DoDispose ();
 }
@@ -114,6 +125,10 @@ void BulkSendApplication::StartApplication (void) // Called at time specified by
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_usePacketPool && !m_packetPool)
+    {
+      m_packetPool = CreateObject<PacketPool> ();
+    }
   // Create the socket if not already
   if (!m_socket)
     {
@@ -182,9 +197,13 @@ void BulkSendApplication::SendData (void)
           toSend = std::min (m_sendSize, m_maxBytes - m_totBytes);
         }
       NS_LOG_LOGIC ("sending packet at " << Simulator::Now ());
-      Ptr<Packet> packet = Create<Packet> (toSend);
+      Ptr<Packet> packet = m_packetPool ? m_packetPool->Get (toSend) : Create<Packet> (toSend);
       m_txTrace (packet);
       int actual = m_socket->Send (packet);
+      if (m_packetPool)
+        {
+          m_packetPool->Release (packet);
+        }
       if (actual > 0)
         {
           m_totBytes += actual;
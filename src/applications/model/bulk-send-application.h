@@ -31,6 +31,7 @@ namespace ns3 {
 
 class Address;
 class Socket;
+class PacketPool;
 
 /**
  * \ingroup applications
@@ -118,6 +119,8 @@ private:
   uint32_t        m_maxBytes;     //!< Limit total number of bytes sent
   uint32_t        m_totBytes;     //!< Total bytes sent so far
   TypeId          m_tid;          //!< The type of protocol to use.
+  bool            m_usePacketPool; //!< Take the packets from m_packetPool
+  Ptr<PacketPool> m_packetPool;   //!< The pool of sent packets, if used
 
   /// Traced Callback: sent packets
   TracedCallback<Ptr<const Packet> > m_txTrace;
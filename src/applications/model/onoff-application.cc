@@ -41,6 +41,8 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/packet-pool.h"
 
 namespace ns3 {
 
@@ -86,6 +88,13 @@ OnOffApplication::GetTypeId (void)
                    TypeIdValue (UdpSocketFactory::GetTypeId ()),
                    MakeTypeIdAccessor (&OnOffApplication::m_tid),
                    MakeTypeIdChecker ())
+    .AddAttribute ("UsePacketPool",
+                   "If true, take the packets to send from a PacketPool, "
+                   "which reuses them once they have been delivered or dropped, "
+                   "instead of creating a new packet for each send.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&OnOffApplication::m_usePacketPool),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&OnOffApplication::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -99,7 +108,8 @@ OnOffApplication::OnOffApplication ()
     m_connected (false),
     m_residualBits (0),
     m_lastStartTime (Seconds (0)),
-    m_totBytes (0)
+    m_totBytes (0),
+    m_usePacketPool (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -138,6 +148,7 @@ OnOffApplication::DoDispose (void)
   NS_LOG_FUNCTION (this);
 
   m_socket = 0;
+  m_packetPool = 0;
   // chain up
   Application::DoDispose ();
 }
@@ -147,6 +158,10 @@ void OnOffApplication::StartApplication () // Called at time specified by Start
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_usePacketPool && !m_packetPool)
+    {
+      m_packetPool = CreateObject<PacketPool> ();
+    }
   // Create the socket if not already
   if (!m_socket)
     {
@@ -271,9 +286,13 @@ void OnOffApplication::SendPacket ()
   NS_LOG_FUNCTION (this);
 
   NS_ASSERT (m_sendEvent.IsExpired ());
-  Ptr<Packet> packet = Create<Packet> (m_pktSize);
+  Ptr<Packet> packet = m_packetPool ? m_packetPool->Get (m_pktSize) : Create<Packet> (m_pktSize);
   m_txTrace (packet);
   m_socket->Send (packet);
+  if (m_packetPool)
+    {
+      m_packetPool->Release (packet);
+    }
   m_totBytes += m_pktSize;
   if (InetSocketAddress::IsMatchingType (m_peer))
     {
@@ -37,6 +37,7 @@ namespace ns3 {
 class Address;
 class RandomVariableStream;
 class Socket;
+class PacketPool;
 
 /**
  * \ingroup applications 
@@ -163,6 +164,8 @@ private:
   EventId         m_startStopEvent;     //!< Event id for next start or stop event
   EventId         m_sendEvent;    //!< Event id of pending "send packet" event
   TypeId          m_tid;          //!< Type of the socket used
+  bool            m_usePacketPool; //!< Take the packets from m_packetPool
+  Ptr<PacketPool> m_packetPool;   //!< The pool of sent packets, if used
 
   /// Traced Callback: transmitted packets.
   TracedCallback<Ptr<const Packet> > m_txTrace;
@@ -29,6 +29,8 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "udp-client.h"
+#include "ns3/boolean.h"
+#include "ns3/packet-pool.h"
 #include "seq-ts-header.h"
 #include <cstdlib>
 #include <cstdio>
@@ -69,6 +71,13 @@ UdpClient::GetTypeId (void)
                    UintegerValue (1024),
                    MakeUintegerAccessor (&UdpClient::m_size),
                    MakeUintegerChecker<uint32_t> (12,1500))
+    .AddAttribute ("UsePacketPool",
+                   "If true, take the packets to send from a PacketPool, "
+                   "which reuses them once they have been delivered or dropped, "
+                   "instead of creating a new packet for each send.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpClient::m_usePacketPool),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -78,6 +87,7 @@ UdpClient::UdpClient ()
   NS_LOG_FUNCTION (this);
   m_sent = 0;
   m_socket = 0;
+  m_usePacketPool = false;
   m_sendEvent = EventId ();
 }
 
@@ -114,6 +124,7 @@ void
 UdpClient::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_packetPool = 0;
   Application::DoDispose ();
 }
 
@@ -122,6 +133,10 @@ UdpClient::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_usePacketPool && !m_packetPool)
+    {
+      m_packetPool = CreateObject<PacketPool> ();
+    }
   if (m_socket == 0)
     {
       TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
@@ -156,7 +171,8 @@ UdpClient::Send (void)
   NS_ASSERT (m_sendEvent.IsExpired ());
   SeqTsHeader seqTs;
   seqTs.SetSeq (m_sent);
-  Ptr<Packet> p = Create<Packet> (m_size-(8+4)); // 8+4 : the size of the seqTs header
+  // 8+4 : the size of the seqTs header
+  Ptr<Packet> p = m_packetPool ? m_packetPool->Get (m_size-(8+4)) : Create<Packet> (m_size-(8+4));
   p->AddHeader (seqTs);
 
   std::stringstream peerAddressStringStream;
@@ -183,6 +199,10 @@ UdpClient::Send (void)
       NS_LOG_INFO ("Error while sending " << m_size << " bytes to "
                                           << peerAddressStringStream.str ());
     }
+  if (m_packetPool)
+    {
+      m_packetPool->Release (p);
+    }
 
   if (m_sent < m_count)
     {
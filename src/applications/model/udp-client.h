@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Socket;
 class Packet;
+class PacketPool;
 
 /**
  * \ingroup udpclientserver
@@ -94,6 +95,8 @@ private:
   Address m_peerAddress; //!< Remote peer address
   uint16_t m_peerPort; //!< Remote peer port
   EventId m_sendEvent; //!< Event to send the next packet
+  bool m_usePacketPool; //!< Take the packets from m_packetPool
+  Ptr<PacketPool> m_packetPool; //!< The pool of sent packets, if used
 
 };
 
@@ -236,8 +236,9 @@ CalendarScheduler::Remove (const Event &ev)
   // bucket index of event
   uint32_t bucket = Hash (ev.key.m_ts);
 
+  // buckets are sorted, so the search stops at the position of the event
   Bucket::iterator end = m_buckets[bucket].end ();
-  for (Bucket::iterator i = m_buckets[bucket].begin (); i != end; ++i)
+  for (Bucket::iterator i = m_buckets[bucket].begin (); i != end && !(ev.key < i->key); ++i)
     {
       if (i->key.m_uid == ev.key.m_uid)
         {
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "checkpoint.h"
+#include "fatal-error.h"
+#include "simulator.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Checkpoint");
+
+/** The number of branches of the last Fork which failed. */
+static uint32_t g_failedBranches = 0;
+
+/**
+ * Wait for one of the running branches to exit.
+ *
+ * \param [in,out] running The processes of the running branches; the
+ *        process which exited is removed.
+ */
+static void
+WaitBranch (std::vector<pid_t> &running)
+{
+  NS_LOG_FUNCTION (running.size ());
+  while (true)
+    {
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("waitpid() failed: " << std::strerror (errno));
+        }
+      std::vector<pid_t>::iterator i = std::find (running.begin (), running.end (), pid);
+      if (i == running.end ())
+        {
+          // Another child of the process, e.g., a tap creator
+          continue;
+        }
+      running.erase (i);
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          NS_LOG_WARN ("branch process " << pid << " failed with status " << status);
+          g_failedBranches++;
+        }
+      return;
+    }
+}
+
+int32_t
+Checkpoint::Fork (uint32_t branches, uint32_t parallel)
+{
+  NS_LOG_FUNCTION (branches << parallel);
+  NS_ASSERT (branches > 0);
+  if (parallel == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      parallel = processors > 0 ? processors : 1;
+    }
+
+  // The branches get a copy of the buffers of the streams: write them
+  // out now, so that their contents are written once, not once per
+  // branch.  The other streams are not known here: see the class
+  // documentation.
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  std::fflush (0);
+
+  g_failedBranches = 0;
+  std::vector<pid_t> running;
+  for (uint32_t branch = 0; branch < branches; branch++)
+    {
+      if (running.size () == parallel)
+        {
+          WaitBranch (running);
+        }
+      pid_t pid = fork ();
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("fork() failed: " << std::strerror (errno));
+        }
+      if (pid == 0)
+        {
+          NS_LOG_LOGIC ("branch " << branch << " at " << Simulator::Now ().GetSeconds () << "s");
+          return branch;
+        }
+      running.push_back (pid);
+    }
+  while (!running.empty ())
+    {
+      WaitBranch (running);
+    }
+  NS_LOG_LOGIC (branches << " branches, " << g_failedBranches << " failed");
+  return -1;
+}
+
+uint32_t
+Checkpoint::GetFailedBranches (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_failedBranches;
+}
+
+} // namespace ns3
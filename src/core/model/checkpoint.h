@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief Run several branches of a simulation from its current state
+ *
+ * A simulation which takes long to reach a steady state can be brought
+ * to that state once, then forked into one branch per parameter value:
+ *
+ * \code
+ *   Simulator::Stop (warmup);
+ *   Simulator::Run ();
+ *   int32_t branch = Checkpoint::Fork (maxTh.size ());
+ *   if (branch < 0)
+ *     {
+ *       // All the branches have exited
+ *       return Checkpoint::GetFailedBranches () == 0 ? 0 : 1;
+ *     }
+ *   red->SetAttribute ("MaxTh", DoubleValue (maxTh[branch]));
+ *   Simulator::Stop (measure);
+ *   Simulator::Run ();
+ * \endcode
+ *
+ * Each branch is a copy of the process made by fork(), so it starts
+ * with the whole state of the simulation: the events of the scheduler,
+ * the objects and their attributes, the packets in the queues and on
+ * the channels, and the positions of the random number streams.  The
+ * branches thus draw the same random numbers until their parameters
+ * make them diverge, which reduces the variance of the comparison
+ * between parameters (common random numbers); a branch can call
+ * RandomVariableStream::SetStream to draw other numbers.
+ *
+ * Fork can be called between two runs, as above, or in an event, in
+ * which case the run goes on in each branch.  The simulation must run
+ * in a single thread: the threads of a realtime simulation and the
+ * other ranks of a distributed simulation are not copied.
+ *
+ * Fork writes out the buffers of the C stdio streams and of std::cout,
+ * std::cerr and std::clog before it forks.  The buffers of the other
+ * C++ streams, e.g. the std::ofstream of an ascii trace file, are
+ * copied into each branch, which writes them again: flush such streams
+ * before calling Fork.
+ *
+ * The state is only copied in memory, to branches of the same process:
+ * there is no snapshot file to restore a simulation from in another
+ * process.
+ */
+class Checkpoint
+{
+public:
+  /**
+   * Fork the simulation into branches.
+   *
+   * The calling process waits for the branches to exit, running at
+   * most \p parallel of them at a time.
+   *
+   * \param [in] branches The number of branches.
+   * \param [in] parallel The largest number of branches running at a
+   *        time, or 0 for the number of processors.
+   * \returns The number of the branch, from 0 to \p branches - 1, in
+   *        each branch, and -1 in the calling process, once all the
+   *        branches have exited.
+   */
+  static int32_t Fork (uint32_t branches, uint32_t parallel = 0);
+  /**
+   * \returns The number of branches of the last Fork which did not
+   *          exit with status 0.
+   */
+  static uint32_t GetFailedBranches (void);
+
+private:
+  /** Default constructor: Checkpoint is not meant to be instantiated. */
+  Checkpoint ();
+  /** Destructor. */
+  ~Checkpoint ();
+};
+
+} // namespace ns3
+
+#endif /* CHECKPOINT_H */
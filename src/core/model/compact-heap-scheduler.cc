@@ -0,0 +1,277 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "compact-heap-scheduler.h"
+#include "event-impl.h"
+#include "uinteger.h"
+#include "abort.h"
+#include "assert.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::CompactHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompactHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (CompactHeapScheduler);
+
+/** The size of a cache line, to which the heap is aligned. */
+static const uint32_t CACHE_LINE_SIZE = 64;
+
+TypeId
+CompactHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CompactHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<CompactHeapScheduler> ()
+    .AddAttribute ("Arity",
+                   "The number of children of an item of the heap, "
+                   "a power of 2.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&CompactHeapScheduler::SetArity,
+                                         &CompactHeapScheduler::GetArity),
+                   MakeUintegerChecker<uint32_t> (2, 64))
+  ;
+  return tid;
+}
+
+CompactHeapScheduler::CompactHeapScheduler ()
+  : m_shift (2),
+    m_buffer (0),
+    m_heap (0),
+    m_size (0),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompactHeapScheduler::~CompactHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  free (m_buffer);
+}
+
+void
+CompactHeapScheduler::SetArity (uint32_t arity)
+{
+  NS_LOG_FUNCTION (this << arity);
+  NS_ABORT_MSG_IF (arity < 2 || (arity & (arity - 1)) != 0,
+                   "The arity of the heap must be a power of 2");
+  NS_ABORT_MSG_IF (m_size != 0, "Cannot change the arity of a non-empty heap");
+  m_shift = 0;
+  while ((1U << m_shift) < arity)
+    {
+      m_shift++;
+    }
+  // The offset of the root depends on the arity
+  free (m_buffer);
+  m_buffer = 0;
+  m_heap = 0;
+  m_capacity = 0;
+}
+
+uint32_t
+CompactHeapScheduler::GetArity (void) const
+{
+  return 1U << m_shift;
+}
+
+bool
+CompactHeapScheduler::IsLess (const Key &a, const Key &b)
+{
+  return a.ts < b.ts || (a.ts == b.ts && a.uid < b.uid);
+}
+
+void
+CompactHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this << m_capacity);
+  // The children of item i are the items (i << m_shift) + 1 to
+  // (i << m_shift) + arity: with the root arity - 1 items after the start
+  // of the aligned buffer, the first child of an item is at a multiple
+  // of arity items from the start.
+  uint32_t offset = GetArity () - 1;
+  uint32_t capacity = m_capacity == 0 ? CACHE_LINE_SIZE : 2 * m_capacity;
+  void *buffer;
+  if (posix_memalign (&buffer, CACHE_LINE_SIZE, (offset + capacity) * sizeof (Key)) != 0)
+    {
+      NS_FATAL_ERROR ("Cannot allocate a heap of " << capacity << " events");
+    }
+  Key *heap = static_cast<Key *> (buffer) + offset;
+  if (m_size != 0)
+    {
+      memcpy (heap, m_heap, m_size * sizeof (Key));
+    }
+  free (m_buffer);
+  m_buffer = static_cast<Key *> (buffer);
+  m_heap = heap;
+  m_capacity = capacity;
+}
+
+void
+CompactHeapScheduler::SiftUp (uint32_t index, const Key &key)
+{
+  while (index > 0)
+    {
+      uint32_t parent = (index - 1) >> m_shift;
+      if (!IsLess (key, m_heap[parent]))
+        {
+          break;
+        }
+      m_heap[index] = m_heap[parent];
+      index = parent;
+    }
+  m_heap[index] = key;
+}
+
+void
+CompactHeapScheduler::SiftDown (uint32_t index, const Key &key)
+{
+  uint32_t arity = GetArity ();
+  while (true)
+    {
+      uint32_t first = (index << m_shift) + 1;
+      if (first >= m_size)
+        {
+          break;
+        }
+      uint32_t last = first + arity < m_size ? first + arity : m_size;
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < last; child++)
+        {
+          if (IsLess (m_heap[child], m_heap[smallest]))
+            {
+              smallest = child;
+            }
+        }
+      if (!IsLess (m_heap[smallest], key))
+        {
+          break;
+        }
+      m_heap[index] = m_heap[smallest];
+      index = smallest;
+    }
+  m_heap[index] = key;
+}
+
+Scheduler::Event
+CompactHeapScheduler::GetEvent (const Key &key) const
+{
+  Scheduler::Event ev;
+  ev.impl = m_impl[key.slot];
+  ev.key.m_ts = key.ts;
+  ev.key.m_uid = key.uid;
+  ev.key.m_context = m_context[key.slot];
+  return ev;
+}
+
+void
+CompactHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  if (m_size == m_capacity)
+    {
+      Grow ();
+    }
+  Key key;
+  key.ts = ev.key.m_ts;
+  key.uid = ev.key.m_uid;
+  if (m_free.empty ())
+    {
+      key.slot = m_impl.size ();
+      m_impl.push_back (ev.impl);
+      m_context.push_back (ev.key.m_context);
+    }
+  else
+    {
+      key.slot = m_free.back ();
+      m_free.pop_back ();
+      m_impl[key.slot] = ev.impl;
+      m_context[key.slot] = ev.key.m_context;
+    }
+  ev.impl->SetSchedulerIndex (key.slot);
+  m_size++;
+  SiftUp (m_size - 1, key);
+}
+
+void
+CompactHeapScheduler::Pop (void)
+{
+  m_free.push_back (m_heap[0].slot);
+  m_size--;
+  if (m_size != 0)
+    {
+      SiftDown (0, m_heap[m_size]);
+    }
+}
+
+void
+CompactHeapScheduler::Purge (void)
+{
+  while (m_size != 0 && m_impl[m_heap[0].slot] == 0)
+    {
+      Pop ();
+    }
+}
+
+bool
+CompactHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // The top key is never the key of a removed event
+  return m_size == 0;
+}
+
+Scheduler::Event
+CompactHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size != 0);
+  return GetEvent (m_heap[0]);
+}
+
+Scheduler::Event
+CompactHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size != 0);
+  Scheduler::Event next = GetEvent (m_heap[0]);
+  m_impl[m_heap[0].slot] = 0;
+  Pop ();
+  Purge ();
+  return next;
+}
+
+void
+CompactHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint32_t slot = ev.impl->GetSchedulerIndex ();
+  NS_ASSERT (slot < m_impl.size () && m_impl[slot] == ev.impl);
+  m_impl[slot] = 0;
+  Purge ();
+}
+
+} // namespace ns3
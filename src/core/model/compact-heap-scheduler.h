@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPACT_HEAP_SCHEDULER_H
+#define COMPACT_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::CompactHeapScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a d-ary heap event scheduler over compact keys
+ *
+ * HeapScheduler moves whole Scheduler::Event items, and writes the new
+ * position of an event in its EventImpl at each move.  This scheduler
+ * splits the events in two structures of arrays:
+ *
+ *  - the heap holds 16 byte keys: the timestamp, the uid, and the slot
+ *    of the event in the store;
+ *  - the store holds, by slot, the EventImpl and the context of the
+ *    event.  Slots are recycled from a free list, so the store does not
+ *    grow beyond the largest number of keys in the heap.
+ *
+ * The heap compares and moves keys only, and never touches the store or
+ * the EventImpl, which can be anywhere in memory.  Remove() marks the
+ * slot of the event, found through the scheduler index of the EventImpl
+ * (EventImpl::SetSchedulerIndex), as removed; the key stays in the heap
+ * until it reaches the top, where it is discarded, so Remove() runs in
+ * constant time, save for the discarded keys.  A removed event is thus
+ * never returned, and its EventImpl can be released at once.
+ *
+ * The heap is d-ary, with d set by the Arity attribute (4 by default):
+ * the d children of an item are compared together, and the heap is
+ * allocated with an offset such that, with 4 children, they share a 64
+ * byte cache line.  A d-ary heap is shallower than a binary heap, so an
+ * event crosses fewer cache lines from the bottom to the top of a large
+ * heap.
+ */
+class CompactHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  CompactHeapScheduler ();
+  /** Destructor. */
+  virtual ~CompactHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** The key of an event in the heap. */
+  struct Key
+  {
+    uint64_t ts;    //!< the event timestamp
+    uint32_t uid;   //!< the event uid
+    uint32_t slot;  //!< the slot of the event in the store
+  };
+
+  /**
+   * \param [in] a The first key.
+   * \param [in] b The second key.
+   * \returns \c true if \c a is before \c b
+   */
+  static inline bool IsLess (const Key &a, const Key &b);
+
+  /**
+   * Set the arity of the heap.
+   * \param [in] arity The number of children of an item, a power of 2.
+   */
+  void SetArity (uint32_t arity);
+  /**
+   * \returns The arity of the heap.
+   */
+  uint32_t GetArity (void) const;
+
+  /**
+   * Move a key up from a position to its proper position.
+   *
+   * \param [in] index The starting position, whose key is overwritten.
+   * \param [in] key The key.
+   */
+  void SiftUp (uint32_t index, const Key &key);
+  /**
+   * Move a key down from a position to its proper position.
+   *
+   * \param [in] index The starting position, whose key is overwritten.
+   * \param [in] key The key.
+   */
+  void SiftDown (uint32_t index, const Key &key);
+  /**
+   * Remove the top key of the heap.
+   */
+  void Pop (void);
+  /**
+   * Discard the keys of the removed events from the top of the heap.
+   */
+  void Purge (void);
+  /**
+   * Make room for one more key in the heap.
+   */
+  void Grow (void);
+  /**
+   * \param [in] key The key of an event.
+   * \returns The event.
+   */
+  Scheduler::Event GetEvent (const Key &key) const;
+
+  uint32_t m_shift;      //!< log2 of the arity
+  Key *m_buffer;         //!< the allocated heap, cache line aligned
+  Key *m_heap;           //!< the root of the heap, within m_buffer
+  uint32_t m_size;       //!< the number of keys in the heap
+  uint32_t m_capacity;   //!< the number of keys m_heap can hold
+
+  std::vector<EventImpl *> m_impl;    //!< the event of each slot, 0 if removed
+  std::vector<uint32_t> m_context;    //!< the context of each slot
+  std::vector<uint32_t> m_free;       //!< the free slots
+};
+
+} // namespace ns3
+
+#endif /* COMPACT_HEAP_SCHEDULER_H */
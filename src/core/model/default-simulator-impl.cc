@@ -22,13 +22,19 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "pointer.h"
+#include "boolean.h"
+#include "string.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <fstream>
+#include <iostream>
+#include <typeinfo>
 
 
 /**
@@ -53,6 +59,25 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("EagerCancel",
+                   "Remove cancelled events from the event list at once, "
+                   "rather than when their time comes.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_eagerCancel),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Profile",
+                   "Account for the wall clock time and the number of the "
+                   "events by event type and context, and print the profile "
+                   "when the simulator is destroyed.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_profile),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfileFile",
+                   "The file to print the profile of the events to, "
+                   "or empty for the standard error.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profileFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -71,13 +96,16 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_eventCount = 0;
+  m_deadEventCount = 0;
+  m_profiler = 0;
   m_main = SystemThread::Self();
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_profiler;
 }
 
 void
@@ -108,6 +136,34 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  ReportProfile ();
+}
+
+void
+DefaultSimulatorImpl::ReportProfile (void)
+{
+  if (m_profiler == 0)
+    {
+      return;
+    }
+  if (m_profileFile.empty ())
+    {
+      m_profiler->Print (std::clog, 20);
+    }
+  else
+    {
+      std::ofstream os (m_profileFile.c_str ());
+      if (os.is_open ())
+        {
+          m_profiler->Print (os, 20);
+        }
+      else
+        {
+          NS_LOG_ERROR ("cannot open " << m_profileFile);
+        }
+    }
+  delete m_profiler;
+  m_profiler = 0;
 }
 
 void
@@ -146,12 +202,47 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  m_eventCount++;
+  if (next.impl->IsCancelled ())
+    {
+      m_deadEventCount++;
+    }
   next.impl->Invoke ();
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
 }
 
+void
+DefaultSimulatorImpl::ProcessOneProfiledEvent (void)
+{
+  Scheduler::Event next = m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= m_currentTs);
+  m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  m_currentTs = next.key.m_ts;
+  m_currentContext = next.key.m_context;
+  m_currentUid = next.key.m_uid;
+  m_eventCount++;
+  if (next.impl->IsCancelled ())
+    {
+      m_deadEventCount++;
+    }
+  else
+    {
+      const std::type_info &type = typeid (*next.impl);
+      const void *function = next.impl->GetFunction ();
+      uint64_t start = EventProfiler::GetTicks ();
+      next.impl->Invoke ();
+      m_profiler->Record (type, function, next.key.m_context, EventProfiler::GetTicks () - start);
+    }
+  next.impl->Unref ();
+
+  ProcessEventsWithContext ();
+}
+
 bool 
 DefaultSimulatorImpl::IsFinished (void) const
 {
@@ -161,30 +252,17 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
     {
-      return;
-    }
-
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
-    {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = m_currentTs + event.timestamp;
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
     }
 }
 
@@ -197,9 +275,25 @@ DefaultSimulatorImpl::Run (void)
   ProcessEventsWithContext ();
   m_stop = false;
 
-  while (!m_events->IsEmpty () && !m_stop) 
+  if (m_profile && m_profiler == 0)
+    {
+      m_profiler = new EventProfiler ();
+    }
+  // The profiled events have their own loop, to leave the usual one
+  // untouched.
+  if (m_profiler != 0)
+    {
+      while (!m_events->IsEmpty () && !m_stop)
+        {
+          ProcessOneProfiledEvent ();
+        }
+    }
+  else
     {
-      ProcessOneEvent ();
+      while (!m_events->IsEmpty () && !m_stop)
+        {
+          ProcessOneEvent ();
+        }
     }
 
   // If the simulator stopped naturally by lack of events, make a
@@ -269,11 +363,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      m_eventsWithContext.Push (ev);
     }
 }
 
@@ -360,7 +450,15 @@ DefaultSimulatorImpl::Remove (const EventId &id)
 void
 DefaultSimulatorImpl::Cancel (const EventId &id)
 {
-  if (!IsExpired (id))
+  if (IsExpired (id))
+    {
+      return;
+    }
+  if (m_eagerCancel && id.GetUid () != 2)
+    {
+      Remove (id);
+    }
+  else
     {
       id.PeekEventImpl ()->Cancel ();
     }
@@ -414,4 +512,32 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+DefaultSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
+uint64_t
+DefaultSimulatorImpl::GetDeadEventCount (void) const
+{
+  return m_deadEventCount;
+}
+
+double
+DefaultSimulatorImpl::GetDeadEventRatio (void) const
+{
+  if (m_eventCount == 0)
+    {
+      return 0;
+    }
+  return static_cast<double> (m_deadEventCount) / m_eventCount;
+}
+
+const EventProfiler *
+DefaultSimulatorImpl::GetProfiler (void) const
+{
+  return m_profiler;
+}
+
 } // namespace ns3
@@ -25,11 +25,12 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "system-thread.h"
-#include "ns3/system-mutex.h"
+#include "mpsc-queue.h"
 
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,10 +40,22 @@
 
 namespace ns3 {
 
+class EventProfiler;
+
 /**
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Cancel() only marks an event as cancelled by default: the "dead"
+ * event stays in the event list until its time comes, when it is
+ * discarded.  When the EagerCancel attribute is set, Cancel() removes
+ * the event from the event list at once, as Remove() does; this suits
+ * the schedulers which remove events in O(log n) (MapScheduler,
+ * HeapScheduler) or close to O(1) (CalendarScheduler), and keeps the
+ * event list small when timers are rescheduled often.
+ * GetDeadEventRatio() tells which fraction of the events removed from
+ * the event list were dead.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -78,11 +91,36 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns The number of events taken from the event list to be run,
+   *          including the dead (cancelled) ones.
+   */
+  uint64_t GetEventCount (void) const;
+  /**
+   * \returns The number of dead (cancelled) events taken from the event
+   *          list and discarded.
+   */
+  uint64_t GetDeadEventCount (void) const;
+  /**
+   * \returns The ratio of GetDeadEventCount() to GetEventCount(), or 0
+   *          when no event was run.
+   */
+  double GetDeadEventRatio (void) const;
+  /**
+   * \returns The profile of the events run so far, or 0 unless the
+   *          Profile attribute was set when Run was called.
+   */
+  const EventProfiler * GetProfiler (void) const;
+
 private:
   virtual void DoDispose (void);
 
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /** Process the next event, and account for its wall clock time. */
+  void ProcessOneProfiledEvent (void);
+  /** Print the profile of the events, if any, and forget it. */
+  void ReportProfile (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
  
@@ -95,17 +133,11 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
-  /** Container type for the events from a different context. */
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The events scheduled from other threads, inserted into the main event
+   * queue by the main thread.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -129,6 +161,18 @@ private:
    *  not counting the Destroy events; this is used for validation
    */
   int m_unscheduledEvents;
+  /** Remove cancelled events from the event list at once. */
+  bool m_eagerCancel;
+  /** Number of events taken from the event list. */
+  uint64_t m_eventCount;
+  /** Number of dead events taken from the event list. */
+  uint64_t m_deadEventCount;
+  /** Account for the wall clock time of the events. */
+  bool m_profile;
+  /** File to print the profile of the events to, or empty for std::clog. */
+  std::string m_profileFile;
+  /** The profile of the events, or 0 if not profiling. */
+  EventProfiler *m_profiler;
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
@@ -20,6 +20,10 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 /**
  * \file
@@ -31,13 +35,110 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Granularity of the size classes of the event free lists, in bytes. */
+const std::size_t EVENT_POOL_GRANULARITY = 16;
+/** Number of size classes: events of up to 256 bytes are pooled. */
+const std::size_t EVENT_POOL_CLASSES = 16;
+/**
+ * Max number of events in a free list, so that a thread which only
+ * frees the events created by another thread does not hoard memory.
+ */
+const uint32_t EVENT_POOL_MAX_FREE = 1024;
+
+/** A free event, linked in a free list. */
+struct FreeEvent
+{
+  FreeEvent *next;  /**< Next free event. */
+};
+
+/** A free list of events of one size class. */
+struct EventFreeList
+{
+  FreeEvent *head;  /**< First free event. */
+  uint32_t nFree;   /**< Number of free events. */
+};
+
+/** The free lists of a thread. */
+struct EventFreeLists
+{
+  EventFreeList lists[EVENT_POOL_CLASSES];  /**< The free lists, by size class. */
+  bool registered;  /**< Whether ReleaseEventFreeLists will run at thread exit. */
+};
+
+/**
+ * The free lists of the thread.  The initial-exec model turns each
+ * access into a single load relative to the thread pointer, as for the
+ * caches of ThreadFreeList; the default model calls __tls_get_addr,
+ * which costs more than the glibc allocator path the lists replace.
+ * The 264 bytes fit in the static TLS space that the loader keeps for
+ * libraries opened with dlopen (e.g. by the python bindings).
+ */
+__thread EventFreeLists g_eventFreeLists
+  __attribute__ ((tls_model ("initial-exec")));
+
+/**
+ * Release the events in the free lists of the calling thread.
+ *
+ * \param [in] lists The free lists of the thread.
+ */
+void
+ReleaseEventFreeLists (void *lists)
+{
+  EventFreeLists *freeLists = static_cast<EventFreeLists *> (lists);
+  // The destructors of other thread-specific values may still free
+  // events: they go to the lists again, and the lists register again.
+  freeLists->registered = false;
+  for (std::size_t i = 0; i < EVENT_POOL_CLASSES; i++)
+    {
+      EventFreeList *list = &freeLists->lists[i];
+      while (list->head != 0)
+        {
+          FreeEvent *event = list->head;
+          list->head = event->next;
+          ::operator delete (event);
+        }
+      list->nFree = 0;
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+pthread_once_t g_eventFreeListsOnce = PTHREAD_ONCE_INIT;  /**< Create g_eventFreeListsKey once. */
+pthread_key_t g_eventFreeListsKey;  /**< Calls ReleaseEventFreeLists when a thread exits. */
+
+/** Create g_eventFreeListsKey. */
+void
+CreateEventFreeListsKey (void)
+{
+  pthread_key_create (&g_eventFreeListsKey, &ReleaseEventFreeLists);
+}
+#endif
+
+/**
+ * Make the calling thread release its free lists when it exits, so
+ * that the events it cached are not leaked.
+ */
+void
+RegisterEventFreeLists (void)
+{
+  g_eventFreeLists.registered = true;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_eventFreeListsOnce, &CreateEventFreeListsKey);
+  pthread_setspecific (g_eventFreeListsKey, &g_eventFreeLists);
+#endif
+}
+
+} // unnamed namespace
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_schedulerIndex (0),
+    m_cancel (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,4 +167,54 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetFunction (void) const
+{
+  return 0;
+}
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass >= EVENT_POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  EventFreeList *list = &g_eventFreeLists.lists[sizeClass];
+  FreeEvent *event = list->head;
+  if (event != 0)
+    {
+      list->head = event->next;
+      list->nFree--;
+      return event;
+    }
+  return ::operator new ((sizeClass + 1) * EVENT_POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass >= EVENT_POOL_CLASSES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  EventFreeList *list = &g_eventFreeLists.lists[sizeClass];
+  if (list->nFree >= EVENT_POOL_MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (!g_eventFreeLists.registered)
+    {
+      RegisterEventFreeLists ();
+    }
+  FreeEvent *event = static_cast<FreeEvent *> (p);
+  event->next = list->head;
+  list->head = event;
+  list->nFree++;
+}
+
 } // namespace ns3
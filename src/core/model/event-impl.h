@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,12 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from per-thread free lists, one per size class
+ * of 16 bytes up to 256 bytes, rather than with malloc and free for
+ * each event.  A free list holds at most 1024 events; beyond that, and
+ * for larger events, memory goes back to the global allocator.  The
+ * events in the free lists of a thread are released when it exits.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -65,6 +72,42 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * Record the position of the event in the Scheduler which holds it,
+   * so that the scheduler can find the event without searching for it.
+   *
+   * \param [in] index The position, meaningful only to the scheduler.
+   */
+  inline void SetSchedulerIndex (uint32_t index);
+  /**
+   * \returns The position of the event, as last set by SetSchedulerIndex().
+   */
+  inline uint32_t GetSchedulerIndex (void) const;
+  /**
+   * Get the address of the code this event calls, e.g. to find the
+   * name of the function or method with dladdr.
+   *
+   * \returns The address of the function or method called by Notify(),
+   *          or 0 if it is not known.
+   */
+  virtual const void * GetFunction (void) const;
+
+  /**
+   * Allocate memory for an event, from the free list of the calling
+   * thread when possible.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an event to the free list of the calling
+   * thread.
+   *
+   * \param [in] p The memory.
+   * \param [in] size The size of the event, as given to operator new.
+   */
+  static void operator delete (void *p, std::size_t size);
 
 protected:
   /**
@@ -76,9 +119,31 @@ protected:
   virtual void Notify (void) = 0;
 
 private:
+  uint32_t m_schedulerIndex;  /**< Position of the event in its Scheduler. */
   bool m_cancel;  /**< Has this event been cancelled. */
 };
 
 } // namespace ns3
 
+
+/********************************************************************
+ *  Implementation of inline methods.
+ ********************************************************************/
+
+namespace ns3 {
+
+void
+EventImpl::SetSchedulerIndex (uint32_t index)
+{
+  m_schedulerIndex = index;
+}
+
+uint32_t
+EventImpl::GetSchedulerIndex (void) const
+{
+  return m_schedulerIndex;
+}
+
+} // namespace ns3
+
 #endif /* EVENT_IMPL_H */
@@ -0,0 +1,424 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "assert.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <time.h>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#ifdef HAVE_DLFCN_H
+#include <dlfcn.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of ns3::EventProfiler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+/** The initial size of the hash table. */
+static const uint32_t INITIAL_SLOTS = 256;
+
+/**
+ * \param a an entry
+ * \param b another entry
+ * \return true if a took more time than b
+ */
+static bool
+MoreTime (const EventProfiler::Entry &a, const EventProfiler::Entry &b)
+{
+  return a.time > b.time;
+}
+
+EventProfiler::EventProfiler ()
+  : m_nSlots (0),
+    m_last (0),
+    m_startTime (GetTime ()),
+    m_startTicks (GetTicks ())
+{
+  NS_LOG_FUNCTION (this);
+  Slot free = { 0, 0, 0, 0, 0 };
+  m_slots.resize (INITIAL_SLOTS, free);
+}
+
+EventProfiler::~EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+EventProfiler::GetTime (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t
+EventProfiler::GetTicks (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  uint32_t low;
+  uint32_t high;
+  __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+  return (static_cast<uint64_t> (high) << 32) | low;
+#else
+  return GetTime ();
+#endif
+}
+
+double
+EventProfiler::GetTickPeriod (void) const
+{
+#if defined (__x86_64__) || defined (__i386__)
+  uint64_t ticks = GetTicks () - m_startTicks;
+  uint64_t time = GetTime () - m_startTime;
+  if (ticks == 0 || time == 0)
+    {
+      return 1;
+    }
+  return static_cast<double> (time) / ticks;
+#else
+  return 1;
+#endif
+}
+
+EventProfiler::Slot *
+EventProfiler::Lookup (const std::type_info *type, const void *function, uint32_t context)
+{
+  uint32_t mask = m_slots.size () - 1;
+  uintptr_t key = reinterpret_cast<uintptr_t> (function) ^ (reinterpret_cast<uintptr_t> (type) >> 4);
+  uint32_t i = ((key ^ (key >> 16)) ^ (context * 0x9e3779b9U)) & mask;
+  while (m_slots[i].type != 0)
+    {
+      if (m_slots[i].function == function && m_slots[i].type == type
+          && m_slots[i].context == context)
+        {
+          return &m_slots[i];
+        }
+      i = (i + 1) & mask;
+    }
+  if (2 * (m_nSlots + 1) > m_slots.size ())
+    {
+      Grow ();
+      return Lookup (type, function, context);
+    }
+  m_slots[i].type = type;
+  m_slots[i].function = function;
+  m_slots[i].context = context;
+  m_nSlots++;
+  return &m_slots[i];
+}
+
+void
+EventProfiler::Grow (void)
+{
+  NS_LOG_FUNCTION (this << m_slots.size ());
+  std::vector<Slot> slots;
+  Slot free = { 0, 0, 0, 0, 0 };
+  slots.resize (2 * m_slots.size (), free);
+  slots.swap (m_slots);
+  m_nSlots = 0;
+  m_last = 0;
+  for (std::vector<Slot>::const_iterator i = slots.begin (); i != slots.end (); ++i)
+    {
+      if (i->type != 0)
+        {
+          Slot *slot = Lookup (i->type, i->function, i->context);
+          slot->count = i->count;
+          slot->ticks = i->ticks;
+        }
+    }
+}
+
+void
+EventProfiler::Record (const std::type_info &type, const void *function, uint32_t context, uint64_t ticks)
+{
+  // Events of the same function and context often follow each other,
+  // e.g. the packets of a burst on a link.
+  Slot *slot = m_last;
+  if (slot == 0 || slot->function != function || slot->type != &type
+      || slot->context != context)
+    {
+      slot = Lookup (&type, function, context);
+      m_last = slot;
+    }
+  slot->count++;
+  slot->ticks += ticks;
+}
+
+uint64_t
+EventProfiler::GetEventCount (void) const
+{
+  uint64_t count = 0;
+  for (std::vector<Slot>::const_iterator i = m_slots.begin (); i != m_slots.end (); ++i)
+    {
+      count += i->count;
+    }
+  return count;
+}
+
+uint64_t
+EventProfiler::GetTotalTime (void) const
+{
+  uint64_t ticks = 0;
+  for (std::vector<Slot>::const_iterator i = m_slots.begin (); i != m_slots.end (); ++i)
+    {
+      ticks += i->ticks;
+    }
+  return static_cast<uint64_t> (ticks * GetTickPeriod ());
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::Sort (const std::vector<Entry> &entries)
+{
+  std::map<std::string, Entry> merged;
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      std::map<std::string, Entry>::iterator j = merged.find (i->name);
+      if (j == merged.end ())
+        {
+          merged[i->name] = *i;
+        }
+      else
+        {
+          j->second.count += i->count;
+          j->second.time += i->time;
+        }
+    }
+  std::vector<Entry> sorted;
+  for (std::map<std::string, Entry>::const_iterator i = merged.begin (); i != merged.end (); ++i)
+    {
+      sorted.push_back (i->second);
+    }
+  std::stable_sort (sorted.begin (), sorted.end (), &MoreTime);
+  return sorted;
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::GetEventTypes (void) const
+{
+  double period = GetTickPeriod ();
+  // Look up each function once.
+  typedef std::map<std::pair<const std::type_info *, const void *>, std::string> Names;
+  Names names;
+  std::vector<Entry> entries;
+  for (std::vector<Slot>::const_iterator i = m_slots.begin (); i != m_slots.end (); ++i)
+    {
+      if (i->type == 0)
+        {
+          continue;
+        }
+      std::pair<const std::type_info *, const void *> key (i->type, i->function);
+      Names::iterator name = names.find (key);
+      if (name == names.end ())
+        {
+          name = names.insert (std::make_pair (key, GetEventName (*i->type, i->function))).first;
+        }
+      Entry entry = { name->second, i->count, static_cast<uint64_t> (i->ticks * period) };
+      entries.push_back (entry);
+    }
+  return Sort (entries);
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::GetContexts (void) const
+{
+  double period = GetTickPeriod ();
+  std::vector<Entry> entries;
+  for (std::vector<Slot>::const_iterator i = m_slots.begin (); i != m_slots.end (); ++i)
+    {
+      if (i->type == 0)
+        {
+          continue;
+        }
+      std::ostringstream name;
+      if (i->context == 0xffffffff)
+        {
+          name << "no context";
+        }
+      else
+        {
+          name << "node " << i->context;
+        }
+      Entry entry = { name.str (), i->count, static_cast<uint64_t> (i->ticks * period) };
+      entries.push_back (entry);
+    }
+  return Sort (entries);
+}
+
+/**
+ * Print a table of entries.
+ *
+ * \param os the output stream
+ * \param entries the entries, from the most expensive
+ * \param total the total time of the events, in nanoseconds
+ * \param maxLines the largest number of lines
+ * \param what the title of the name column
+ */
+static void
+PrintEntries (std::ostream &os, const std::vector<EventProfiler::Entry> &entries,
+              uint64_t total, uint32_t maxLines, const char *what)
+{
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << std::setw (12) << "time (s)" << std::setw (8) << "%"
+     << std::setw (14) << "events" << std::setw (11) << "ns/event"
+     << "  " << what << std::endl;
+  uint32_t lines = 0;
+  for (std::vector<EventProfiler::Entry>::const_iterator i = entries.begin ();
+       i != entries.end () && lines < maxLines; ++i, ++lines)
+    {
+      os << std::fixed
+         << std::setw (12) << std::setprecision (6) << i->time / 1e9
+         << std::setw (7) << std::setprecision (1)
+         << (total == 0 ? 0.0 : 100.0 * i->time / total) << "%"
+         << std::setw (14) << i->count
+         << std::setw (11) << std::setprecision (1)
+         << (i->count == 0 ? 0.0 : static_cast<double> (i->time) / i->count)
+         << "  " << i->name << std::endl;
+    }
+  if (entries.size () > lines)
+    {
+      os << "  ... " << entries.size () - lines << " more" << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+EventProfiler::Print (std::ostream &os, uint32_t maxLines) const
+{
+  uint64_t total = GetTotalTime ();
+  os << "Event profile: " << GetEventCount () << " events in "
+     << total / 1e9 << " s" << std::endl;
+  PrintEntries (os, GetEventTypes (), total, maxLines, "event type");
+  PrintEntries (os, GetContexts (), total, maxLines, "context");
+}
+
+void
+EventProfiler::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  Slot free = { 0, 0, 0, 0, 0 };
+  m_slots.assign (INITIAL_SLOTS, free);
+  m_nSlots = 0;
+  m_last = 0;
+  m_startTime = GetTime ();
+  m_startTicks = GetTicks ();
+}
+
+std::string
+EventProfiler::GetEventTypeName (const std::type_info &type)
+{
+  int status;
+  char *demangled = abi::__cxa_demangle (type.name (), NULL, NULL, &status);
+  if (status != 0 || demangled == 0)
+    {
+      return type.name ();
+    }
+  std::string name = demangled;
+  std::free (demangled);
+
+  // The events of MakeEvent are local classes of the MakeEvent function
+  // templates, e.g. "ns3::EventImpl* ns3::MakeEvent<void (A::*)(), A*>
+  // (void (A::*)(), A*)::EventMemberImpl0": keep the first parameter of
+  // the function, the type of the function pointer.
+  std::string::size_type start = name.find ("MakeEvent");
+  if (start == std::string::npos)
+    {
+      return name;
+    }
+  start += 9;
+  int depth = 0;
+  for (std::string::size_type i = start; i < name.size (); ++i)
+    {
+      char c = name[i];
+      if (c == '<' || c == '(')
+        {
+          if (depth == 0 && c == '(')
+            {
+              start = i + 1;
+            }
+          depth++;
+        }
+      else if (c == '>' || c == ')')
+        {
+          depth--;
+          if (depth == 0 && c == ')')
+            {
+              return name.substr (start, i - start);
+            }
+        }
+      else if (depth == 1 && c == ',' && name[start - 1] == '(')
+        {
+          return name.substr (start, i - start);
+        }
+    }
+  return name;
+}
+
+std::string
+EventProfiler::GetEventName (const std::type_info &type, const void *function)
+{
+  if (function == 0)
+    {
+      return GetEventTypeName (type);
+    }
+#ifdef HAVE_DLFCN_H
+  Dl_info info;
+  if (dladdr (function, &info) != 0 && info.dli_sname != 0
+      && info.dli_saddr == function)
+    {
+      int status;
+      char *demangled = abi::__cxa_demangle (info.dli_sname, NULL, NULL, &status);
+      if (status != 0 || demangled == 0)
+        {
+          return info.dli_sname;
+        }
+      std::string name = demangled;
+      std::free (demangled);
+      // A virtual method called through a base class with an offset
+      static const char *thunks[] = { "non-virtual thunk to ", "virtual thunk to " };
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          if (name.compare (0, std::strlen (thunks[i]), thunks[i]) == 0)
+            {
+              name.erase (0, std::strlen (thunks[i]));
+              break;
+            }
+        }
+      return name;
+    }
+#endif
+  std::ostringstream name;
+  name << GetEventTypeName (type) << " at " << function;
+  return name.str ();
+}
+
+} // namespace ns3
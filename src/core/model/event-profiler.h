@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of ns3::EventProfiler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \brief Wall clock time and count of the events, by event type and context
+ *
+ * The type of an event is the function or method it calls, as given by
+ * EventImpl::GetFunction, e.g.
+ * "ns3::PointToPointNetDevice::TransmitComplete()".  The name of the
+ * function is looked up with dladdr when the report is built, so only
+ * the functions exported by the executable or a library are named; the
+ * others, and the events which do not tell their function, are named
+ * after the C++ type of their EventImpl, i.e. the type of the scheduled
+ * function pointer for the events made by MakeEvent, followed by the
+ * address of the function if it is known.  The context of an event is
+ * the node id it was scheduled with, if any.
+ *
+ * The events are timed with the time stamp counter of the processor
+ * where available, which is calibrated against the monotonic clock over
+ * the life of the profiler, and with the monotonic clock otherwise.  The
+ * records are kept in an open addressing hash table keyed by the
+ * function, the EventImpl type and the context, so that recording an
+ * event costs two reads of the counter and a table lookup; the names of
+ * the functions are only looked up when the report is built.
+ */
+class EventProfiler
+{
+public:
+  /** The time and count of the events of a type, or of a context. */
+  struct Entry
+  {
+    std::string name;  //!< the event type, or the context
+    uint64_t count;    //!< the number of events
+    uint64_t time;     //!< the wall clock time of the events, in nanoseconds
+  };
+
+  EventProfiler ();
+  ~EventProfiler ();
+
+  /**
+   * \return the monotonic wall clock time, in nanoseconds
+   */
+  static uint64_t GetTime (void);
+  /**
+   * \return the time stamp counter, or the monotonic wall clock time in
+   *         nanoseconds where there is no such counter
+   */
+  static uint64_t GetTicks (void);
+
+  /**
+   * Account for an event.
+   *
+   * \param type the type of the EventImpl of the event
+   * \param function the function called by the event, from
+   *        EventImpl::GetFunction
+   * \param context the context of the event
+   * \param ticks the wall clock time of the event, from GetTicks
+   */
+  void Record (const std::type_info &type, const void *function, uint32_t context, uint64_t ticks);
+
+  /**
+   * \return the number of events recorded
+   */
+  uint64_t GetEventCount (void) const;
+  /**
+   * \return the wall clock time of the events recorded, in nanoseconds
+   */
+  uint64_t GetTotalTime (void) const;
+  /**
+   * \return the events by type, from the most expensive
+   */
+  std::vector<Entry> GetEventTypes (void) const;
+  /**
+   * \return the events by context, from the most expensive
+   */
+  std::vector<Entry> GetContexts (void) const;
+  /**
+   * Print the events by type and by context, from the most expensive.
+   *
+   * \param os the output stream
+   * \param maxLines the largest number of lines of each table
+   */
+  void Print (std::ostream &os, uint32_t maxLines) const;
+  /** Forget all the events recorded. */
+  void Clear (void);
+
+  /**
+   * \param type the type of an EventImpl
+   * \return a readable name for the type: the function pointer type
+   *         for the events made by MakeEvent, the demangled type
+   *         otherwise
+   */
+  static std::string GetEventTypeName (const std::type_info &type);
+  /**
+   * \param type the type of an EventImpl
+   * \param function the function called by the event, or 0
+   * \return the demangled name of the function if it has a symbol,
+   *         otherwise the name of the type, followed by the address of
+   *         the function if it is known
+   */
+  static std::string GetEventName (const std::type_info &type, const void *function);
+
+private:
+  EventProfiler (const EventProfiler &);
+  EventProfiler & operator = (const EventProfiler &);
+
+  /** The time and count of the events of a type in a context. */
+  struct Slot
+  {
+    const std::type_info *type;  //!< the event type, 0 if the slot is free
+    const void *function;        //!< the function called by the events
+    uint32_t context;            //!< the context
+    uint64_t count;              //!< the number of events
+    uint64_t ticks;              //!< the wall clock time of the events
+  };
+
+  /**
+   * \param type the event type
+   * \param function the function called by the events
+   * \param context the context
+   * \return the slot of the type, function and context, created if needed
+   */
+  Slot * Lookup (const std::type_info *type, const void *function, uint32_t context);
+  /** Double the size of the table. */
+  void Grow (void);
+  /**
+   * \param entries entries to merge by name and sort by time
+   * \return the merged and sorted entries
+   */
+  static std::vector<Entry> Sort (const std::vector<Entry> &entries);
+  /**
+   * \return the number of nanoseconds per tick
+   */
+  double GetTickPeriod (void) const;
+
+  std::vector<Slot> m_slots;  //!< the hash table, of a power of two size
+  uint32_t m_nSlots;          //!< the number of used slots
+  Slot *m_last;               //!< the slot of the last event recorded
+  uint64_t m_startTime;       //!< the creation time of the profiler
+  uint64_t m_startTicks;      //!< the creation ticks of the profiler
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -126,6 +126,8 @@ HeapScheduler::Exch (uint32_t a, uint32_t b)
   Event tmp (m_heap[a]);
   m_heap[a] = m_heap[b];
   m_heap[b] = tmp;
+  m_heap[a].impl->SetSchedulerIndex (a);
+  m_heap[b].impl->SetSchedulerIndex (b);
 }
 
 bool
@@ -150,10 +152,10 @@ HeapScheduler::IsEmpty (void) const
 }
 
 void
-HeapScheduler::BottomUp (void)
+HeapScheduler::BottomUp (uint32_t start)
 {
-  NS_LOG_FUNCTION (this);
-  uint32_t index = Last ();
+  NS_LOG_FUNCTION (this << start);
+  uint32_t index = start;
   while (!IsRoot (index)
          && IsLessStrictly (index, Parent (index)))
     {
@@ -203,7 +205,8 @@ HeapScheduler::Insert (const Event &ev)
 {
   NS_LOG_FUNCTION (this << &ev);
   m_heap.push_back (ev);
-  BottomUp ();
+  ev.impl->SetSchedulerIndex (Last ());
+  BottomUp (Last ());
 }
 
 Scheduler::Event
@@ -228,19 +231,17 @@ void
 HeapScheduler::Remove (const Event &ev)
 {
   NS_LOG_FUNCTION (this << &ev);
-  uint32_t uid = ev.key.m_uid;
-  for (uint32_t i = 1; i < m_heap.size (); i++)
+  uint32_t i = ev.impl->GetSchedulerIndex ();
+  NS_ASSERT (i < m_heap.size () && m_heap[i].key.m_uid == ev.key.m_uid);
+  NS_ASSERT (m_heap[i].impl == ev.impl);
+  Exch (i, Last ());
+  m_heap.pop_back ();
+  if (i < m_heap.size ())
     {
-      if (uid == m_heap[i].key.m_uid)
-        {
-          NS_ASSERT (m_heap[i].impl == ev.impl);
-          Exch (i, Last ());
-          m_heap.pop_back ();
-          TopDown (i);
-          return;
-        }
+      // The former Last item may belong above or below i
+      BottomUp (i);
+      TopDown (i);
     }
-  NS_ASSERT (false);
 }
 
 } // namespace ns3
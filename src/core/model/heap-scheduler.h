@@ -49,6 +49,9 @@ namespace ns3 {
  *    the index of the root is 1.
  *  - It uses a slightly non-standard while loop for top-down heapify
  *    to move one if statement out of the loop.
+ *  - It records the index of each event in its EventImpl
+ *    (EventImpl::SetSchedulerIndex) whenever the event moves, so that
+ *    Remove() finds the event in constant time and runs in O(log n).
  */
 class HeapScheduler : public Scheduler
 {
@@ -151,8 +154,13 @@ private:
    * \param [in] b The second item.
    */
   inline void Exch (uint32_t a, uint32_t b);
-  /** Percolate a newly inserted Last item to its proper position. */ 
-  void BottomUp (void);
+  /**
+   * Percolate an item up to its proper position.
+   *
+   * \param [in] start The index of the item, the Last item when it was
+   *                   just inserted.
+   */
+  void BottomUp (uint32_t start);
   /**
    * Percolate a deletion bubble down the heap.
    *
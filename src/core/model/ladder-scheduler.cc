@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+const uint32_t LadderScheduler::THRESHOLD;
+const uint32_t LadderScheduler::MAX_RUNGS;
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Compare (greater than) two events, to sort Bottom in decreasing order.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a > \c b
+ */
+bool
+EventGreater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (0),
+    m_topMax (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_bottomLimit (THRESHOLD),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung)
+{
+  return rung.start + rung.current * rung.width;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_size++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+  InsertBelowTop (ev);
+}
+
+void
+LadderScheduler::InsertBelowTop (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= GetCurrentStart (rung))
+        {
+          uint64_t bucket = (ts - rung.start) / rung.width;
+          NS_ASSERT (bucket < rung.nBuckets);
+          NS_LOG_LOGIC ("insert in rung=" << i << ", bucket=" << bucket);
+          rung.buckets[bucket].push_back (ev);
+          rung.nEvents++;
+          return;
+        }
+    }
+
+  NS_LOG_LOGIC ("insert in bottom");
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, EventGreater), ev);
+
+  if (m_bottom.size () > m_bottomLimit && m_nRungs < MAX_RUNGS)
+    {
+      // Bottom covers the range below the lowest rung, or below Top
+      uint64_t start = m_bottom.back ().key.m_ts;
+      uint64_t end = m_nRungs > 0 ? GetCurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+      NS_LOG_LOGIC ("turn bottom into rung=" << m_nRungs);
+      Bucket events;
+      events.swap (m_bottom);
+      AddRung (events, start, end);
+      // Keep the storage of Bottom
+      m_bottom.swap (events);
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // Moving events down the ladder does not change the set of events
+  const_cast<LadderScheduler *> (this)->FillBottom ();
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  FillBottom ();
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket = &m_bottom;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= GetCurrentStart (rung))
+            {
+              bucket = &rung.buckets[(ts - rung.start) / rung.width];
+              rung.nEvents--;
+              break;
+            }
+        }
+    }
+
+  if (bucket == &m_bottom)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, EventGreater);
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      m_bottom.erase (i);
+      m_size--;
+      return;
+    }
+
+  // Top and the buckets are not sorted
+  for (Bucket::iterator i = bucket->begin (); i != bucket->end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = bucket->back ();
+          bucket->pop_back ();
+          m_size--;
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          // Start a new epoch with the events of Top
+          NS_ASSERT (!m_top.empty ());
+          uint64_t start = m_topMin;
+          uint64_t end = m_topMax + 1;
+          m_topStart = end;
+          if (m_top.size () <= THRESHOLD)
+            {
+              SortIntoBottom (m_top);
+            }
+          else
+            {
+              AddRung (m_top, start, end);
+            }
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = GetCurrentStart (rung);
+      rung.current++;
+      rung.nEvents -= bucket.size ();
+      if (bucket.size () > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          AddRung (bucket, start, start + rung.width);
+        }
+      else
+        {
+          SortIntoBottom (bucket);
+        }
+    }
+}
+
+void
+LadderScheduler::AddRung (Bucket &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (end > start);
+  // m_rungs has MAX_RUNGS elements, so references to rungs stay valid
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+
+  uint64_t span = end - start;
+  uint64_t n = events.size ();
+  uint64_t width = (span + n - 1) / n;
+  uint32_t nBuckets = (span + width - 1) / width;
+  if (rung.buckets.size () < nBuckets)
+    {
+      rung.buckets.resize (nBuckets);
+    }
+  rung.nBuckets = nBuckets;
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.nEvents = n;
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.buckets[(i->key.m_ts - start) / width].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::SortIntoBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), EventGreater);
+  m_bottomLimit = std::max (THRESHOLD, 2 * static_cast<uint32_t> (m_bottom.size ()));
+}
+
+} // namespace ns3
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wee Tee Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * Events are kept in three tiers:
+ *  - Top: an unsorted list of the events beyond the range of the ladder;
+ *  - Ladder: up to MAX_RUNGS rungs of buckets, each rung splitting one
+ *    bucket of the rung above into finer buckets.  Buckets are unsorted;
+ *  - Bottom: a sorted list of the earliest events.
+ *
+ * New events are appended to Top or to a bucket, without sorting.  When
+ * Bottom is empty, the next non-empty bucket of the lowest rung is either
+ * sorted into Bottom, if it holds at most THRESHOLD events, or split into
+ * a new rung.  Only small sets of events are ever sorted, and the bucket
+ * width of each rung is derived from the events it holds, so the
+ * structure adapts to skewed distributions of timestamps (e.g. short
+ * serialization delays mixed with long timers) without the global
+ * resizing of the CalendarScheduler.
+ *
+ * Buckets are std::vector objects which are kept, with their capacity,
+ * when they are emptied, so that the scheduler stops allocating memory
+ * once it has reached its steady state.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Event list type: a vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    std::vector<Bucket> buckets;  /**< The buckets; only the first nBuckets are in use. */
+    uint32_t nBuckets;            /**< Number of buckets in use. */
+    uint64_t start;               /**< Timestamp at the start of the first bucket. */
+    uint64_t width;               /**< Duration of a bucket, in dimensionless time units. */
+    uint32_t current;             /**< Index of the first bucket which may hold events. */
+    uint32_t nEvents;             /**< Number of events in the buckets. */
+  };
+
+  /** Max number of events sorted into Bottom at once. */
+  static const uint32_t THRESHOLD = 50;
+  /** Max number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /**
+   * Make sure that Bottom holds the earliest event, moving events down
+   * from the ladder and Top as needed.
+   */
+  void FillBottom (void);
+  /**
+   * Create a new lowest rung covering [start, end) with the given events.
+   *
+   * \param [in,out] events The events, which are moved to the new rung.
+   * \param [in] start The start of the range of the rung.
+   * \param [in] end The end of the range of the rung.
+   */
+  void AddRung (Bucket &events, uint64_t start, uint64_t end);
+  /**
+   * Sort the events of a bucket into Bottom, which must be empty.
+   *
+   * \param [in,out] events The events, which are moved to Bottom.
+   */
+  void SortIntoBottom (Bucket &events);
+  /**
+   * Insert an event in the ladder or in Bottom.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBelowTop (const Scheduler::Event &ev);
+  /**
+   * Get the start of the first bucket of a rung which may hold events.
+   *
+   * \param [in] rung The rung.
+   * \returns The timestamp.
+   */
+  static uint64_t GetCurrentStart (const Rung &rung);
+
+  /** Events beyond the ladder, unsorted. */
+  Bucket m_top;
+  /** Timestamps at and above this go to Top. */
+  uint64_t m_topStart;
+  /** Smallest timestamp in Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in Top. */
+  uint64_t m_topMax;
+  /** The rungs; only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The earliest events, sorted in decreasing order so that the next one is at the back. */
+  Bucket m_bottom;
+  /**
+   * Size above which Bottom is turned into a rung when an event is
+   * inserted into it; doubled when a large set of events could not be
+   * split (e.g. events with equal timestamps), so that it is not
+   * sorted again on every insertion.
+   */
+  uint32_t m_bottomLimit;
+  /** Number of events in the scheduler. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
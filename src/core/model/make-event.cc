@@ -47,6 +47,10 @@ public:
     virtual ~EventFunctionImpl0 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 protected:
     virtual void Notify (void)
     {
@@ -263,6 +263,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5
 
 #include "event-impl.h"
 #include "type-traits.h"
+#include <cstring>
 
 namespace ns3 {
 
@@ -302,6 +303,77 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \ingroup makeeventmemptr
+ * Get the address of the code a class method pointer calls on an
+ * object, for EventImpl::GetFunction().
+ *
+ * The pointer is decoded as laid out by the Itanium C++ ABI, which GCC
+ * and clang use: a virtual method is looked up in the virtual table of
+ * the object.  With other ABIs the address is not known.
+ *
+ * \tparam R \deduced The type of the method.
+ * \tparam X \deduced The class of the method.
+ * \tparam T \deduced The class of the object.
+ * \param [in] method The class method pointer.
+ * \param [in] obj The object.
+ * \returns The address of the code, or 0 if it is not known.
+ */
+template <typename R, typename X, typename T>
+const void * GetEventMethodAddress (R X::*method, const T &obj)
+{
+#if defined (__GXX_ABI_VERSION)
+  struct
+  {
+    uintptr_t ptr;
+    ptrdiff_t adj;
+  } rep;
+  if (sizeof (method) != sizeof (rep))
+    {
+      return 0;
+    }
+  std::memcpy (&rep, &method, sizeof (rep));
+#if defined (__arm__) || defined (__aarch64__)
+  // The virtual flag is in adj, and ptr is the offset in the table
+  bool isVirtual = (rep.adj & 1) != 0;
+  ptrdiff_t adj = rep.adj >> 1;
+  uintptr_t offset = rep.ptr;
+#else
+  // ptr is the address of the code, or 1 + the offset in the table
+  bool isVirtual = (rep.ptr & 1) != 0;
+  ptrdiff_t adj = rep.adj;
+  uintptr_t offset = rep.ptr - 1;
+#endif
+  if (!isVirtual)
+    {
+      return reinterpret_cast<const void *> (rep.ptr);
+    }
+  const X *base = &obj;
+  const char *self = reinterpret_cast<const char *> (base) + adj;
+  const void * const *vtable = *reinterpret_cast<const void * const * const *> (self);
+  return vtable[offset / sizeof (void *)];
+#else
+  return 0;
+#endif
+}
+
+/**
+ * \ingroup makeeventfnptr
+ * Get the address of the code of a function pointer, for
+ * EventImpl::GetFunction().
+ *
+ * \tparam F \deduced The type of the function pointer.
+ * \param [in] function The function pointer.
+ * \returns The address of the code.
+ */
+template <typename F>
+const void * GetEventFunctionAddress (F function)
+{
+  const void *address;
+  std::memcpy (&address, &function, sizeof (address));
+  return address;
+}
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -317,6 +389,10 @@ public:
     virtual ~EventMemberImpl0 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -347,6 +423,10 @@ protected:
     virtual ~EventMemberImpl1 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -378,6 +458,10 @@ protected:
     virtual ~EventMemberImpl2 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -411,6 +495,10 @@ protected:
     virtual ~EventMemberImpl3 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -446,6 +534,10 @@ protected:
     virtual ~EventMemberImpl4 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -484,6 +576,10 @@ protected:
     virtual ~EventMemberImpl5 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventMethodAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -518,6 +614,10 @@ protected:
     virtual ~EventFunctionImpl1 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -548,6 +648,10 @@ protected:
     virtual ~EventFunctionImpl2 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -581,6 +685,10 @@ protected:
     virtual ~EventFunctionImpl3 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -616,6 +724,10 @@ protected:
     virtual ~EventFunctionImpl4 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -653,6 +765,10 @@ protected:
     virtual ~EventFunctionImpl5 ()
     {
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPSC_QUEUE_H
+#define NS3_MPSC_QUEUE_H
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MpscQueue declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief An unbounded lock-free queue with many producer threads and a
+ * single consumer thread
+ *
+ * Each item is held in a node of a singly linked list.  A producer
+ * swaps its node in as the new tail with an atomic exchange, then links
+ * the previous tail to it with a release store; the consumer follows
+ * the links from the head with acquire loads.  Push is thus wait-free:
+ * a producer never waits for another producer, nor for the consumer.
+ *
+ * Between the exchange and the link of a Push, the items pushed after
+ * it are not yet visible to the consumer: Pop reports the queue as
+ * empty until the link is made.  The items of each producer are popped
+ * in the order they were pushed.
+ *
+ * The head of the list is a node whose item was already popped, so
+ * that Push and Pop never touch the same node unless the queue is
+ * empty.  The head and tail pointers are kept on separate cache lines.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  MpscQueue ();
+  ~MpscQueue ();
+
+  /**
+   * Append an item; may be called by any thread.
+   *
+   * \param item the item
+   */
+  void Push (const T &item);
+  /**
+   * Remove the first item; called by the consumer thread only.
+   *
+   * \param item the item, if any
+   * \return true if an item was removed, false if the queue was empty
+   */
+  bool Pop (T &item);
+  /**
+   * \return true if no item can be popped; called by the consumer
+   *         thread only.
+   */
+  bool IsEmpty (void) const;
+
+private:
+  MpscQueue (const MpscQueue &);
+  MpscQueue & operator = (const MpscQueue &);
+
+  /** A node of the list. */
+  struct Node
+  {
+    Node ();
+    T item;                //!< the item
+    Node *next;            //!< the next node, linked by the producer
+  };
+
+  Node *m_head;            //!< the last node popped by the consumer
+  char m_pad[64];          //!< keep the producer field on another cache line
+  Node *m_tail;            //!< the last node pushed by the producers
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::Node::Node ()
+  : item (),
+    next (0)
+{
+}
+
+template <typename T>
+MpscQueue<T>::MpscQueue ()
+{
+  m_head = new Node ();
+  m_tail = m_head;
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  while (m_head != 0)
+    {
+      Node *next = m_head->next;
+      delete m_head;
+      m_head = next;
+    }
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push (const T &item)
+{
+  Node *node = new Node ();
+  node->item = item;
+  Node *prev = __atomic_exchange_n (&m_tail, node, __ATOMIC_ACQ_REL);
+  __atomic_store_n (&prev->next, node, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &item)
+{
+  Node *next = __atomic_load_n (&m_head->next, __ATOMIC_ACQUIRE);
+  if (next == 0)
+    {
+      return false;
+    }
+  item = next->item;
+  delete m_head;
+  m_head = next;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return __atomic_load_n (&m_head->next, __ATOMIC_ACQUIRE) == 0;
+}
+
+} // namespace ns3
+
+#endif /* NS3_MPSC_QUEUE_H */
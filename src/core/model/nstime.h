@@ -26,6 +26,7 @@
 #include "int64x64.h"
 #include "unused.h"
 #include <stdint.h>
+#include <string.h>
 #include <limits>
 #include <cmath>
 #include <ostream>
@@ -441,6 +442,14 @@ public:
   }
   inline static Time FromDouble (double value, enum Unit unit)
   {
+#if (defined (INT64X64_USE_128) || defined (INT64X64_USE_CAIRO)) && defined (__SIZEOF_INT128__)
+    struct Information *info = PeekInformation (unit);
+    int64_t ts;
+    if (info->fromMul && MulDouble (value, info->factor, &ts))
+      {
+        return Time (ts);
+      }
+#endif
     return From (int64x64_t (value), unit);
   }
   inline static Time From (const int64x64_t & value, enum Unit unit)
@@ -484,12 +493,32 @@ public:
       }
     else
       {
-        v /= info->factor;
+        v = Divide (v, info);
       }
     return v;
   }
+  /**
+   *  Get the Time value expressed in a particular unit, as a double.
+   *
+   *  When \p unit is coarser than the resolution, and both the Time
+   *  value and the factor of \p unit are at most \f$ 2^{53} \f$ in
+   *  magnitude, they are exact doubles, and the result is their
+   *  quotient, correctly rounded.  It may then differ in the last bit
+   *  from To (unit).GetDouble (), which rounds twice and is used in
+   *  the other cases.
+   *
+   *  \param [in] unit The desired unit
+   *  \return The Time expressed in \p unit
+   */
   inline double ToDouble (enum Unit unit) const
   {
+    struct Information *info = PeekInformation (unit);
+    const int64_t exact = static_cast<int64_t> (1) << 53;
+    if (!info->toMul && m_data <= exact && m_data >= -exact && info->factor <= exact)
+      {
+        // One rounding, instead of two through int64x64_t.
+        return static_cast<double> (m_data) / static_cast<double> (info->factor);
+      }
     return To (unit).GetDouble ();
   }
   inline int64x64_t To (enum Unit unit) const
@@ -540,6 +569,8 @@ private:
     int64_t factor;                 //!< Ratio of this unit / current unit
     int64x64_t timeTo;              //!< Multiplier to convert to this unit
     int64x64_t timeFrom;            //!< Multiplier to convert from this unit
+    uint64_t divMagic;              //!< Multiplier to divide by factor, see Divide()
+    int divShift;                   //!< Shift to divide by factor, see Divide()
   };
   /** Current time unit, and conversion info. */
   struct Resolution
@@ -569,6 +600,111 @@ private:
     return & (PeekResolution ()->info[timeUnit]);
   }
 
+  /**
+   *  Divide by the factor of a unit, rounding toward zero as \c /.
+   *
+   *  \internal
+   *
+   *  The integer division is replaced by a multiplication by a
+   *  precomputed reciprocal (Granlund and Montgomery, "Division by
+   *  invariant integers using multiplication", 1994): with
+   *  \f$ l = \lceil \log_2 d \rceil \f$ and
+   *  \f$ m = \lceil 2^{63 + l} / d \rceil \f$, which fits in 64 bits,
+   *  \f$ \lfloor n / d \rfloor = \lfloor n m / 2^{63 + l} \rfloor \f$
+   *  for all \f$ 0 \le n < 2^{63} \f$.
+   *
+   *  \param [in] v The value to divide.
+   *  \param [in] info The Information of the unit.
+   *  \return \p v divided by the factor of the unit.
+   */
+  static inline int64_t Divide (int64_t v, const struct Information *info)
+  {
+#ifdef __SIZEOF_INT128__
+    if (v != std::numeric_limits<int64_t>::min ())
+      {
+        uint64_t n = v < 0 ? -v : v;
+        uint64_t q = static_cast<uint64_t> ((static_cast<__uint128_t> (n) * info->divMagic)
+                                            >> (63 + info->divShift));
+        return v < 0 ? -static_cast<int64_t> (q) : static_cast<int64_t> (q);
+      }
+#endif
+    return v / info->factor;
+  }
+#if (defined (INT64X64_USE_128) || defined (INT64X64_USE_CAIRO)) && defined (__SIZEOF_INT128__)
+  /**
+   *  Multiply a double by the factor of a unit, with the same result as
+   *  From (int64x64_t (value), unit), without going through int64x64_t.
+   *
+   *  \internal
+   *
+   *  int64x64_t (value) is exact when \p value has no more than 64
+   *  fractional bits, and rounds the fractional part to 64 bits, half
+   *  up, otherwise; the product by an integer factor is then exact, and
+   *  the Time is its floor.  The double \p value is \f$ m 2^e \f$, with
+   *  an integer mantissa \f$ m < 2^{53} \f$, so this is done with a
+   *  128 bit integer product and a shift.
+   *
+   *  \param [in] value The value to multiply.
+   *  \param [in] factor The factor of the unit.
+   *  \param [out] ts The Time value, in the current unit.
+   *  \return \c false, leaving \p ts alone, if \p value is not finite,
+   *          too small (below \f$ 2^{-76} \f$) or too large for this path.
+   */
+  static inline bool MulDouble (double value, int64_t factor, int64_t *ts)
+  {
+    uint64_t bits;
+    memcpy (&bits, &value, sizeof (bits));
+    int exponent = static_cast<int> ((bits >> 52) & 0x7ff);
+    uint64_t m = bits & ((static_cast<uint64_t> (1) << 52) - 1);
+    if (exponent == 0 || exponent == 0x7ff)
+      {
+        // Zero, subnormal, infinite or NaN
+        if (exponent == 0 && m == 0)
+          {
+            *ts = 0;
+            return true;
+          }
+        return false;
+      }
+    m |= static_cast<uint64_t> (1) << 52;
+    int e = exponent - 1075;
+    if (e > 0 || e < -128)
+      {
+        return false;
+      }
+    __uint128_t product;
+    int shift;
+    if (e >= -64)
+      {
+        product = static_cast<__uint128_t> (m) * static_cast<uint64_t> (factor);
+        shift = -e;
+      }
+    else
+      {
+        // Round the fractional part of value to 64 bits, half up
+        int k = -64 - e;
+        uint64_t low = static_cast<uint64_t> ((static_cast<__uint128_t> (m)
+                                               + (static_cast<__uint128_t> (1) << (k - 1))) >> k);
+        product = static_cast<__uint128_t> (low) * static_cast<uint64_t> (factor);
+        shift = 64;
+      }
+    __uint128_t q = product >> shift;
+    if ((q >> 63) != 0)
+      {
+        return false;
+      }
+    int64_t r = static_cast<int64_t> (q);
+    if ((bits >> 63) != 0)
+      {
+        // floor of a negative value
+        bool exact = shift == 0 || (product & ((static_cast<__uint128_t> (1) << shift) - 1)) == 0;
+        r = exact ? -r : -r - 1;
+      }
+    *ts = r;
+    return true;
+  }
+#endif
+
   /**
    *  Set the default resolution
    *
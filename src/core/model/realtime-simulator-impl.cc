@@ -34,6 +34,9 @@
 
 
 #include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 
 
 /**
@@ -69,6 +72,12 @@ RealtimeSimulatorImpl::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&RealtimeSimulatorImpl::m_hardLimit),
                    MakeTimeChecker ())
+    .AddAttribute ("ReportLateness",
+                   "Print the histogram of the lateness of the events, "
+                   "with respect to real time, when the simulator is destroyed.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RealtimeSimulatorImpl::m_reportLateness),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -90,6 +99,7 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_lateness.resize (LATENESS_BUCKETS, 0);
 
   m_main = SystemThread::Self();
 
@@ -107,6 +117,11 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      event.event->Unref ();
+    }
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -140,6 +155,10 @@ RealtimeSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_reportLateness)
+    {
+      PrintLateness (std::clog);
+    }
 }
 
 void
@@ -221,6 +240,15 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         NS_ASSERT_MSG (m_synchronizer->Realtime (), 
                        "RealtimeSimulatorImpl::ProcessOneEvent (): Synchronizer reports not Realtime ()");
 
+        //
+        // This resets the synchronizer so that any future event will cause it
+        // to interrupt.  It is done before we look at the events scheduled
+        // from other threads: an event pushed after we have looked is 
+        // followed by a Signal () which will interrupt the wait below.
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
+
         //
         // tsNow is set to the normalized current real time.  When the simulation was
         // started, the current real time was effectively set to zero; so tsNow is
@@ -249,24 +277,16 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
             tsDelay = tsNext - tsNow;
           }
 
-        //
-        // We've figured out how long we need to delay in order to pace the 
-        // simulation time with the real time.  We're going to sleep, but need
-        // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
-        //
-        m_synchronizer->SetCondition (false);
       }
 
       //
       // We have a time to delay.  This time may actually not be valid anymore
       // since we released the critical section immediately above, and a real-time
       // ScheduleReal or ScheduleRealNow may have snuck in, well, between the 
-      // closing brace above and this comment so to speak.  If this is the case, 
-      // that schedule operation will have done a synchronizer Signal() that 
-      // will set the condition variable to true and cause the Synchronize call 
-      // below to return immediately.
+      // call to ProcessEventsWithContext above and this comment so to speak.
+      // If this is the case, that schedule operation will have done a 
+      // synchronizer Signal() that will set the condition variable to true and
+      // cause the Synchronize call below to return immediately.
       //
       // It's easiest to understand if you just consider a short tsDelay that only
       // requires a SpinWait down in the synchronizer.  What will happen is that 
@@ -326,6 +346,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // event we're working on won't be on the list and so subsequent operations won't
     // mess with us.
     //
+    ProcessEventsWithContext ();
     NS_ASSERT_MSG (m_events->IsEmpty () == false, 
                    "RealtimeSimulatorImpl::ProcessOneEvent(): event queue is empty");
     next = m_events->RemoveNext ();
@@ -359,9 +380,11 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // We check the simulation time against the current real time to make this
     // judgement.
     //
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    RecordLateness (tsFinal);
+
     if (m_synchronizationMode == SYNC_HARD_LIMIT)
       {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
         uint64_t tsJitter;
 
         if (tsFinal >= m_currentTs)
@@ -393,13 +416,86 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   event->Unref ();
 }
 
+void
+RealtimeSimulatorImpl::RecordLateness (uint64_t tsNow)
+{
+  uint32_t bucket;
+  if (tsNow < m_currentTs)
+    {
+      bucket = 0;
+    }
+  else
+    {
+      // Bucket b > 0 holds the events late by less than 2^(b-1) us
+      uint64_t us = (tsNow - m_currentTs) / 1000;
+      bucket = 1;
+      while (us != 0 && bucket < LATENESS_BUCKETS - 1)
+        {
+          us >>= 1;
+          bucket++;
+        }
+    }
+  m_lateness[bucket]++;
+}
+
+std::vector<uint64_t>
+RealtimeSimulatorImpl::GetLatenessHistogram (void) const
+{
+  CriticalSection cs (m_mutex);
+  return m_lateness;
+}
+
+void
+RealtimeSimulatorImpl::PrintLateness (std::ostream &os) const
+{
+  std::vector<uint64_t> lateness = GetLatenessHistogram ();
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < lateness.size (); ++i)
+    {
+      total += lateness[i];
+    }
+  os << "Event lateness: " << total << " events" << std::endl;
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  for (uint32_t i = 0; i < lateness.size (); ++i)
+    {
+      if (lateness[i] == 0)
+        {
+          continue;
+        }
+      std::ostringstream range;
+      if (i == 0)
+        {
+          range << "early";
+        }
+      else if (i == 1)
+        {
+          range << "< 1 us";
+        }
+      else if (i == lateness.size () - 1)
+        {
+          range << ">= " << (1ULL << (i - 2)) << " us";
+        }
+      else
+        {
+          range << (1ULL << (i - 2)) << " - " << (1ULL << (i - 1)) << " us";
+        }
+      os << std::setw (20) << range.str ()
+         << std::setw (14) << lateness[i]
+         << std::fixed << std::setprecision (2)
+         << std::setw (9) << 100.0 * lateness[i] / total << "%" << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
 bool 
 RealtimeSimulatorImpl::IsFinished (void) const
 {
   bool rc;
   {
     CriticalSection cs (m_mutex);
-    rc = m_events->IsEmpty () || m_stop;
+    rc = (m_events->IsEmpty () && m_eventsWithContext.IsEmpty ()) || m_stop;
   }
 
   return rc;
@@ -417,6 +513,54 @@ RealtimeSimulatorImpl::NextTs (void) const
   return ev.key.m_ts;
 }
 
+void
+RealtimeSimulatorImpl::PushEventWithContext (uint32_t context, uint64_t ts, bool relative,
+                                             EventImpl *impl)
+{
+  EventWithContext ev;
+  ev.context = context;
+  ev.timestamp = ts;
+  ev.relative = relative;
+  ev.event = impl;
+  m_eventsWithContext.Push (ev);
+  //
+  // The event is visible to ProcessEventsWithContext before the synchronizer
+  // is signalled, so a wait which starts after the condition is reset cannot
+  // miss it.
+  //
+  m_synchronizer->Signal ();
+}
+
+//
+// Should be called with critical section locked.
+//
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      uint64_t ts = event.relative ? m_currentTs + event.timestamp : event.timestamp;
+      //
+      // The real time was read by the other thread before we took the lock,
+      // so the event we executed since may be later.  Time cannot move 
+      // backward.
+      //
+      if (ts < m_currentTs)
+        {
+          ts = m_currentTs;
+        }
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+}
+
 void
 RealtimeSimulatorImpl::Run (void)
 {
@@ -442,6 +586,10 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        // As in ProcessOneEvent, reset the synchronizer before looking at
+        // the events scheduled from other threads, not to miss a Signal ().
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -543,23 +691,27 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      //
+      // If the simulator is running, we're pacing and have a meaningful 
+      // realtime clock.  If we're not, then m_currentTs is where we stopped.
+      // 
+      if (m_running)
+        {
+          PushEventWithContext (context, m_synchronizer->GetCurrentRealtime () + delay.GetTimeStep (),
+                                false, impl);
+        }
+      else
+        {
+          PushEventWithContext (context, delay.GetTimeStep (), true, impl);
+        }
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
-
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + delay.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += delay.GetTimeStep ();
-      }
+    uint64_t ts = m_currentTs + delay.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -609,6 +761,13 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      PushEventWithContext (context, m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (),
+                            false, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -636,6 +795,20 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  if (!SystemThread::Equals (m_main))
+    {
+      if (m_running)
+        {
+          PushEventWithContext (context, m_synchronizer->GetCurrentRealtime (), false, impl);
+        }
+      else
+        {
+          PushEventWithContext (context, 0, true, impl);
+        }
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
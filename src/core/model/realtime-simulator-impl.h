@@ -30,8 +30,11 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
 
 #include <list>
+#include <ostream>
+#include <vector>
 
 /**
  * \file
@@ -154,6 +157,26 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /**
+   * Get the histogram of the lateness of the events run so far, i.e. of
+   * the real time at which they started minus their simulation time.
+   *
+   * Element 0 counts the events started ahead of time, which the
+   * synchronizer may do to batch events (see WallClockSynchronizer
+   * Slack attribute); element 1 the events late by less than 1 &mu;s;
+   * element \c i > 1 the events late by 2^(i-2) to 2^(i-1) &mu;s.  The
+   * last element also counts all the later events.
+   *
+   * \returns The number of events in each lateness bucket.
+   */
+  std::vector<uint64_t> GetLatenessHistogram (void) const;
+  /**
+   * Print the histogram of the lateness of the events run so far.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void PrintLateness (std::ostream &os) const;
+
 private:
   /**
    * Is the simulator running?
@@ -172,6 +195,28 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Account for the lateness of the current event.
+   * Should be called with #m_mutex locked.
+   *
+   * \param [in] tsNow The real time at which the current event starts.
+   */
+  void RecordLateness (uint64_t tsNow);
+  /**
+   * Move the events scheduled from other threads into the event list.
+   * Should be called with #m_mutex locked.
+   */
+  void ProcessEventsWithContext (void);
+  /**
+   * Queue an event scheduled from a thread other than the main thread.
+   *
+   * \param [in] context The event context.
+   * \param [in] ts The event timestamp.
+   * \param [in] relative \c true if \p ts is relative to the timestamp
+   *     of the current event when the event is moved into the event list.
+   * \param [in] impl The event implementation.
+   */
+  void PushEventWithContext (uint32_t context, uint64_t ts, bool relative, EventImpl *impl);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -207,6 +252,24 @@ private:
   /** Mutex to control access to key state. */  
   mutable SystemMutex m_mutex;  
 
+  /** Wrap an event scheduled from another thread with its context. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** Is the timestamp relative to the current event? */
+    bool relative;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /**
+   * The events scheduled from other threads.  They are pushed without
+   * locking #m_mutex, and moved into the event list by the holder of
+   * #m_mutex.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
+
   /** The synchronizer in use to track real time. */
   Ptr<Synchronizer> m_synchronizer;
 
@@ -218,6 +281,13 @@ private:
 
   /** Main SystemThread. */
   SystemThread::ThreadId m_main;
+
+  /** The number of lateness buckets. */
+  static const uint32_t LATENESS_BUCKETS = 32;
+  /** The number of events in each lateness bucket, protected by #m_mutex. */
+  std::vector<uint64_t> m_lateness;
+  /** Print the lateness histogram at Destroy. */
+  bool m_reportLateness;
 };
 
 } // namespace ns3
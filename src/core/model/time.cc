@@ -222,6 +222,8 @@ Time::SetResolution (enum Unit unit, struct Resolution *resolution,
       NS_LOG_DEBUG ("SetResolution factor " << factor << " real factor " << realFactor);
       struct Information *info = &resolution->info[i];
       info->factor = factor;
+      info->divMagic = 0;
+      info->divShift = 0;
       // here we could equivalently check for realFactor == 1.0 but it's better
       // to avoid checking equality of doubles
       if (shift == 0 && quotient == 1)
@@ -237,6 +239,15 @@ Time::SetResolution (enum Unit unit, struct Resolution *resolution,
           info->timeTo = int64x64_t::Invert (factor);
           info->toMul = false;
           info->fromMul = true;
+#ifdef __SIZEOF_INT128__
+          // See Divide ()
+          while ((static_cast<uint64_t> (1) << info->divShift) < static_cast<uint64_t> (factor))
+            {
+              info->divShift++;
+            }
+          __uint128_t one = 1;
+          info->divMagic = static_cast<uint64_t> (((one << (63 + info->divShift)) + factor - 1) / factor);
+#endif
         }
       else
         {
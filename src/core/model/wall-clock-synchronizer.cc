@@ -18,10 +18,15 @@
 
 
 #include <ctime>       // clock_t
+#include <cerrno>
 #include <sys/time.h>  // gettimeofday
+#ifdef __linux__
+#include <sys/prctl.h> // prctl (PR_SET_TIMERSLACK)
+#endif
                        // clock_getres: glibc < 2.17, link with librt
 
 #include "log.h"
+#include "enum.h"
 #include "system-condition.h"
 
 #include "wall-clock-synchronizer.h"
@@ -44,11 +49,32 @@ WallClockSynchronizer::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::WallClockSynchronizer")
     .SetParent<Synchronizer> ()
     .SetGroupName ("Core")
+    .AddAttribute ("SleepMode",
+                   "How to wait for the next event.",
+                   EnumValue (SLEEP_SPIN),
+                   MakeEnumAccessor (&WallClockSynchronizer::m_sleepMode),
+                   MakeEnumChecker (SLEEP_SPIN, "Spin",
+                                    SLEEP_ABSOLUTE, "Absolute"))
+    .AddAttribute ("Slack",
+                   "In Absolute sleep mode, the events due within this time "
+                   "are run at once, ahead of time.",
+                   TimeValue (MicroSeconds (0)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_slack),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("AbsoluteTail",
+                   "In Absolute sleep mode, the time before an event at which "
+                   "the interruptible sleep ends and the uninterruptible sleep "
+                   "to the time of the event starts.  It should cover the "
+                   "late wake-ups of the interruptible sleep.",
+                   TimeValue (MicroSeconds (200)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_absoluteTail),
+                   MakeTimeChecker (Time (0)))
   ;
   return tid;
 }
 
 WallClockSynchronizer::WallClockSynchronizer ()
+  : m_oldTimerSlack (-1)
 {
   NS_LOG_FUNCTION (this);
 //
@@ -91,6 +117,12 @@ WallClockSynchronizer::WallClockSynchronizer ()
 WallClockSynchronizer::~WallClockSynchronizer ()
 {
   NS_LOG_FUNCTION (this);
+#ifdef PR_SET_TIMERSLACK
+  if (m_oldTimerSlack >= 0)
+    {
+      prctl (PR_SET_TIMERSLACK, static_cast<unsigned long> (m_oldTimerSlack), 0UL, 0UL, 0UL);
+    }
+#endif
 }
 
 bool
@@ -121,6 +153,23 @@ WallClockSynchronizer::DoSetOrigin (uint64_t ns)
 //
   m_realtimeOriginNano = GetRealtime ();
   NS_LOG_INFO ("origin = " << m_realtimeOriginNano);
+//
+// Linux delays the timed waits of a thread by up to its timer slack, 50 us
+// by default, to batch the wake-ups of the system.  We are the ones 
+// batching here, so ask for wake-ups on time.  The simulator is started
+// from the thread which will wait for the events, and usually destroyed
+// from it too: the destructor restores the slack.
+//
+#ifdef PR_SET_TIMERSLACK
+  if (m_sleepMode == SLEEP_ABSOLUTE)
+    {
+      if (m_oldTimerSlack < 0)
+        {
+          m_oldTimerSlack = prctl (PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL);
+        }
+      prctl (PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+    }
+#endif
 }
 
 int64_t
@@ -192,6 +241,22 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
   uint64_t ns = DriftCorrect (nsCurrent, nsDelay);
   NS_LOG_INFO ("Synchronize ns = " << ns);
 //
+// In SLEEP_ABSOLUTE mode, the events due within the slack are not waited 
+// for: we tell the simulator the time has come and it runs them back to
+// back.  The others are waited for until their absolute time, which is 
+// nsCurrent + nsDelay in normalized real time, so there is no drift to 
+// correct.
+//
+  if (m_sleepMode == SLEEP_ABSOLUTE)
+    {
+      if (ns <= static_cast<uint64_t> (m_slack.GetNanoSeconds ()))
+        {
+          NS_LOG_INFO ("Within slack");
+          return true;
+        }
+      return AbsoluteWait (nsCurrent + nsDelay);
+    }
+//
 // Once we've decided on how long we need to delay, we need to split this
 // time into sleep waits and busy waits.  The reason for this is described
 // in the comments for the constructor where jiffies and jiffy resolution is
@@ -339,6 +404,42 @@ WallClockSynchronizer::SleepWait (uint64_t ns)
   return m_condition.TimedWait (ns);
 }
 
+bool
+WallClockSynchronizer::AbsoluteWait (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  uint64_t nsNow = GetNormalizedRealtime ();
+  uint64_t nsTail = m_absoluteTail.GetNanoSeconds ();
+  if (nsNow + nsTail < ns)
+    {
+      if (SleepWait (ns - nsTail - nsNow) == false)
+        {
+          NS_LOG_INFO ("SleepWait interrupted");
+          return false;
+        }
+    }
+  else if (m_condition.GetCondition ())
+    {
+      return false;
+    }
+//
+// The last stretch is not interruptible, but it is short.  The absolute 
+// time is on the same clock as GetRealtime.
+//
+  uint64_t nsTarget = m_realtimeOriginNano + ns;
+  struct timespec ts;
+  ts.tv_sec = nsTarget / NS_PER_SEC;
+  ts.tv_nsec = nsTarget % NS_PER_SEC;
+  int rc;
+  do
+    {
+      // Go back to sleep if interrupted by a signal handler.
+      rc = clock_nanosleep (CLOCK_REALTIME, TIMER_ABSTIME, &ts, NULL);
+    }
+  while (rc == EINTR);
+  return true;
+}
+
 uint64_t
 WallClockSynchronizer::DriftCorrect (uint64_t nsNow, uint64_t nsDelay)
 {
@@ -21,6 +21,7 @@
 
 #include "system-condition.h"
 #include "synchronizer.h"
+#include "nstime.h"
 
 /**
  * @file
@@ -59,6 +60,21 @@ namespace ns3 {
  *
  * @todo Add more on jiffies, sleep, processes, etc.
  *
+ * The SleepMode attribute selects how the wait for an event is done:
+ *
+ *  - @c Spin: sleep on the condition variable for all but three jiffies
+ *    of the delay, then busy-wait for the rest;
+ *  - @c Absolute: run at once the events due within the Slack attribute
+ *    of the current real time, so that a burst of events is run back to
+ *    back, and sleep until the absolute real time of the next event.  The
+ *    sleep is done on the condition variable, so that it can be
+ *    interrupted, until the AbsoluteTail attribute before the event,
+ *    then with @c clock_nanosleep and @c TIMER_ABSTIME for the last
+ *    stretch, without any busy-wait.  On Linux, the timer slack of the
+ *    thread which runs the simulation is set to 1 ns when the simulation
+ *    starts, and restored when the synchronizer is destroyed.  The sleep does not accumulate the drift of
+ *    each wake-up, since the target time is absolute.
+ *
  * @internal
  * Nanosleep takes a <tt>struct timeval</tt> as an input so we have to
  * deal with conversion between Time and @c timeval here.
@@ -73,6 +89,14 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** How to wait for the next event. */
+  enum SleepMode {
+    /** Sleep, then busy-wait for the last jiffies. */
+    SLEEP_SPIN,
+    /** Batch the events due within the slack, sleep to an absolute time. */
+    SLEEP_ABSOLUTE
+  };
+
   /** Constructor. */
   WallClockSynchronizer ();
   /** Destructor. */
@@ -123,6 +147,20 @@ protected:
    *          @c false if we retured because the condition was set.
    */
   bool SleepWait (uint64_t ns);
+  /**
+   * Put our process to sleep until the normalized real time equals the
+   * argument, or the condition variable becomes @c true, without a
+   * busy-wait.
+   *
+   * The sleep is done with SleepWait, which is interrupted by Signal(),
+   * until shortly before the target time, then with @c clock_nanosleep
+   * to the absolute target time.
+   *
+   * @param [in] ns The target normalized real time we should wait for.
+   * @returns @c true if we reached the target time,
+   *          @c false if we retured because the condition was set.
+   */
+  bool AbsoluteWait (uint64_t ns);
 
   // Inherited from Synchronizer
   virtual void DoSetOrigin (uint64_t ns);
@@ -190,6 +228,21 @@ protected:
   uint64_t m_jiffy;
   /** Time recorded by DoEventStart. */
   uint64_t m_nsEventStart;
+  /** How to wait for the next event. */
+  SleepMode m_sleepMode;
+  /** Events due within this time are run at once in SLEEP_ABSOLUTE mode. */
+  Time m_slack;
+  /**
+   * In SLEEP_ABSOLUTE mode, the time before the event at which the sleep
+   * on the condition variable ends, and the sleep to the absolute time
+   * of the event starts.
+   */
+  Time m_absoluteTail;
+  /**
+   * The timer slack of the thread before DoSetOrigin set it, restored
+   * by the destructor, or -1 if it was not changed.
+   */
+  int m_oldTimerSlack;
 
   /** Thread synchronizer. */
   SystemCondition m_condition;
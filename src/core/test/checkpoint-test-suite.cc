@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/checkpoint.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace ns3;
+
+class CheckpointForkTestCase : public TestCase
+{
+public:
+  CheckpointForkTestCase (bool inEvent, uint32_t parallel);
+
+private:
+  /** What a branch reports to the calling process. */
+  struct Report
+  {
+    int32_t branch;
+    int64_t now;
+    double sum;
+  };
+
+  virtual void DoRun (void);
+  void Step (void);
+  void Fork (void);
+  void SendReport (void);
+
+  bool m_inEvent;
+  uint32_t m_parallel;
+  uint32_t m_branches;
+  int32_t m_branch;
+  int m_pipe[2];
+  Ptr<UniformRandomVariable> m_rng;
+  double m_gain;
+  double m_sum;
+  double m_sumAtFork;
+};
+
+static std::string
+CheckpointForkName (bool inEvent, uint32_t parallel)
+{
+  std::ostringstream oss;
+  oss << "Check that the branches start from the state of the simulation, "
+      << (inEvent ? "forked in an event" : "forked between runs");
+  if (parallel != 0)
+    {
+      oss << ", " << parallel << " at a time";
+    }
+  return oss.str ();
+}
+
+CheckpointForkTestCase::CheckpointForkTestCase (bool inEvent, uint32_t parallel)
+  : TestCase (CheckpointForkName (inEvent, parallel)),
+    m_inEvent (inEvent),
+    m_parallel (parallel),
+    m_branches (4)
+{
+}
+
+void
+CheckpointForkTestCase::Step (void)
+{
+  m_sum += m_gain * m_rng->GetValue ();
+  Simulator::Schedule (Seconds (m_rng->GetValue (0.5, 1.5)), &CheckpointForkTestCase::Step, this);
+}
+
+void
+CheckpointForkTestCase::Fork (void)
+{
+  m_sumAtFork = m_sum;
+  m_branch = Checkpoint::Fork (m_branches, m_parallel);
+  if (m_branch < 0)
+    {
+      close (m_pipe[1]);
+    }
+  else
+    {
+      // Branch 0 runs as the calling process does, the others with
+      // another gain.
+      m_gain = 1 + m_branch;
+    }
+}
+
+void
+CheckpointForkTestCase::SendReport (void)
+{
+  Report report;
+  report.branch = m_branch;
+  report.now = Simulator::Now ().GetTimeStep ();
+  report.sum = m_sum;
+  bool ok = write (m_pipe[1], &report, sizeof (report)) == sizeof (report);
+  // Do not return to the test runner; the last branch fails on purpose.
+  _exit (ok && m_branch != 3 ? 0 : 1);
+}
+
+void
+CheckpointForkTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (pipe (m_pipe), 0, "pipe() failed");
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_gain = 1;
+  m_sum = 0;
+  m_branch = -1;
+  Simulator::Schedule (Seconds (0), &CheckpointForkTestCase::Step, this);
+
+  if (m_inEvent)
+    {
+      Simulator::Schedule (Seconds (50), &CheckpointForkTestCase::Fork, this);
+      Simulator::Stop (Seconds (100));
+      Simulator::Run ();
+    }
+  else
+    {
+      Simulator::Stop (Seconds (50));
+      Simulator::Run ();
+      Fork ();
+      Simulator::Stop (Seconds (50));
+      Simulator::Run ();
+    }
+  if (m_branch >= 0)
+    {
+      SendReport ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (100), "Wrong stop time");
+  Simulator::Destroy ();
+
+  std::vector<bool> reported (m_branches, false);
+  Report report;
+  while (read (m_pipe[0], &report, sizeof (report)) == sizeof (report))
+    {
+      NS_TEST_ASSERT_MSG_LT (static_cast<uint32_t> (report.branch), m_branches, "Unknown branch");
+      reported[report.branch] = true;
+      NS_TEST_EXPECT_MSG_EQ (report.now, Seconds (100).GetTimeStep (),
+                             "Wrong stop time in branch " << report.branch);
+      // The branches draw the same numbers as the calling process, so
+      // their sums only differ by the gain after the fork.
+      double expected = m_sumAtFork + (1 + report.branch) * (m_sum - m_sumAtFork);
+      NS_TEST_EXPECT_MSG_EQ_TOL (report.sum, expected, 1e-9 * expected,
+                                 "Wrong sum in branch " << report.branch);
+      if (report.branch == 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (report.sum, m_sum, "Branch 0 diverged");
+        }
+    }
+  close (m_pipe[0]);
+  for (uint32_t i = 0; i < m_branches; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (reported[i], true, "No report from branch " << i);
+    }
+  NS_TEST_EXPECT_MSG_GT (m_sumAtFork, 0, "Nothing happened before the fork");
+  NS_TEST_EXPECT_MSG_EQ (Checkpoint::GetFailedBranches (), 1, "Wrong number of failed branches");
+}
+
+class CheckpointTestSuite : public TestSuite
+{
+public:
+  CheckpointTestSuite ()
+    : TestSuite ("checkpoint")
+  {
+    AddTestCase (new CheckpointForkTestCase (false, 0), TestCase::QUICK);
+    AddTestCase (new CheckpointForkTestCase (true, 0), TestCase::QUICK);
+    AddTestCase (new CheckpointForkTestCase (true, 1), TestCase::QUICK);
+  }
+} g_checkpointTestSuite;
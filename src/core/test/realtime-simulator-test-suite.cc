@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+using namespace ns3;
+
+class RealtimeSleepModeTestCase : public TestCase
+{
+public:
+  RealtimeSleepModeTestCase (const std::string &sleepMode, Time slack);
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void Event (uint32_t rank);
+
+  std::string m_sleepMode;
+  Time m_slack;
+  uint32_t m_events;
+  uint32_t m_next;
+};
+
+RealtimeSleepModeTestCase::RealtimeSleepModeTestCase (const std::string &sleepMode, Time slack)
+  : TestCase ("Check that the events run in order, with their lateness accounted for, "
+              "in " + sleepMode + " sleep mode" + (slack.IsZero () ? "" : " with slack")),
+    m_sleepMode (sleepMode),
+    m_slack (slack),
+    m_events (200)
+{
+}
+
+void
+RealtimeSleepModeTestCase::Event (uint32_t rank)
+{
+  NS_TEST_EXPECT_MSG_EQ (rank, m_next, "Events out of order");
+  m_next++;
+  if (m_next == m_events)
+    {
+      Simulator::Stop ();
+    }
+}
+
+void
+RealtimeSleepModeTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  Config::SetDefault ("ns3::WallClockSynchronizer::SleepMode", StringValue (m_sleepMode));
+  Config::SetDefault ("ns3::WallClockSynchronizer::Slack", TimeValue (m_slack));
+}
+
+void
+RealtimeSleepModeTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::WallClockSynchronizer::SleepMode", StringValue ("Spin"));
+  Config::SetDefault ("ns3::WallClockSynchronizer::Slack", TimeValue (Time (0)));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+RealtimeSleepModeTestCase::DoRun (void)
+{
+  m_next = 0;
+#ifdef PR_GET_TIMERSLACK
+  int timerSlack = prctl (PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL);
+#endif
+  for (uint32_t i = 0; i < m_events; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (500 * (i + 1)), &RealtimeSleepModeTestCase::Event, this, i);
+    }
+  Simulator::Run ();
+
+  Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not a realtime simulator");
+  std::vector<uint64_t> lateness = impl->GetLatenessHistogram ();
+  impl = 0;
+  Simulator::Destroy ();
+#ifdef PR_GET_TIMERSLACK
+  NS_TEST_EXPECT_MSG_EQ (prctl (PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL), timerSlack,
+                         "Timer slack not restored");
+#endif
+
+  NS_TEST_EXPECT_MSG_EQ (m_next, m_events, "Events lost");
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < lateness.size (); ++i)
+    {
+      total += lateness[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, m_events, "Events not accounted for");
+  if (m_slack > MicroSeconds (500))
+    {
+      // Each event is within the slack of the previous one.
+      NS_TEST_EXPECT_MSG_GT (lateness[0], 0, "No event run ahead of time");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (lateness[0], 0, "Event run ahead of time");
+    }
+}
+
+class RealtimeSimulatorTestSuite : public TestSuite
+{
+public:
+  RealtimeSimulatorTestSuite ()
+    : TestSuite ("realtime-simulator")
+  {
+    AddTestCase (new RealtimeSleepModeTestCase ("Spin", Time (0)), TestCase::QUICK);
+    AddTestCase (new RealtimeSleepModeTestCase ("Absolute", Time (0)), TestCase::QUICK);
+    AddTestCase (new RealtimeSleepModeTestCase ("Absolute", MilliSeconds (1)), TestCase::QUICK);
+  }
+} g_realtimeSimulatorTestSuite;
@@ -23,6 +23,20 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/compact-heap-scheduler.h"
+#include "ns3/make-event.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-profiler.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <set>
 
 using namespace ns3;
 
@@ -459,6 +473,448 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check the order of the events removed from a scheduler, under a hold
+ * model with a bimodal distribution of delays (many short delays and a
+ * few long ones) and random cancellations, against a std::set.  The
+ * event population is large enough for the LadderScheduler to build
+ * several rungs and to turn its Bottom into a rung.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+private:
+  /** \returns a pseudo-random number */
+  uint32_t Rand (void);
+  /** \returns a pseudo-random delay */
+  uint64_t Delay (void);
+  /** The function of the events, never invoked. */
+  void Nop (void);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_seed;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Rand (void)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return m_seed >> 8;
+}
+
+void
+SchedulerOrderTestCase::Nop (void)
+{
+}
+
+uint64_t
+SchedulerOrderTestCase::Delay (void)
+{
+  uint32_t r = Rand ();
+  if (r % 100 == 0)
+    {
+      return 1000000 + r % 1000000;
+    }
+  if (r % 10 == 0)
+    {
+      // events at the current time
+      return 0;
+    }
+  return r % 200;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<std::pair<uint64_t, uint32_t> > reference;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+  // the events, by uid, as the HeapScheduler records its indexes in them
+  std::vector<EventImpl *> events;
+  Scheduler::Event ev;
+
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      ev.key.m_ts = Delay ();
+      ev.key.m_uid = uid++;
+      ev.key.m_context = ev.key.m_uid;
+      ev.impl = MakeEvent (&SchedulerOrderTestCase::Nop, this);
+      events.push_back (ev.impl);
+      scheduler->Insert (ev);
+      reference.insert (std::make_pair (ev.key.m_ts, ev.key.m_uid));
+    }
+  for (uint32_t i = 0; i < 50000; i++)
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_ts, reference.begin ()->first, "wrong timestamp");
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, reference.begin ()->second, "wrong uid");
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_context, next.key.m_uid, "wrong context");
+      reference.erase (reference.begin ());
+      now = next.key.m_ts;
+
+      uint32_t nInserts = (i % 1000 < 500) ? 2 : 1;
+      // bursts of events very close to the current time
+      uint32_t nBurst = (i % 1000 < 10) ? 20 : 0;
+      for (uint32_t j = 0; j < nInserts + nBurst && (i % 1000 < 990 || reference.size () < 10); j++)
+        {
+          ev.key.m_ts = now + (j < nBurst ? Rand () % 4 : Delay ());
+          ev.key.m_uid = uid++;
+          ev.key.m_context = ev.key.m_uid;
+          ev.impl = MakeEvent (&SchedulerOrderTestCase::Nop, this);
+          events.push_back (ev.impl);
+          scheduler->Insert (ev);
+          reference.insert (std::make_pair (ev.key.m_ts, ev.key.m_uid));
+        }
+      if (Rand () % 8 == 0)
+        {
+          std::set<std::pair<uint64_t, uint32_t> >::iterator it =
+            reference.lower_bound (std::make_pair (now + Delay (), 0));
+          if (it != reference.end ())
+            {
+              ev.key.m_ts = it->first;
+              ev.key.m_uid = it->second;
+              ev.impl = events[it->second];
+              scheduler->Remove (ev);
+              reference.erase (it);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), reference.empty (), "wrong size");
+      if (reference.empty ())
+        {
+          break;
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, reference.begin ()->second,
+                             "wrong next event");
+    }
+  while (!reference.empty ())
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, reference.begin ()->second, "wrong uid");
+      reference.erase (reference.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "scheduler not empty");
+  for (std::vector<EventImpl *>::iterator i = events.begin (); i != events.end (); ++i)
+    {
+      (*i)->Unref ();
+    }
+}
+
+/**
+ * Check that the memory of released events is reused for new events
+ * of the same size class, and that events of different sizes do not
+ * share memory.
+ */
+class EventImplPoolTestCase : public TestCase
+{
+public:
+  EventImplPoolTestCase ();
+  virtual void DoRun (void);
+  void Event0 (void);
+  void Event3 (uint64_t a, uint64_t b, uint64_t c);
+  int m_invoked;
+};
+
+EventImplPoolTestCase::EventImplPoolTestCase ()
+  : TestCase ("Check the reuse of the memory of events")
+{
+}
+
+void
+EventImplPoolTestCase::Event0 (void)
+{
+  m_invoked++;
+}
+
+void
+EventImplPoolTestCase::Event3 (uint64_t a, uint64_t b, uint64_t c)
+{
+  m_invoked += a + b + c;
+}
+
+void
+EventImplPoolTestCase::DoRun (void)
+{
+  m_invoked = 0;
+  EventImpl *small = MakeEvent (&EventImplPoolTestCase::Event0, this);
+  EventImpl *large = MakeEvent (&EventImplPoolTestCase::Event3, this, 1, 2, 3);
+  NS_TEST_ASSERT_MSG_NE (small, large, "events share memory");
+  small->Invoke ();
+  large->Invoke ();
+  NS_TEST_ASSERT_MSG_EQ (m_invoked, 7, "events not invoked");
+  small->Unref ();
+  large->Unref ();
+
+  EventImpl *event = MakeEvent (&EventImplPoolTestCase::Event3, this, 4, 5, 6);
+  NS_TEST_ASSERT_MSG_EQ (event, large, "memory of the event not reused");
+  event->Invoke ();
+  NS_TEST_ASSERT_MSG_EQ (m_invoked, 22, "event not invoked");
+  event->Unref ();
+  event = MakeEvent (&EventImplPoolTestCase::Event0, this);
+  NS_TEST_ASSERT_MSG_EQ (event, small, "memory of the event not reused");
+  event->Unref ();
+}
+
+/**
+ * Check that cancelled events are discarded as dead events, or removed
+ * from the event list at once when the EagerCancel attribute is set.
+ */
+class EagerCancelTestCase : public TestCase
+{
+public:
+  EagerCancelTestCase (ObjectFactory schedulerFactory, bool eager);
+  virtual void DoRun (void);
+  void Event (void);
+  ObjectFactory m_schedulerFactory;
+  bool m_eager;
+  uint32_t m_invoked;
+};
+
+EagerCancelTestCase::EagerCancelTestCase (ObjectFactory schedulerFactory, bool eager)
+  : TestCase (std::string (eager ? "Check eager" : "Check lazy") +
+              " cancellation with " + schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_eager (eager)
+{
+}
+
+void
+EagerCancelTestCase::Event (void)
+{
+  m_invoked++;
+}
+
+void
+EagerCancelTestCase::DoRun (void)
+{
+  m_invoked = 0;
+  Simulator::Destroy ();
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "not a DefaultSimulatorImpl");
+  impl->SetAttribute ("EagerCancel", BooleanValue (m_eager));
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (100 - i), &EagerCancelTestCase::Event, this));
+    }
+  for (uint32_t i = 0; i < 100; i += 5)
+    {
+      // cancel 3 events out of 5, in an order unrelated to their times
+      Simulator::Cancel (ids[i]);
+      ids[i + 3].Cancel ();
+      Simulator::Cancel (ids[i + 1]);
+      NS_TEST_ASSERT_MSG_EQ (ids[i + 1].IsExpired (), true, "cancelled event not expired");
+      NS_TEST_ASSERT_MSG_EQ (ids[i + 2].IsExpired (), false, "event expired");
+    }
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_invoked, 40, "wrong number of events invoked");
+  NS_TEST_ASSERT_MSG_EQ (impl->GetEventCount (), (m_eager ? 40 : 100), "wrong event count");
+  NS_TEST_ASSERT_MSG_EQ (impl->GetDeadEventCount (), (m_eager ? 0 : 60), "wrong dead event count");
+  NS_TEST_ASSERT_MSG_EQ_TOL (impl->GetDeadEventRatio (), (m_eager ? 0 : 0.6), 1e-9, "wrong dead event ratio");
+  Simulator::Destroy ();
+}
+
+static void
+ProfiledFunction (Ptr<EventImpl> event)
+{
+}
+
+/** A class whose virtual method is profiled. */
+class ProfiledBase
+{
+public:
+  virtual ~ProfiledBase ();
+  virtual void Tick (void);
+};
+
+ProfiledBase::~ProfiledBase ()
+{
+}
+
+void
+ProfiledBase::Tick (void)
+{
+}
+
+/** A class which overrides the profiled virtual method. */
+class ProfiledDerived : public ProfiledBase
+{
+public:
+  virtual void Tick (void);
+};
+
+void
+ProfiledDerived::Tick (void)
+{
+}
+
+/**
+ * Check that the Profile attribute accounts for the events by function
+ * and context, and prints the profile when the simulator is destroyed.
+ */
+class EventProfilerTestCase : public TestCase
+{
+public:
+  EventProfilerTestCase ();
+  virtual void DoRun (void);
+  void Short (void);
+  void Other (void);
+  void Long (uint32_t n);
+  uint32_t m_sum;
+};
+
+EventProfilerTestCase::EventProfilerTestCase ()
+  : TestCase ("Check the profile of the events")
+{
+}
+
+void
+EventProfilerTestCase::Short (void)
+{
+}
+
+void
+EventProfilerTestCase::Other (void)
+{
+}
+
+void
+EventProfilerTestCase::Long (uint32_t n)
+{
+  // Wait for the clock to move, so that these events take more time
+  // than the others.
+  uint64_t start = EventProfiler::GetTime ();
+  while (EventProfiler::GetTime () < start + 100000)
+    {
+      m_sum += n;
+    }
+}
+
+void
+EventProfilerTestCase::DoRun (void)
+{
+  m_sum = 0;
+  ProfiledDerived derived;
+
+  EventImpl *event = MakeEvent (&EventProfilerTestCase::Long, this, 1);
+  NS_TEST_ASSERT_MSG_EQ (EventProfiler::GetEventTypeName (typeid (*event)),
+                         "void (EventProfilerTestCase::*)(unsigned int)",
+                         "wrong event type name");
+  NS_TEST_ASSERT_MSG_EQ (EventProfiler::GetEventName (typeid (*event), event->GetFunction ()),
+                         "EventProfilerTestCase::Long(unsigned int)",
+                         "wrong event name");
+  EventImpl *function = MakeEvent (&ProfiledFunction, Ptr<EventImpl> (event));
+  NS_TEST_ASSERT_MSG_EQ (EventProfiler::GetEventTypeName (typeid (*function)),
+                         "void (*)(ns3::Ptr<ns3::EventImpl>)",
+                         "wrong event type name");
+  // A static function has no dynamic symbol
+  std::string name = EventProfiler::GetEventName (typeid (*function), function->GetFunction ());
+  std::string prefix = "void (*)(ns3::Ptr<ns3::EventImpl>) at ";
+  NS_TEST_ASSERT_MSG_EQ (name.substr (0, prefix.size ()), prefix, "wrong event name");
+  NS_TEST_ASSERT_MSG_GT (name.size (), prefix.size (), "no function address");
+  function->Unref ();
+  event->Unref ();
+  EventImpl *method = MakeEvent (&ProfiledBase::Tick, static_cast<ProfiledBase *> (&derived));
+  NS_TEST_ASSERT_MSG_EQ (EventProfiler::GetEventName (typeid (*method), method->GetFunction ()),
+                         "ProfiledDerived::Tick()",
+                         "wrong virtual method name");
+  method->Unref ();
+
+  std::string file = CreateTempDirFilename ("event-profile.txt");
+  Simulator::Destroy ();
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "not a DefaultSimulatorImpl");
+  impl->SetAttribute ("Profile", BooleanValue (true));
+  impl->SetAttribute ("ProfileFile", StringValue (file));
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventProfilerTestCase::Short, this);
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::ScheduleWithContext (7, MicroSeconds (i), &EventProfilerTestCase::Long, this, i);
+    }
+  // Same signature as Short, on another context
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::ScheduleWithContext (7, MicroSeconds (i), &EventProfilerTestCase::Other, this);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::ScheduleWithContext (3, MicroSeconds (i), &ProfiledBase::Tick,
+                                      static_cast<ProfiledBase *> (&derived));
+    }
+  EventId cancelled = Simulator::Schedule (MicroSeconds (1), &EventProfilerTestCase::Long, this, 0);
+  cancelled.Cancel ();
+  Simulator::Run ();
+
+  const EventProfiler *profiler = impl->GetProfiler ();
+  NS_TEST_ASSERT_MSG_NE (profiler, 0, "no profile");
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetEventCount (), 135, "dead events are not profiled");
+  std::vector<EventProfiler::Entry> types = profiler->GetEventTypes ();
+  NS_TEST_ASSERT_MSG_EQ (types.size (), 4, "wrong number of event types");
+  NS_TEST_EXPECT_MSG_EQ (types[0].name, "EventProfilerTestCase::Long(unsigned int)", "wrong costliest event type");
+  NS_TEST_EXPECT_MSG_EQ (types[0].count, 10, "wrong number of events");
+  NS_TEST_EXPECT_MSG_GT (types[0].time, 1000000 - 1, "wrong time of the events");
+  std::map<std::string, uint64_t> typeCounts;
+  for (uint32_t i = 0; i < types.size (); i++)
+    {
+      typeCounts[types[i].name] = types[i].count;
+    }
+  NS_TEST_EXPECT_MSG_EQ (typeCounts["EventProfilerTestCase::Short()"], 100, "wrong number of events");
+  NS_TEST_EXPECT_MSG_EQ (typeCounts["EventProfilerTestCase::Other()"], 20, "wrong number of events");
+  NS_TEST_EXPECT_MSG_EQ (typeCounts["ProfiledDerived::Tick()"], 5, "wrong number of events");
+  std::vector<EventProfiler::Entry> contexts = profiler->GetContexts ();
+  NS_TEST_ASSERT_MSG_EQ (contexts.size (), 3, "wrong number of contexts");
+  NS_TEST_EXPECT_MSG_EQ (contexts[0].name, "node 7", "wrong costliest context");
+  NS_TEST_EXPECT_MSG_EQ (contexts[0].count, 30, "wrong number of events");
+
+  Simulator::Destroy ();
+
+  // The first line gives the number of events, and each line of the
+  // tables is "time percent% count ns/event  name"
+  std::ifstream is (file.c_str ());
+  std::string line;
+  std::getline (is, line);
+  prefix = "Event profile: 135 events in ";
+  NS_TEST_EXPECT_MSG_EQ (line.substr (0, std::min (line.size (), prefix.size ())), prefix, "no profile printed");
+  std::map<std::string, uint64_t> counts;
+  while (std::getline (is, line))
+    {
+      std::istringstream fields (line);
+      double time;
+      std::string percent;
+      uint64_t count;
+      double perEvent;
+      if (fields >> time >> percent >> count >> perEvent)
+        {
+          std::getline (fields >> std::ws, name);
+          counts[name] = count;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (counts.size (), 7, "wrong number of lines");
+  NS_TEST_EXPECT_MSG_EQ (counts["EventProfilerTestCase::Long(unsigned int)"], 10, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["EventProfilerTestCase::Short()"], 100, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["EventProfilerTestCase::Other()"], 20, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["ProfiledDerived::Tick()"], 5, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["node 7"], 30, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["node 3"], 5, "wrong line");
+  NS_TEST_EXPECT_MSG_EQ (counts["no context"], 100, "wrong line");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +931,39 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CompactHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CompactHeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.Set ("Arity", UintegerValue (2));
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.Set ("Arity", UintegerValue (8));
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory = ObjectFactory ();
+
+    AddTestCase (new EventImplPoolTestCase (), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new EagerCancelTestCase (factory, false), TestCase::QUICK);
+    AddTestCase (new EagerCancelTestCase (factory, true), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new EagerCancelTestCase (factory, true), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new EagerCancelTestCase (factory, true), TestCase::QUICK);
+    factory.SetTypeId (CompactHeapScheduler::GetTypeId ());
+    AddTestCase (new EagerCancelTestCase (factory, true), TestCase::QUICK);
+
+    AddTestCase (new EventProfilerTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -26,10 +26,12 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/mpsc-queue.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +227,210 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class MpscQueueTestCase : public TestCase
+{
+public:
+  MpscQueueTestCase (unsigned int threads, unsigned int items);
+  static void ProducerThread (std::pair<MpscQueueTestCase *, unsigned int> context);
+
+private:
+  virtual void DoRun (void);
+
+  /** An item: the producer thread and the rank of the item in its thread. */
+  typedef std::pair<unsigned int, unsigned int> Item;
+  MpscQueue<Item> m_queue;
+  unsigned int m_threads;
+  unsigned int m_items;
+};
+
+MpscQueueTestCase::MpscQueueTestCase (unsigned int threads, unsigned int items)
+  : TestCase ("Check that the lock-free queue keeps the items of each of many producer threads in order"),
+    m_threads (threads),
+    m_items (items)
+{
+}
+
+void
+MpscQueueTestCase::ProducerThread (std::pair<MpscQueueTestCase *, unsigned int> context)
+{
+  MpscQueueTestCase *me = context.first;
+  for (unsigned int i = 0; i < me->m_items; ++i)
+    {
+      me->m_queue.Push (Item (context.second, i));
+    }
+}
+
+void
+MpscQueueTestCase::DoRun (void)
+{
+  std::list<Ptr<SystemThread> > threads;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+                                                 &MpscQueueTestCase::ProducerThread,
+                                                 std::pair<MpscQueueTestCase *, unsigned int> (this, i))));
+    }
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+
+  // Pop while the producers push.
+  std::vector<unsigned int> next (m_threads, 0);
+  unsigned int popped = 0;
+  bool ordered = true;
+  Item item;
+  while (popped < m_threads * m_items)
+    {
+      if (!m_queue.Pop (item))
+        {
+          struct timespec ts;
+          ts.tv_sec = 0;
+          ts.tv_nsec = 500;
+          nanosleep (&ts, NULL);
+          continue;
+        }
+      if (item.first >= m_threads || item.second != next[item.first])
+        {
+          ordered = false;
+          break;
+        }
+      next[item.first]++;
+      popped++;
+    }
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (ordered, true, "Items of a producer out of order");
+  NS_TEST_EXPECT_MSG_EQ (popped, m_threads * m_items, "Items lost");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "Items duplicated");
+}
+
+class ThreadedScheduleWithContextTestCase : public TestCase
+{
+public:
+  ThreadedScheduleWithContextTestCase (const std::string &simulatorType, unsigned int threads, unsigned int events);
+  static void SchedulingThread (std::pair<ThreadedScheduleWithContextTestCase *, unsigned int> context);
+  void Event (unsigned int threadno, unsigned int rank);
+  void Poll (void);
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_simulatorType;
+  unsigned int m_threads;
+  unsigned int m_events;
+  std::vector<unsigned int> m_received;
+  unsigned int m_total;
+  unsigned int m_finished;
+  time_t m_deadline;
+  std::string m_error;
+  std::list<Ptr<SystemThread> > m_threadlist;
+};
+
+ThreadedScheduleWithContextTestCase::ThreadedScheduleWithContextTestCase (const std::string &simulatorType,
+                                                                          unsigned int threads,
+                                                                          unsigned int events)
+  : TestCase ("Check that events scheduled from many threads all run, in order, in " + simulatorType),
+    m_simulatorType (simulatorType),
+    m_threads (threads),
+    m_events (events)
+{
+}
+
+void
+ThreadedScheduleWithContextTestCase::SchedulingThread (std::pair<ThreadedScheduleWithContextTestCase *, unsigned int> context)
+{
+  ThreadedScheduleWithContextTestCase *me = context.first;
+  unsigned int threadno = context.second;
+  for (unsigned int i = 0; i < me->m_events; ++i)
+    {
+      Simulator::ScheduleWithContext (threadno, Seconds (0),
+                                      &ThreadedScheduleWithContextTestCase::Event, me, threadno, i);
+    }
+  __atomic_add_fetch (&me->m_finished, 1, __ATOMIC_RELEASE);
+}
+
+void
+ThreadedScheduleWithContextTestCase::Event (unsigned int threadno, unsigned int rank)
+{
+  if (Simulator::GetContext () != threadno)
+    {
+      m_error = "Bad context";
+    }
+  if (m_received[threadno] != rank)
+    {
+      m_error = "Events of a thread out of order";
+    }
+  m_received[threadno]++;
+  m_total++;
+}
+
+void
+ThreadedScheduleWithContextTestCase::Poll (void)
+{
+  if (__atomic_load_n (&m_finished, __ATOMIC_ACQUIRE) == m_threads
+      && m_total == m_threads * m_events)
+    {
+      Simulator::Stop ();
+      return;
+    }
+  if (time (0) > m_deadline)
+    {
+      m_error = "Events lost";
+      Simulator::Stop ();
+      return;
+    }
+  Simulator::Schedule (MicroSeconds (100), &ThreadedScheduleWithContextTestCase::Poll, this);
+}
+
+void
+ThreadedScheduleWithContextTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
+  m_error = "";
+  m_received.assign (m_threads, 0);
+  m_total = 0;
+  m_finished = 0;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      m_threadlist.push_back (Create<SystemThread> (MakeBoundCallback (
+                                                      &ThreadedScheduleWithContextTestCase::SchedulingThread,
+                                                      std::pair<ThreadedScheduleWithContextTestCase *, unsigned int> (this, i))));
+    }
+}
+
+void
+ThreadedScheduleWithContextTestCase::DoTeardown (void)
+{
+  m_threadlist.clear ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+ThreadedScheduleWithContextTestCase::DoRun (void)
+{
+  m_deadline = time (0) + 60;
+  Simulator::Schedule (MicroSeconds (100), &ThreadedScheduleWithContextTestCase::Poll, this);
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+  Simulator::Run ();
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_error.empty (), true, m_error.c_str ());
+  NS_TEST_EXPECT_MSG_EQ (m_total, m_threads * m_events, "Events lost");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -261,6 +467,8 @@ public:
                 AddTestCase (new ThreadedSimulatorEventsTestCase (factory, simulatorTypes[i], threadcounts[j]), TestCase::QUICK);
               }
           }
+        AddTestCase (new ThreadedScheduleWithContextTestCase (simulatorTypes[i], 16, 5000), TestCase::QUICK);
       }
+    AddTestCase (new MpscQueueTestCase (16, 100000), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -24,6 +24,8 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <limits>
+#include <cmath>
 
 #include "ns3/nstime.h"
 #include "ns3/int64x64.h"
@@ -230,6 +232,91 @@ TimeInputOutputTestCase::DoRun (void)
   std::cout << std::endl;
 }
     
+class TimeConversionTestCase : public TestCase
+{
+public:
+  TimeConversionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeConversionTestCase::TimeConversionTestCase ()
+  : TestCase ("Check that the conversions between Time and numbers match int64x64_t")
+{
+}
+
+void
+TimeConversionTestCase::DoRun (void)
+{
+  const double seconds[] = {
+    0, 1, -1, 0.3, -0.3, 0.1, 1e-4, -1e-4, 1e-6, 3e-9, 1e-9, 1.5e-9, 1e-12,
+    1e-20, 1e-30, 12e-6, 1.2e-5, 8 * 1500 / 1e9, 8 * 40 / 10e6, 0.000123456789,
+    123.456789, -123.456789, 9.2e9, 2.5e20, 1.0 / 3, -2.0 / 3
+  };
+  for (uint32_t i = 0; i < sizeof (seconds) / sizeof (seconds[0]); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Seconds (seconds[i]).GetTimeStep (),
+                             Time::From (int64x64_t (seconds[i]), Time::S).GetTimeStep (),
+                             "Seconds (" << seconds[i] << ")");
+      NS_TEST_EXPECT_MSG_EQ (Time::FromDouble (seconds[i], Time::MS).GetTimeStep (),
+                             Time::From (int64x64_t (seconds[i]), Time::MS).GetTimeStep (),
+                             "FromDouble (" << seconds[i] << ", MS)");
+    }
+
+  const int64_t steps[] = {
+    0, 1, -1, 999, -999, 1000, -1000, 1001, 123456789, -123456789,
+    999999999, 1000000000, 1000000001, 86400000000000LL, -86400000000000LL,
+    std::numeric_limits<int64_t>::max (), std::numeric_limits<int64_t>::min (),
+    std::numeric_limits<int64_t>::max () - 1, std::numeric_limits<int64_t>::min () + 1
+  };
+  for (uint32_t i = 0; i < sizeof (steps) / sizeof (steps[0]); i++)
+    {
+      Time t = TimeStep (steps[i]);
+      NS_TEST_EXPECT_MSG_EQ (t.GetMicroSeconds (), steps[i] / 1000, "GetMicroSeconds of " << steps[i]);
+      NS_TEST_EXPECT_MSG_EQ (t.GetMilliSeconds (), steps[i] / 1000000, "GetMilliSeconds of " << steps[i]);
+      NS_TEST_EXPECT_MSG_EQ (t.ToInteger (Time::S), steps[i] / 1000000000, "ToInteger (S) of " << steps[i]);
+      NS_TEST_EXPECT_MSG_EQ (t.ToInteger (Time::H), steps[i] / 3600000000000LL, "ToInteger (H) of " << steps[i]);
+      // int64x64_t holds the fraction to 2^-64
+      NS_TEST_EXPECT_MSG_EQ_TOL (t.GetSeconds (), t.To (Time::S).GetDouble (),
+                                 1e-19 + std::fabs (steps[i] / 1e9) * 1e-15, "GetSeconds of " << steps[i]);
+    }
+
+  // The decimal literals are the correctly rounded values of the
+  // nanoseconds in seconds.  GetSeconds is a single division, thus
+  // correctly rounded too, up to 2^53 nanoseconds.
+  const struct
+  {
+    int64_t ns;
+    double s;
+  } exact[] = {
+    { 0, 0.0 }, { 1, 1e-9 }, { -1, -1e-9 }, { 3, 3e-9 }, { 999, 999e-9 },
+    { 1001, 1.001e-6 }, { 123456789, 0.123456789 }, { -123456789, -0.123456789 },
+    { 999999999, 0.999999999 }, { 1000000001, 1.000000001 },
+    { 86400000000000LL, 86400.0 }, { 9007199254740991LL, 9007199.254740991 },
+    { 9007199254740992LL, 9007199.254740992 }, { -9007199254740992LL, -9007199.254740992 }
+  };
+  for (uint32_t i = 0; i < sizeof (exact) / sizeof (exact[0]); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (TimeStep (exact[i].ns).GetSeconds (), exact[i].s, "GetSeconds of " << exact[i].ns);
+    }
+  // Beyond 2^53 nanoseconds, the conversion rounds more than once
+  const struct
+  {
+    int64_t ns;
+    double s;
+  } large[] = {
+    { 9007199254740993LL, 9007199.254740993 }, { -9007199254740993LL, -9007199.254740993 },
+    { 1234567890123456789LL, 1234567890.123456789 },
+    { std::numeric_limits<int64_t>::max (), 9223372036.854775807 },
+    { std::numeric_limits<int64_t>::min (), -9223372036.854775808 }
+  };
+  for (uint32_t i = 0; i < sizeof (large) / sizeof (large[0]); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (TimeStep (large[i].ns).GetSeconds (), large[i].s,
+                                 std::fabs (large[i].s) * 4e-16, "GetSeconds of " << large[i].ns);
+    }
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -238,6 +325,7 @@ public:
   {
     AddTestCase (new TimeWithSignTestCase (), TestCase::QUICK);
     AddTestCase (new TimeInputOutputTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeConversionTestCase (), TestCase::QUICK);
     // This should be last, since it changes the resolution
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
   }
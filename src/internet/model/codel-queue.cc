@@ -280,7 +280,13 @@ CoDelQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () + 1 > m_maxPackets))
+  if (m_packets.GetCapacity () == 0 && m_mode == QUEUE_MODE_PACKETS)
+    {
+      // First packet: allocate the storage for a full queue at once
+      m_packets.Reserve (m_maxPackets);
+    }
+
+  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.GetSize () + 1 > m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
@@ -301,9 +307,9 @@ CoDelQueue::DoEnqueue (Ptr<Packet> p)
   p->AddPacketTag (tag);
 
   m_bytesInQueue += p->GetSize ();
-  m_packets.push (p);
+  m_packets.Push (p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return true;
@@ -356,7 +362,7 @@ CoDelQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       // Leave dropping state when queue is empty
       m_dropping = false;
@@ -365,12 +371,12 @@ CoDelQueue::DoDequeue (void)
       return 0;
     }
   uint32_t now = CoDelGetTime ();
-  Ptr<Packet> p = m_packets.front ();
-  m_packets.pop ();
+  Ptr<Packet> p = m_packets.Front ();
+  m_packets.Pop ();
   m_bytesInQueue -= p->GetSize ();
 
   NS_LOG_LOGIC ("Popped " << p);
-  NS_LOG_LOGIC ("Number packets remaining " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets remaining " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes remaining " << m_bytesInQueue);
 
   // Determine if p should be dropped
@@ -409,19 +415,19 @@ CoDelQueue::DoDequeue (void)
               ++m_dropCount;
               ++m_count;
               NewtonStep ();
-              if (m_packets.empty ())
+              if (m_packets.IsEmpty ())
                 {
                   m_dropping = false;
                   NS_LOG_LOGIC ("Queue empty");
                   ++m_states;
                   return 0;
                 }
-              p = m_packets.front ();
-              m_packets.pop ();
+              p = m_packets.Front ();
+              m_packets.Pop ();
               m_bytesInQueue -= p->GetSize ();
 
               NS_LOG_LOGIC ("Popped " << p);
-              NS_LOG_LOGIC ("Number packets remaining " << m_packets.size ());
+              NS_LOG_LOGIC ("Number packets remaining " << m_packets.GetSize ());
               NS_LOG_LOGIC ("Number bytes remaining " << m_bytesInQueue);
 
               if (!OkToDrop (p, now))
@@ -457,7 +463,7 @@ CoDelQueue::DoDequeue (void)
           m_nBytes -= p->GetSize ();
           m_nPackets--;
 
-          if (m_packets.empty ())
+          if (m_packets.IsEmpty ())
             {
               m_dropping = false;
               okToDrop = false;
@@ -466,12 +472,12 @@ CoDelQueue::DoDequeue (void)
             }
           else
             {
-              p = m_packets.front ();
-              m_packets.pop ();
+              p = m_packets.Front ();
+              m_packets.Pop ();
               m_bytesInQueue -= p->GetSize ();
 
               NS_LOG_LOGIC ("Popped " << p);
-              NS_LOG_LOGIC ("Number packets remaining " << m_packets.size ());
+              NS_LOG_LOGIC ("Number packets remaining " << m_packets.GetSize ());
               NS_LOG_LOGIC ("Number bytes remaining " << m_bytesInQueue);
 
               okToDrop = OkToDrop (p, now);
@@ -514,7 +520,7 @@ CoDelQueue::GetQueueSize (void)
     }
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
-      return m_packets.size ();
+      return m_packets.GetSize ();
     }
   else
     {
@@ -557,15 +563,15 @@ CoDelQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
+  Ptr<Packet> p = m_packets.Front ();
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
@@ -28,9 +28,9 @@
 #ifndef CODEL_H
 #define CODEL_H
 
-#include <queue>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
+#include "ns3/ring-buffer.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
@@ -223,7 +223,7 @@ private:
    */
   uint32_t Time2CoDel (Time t);
 
-  std::queue<Ptr<Packet> > m_packets;     //!< The packet queue
+  RingBuffer<Ptr<Packet> > m_packets;     //!< The packet queue
   uint32_t m_maxPackets;                  //!< Max # of packets accepted by the queue
   uint32_t m_maxBytes;                    //!< Max # of bytes accepted by the queue
   TracedValue<uint32_t> m_bytesInQueue;   //!< The total number of bytes in queue
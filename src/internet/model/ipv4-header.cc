@@ -379,17 +379,36 @@ Ipv4Header::GetSerializedSize (void) const
 	return m_headerSize;
 }
 
-void
-Ipv4Header::Serialize (Buffer::Iterator start) const
+/**
+ * \param buffer the bytes to sum
+ * \param size the number of bytes, which must be even
+ * \returns the checksum of the bytes, as Buffer::Iterator::CalculateIpChecksum
+ *          computes it
+ */
+static uint16_t
+CalculateIpChecksum (const uint8_t *buffer, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
+  /* see RFC 1071 to understand this code. */
+  uint32_t sum = 0;
+  for (uint32_t j = 0; j < size; j += 2)
+    {
+      sum += buffer[j] | (buffer[j + 1] << 8);
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
 
-  uint8_t verIhl = (4 << 4) | (5);
-  i.WriteU8 (verIhl);
-  i.WriteU8 (m_tos);
-  i.WriteHtonU16 (m_payloadSize + 5*4);
-  i.WriteHtonU16 (m_identification);
+void
+Ipv4Header::SerializeTo (uint8_t *buffer) const
+{
+  NS_LOG_FUNCTION (this << &buffer);
+  buffer[0] = (4 << 4) | (5);
+  buffer[1] = m_tos;
+  WriteHtonU16 (buffer + 2, m_payloadSize + 5*4);
+  WriteHtonU16 (buffer + 4, m_identification);
   uint32_t fragmentOffset = m_fragmentOffset / 8;
   uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
   if (m_flags & DONT_FRAGMENT) 
@@ -400,25 +419,68 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
     {
       flagsFrag |= (1<<5);
     }
-  i.WriteU8 (flagsFrag);
-  uint8_t frag = fragmentOffset & 0xff;
-  i.WriteU8 (frag);
-  i.WriteU8 (m_ttl);
-  i.WriteU8 (m_protocol);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU32 (m_source.Get ());
-  i.WriteHtonU32 (m_destination.Get ());
+  buffer[6] = flagsFrag;
+  buffer[7] = fragmentOffset & 0xff;
+  buffer[8] = m_ttl;
+  buffer[9] = m_protocol;
+  buffer[10] = 0;
+  buffer[11] = 0;
+  WriteHtonU32 (buffer + 12, m_source.Get ());
+  WriteHtonU32 (buffer + 16, m_destination.Get ());
 
   if (m_calcChecksum) 
     {
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (20);
+      uint16_t checksum = CalculateIpChecksum (buffer, 20);
       NS_LOG_LOGIC ("checksum=" <<checksum);
-      i = start;
-      i.Next (10);
-      i.WriteU16 (checksum);
+      // in the byte order of Buffer::Iterator::WriteU16
+      buffer[10] = checksum & 0xff;
+      buffer[11] = checksum >> 8;
+    }
+}
+
+uint32_t
+Ipv4Header::DeserializeFrom (const uint8_t *buffer)
+{
+  NS_LOG_FUNCTION (this << &buffer);
+  if (buffer[0] != ((4 << 4) | 5))
+    {
+      // Deserialize skips the options
+      return 0;
     }
+  m_tos = buffer[1];
+  m_payloadSize = ReadNtohU16 (buffer + 2) - 5*4;
+  m_identification = ReadNtohU16 (buffer + 4);
+  uint8_t flags = buffer[6];
+  m_flags = 0;
+  if (flags & (1<<6)) 
+    {
+      m_flags |= DONT_FRAGMENT;
+    }
+  if (flags & (1<<5)) 
+    {
+      m_flags |= MORE_FRAGMENTS;
+    }
+  m_fragmentOffset = flags & 0x1f;
+  m_fragmentOffset <<= 8;
+  m_fragmentOffset |= buffer[7];
+  m_fragmentOffset <<= 3;
+  m_ttl = buffer[8];
+  m_protocol = buffer[9];
+  m_checksum = buffer[10] | (buffer[11] << 8);
+  m_source.Set (ReadNtohU32 (buffer + 12));
+  m_destination.Set (ReadNtohU32 (buffer + 16));
+  m_headerSize = 5*4;
+
+  if (m_calcChecksum) 
+    {
+      uint16_t checksum = CalculateIpChecksum (buffer, 20);
+      NS_LOG_LOGIC ("checksum=" <<checksum);
+
+      m_goodChecksum = (checksum == 0);
+    }
+  return 5*4;
 }
+
 uint32_t
 Ipv4Header::Deserialize (Buffer::Iterator start)
 {
@@ -21,14 +21,17 @@
 #ifndef IPV4_HEADER_H
 #define IPV4_HEADER_H
 
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
 /**
  * \brief Packet header for IPv4
+ *
+ * The header is serialized without options, in 20 bytes.  A header
+ * with options is deserialized by Deserialize, which skips them.
  */
-class Ipv4Header : public Header 
+class Ipv4Header : public FixedSizeHeader<Ipv4Header, 20>
 {
 public:
   /**
@@ -230,8 +233,16 @@ public:
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
   virtual uint32_t GetSerializedSize (void) const;
-  virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
+  /**
+   * \param buffer where to write the 20 bytes of the header
+   */
+  void SerializeTo (uint8_t *buffer) const;
+  /**
+   * \param buffer where to read the 20 bytes of the header
+   * \return the number of bytes read, or 0 if the header has options
+   */
+  uint32_t DeserializeFrom (const uint8_t *buffer);
 private:
 
   /// flags related to IP fragmentation
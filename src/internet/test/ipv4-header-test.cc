@@ -256,11 +256,80 @@ Ipv4HeaderTest::DoRun (void)
   Simulator::Destroy ();
 }
 //-----------------------------------------------------------------------------
+class Ipv4HeaderFixedSizeTest : public TestCase
+{
+public:
+  virtual void DoRun (void);
+  Ipv4HeaderFixedSizeTest ();
+};
+
+Ipv4HeaderFixedSizeTest::Ipv4HeaderFixedSizeTest ()
+  : TestCase ("Check that IPv4 headers are serialized the same way with and without an Iterator")
+{
+}
+
+void
+Ipv4HeaderFixedSizeTest::DoRun (void)
+{
+  Ipv4Header header;
+  header.EnableChecksum ();
+  header.SetSource (Ipv4Address ("10.1.2.3"));
+  header.SetDestination (Ipv4Address ("192.168.200.1"));
+  header.SetProtocol (17);
+  header.SetPayloadSize (1480);
+  header.SetTtl (63);
+  header.SetIdentification (0xabcd);
+  header.SetMoreFragments ();
+  header.SetFragmentOffset (2960);
+  header.SetDscp (Ipv4Header::DSCP_AF21);
+  header.SetEcn (Ipv4Header::ECN_CE);
+
+  Ptr<Packet> direct = Create<Packet> (1480);
+  direct->AddHeader (header);
+  Ptr<Packet> iterator = Create<Packet> (1480);
+  const Header &base = header;
+  iterator->AddHeader (base);
+  uint8_t directBytes[20];
+  uint8_t iteratorBytes[20];
+  direct->CopyData (directBytes, 20);
+  iterator->CopyData (iteratorBytes, 20);
+  bool same = memcmp (directBytes, iteratorBytes, 20) == 0;
+  NS_TEST_EXPECT_MSG_EQ (same, true, "The serialized headers differ");
+
+  Ipv4Header received;
+  received.EnableChecksum ();
+  NS_TEST_EXPECT_MSG_EQ (direct->RemoveHeader (received), 20, "Wrong header size");
+  NS_TEST_EXPECT_MSG_EQ (received.IsChecksumOk (), true, "Wrong checksum");
+  NS_TEST_EXPECT_MSG_EQ (received.GetSource (), header.GetSource (), "Wrong source");
+  NS_TEST_EXPECT_MSG_EQ (received.GetDestination (), header.GetDestination (), "Wrong destination");
+  NS_TEST_EXPECT_MSG_EQ (received.GetPayloadSize (), 1480, "Wrong payload size");
+  NS_TEST_EXPECT_MSG_EQ (received.GetIdentification (), 0xabcd, "Wrong identification");
+  NS_TEST_EXPECT_MSG_EQ (received.IsLastFragment (), false, "Wrong flags");
+  NS_TEST_EXPECT_MSG_EQ (received.GetFragmentOffset (), 2960, "Wrong fragment offset");
+  NS_TEST_EXPECT_MSG_EQ (received.GetDscp (), Ipv4Header::DSCP_AF21, "Wrong DSCP");
+  NS_TEST_EXPECT_MSG_EQ (received.GetEcn (), Ipv4Header::ECN_CE, "Wrong ECN");
+
+  // A corrupted header
+  iteratorBytes[8]++;
+  Ptr<Packet> corrupted = Create<Packet> (iteratorBytes, 20);
+  corrupted->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (received.IsChecksumOk (), false, "Wrong checksum accepted");
+
+  // A header with 4 bytes of options is deserialized by the Iterator
+  uint8_t options[24] = { 0x46, 0, 0, 28, 0, 0, 0, 0, 64, 17, 0, 0,
+                          10, 0, 0, 1, 10, 0, 0, 2, 1, 1, 1, 0 };
+  Ptr<Packet> withOptions = Create<Packet> (options, 24);
+  NS_TEST_EXPECT_MSG_EQ (withOptions->RemoveHeader (received), 24, "Wrong header size");
+  NS_TEST_EXPECT_MSG_EQ (withOptions->GetSize (), 0, "Options left in the packet");
+  NS_TEST_EXPECT_MSG_EQ (received.GetDestination (), Ipv4Address ("10.0.0.2"), "Wrong destination");
+}
+//-----------------------------------------------------------------------------
 class Ipv4HeaderTestSuite : public TestSuite
 {
 public:
   Ipv4HeaderTestSuite () : TestSuite ("ipv4-header", UNIT)
   {
     AddTestCase (new Ipv4HeaderTest, TestCase::QUICK);
+    AddTestCase (new Ipv4HeaderFixedSizeTest, TestCase::QUICK);
   }
 } g_ipv4HeaderTestSuite;
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measure the rate of the packets, and of the MPI messages, which cross
+ * the ranks of a distributed simulation.
+ *
+ * Each of the nFlows nodes of rank 0 is linked by a point-to-point link
+ * to a node of rank 1, and both nodes of each link send a packet to
+ * each other at every interval, without any protocol stack.  Each rank
+ * prints the number of packets it sent and received, the number of MPI
+ * messages it sent, and their rates in wall clock time.
+ *
+ *   mpirun -np 2 ./distributed-packet-rate [--nullmsg] [--nFlows=16]
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/point-to-point-helper.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#include "ns3/granted-time-window-mpi-interface.h"
+#endif
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DistributedPacketRate");
+
+#ifdef NS3_MPI
+
+static uint32_t g_sent = 0;
+static uint32_t g_received = 0;
+
+static bool
+Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  g_received++;
+  return true;
+}
+
+static void
+Send (Ptr<NetDevice> device, uint32_t size, Time interval)
+{
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x0800);
+  g_sent++;
+  Simulator::Schedule (interval, &Send, device, size, interval);
+}
+
+#endif
+
+int
+main (int argc, char *argv[])
+{
+#ifdef NS3_MPI
+
+  bool nullmsg = false;
+  uint32_t nFlows = 16;
+  uint32_t size = 100;
+  Time interval = MicroSeconds (10);
+  Time duration = MilliSeconds (100);
+
+  CommandLine cmd;
+  cmd.AddValue ("nullmsg", "Enable the use of null-message synchronization", nullmsg);
+  cmd.AddValue ("nFlows", "Number of links between the two ranks", nFlows);
+  cmd.AddValue ("size", "Packet size, in bytes", size);
+  cmd.AddValue ("interval", "Interval between the packets of a node", interval);
+  cmd.AddValue ("duration", "Simulated time", duration);
+  cmd.Parse (argc, argv);
+
+  if (nullmsg)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::NullMessageSimulatorImpl"));
+    }
+  else
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::DistributedSimulatorImpl"));
+    }
+
+  MpiInterface::Enable (&argc, &argv);
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  if (MpiInterface::GetSize () != 2)
+    {
+      std::cout << "This simulation requires 2 and only 2 logical processors." << std::endl;
+      return 1;
+    }
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  for (uint32_t i = 0; i < nFlows; ++i)
+    {
+      NodeContainer nodes;
+      nodes.Add (CreateObject<Node> (0));
+      nodes.Add (CreateObject<Node> (1));
+      NetDeviceContainer devices = link.Install (nodes);
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          if (nodes.Get (j)->GetSystemId () != systemId)
+            {
+              continue;
+            }
+          devices.Get (j)->SetReceiveCallback (MakeCallback (&Receive));
+          Simulator::Schedule (NanoSeconds (i), &Send, devices.Get (j), size, interval);
+        }
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Stop (duration);
+  Simulator::Run ();
+  double seconds = clock.End () / 1000.0;
+
+  std::cout << "rank " << systemId << ": sent " << g_sent << " packets, received "
+            << g_received << " packets, in " << seconds << " s: "
+            << g_sent / seconds << " packets/s" << std::endl;
+  if (!nullmsg)
+    {
+      uint32_t messages = GrantedTimeWindowMpiInterface::GetTxMessageCount ();
+      std::cout << "rank " << systemId << ": sent " << messages << " MPI messages: "
+                << messages / seconds << " messages/s, "
+                << GrantedTimeWindowMpiInterface::GetTxCount () / static_cast<double> (messages)
+                << " packets/message" << std::endl;
+    }
+
+  Simulator::Destroy ();
+  MpiInterface::Disable ();
+  return 0;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
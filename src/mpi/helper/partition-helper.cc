@@ -0,0 +1,409 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "partition-helper.h"
+
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/net-device.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PartitionHelper");
+
+/** Threshold which contracts no link of non-zero delay. */
+static const int64_t NO_THRESHOLD = 0x7fffffffffffffffLL;
+
+PartitionHelper::PartitionHelper ()
+  : m_maxImbalance (0.1),
+    m_lookahead (Time::Max ()),
+    m_cutSize (0),
+    m_imbalance (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PartitionHelper::SetMaxImbalance (double imbalance)
+{
+  NS_LOG_FUNCTION (this << imbalance);
+  NS_ASSERT (imbalance >= 0);
+  m_maxImbalance = imbalance;
+}
+
+Time
+PartitionHelper::GetLookahead (void) const
+{
+  return m_lookahead;
+}
+
+uint32_t
+PartitionHelper::GetCutSize (void) const
+{
+  return m_cutSize;
+}
+
+double
+PartitionHelper::GetImbalance (void) const
+{
+  return m_imbalance;
+}
+
+void
+PartitionHelper::BuildGraph (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_load.clear ();
+  m_links.clear ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      m_load.push_back (1 + (*i)->GetNDevices ());
+    }
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      Ptr<Channel> channel = *i;
+      if (channel->GetNDevices () < 2)
+        {
+          continue;
+        }
+      Link link;
+      link.delay = 0;
+      TimeValue delay;
+      if (channel->GetAttributeFailSafe ("Delay", delay))
+        {
+          link.delay = delay.Get ().GetTimeStep ();
+        }
+      link.a = channel->GetDevice (0)->GetNode ()->GetId ();
+      for (uint32_t j = 1; j < channel->GetNDevices (); ++j)
+        {
+          link.b = channel->GetDevice (j)->GetNode ()->GetId ();
+          if (link.b != link.a)
+            {
+              m_links.push_back (link);
+            }
+        }
+    }
+  NS_LOG_LOGIC (m_load.size () << " nodes, " << m_links.size () << " links");
+}
+
+void
+PartitionHelper::Contract (int64_t threshold, Graph &graph) const
+{
+  NS_LOG_FUNCTION (this << threshold);
+  uint32_t nNodes = m_load.size ();
+
+  // Union-find of the nodes linked by the contracted links
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      parent[i] = i;
+    }
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->delay > 0 && i->delay >= threshold)
+        {
+          continue;
+        }
+      uint32_t a = i->a;
+      while (parent[a] != a)
+        {
+          parent[a] = parent[parent[a]];
+          a = parent[a];
+        }
+      uint32_t b = i->b;
+      while (parent[b] != b)
+        {
+          parent[b] = parent[parent[b]];
+          b = parent[b];
+        }
+      parent[std::max (a, b)] = std::min (a, b);
+    }
+
+  // Number the groups in the order of their first node
+  graph.group.resize (nNodes);
+  graph.load.clear ();
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      uint32_t root = i;
+      while (parent[root] != root)
+        {
+          root = parent[root];
+        }
+      if (root == i)
+        {
+          graph.group[i] = graph.load.size ();
+          graph.load.push_back (0);
+        }
+      else
+        {
+          graph.group[i] = graph.group[root];
+        }
+      graph.load[graph.group[i]] += m_load[i];
+    }
+
+  std::vector<std::map<uint32_t, uint32_t> > links (graph.load.size ());
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      uint32_t a = graph.group[i->a];
+      uint32_t b = graph.group[i->b];
+      if (a != b)
+        {
+          links[a][b]++;
+          links[b][a]++;
+        }
+    }
+  graph.adjacency.assign (graph.load.size (), std::vector<std::pair<uint32_t, uint32_t> > ());
+  for (uint32_t i = 0; i < links.size (); ++i)
+    {
+      graph.adjacency[i].assign (links[i].begin (), links[i].end ());
+    }
+}
+
+std::vector<uint32_t>
+PartitionHelper::Split (const Graph &graph, uint32_t nPartitions, double maxLoad) const
+{
+  NS_LOG_FUNCTION (this << graph.load.size () << nPartitions << maxLoad);
+  uint32_t nGroups = graph.load.size ();
+  uint32_t remaining = 0;
+  for (uint32_t i = 0; i < nGroups; ++i)
+    {
+      remaining += graph.load[i];
+    }
+
+  // Grow each partition from a seed group along the links, up to its
+  // share of the remaining load; the last partition takes the rest.
+  std::vector<uint32_t> part (nGroups, nPartitions);
+  std::vector<uint32_t> load (nPartitions, 0);
+  uint32_t seed = 0;
+  for (uint32_t k = 0; k < nPartitions; ++k)
+    {
+      if (k == nPartitions - 1)
+        {
+          for (uint32_t i = 0; i < nGroups; ++i)
+            {
+              if (part[i] == nPartitions)
+                {
+                  part[i] = k;
+                  load[k] += graph.load[i];
+                }
+            }
+          break;
+        }
+      double target = static_cast<double> (remaining) / (nPartitions - k);
+      std::vector<bool> tried (nGroups, false);
+      std::deque<uint32_t> queue;
+      while (load[k] < target)
+        {
+          if (queue.empty ())
+            {
+              while (seed < nGroups && part[seed] != nPartitions)
+                {
+                  seed++;
+                }
+              uint32_t next = seed;
+              while (next < nGroups && (part[next] != nPartitions || tried[next]))
+                {
+                  next++;
+                }
+              if (next == nGroups)
+                {
+                  break;
+                }
+              tried[next] = true;
+              queue.push_back (next);
+            }
+          uint32_t v = queue.front ();
+          queue.pop_front ();
+          if (load[k] > 0 && load[k] + graph.load[v] > maxLoad)
+            {
+              continue;
+            }
+          part[v] = k;
+          load[k] += graph.load[v];
+          for (uint32_t j = 0; j < graph.adjacency[v].size (); ++j)
+            {
+              uint32_t w = graph.adjacency[v][j].first;
+              if (part[w] == nPartitions && !tried[w])
+                {
+                  tried[w] = true;
+                  queue.push_back (w);
+                }
+            }
+        }
+      remaining -= load[k];
+    }
+
+  if (*std::max_element (load.begin (), load.end ()) > maxLoad)
+    {
+      // Fall back to the largest groups first, each in the least loaded
+      // partition, which ignores the links but balances better.
+      NS_LOG_LOGIC ("grown partition is not balanced");
+      std::vector<std::pair<uint32_t, uint32_t> > order;
+      for (uint32_t i = 0; i < nGroups; ++i)
+        {
+          order.push_back (std::make_pair (graph.load[i], nGroups - i));
+        }
+      std::sort (order.rbegin (), order.rend ());
+      std::fill (load.begin (), load.end (), 0);
+      for (uint32_t i = 0; i < nGroups; ++i)
+        {
+          uint32_t v = nGroups - order[i].second;
+          uint32_t k = std::min_element (load.begin (), load.end ()) - load.begin ();
+          part[v] = k;
+          load[k] += graph.load[v];
+        }
+    }
+
+  Refine (graph, maxLoad, part, load);
+  return part;
+}
+
+void
+PartitionHelper::Refine (const Graph &graph, double maxLoad,
+                         std::vector<uint32_t> &part, std::vector<uint32_t> &load) const
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t pass = 0; pass < 10; ++pass)
+    {
+      bool moved = false;
+      for (uint32_t v = 0; v < part.size (); ++v)
+        {
+          uint32_t from = part[v];
+          if (load[from] == graph.load[v])
+            {
+              // Do not empty a partition
+              continue;
+            }
+          std::map<uint32_t, uint32_t> links;
+          for (uint32_t j = 0; j < graph.adjacency[v].size (); ++j)
+            {
+              links[part[graph.adjacency[v][j].first]] += graph.adjacency[v][j].second;
+            }
+          uint32_t internal = links[from];
+          uint32_t best = from;
+          uint32_t bestLinks = internal;
+          for (std::map<uint32_t, uint32_t>::const_iterator i = links.begin (); i != links.end (); ++i)
+            {
+              if (i->second > bestLinks && load[i->first] + graph.load[v] <= maxLoad)
+                {
+                  best = i->first;
+                  bestLinks = i->second;
+                }
+            }
+          if (best != from)
+            {
+              part[v] = best;
+              load[from] -= graph.load[v];
+              load[best] += graph.load[v];
+              moved = true;
+            }
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+}
+
+std::vector<uint32_t>
+PartitionHelper::Partition (uint32_t nPartitions)
+{
+  NS_LOG_FUNCTION (this << nPartitions);
+  NS_ASSERT (nPartitions > 0);
+  BuildGraph ();
+  uint32_t nNodes = m_load.size ();
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      total += m_load[i];
+    }
+  double average = static_cast<double> (total) / nPartitions;
+  double maxLoad = (1 + m_maxImbalance) * average;
+
+  // The candidate lookaheads, from the largest
+  std::vector<int64_t> thresholds;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->delay > 0)
+        {
+          thresholds.push_back (i->delay);
+        }
+    }
+  std::sort (thresholds.rbegin (), thresholds.rend ());
+  thresholds.erase (std::unique (thresholds.begin (), thresholds.end ()), thresholds.end ());
+  if (thresholds.empty ())
+    {
+      thresholds.push_back (NO_THRESHOLD);
+    }
+
+  std::vector<uint32_t> result (nNodes, 0);
+  for (uint32_t t = 0; t < thresholds.size (); ++t)
+    {
+      Graph graph;
+      Contract (thresholds[t], graph);
+      std::vector<uint32_t> part = Split (graph, nPartitions, maxLoad);
+      std::vector<uint32_t> load (nPartitions, 0);
+      for (uint32_t i = 0; i < nNodes; ++i)
+        {
+          result[i] = part[graph.group[i]];
+          load[result[i]] += m_load[i];
+        }
+      uint32_t largest = *std::max_element (load.begin (), load.end ());
+      m_imbalance = nNodes > 0 ? largest / average - 1 : 0;
+      NS_LOG_LOGIC ("threshold " << thresholds[t] << ": " << graph.load.size () <<
+                    " groups, imbalance " << m_imbalance);
+      if (largest <= maxLoad)
+        {
+          break;
+        }
+    }
+
+  m_cutSize = 0;
+  m_lookahead = Time::Max ();
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (result[i->a] != result[i->b])
+        {
+          NS_ASSERT (i->delay > 0);
+          m_cutSize++;
+          m_lookahead = Min (m_lookahead, TimeStep (i->delay));
+        }
+    }
+  NS_LOG_LOGIC ("cut " << m_cutSize << " links, lookahead " << m_lookahead);
+  return result;
+}
+
+void
+PartitionHelper::Assign (uint32_t nPartitions)
+{
+  NS_LOG_FUNCTION (this << nPartitions);
+  std::vector<uint32_t> part = Partition (nPartitions);
+  for (uint32_t i = 0; i < part.size (); ++i)
+    {
+      NodeList::GetNode (i)->SetAttribute ("SystemId", UintegerValue (part[i]));
+    }
+}
+
+} // namespace ns3
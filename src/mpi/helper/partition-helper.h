@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARTITION_HELPER_H
+#define PARTITION_HELPER_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Assign the system ids of the nodes for a parallel simulation
+ *
+ * The helper builds a graph of the topology from the NodeList and the
+ * ChannelList: each node is a vertex whose load is one plus its number of
+ * devices, and each channel links the node of its first device to the
+ * nodes of its other devices.  A link can only be cut, i.e. connect two
+ * partitions, if its channel has a non-zero "Delay" attribute, since the
+ * lookahead of the simulation is the smallest delay of the cut links.
+ *
+ * The partition is computed offline, without any external library.  For
+ * each delay of the links, from the largest, the links of smaller delay
+ * are contracted and the resulting groups of nodes are split into
+ * balanced partitions: each partition is first grown along the links
+ * from a seed node, then single groups are moved between partitions
+ * while this reduces the number of cut links.  The first delay for which
+ * the load of every partition is within the imbalance tolerance of the
+ * average load is kept, hence the partition with the largest lookahead
+ * among the balanced ones.
+ *
+ * MultithreadedSimulatorImpl reads the system ids when Simulator::Run is
+ * called, so Assign can be called once the topology is built.  With
+ * DistributedSimulatorImpl, the remote channels are chosen when the
+ * devices are installed, so the topology must be built once to call
+ * Partition, before MPI is enabled (Simulator::Destroy then clears the
+ * topology), and built again with the system ids it returns.
+ */
+class PartitionHelper
+{
+public:
+  PartitionHelper ();
+
+  /**
+   * \param imbalance the tolerated excess of the load of a partition over
+   *        the average load, e.g. 0.1 for 10% (the default)
+   */
+  void SetMaxImbalance (double imbalance);
+
+  /**
+   * Compute a partition of the nodes of the NodeList.
+   *
+   * \param nPartitions the number of partitions
+   * \return the partition of each node, indexed by node id
+   */
+  std::vector<uint32_t> Partition (uint32_t nPartitions);
+
+  /**
+   * Compute a partition of the nodes of the NodeList, and set the
+   * "SystemId" attribute of each node to its partition.
+   *
+   * \param nPartitions the number of partitions
+   */
+  void Assign (uint32_t nPartitions);
+
+  /**
+   * \return the smallest delay of the links cut by the last partition,
+   *         or Time::Max if no link was cut
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \return the number of links cut by the last partition
+   */
+  uint32_t GetCutSize (void) const;
+  /**
+   * \return the excess of the load of the most loaded partition over the
+   *         average load, for the last partition
+   */
+  double GetImbalance (void) const;
+
+private:
+  /** A link between two nodes. */
+  struct Link
+  {
+    uint32_t a;     //!< the first node
+    uint32_t b;     //!< the second node
+    int64_t delay;  //!< the delay of the channel, 0 if the link cannot be cut
+  };
+
+  /** The groups of nodes linked by contracted links, and their links. */
+  struct Graph
+  {
+    std::vector<uint32_t> group;    //!< the group of each node
+    std::vector<uint32_t> load;     //!< the load of each group
+    /** The groups linked to each group, with the number of links, by group. */
+    std::vector<std::vector<std::pair<uint32_t, uint32_t> > > adjacency;
+  };
+
+  /** Read the nodes and links of the topology. */
+  void BuildGraph (void);
+  /**
+   * Contract the links whose delay is smaller than a threshold.
+   *
+   * \param threshold the delay threshold
+   * \param graph the groups of nodes and their links
+   */
+  void Contract (int64_t threshold, Graph &graph) const;
+  /**
+   * Split the groups of a graph into balanced partitions.
+   *
+   * \param graph the groups of nodes
+   * \param nPartitions the number of partitions
+   * \param maxLoad the largest load of a partition
+   * \return the partition of each group
+   */
+  std::vector<uint32_t> Split (const Graph &graph, uint32_t nPartitions, double maxLoad) const;
+  /**
+   * Move groups to the partition they have the most links with, while
+   * this reduces the number of cut links and respects the largest load.
+   *
+   * \param graph the groups of nodes
+   * \param maxLoad the largest load of a partition
+   * \param part the partition of each group
+   * \param load the load of each partition
+   */
+  void Refine (const Graph &graph, double maxLoad,
+               std::vector<uint32_t> &part, std::vector<uint32_t> &load) const;
+
+  double m_maxImbalance;          //!< the tolerated imbalance
+  std::vector<uint32_t> m_load;   //!< the load of each node
+  std::vector<Link> m_links;      //!< the links of the topology
+  Time m_lookahead;               //!< the lookahead of the last partition
+  uint32_t m_cutSize;             //!< the number of links cut by the last partition
+  double m_imbalance;             //!< the imbalance of the last partition
+};
+
+} // namespace ns3
+
+#endif /* PARTITION_HELPER_H */
@@ -35,6 +35,7 @@
 #include "ns3/simulator-impl.h"
 #include "ns3/nstime.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -81,7 +82,11 @@ bool                  GrantedTimeWindowMpiInterface::m_initialized = false;
 bool                  GrantedTimeWindowMpiInterface::m_enabled = false;
 uint32_t              GrantedTimeWindowMpiInterface::m_rxCount = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_txCount = 0;
+uint32_t              GrantedTimeWindowMpiInterface::m_rxMessageCount = 0;
+uint32_t              GrantedTimeWindowMpiInterface::m_txMessageCount = 0;
 std::list<SentBuffer> GrantedTimeWindowMpiInterface::m_pendingTx;
+MpiPacketBatch*       GrantedTimeWindowMpiInterface::m_batches = 0;
+MpiFlushPolicy        GrantedTimeWindowMpiInterface::m_flushPolicy (MAX_MPI_MSG_SIZE);
 
 #ifdef NS3_MPI
 MPI_Request* GrantedTimeWindowMpiInterface::m_requests;
@@ -110,6 +115,8 @@ GrantedTimeWindowMpiInterface::Destroy ()
     }
   delete [] m_pRxBuffers;
   delete [] m_requests;
+  delete [] m_batches;
+  m_batches = 0;
 
   m_pendingTx.clear ();
 #endif
@@ -127,6 +134,18 @@ GrantedTimeWindowMpiInterface::GetTxCount ()
   return m_txCount;
 }
 
+uint32_t
+GrantedTimeWindowMpiInterface::GetRxMessageCount ()
+{
+  return m_rxMessageCount;
+}
+
+uint32_t
+GrantedTimeWindowMpiInterface::GetTxMessageCount ()
+{
+  return m_txMessageCount;
+}
+
 uint32_t
 GrantedTimeWindowMpiInterface::GetSystemId ()
 {
@@ -182,6 +201,7 @@ GrantedTimeWindowMpiInterface::Enable (int* pargc, char*** pargv)
       MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
                  MPI_COMM_WORLD, &m_requests[i]);
     }
+  m_batches = new MpiPacketBatch[m_size];
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -193,30 +213,69 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
 
 #ifdef NS3_MPI
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
+
+  uint32_t recordSize = MpiPacketBatch::GetRecordSize (p);
+  NS_ABORT_MSG_IF (recordSize > MAX_MPI_MSG_SIZE, "Packet too large for an MPI message: " << recordSize);
+  MpiPacketBatch &batch = m_batches[nodeSysId];
+  if (batch.GetSize () + recordSize > MAX_MPI_MSG_SIZE)
+    {
+      Flush (nodeSysId);
+      m_flushPolicy.NotifyEarlyFlush ();
+    }
+  batch.Add (p, rxTime.GetInteger (), node, dev);
+  m_txCount++;
+  if (batch.GetSize () >= m_flushPolicy.GetFlushSize ())
+    {
+      Flush (nodeSysId);
+      m_flushPolicy.NotifyEarlyFlush ();
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+GrantedTimeWindowMpiInterface::Flush (uint32_t rank)
+{
+  NS_LOG_FUNCTION (rank);
+
+#ifdef NS3_MPI
+  if (m_batches[rank].GetNPackets () == 0)
+    {
+      return;
+    }
   SentBuffer sendBuf;
   m_pendingTx.push_back (sendBuf);
   std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
 
-  uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t t = rxTime.GetInteger ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
+  uint32_t size;
+  i->SetBuffer (m_batches[rank].Detach (size));
+  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), size, MPI_CHAR, rank,
+             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  m_txMessageCount++;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
 
-  // Find the system id for the destination node
-  Ptr<Node> destNode = NodeList::GetNode (node);
-  uint32_t nodeSysId = destNode->GetSystemId ();
+void
+GrantedTimeWindowMpiInterface::FlushSendBuffers ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
 
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
-  m_txCount++;
+#ifdef NS3_MPI
+  for (uint32_t rank = 0; rank < m_size; ++rank)
+    {
+      if (m_batches[rank].GetNPackets () > 0)
+        {
+          m_flushPolicy.NotifySyncFlush (m_batches[rank].GetSize ());
+          Flush (rank);
+        }
+    }
+  m_flushPolicy.NotifySync ();
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -242,40 +301,42 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
+      m_rxMessageCount++; // Count this receive
 
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t time = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
-
-      Time rxTime (time);
-
-      count -= sizeof (time) + sizeof (node) + sizeof (dev);
-
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
-
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
+      // Schedule the rx event of each packet of the batch
+      const uint8_t* pData = reinterpret_cast<uint8_t *> (m_pRxBuffers[index]);
+      const uint8_t* pEnd = pData + count;
+      while (pData < pEnd)
         {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
+          uint64_t time;
+          uint32_t node;
+          uint32_t dev;
+          Ptr<Packet> p;
+          pData = MpiPacketBatch::Read (pData, pEnd, time, node, dev, p);
+          m_rxCount++;
+
+          Time rxTime (time);
+
+          // Find the correct node/device to schedule receive event
+          Ptr<Node> pNode = NodeList::GetNode (node);
+          Ptr<MpiReceiver> pMpiRec = 0;
+          uint32_t nDevices = pNode->GetNDevices ();
+          for (uint32_t i = 0; i < nDevices; ++i)
             {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
+              Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+              if (pThisDev->GetIfIndex () == dev)
+                {
+                  pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+                  break;
+                }
             }
-        }
 
-      NS_ASSERT (pNode && pMpiRec);
+          NS_ASSERT (pNode && pMpiRec);
 
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+          // Schedule the rx event
+          Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                          &MpiReceiver::Receive, pMpiRec, p);
+        }
 
       // Re-queue the next read
       MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
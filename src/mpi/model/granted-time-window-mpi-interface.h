@@ -30,6 +30,7 @@
 #include "ns3/buffer.h"
 
 #include "parallel-communication-interface.h"
+#include "mpi-packet-batch.h"
 
 #ifdef NS3_MPI
 #include "mpi.h"
@@ -43,7 +44,11 @@ namespace ns3 {
  * maximum MPI message size for easy
  * buffer creation
  */
-const uint32_t MAX_MPI_MSG_SIZE = 2000;
+/**
+ * Size of the receive buffers, hence the largest message: a batch of
+ * packets sent to a rank.
+ */
+const uint32_t MAX_MPI_MSG_SIZE = 65536;
 
 /**
  * \ingroup mpi
@@ -128,9 +133,17 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device
+   * Serialize a packet for the specified node and net device, in the
+   * batch of the rank of the node.  The batch is sent when it reaches
+   * the flush size of the MpiFlushPolicy, or by FlushSendBuffers.
    */
   virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the batches of all the ranks; called before each computation
+   * of the granted time window, so that all the packets sent during a
+   * window are received before the next one.
+   */
+  static void FlushSendBuffers ();
   /**
    * Check for received messages complete
    */
@@ -147,8 +160,22 @@ public:
    * \return transmitted count in packets
    */
   static uint32_t GetTxCount ();
+  /**
+   * \return received count in MPI messages
+   */
+  static uint32_t GetRxMessageCount ();
+  /**
+   * \return transmitted count in MPI messages
+   */
+  static uint32_t GetTxMessageCount ();
 
 private:
+  /**
+   * Send the batch of a rank, if not empty.
+   * \param rank the destination rank
+   */
+  static void Flush (uint32_t rank);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -157,6 +184,12 @@ private:
 
   // Total packets sent
   static uint32_t m_txCount;
+
+  // Total messages received
+  static uint32_t m_rxMessageCount;
+
+  // Total messages sent
+  static uint32_t m_txMessageCount;
   static bool     m_initialized;
   static bool     m_enabled;
 
@@ -168,6 +201,12 @@ private:
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
+
+  // Packets not yet sent, by destination rank
+  static MpiPacketBatch* m_batches;
+
+  // When to send the batches
+  static MpiFlushPolicy m_flushPolicy;
 };
 
 } // namespace ns3
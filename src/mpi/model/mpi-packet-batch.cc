@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mpi-packet-batch.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpiPacketBatch");
+
+MpiPacketBatch::MpiPacketBatch ()
+  : m_buffer (0),
+    m_capacity (0),
+    m_size (0),
+    m_headerSize (0),
+    m_nPackets (0)
+{
+}
+
+MpiPacketBatch::~MpiPacketBatch ()
+{
+  delete [] m_buffer;
+}
+
+void
+MpiPacketBatch::SetHeaderSize (uint32_t size)
+{
+  NS_ASSERT (m_nPackets == 0);
+  m_headerSize = size;
+  m_size = size;
+}
+
+uint32_t
+MpiPacketBatch::GetNPackets (void) const
+{
+  return m_nPackets;
+}
+
+uint32_t
+MpiPacketBatch::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+MpiPacketBatch::Reserve (uint32_t size)
+{
+  if (m_buffer != 0 && m_size + size <= m_capacity)
+    {
+      return;
+    }
+  uint32_t capacity = std::max (2 * m_capacity, m_size + size);
+  uint8_t *buffer = new uint8_t[capacity];
+  if (m_buffer != 0)
+    {
+      memcpy (buffer, m_buffer, m_size);
+      delete [] m_buffer;
+    }
+  m_buffer = buffer;
+  m_capacity = capacity;
+}
+
+uint32_t
+MpiPacketBatch::GetRecordSize (Ptr<Packet> p)
+{
+  return RECORD_HEADER_SIZE + p->GetSerializedSize ();
+}
+
+void
+MpiPacketBatch::Add (Ptr<Packet> p, uint64_t rxTime, uint32_t node, uint32_t dev)
+{
+  NS_LOG_FUNCTION (this << p << rxTime << node << dev);
+  uint32_t serializedSize = p->GetSerializedSize ();
+  Reserve (RECORD_HEADER_SIZE + serializedSize);
+  uint8_t *record = m_buffer + m_size;
+  memcpy (record, &rxTime, 8);
+  memcpy (record + 8, &node, 4);
+  memcpy (record + 12, &dev, 4);
+  memcpy (record + 16, &serializedSize, 4);
+  p->Serialize (record + RECORD_HEADER_SIZE, serializedSize);
+  m_size += RECORD_HEADER_SIZE + serializedSize;
+  m_nPackets++;
+}
+
+uint8_t *
+MpiPacketBatch::Detach (uint32_t &size)
+{
+  NS_LOG_FUNCTION (this);
+  size = m_size;
+  Reserve (0);
+  uint8_t *buffer = m_buffer;
+  m_buffer = 0;
+  m_capacity = 0;
+  m_size = m_headerSize;
+  m_nPackets = 0;
+  return buffer;
+}
+
+const uint8_t *
+MpiPacketBatch::Read (const uint8_t *buffer, const uint8_t *end,
+                      uint64_t &rxTime, uint32_t &node, uint32_t &dev,
+                      Ptr<Packet> &p)
+{
+  NS_ASSERT (buffer + RECORD_HEADER_SIZE <= end);
+  uint32_t serializedSize;
+  memcpy (&rxTime, buffer, 8);
+  memcpy (&node, buffer + 8, 4);
+  memcpy (&dev, buffer + 12, 4);
+  memcpy (&serializedSize, buffer + 16, 4);
+  buffer += RECORD_HEADER_SIZE;
+  NS_ASSERT (buffer + serializedSize <= end);
+  p = Create<Packet> (buffer, serializedSize, true);
+  return buffer + serializedSize;
+}
+
+
+MpiFlushPolicy::MpiFlushPolicy (uint32_t maxSize)
+  : m_maxSize (maxSize),
+    m_flushSize (std::min (4 * MIN_FLUSH_SIZE, maxSize)),
+    m_earlyFlushes (0),
+    m_syncFlushes (0),
+    m_largestSync (0)
+{
+  NS_ASSERT (maxSize >= MIN_FLUSH_SIZE);
+}
+
+uint32_t
+MpiFlushPolicy::GetFlushSize (void) const
+{
+  return m_flushSize;
+}
+
+void
+MpiFlushPolicy::NotifyEarlyFlush (void)
+{
+  m_earlyFlushes++;
+}
+
+void
+MpiFlushPolicy::NotifySyncFlush (uint32_t size)
+{
+  m_syncFlushes++;
+  m_largestSync = std::max (m_largestSync, size);
+}
+
+void
+MpiFlushPolicy::NotifySync (void)
+{
+  if (m_earlyFlushes > m_syncFlushes)
+    {
+      m_flushSize = std::min (2 * m_flushSize, m_maxSize);
+      NS_LOG_LOGIC ("flush size up to " << m_flushSize);
+    }
+  else if (m_earlyFlushes == 0 && m_syncFlushes > 0 && m_largestSync < m_flushSize / 4)
+    {
+      m_flushSize = m_flushSize / 2 > MIN_FLUSH_SIZE ? m_flushSize / 2 : MIN_FLUSH_SIZE;
+      NS_LOG_LOGIC ("flush size down to " << m_flushSize);
+    }
+  m_earlyFlushes = 0;
+  m_syncFlushes = 0;
+  m_largestSync = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPI_PACKET_BATCH_H
+#define NS3_MPI_PACKET_BATCH_H
+
+#include <stdint.h>
+
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief The packets sent to one rank, coalesced into a single MPI message
+ *
+ * A message starts with a header, whose size is fixed by the user of the
+ * batch (e.g. the guarantee time of the null message algorithm), followed
+ * by one record per packet: the receive time, the destination node and
+ * device, the size of the serialized packet, and the serialized packet.
+ * Records are not aligned; they are read with Read.
+ */
+class MpiPacketBatch
+{
+public:
+  /** Size of the record of a packet, without the packet. */
+  static const uint32_t RECORD_HEADER_SIZE = 20;
+
+  MpiPacketBatch ();
+  ~MpiPacketBatch ();
+
+  /**
+   * \param size the size of the header of the messages
+   */
+  void SetHeaderSize (uint32_t size);
+  /**
+   * Append a packet to the batch.
+   *
+   * \param p packet to send
+   * \param rxTime received time at destination node, in time steps
+   * \param node destination node
+   * \param dev destination device
+   */
+  void Add (Ptr<Packet> p, uint64_t rxTime, uint32_t node, uint32_t dev);
+  /**
+   * \return the number of packets in the batch
+   */
+  uint32_t GetNPackets (void) const;
+  /**
+   * \return the size of the message, header included
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * Hand the message over, and start a new batch.
+   *
+   * \param size the size of the message, header included
+   * \return the message, allocated with new [], whose header is to be
+   *         filled by the caller
+   */
+  uint8_t * Detach (uint32_t &size);
+
+  /**
+   * \param p a packet
+   * \return the size of the record of the packet
+   */
+  static uint32_t GetRecordSize (Ptr<Packet> p);
+  /**
+   * Read the next record of a message.
+   *
+   * \param buffer the record
+   * \param end the end of the message
+   * \param rxTime received time at destination node, in time steps
+   * \param node destination node
+   * \param dev destination device
+   * \param p the packet
+   * \return the next record
+   */
+  static const uint8_t * Read (const uint8_t *buffer, const uint8_t *end,
+                               uint64_t &rxTime, uint32_t &node, uint32_t &dev,
+                               Ptr<Packet> &p);
+
+private:
+  MpiPacketBatch (const MpiPacketBatch &);
+  MpiPacketBatch & operator = (const MpiPacketBatch &);
+
+  /**
+   * Make room for more bytes.
+   * \param size the number of bytes needed after the current ones
+   */
+  void Reserve (uint32_t size);
+
+  uint8_t *m_buffer;      //!< the message, 0 until the first packet
+  uint32_t m_capacity;    //!< the allocated size of m_buffer
+  uint32_t m_size;        //!< the size of the message, header included
+  uint32_t m_headerSize;  //!< the size of the header
+  uint32_t m_nPackets;    //!< the number of packets in the batch
+};
+
+/**
+ * \ingroup mpi
+ *
+ * \brief The adaptive policy which decides when to send the batches
+ *
+ * The batches are all sent at the synchronization points of the
+ * simulator, when it needs the messages of the other ranks to proceed;
+ * a batch is also sent as soon as it reaches the flush size, to overlap
+ * the transfer with the simulation.  The flush size is doubled, up to
+ * the maximum, when most messages since the last synchronization point
+ * were such early flushes, since the overhead of each message then
+ * dominates; it is halved, down to the minimum, when all the batches at
+ * the synchronization point were smaller than a quarter of it, so that
+ * a later burst of traffic is sent early.
+ */
+class MpiFlushPolicy
+{
+public:
+  /** The smallest flush size. */
+  static const uint32_t MIN_FLUSH_SIZE = 4096;
+
+  /**
+   * \param maxSize the largest flush size, i.e. the size of the
+   *        receive buffers
+   */
+  MpiFlushPolicy (uint32_t maxSize);
+
+  /**
+   * \return the size from which a batch is sent at once
+   */
+  uint32_t GetFlushSize (void) const;
+  /**
+   * Notify that a batch was sent because it reached the flush size.
+   */
+  void NotifyEarlyFlush (void);
+  /**
+   * Notify that a batch was sent at a synchronization point.
+   * \param size the size of the batch
+   */
+  void NotifySyncFlush (uint32_t size);
+  /**
+   * Notify the end of a synchronization point, and adapt the flush size.
+   */
+  void NotifySync (void);
+
+private:
+  uint32_t m_maxSize;       //!< the largest flush size
+  uint32_t m_flushSize;     //!< the current flush size
+  uint32_t m_earlyFlushes;  //!< early flushes since the last synchronization
+  uint32_t m_syncFlushes;   //!< flushes at the current synchronization
+  uint32_t m_largestSync;   //!< largest batch at the current synchronization
+};
+
+} // namespace ns3
+
+#endif /* NS3_MPI_PACKET_BATCH_H */
@@ -0,0 +1,624 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "spsc-queue.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <sched.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/** Timestamp of "no event" and "no stop time". */
+static const uint64_t NO_TS = 0x7fffffffffffffffLL;
+
+__thread MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_lookahead (NO_TS),
+    m_running (false),
+    m_stop (false),
+    m_stopTs (NO_TS),
+    m_barrierCount (0),
+    m_barrierSense (false)
+{
+  NS_LOG_FUNCTION (this);
+  GetPartition (0);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *p = *i;
+      for (uint32_t src = 0; src < p->inbound.size (); ++src)
+        {
+          RemoteEvent ev;
+          while (p->inbound[src]->Pop (ev))
+            {
+              ev.event->Unref ();
+            }
+          delete p->inbound[src];
+        }
+      while (!p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      p->events = 0;
+      delete p;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t id)
+{
+  NS_ASSERT (!m_running);
+  while (m_partitions.size () <= id)
+    {
+      Partition *p = new Partition ();
+      p->impl = this;
+      p->id = m_partitions.size ();
+      if (m_schedulerFactory.GetTypeId () != TypeId ())
+        {
+          p->events = m_schedulerFactory.Create<Scheduler> ();
+        }
+      // uids are allocated from 4.
+      // uid 0 is "invalid" events
+      // uid 1 is "now" events
+      // uid 2 is "destroy" events
+      p->uid = 4;
+      // before ::Run is entered, the currentUid will be zero
+      p->currentUid = 0;
+      p->currentTs = 0;
+      p->currentContext = 0xffffffff;
+      p->unscheduledEvents = 0;
+      p->nextTs = NO_TS;
+      p->barrierSense = false;
+      m_partitions.push_back (p);
+    }
+  return m_partitions[id];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  if (m_current != 0)
+    {
+      return m_current;
+    }
+  return m_partitions[0];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartitionOf (uint32_t context) const
+{
+  if (m_running)
+    {
+      if (context < m_nodePartition.size ())
+        {
+          return m_partitions[m_nodePartition[context]];
+        }
+      return 0;
+    }
+  if (context < NodeList::GetNNodes ())
+    {
+      uint32_t id = NodeList::GetNode (context)->GetSystemId ();
+      return const_cast<MultithreadedSimulatorImpl *> (this)->GetPartition (id);
+    }
+  return 0;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartitionOf (const EventId &id) const
+{
+  Partition *p = GetPartitionOf (id.GetContext ());
+  if (p == 0)
+    {
+      p = GetCurrent ();
+    }
+  NS_ASSERT_MSG (!m_running || p == m_current,
+                 "An event can only be accessed from the partition which runs it");
+  return p;
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT (!m_running);
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->events != 0)
+        {
+          while (!(*i)->events->IsEmpty ())
+            {
+              scheduler->Insert ((*i)->events->RemoveNext ());
+            }
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetCurrent ()->id;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->currentContext;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookahead (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nodePartition.clear ();
+  m_lookahead = NO_TS;
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); ++n)
+    {
+      Ptr<Node> node = *n;
+      m_nodePartition.push_back (node->GetSystemId ());
+      GetPartition (node->GetSystemId ());
+      for (uint32_t i = 0; i < node->GetNDevices (); ++i)
+        {
+          Ptr<Channel> channel = node->GetDevice (i)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+            {
+              Ptr<Node> remoteNode = channel->GetDevice (j)->GetNode ();
+              if (remoteNode->GetSystemId () == node->GetSystemId ())
+                {
+                  continue;
+                }
+              TimeValue delay;
+              if (!channel->GetAttributeFailSafe ("Delay", delay))
+                {
+                  NS_FATAL_ERROR ("Channel " << channel->GetInstanceTypeId ().GetName () <<
+                                  " connects nodes of different partitions but has no Delay attribute");
+                }
+              if (static_cast<uint64_t> (delay.Get ().GetTimeStep ()) < m_lookahead)
+                {
+                  m_lookahead = delay.Get ().GetTimeStep ();
+                }
+            }
+        }
+    }
+  if (m_lookahead == 0)
+    {
+      NS_FATAL_ERROR ("A channel with no delay connects nodes of different partitions");
+    }
+  NS_LOG_LOGIC ("partitions=" << m_partitions.size () << ", lookahead=" << m_lookahead);
+}
+
+void
+MultithreadedSimulatorImpl::Partition::Run (void)
+{
+  impl->RunPartition (this);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  CalculateLookahead ();
+  uint32_t n = m_partitions.size ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Partition *p = m_partitions[i];
+      for (uint32_t src = p->inbound.size (); src < n; ++src)
+        {
+          p->inbound.push_back (new SpscQueue<RemoteEvent> ());
+        }
+    }
+
+  m_running = true;
+  m_barrierCount = 0;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < n; ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Partition::Run, m_partitions[i]));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  RunPartition (m_partitions[0]);
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_running = false;
+  m_current = 0;
+
+  // If the simulator stopped running because of a call to Stop,
+  // the next call to Run will continue from where it stopped.
+  m_stop = false;
+  m_stopTs = NO_TS;
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (Partition *p)
+{
+  p->barrierSense = !p->barrierSense;
+  uint32_t n = m_partitions.size ();
+  if (__atomic_add_fetch (&m_barrierCount, 1, __ATOMIC_ACQ_REL) == n)
+    {
+      __atomic_store_n (&m_barrierCount, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (&m_barrierSense, p->barrierSense, __ATOMIC_RELEASE);
+      return;
+    }
+  uint32_t spins = 0;
+  while (__atomic_load_n (&m_barrierSense, __ATOMIC_ACQUIRE) != p->barrierSense)
+    {
+      // spin for short windows, but leave the cpu to the other threads
+      // when there are more partitions than cpus
+      if (++spins > 1000)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *p)
+{
+  NS_LOG_FUNCTION (this << p->id);
+  m_current = p;
+  while (true)
+    {
+      Barrier (p);
+      // the events sent by the other partitions during the last window
+      for (uint32_t src = 0; src < p->inbound.size (); ++src)
+        {
+          RemoteEvent ev;
+          while (p->inbound[src]->Pop (ev))
+            {
+              Insert (p, ev.ts, ev.context, ev.event);
+            }
+        }
+      p->nextTs = p->events->IsEmpty () ? NO_TS : p->events->PeekNext ().key.m_ts;
+      Barrier (p);
+
+      // all the threads compute the same window from the same values
+      if (__atomic_load_n (&m_stop, __ATOMIC_RELAXED))
+        {
+          break;
+        }
+      uint64_t next = NO_TS;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          next = std::min (next, (*i)->nextTs);
+        }
+      uint64_t stopTs = __atomic_load_n (&m_stopTs, __ATOMIC_RELAXED);
+      if (next == NO_TS || next >= stopTs)
+        {
+          break;
+        }
+      uint64_t end = (next > NO_TS - m_lookahead) ? NO_TS : next + m_lookahead;
+      end = std::min (end, stopTs);
+
+      while (!p->events->IsEmpty ()
+             && p->events->PeekNext ().key.m_ts < end
+             && !__atomic_load_n (&m_stop, __ATOMIC_RELAXED))
+        {
+          ProcessOneEvent (p);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *p)
+{
+  Scheduler::Event next = p->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= p->currentTs);
+  p->unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  p->currentTs = next.key.m_ts;
+  p->currentContext = next.key.m_context;
+  p->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (__atomic_load_n (&m_stop, __ATOMIC_RELAXED))
+    {
+      return true;
+    }
+  if (m_running)
+    {
+      return false;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  __atomic_store_n (&m_stop, true, __ATOMIC_RELAXED);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  NS_ASSERT (delay.IsPositive ());
+  uint64_t ts = GetCurrent ()->currentTs + delay.GetTimeStep ();
+  uint64_t stopTs = __atomic_load_n (&m_stopTs, __ATOMIC_RELAXED);
+  while (ts < stopTs
+         && !__atomic_compare_exchange_n (&m_stopTs, &stopTs, ts, false,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = p->uid;
+  p->uid++;
+  p->unscheduledEvents++;
+  p->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+  Partition *p = GetCurrent ();
+  uint64_t ts = p->currentTs + delay.GetTimeStep ();
+  uint32_t uid = Insert (p, ts, p->currentContext, event);
+  return EventId (event, ts, p->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (delay.IsPositive (), "MultithreadedSimulatorImpl::ScheduleWithContext(): Negative delay");
+  Partition *src = GetCurrent ();
+  Partition *dst = GetPartitionOf (context);
+  uint64_t ts = src->currentTs + delay.GetTimeStep ();
+  if (dst == 0 || dst == src || !m_running)
+    {
+      Insert (dst != 0 ? dst : src, ts, context, event);
+      return;
+    }
+  if (static_cast<uint64_t> (delay.GetTimeStep ()) < m_lookahead)
+    {
+      NS_FATAL_ERROR ("Event sent to partition " << dst->id << " with a delay of "
+                      << delay.GetTimeStep () << ", within the lookahead of " << m_lookahead);
+    }
+  RemoteEvent ev;
+  ev.event = event;
+  ev.ts = ts;
+  ev.context = context;
+  dst->inbound[src->id]->Push (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrent ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *p = GetPartitionOf (id);
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  p->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  p->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  Partition *p = GetPartitionOf (id);
+  if (id.GetTs () < p->currentTs ||
+      (id.GetTs () == p->currentTs &&
+       id.GetUid () <= p->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (NO_TS);
+}
+
+} // namespace ns3
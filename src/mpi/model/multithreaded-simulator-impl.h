@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+template <typename T> class SpscQueue;
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator implementation using threads
+ * on shared memory
+ *
+ * The nodes are partitioned by their system id (the argument of the
+ * Node constructor, as with DistributedSimulatorImpl), and each
+ * partition is run by its own thread, with its own event list, current
+ * time and context.  Simulator::Now, Simulator::Schedule and the other
+ * functions of the Simulator apply to the partition of the calling
+ * thread; partition 0 is run by the thread which calls Simulator::Run.
+ * Events scheduled without a node context before Simulator::Run belong
+ * to partition 0, so events which act on a node should be scheduled with
+ * Simulator::ScheduleWithContext.
+ *
+ * The partitions advance in time windows: at the start of a window all
+ * the threads meet at a barrier and compute the time of the earliest
+ * event of the simulation, and each thread then runs the events of its
+ * partition which are earlier than that time plus the lookahead.  The
+ * lookahead is the smallest "Delay" attribute of the channels which
+ * connect nodes of different partitions; the devices of such channels
+ * (e.g. PointToPointChannel) schedule the reception of a packet in the
+ * partition of the receiving node with Simulator::ScheduleWithContext.
+ * Such an event is handed to the receiving partition by pointer, through
+ * a lock-free single-producer single-consumer queue for each pair of
+ * partitions, and inserted in its event list at the next window; the
+ * packet is neither serialized nor copied.
+ *
+ * An event must only be cancelled, removed or checked for expiry by the
+ * partition which runs it, and trace sinks shared by several partitions
+ * must be thread-safe.  Simulator::Stop without a delay stops the
+ * calling partition at once and the others at the end of the window;
+ * Simulator::Stop with a delay stops all the partitions before the
+ * first event at or after the given time.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return the lookahead computed by the last call to Run
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \return the number of partitions, hence of threads, of the last
+   *         call to Run
+   */
+  uint32_t GetPartitionCount (void) const;
+
+private:
+  /** An event sent to another partition. */
+  struct RemoteEvent
+  {
+    EventImpl *event;   //!< the event
+    uint64_t ts;        //!< the event timestamp
+    uint32_t context;   //!< the event context
+  };
+
+  /** The state of a partition, owned by the thread which runs it. */
+  struct Partition
+  {
+    MultithreadedSimulatorImpl *impl; //!< the simulator
+    uint32_t id;                 //!< the partition index
+    Ptr<Scheduler> events;       //!< the event list
+    uint32_t uid;                //!< next event unique id
+    uint32_t currentUid;         //!< unique id of the current event
+    uint64_t currentTs;          //!< timestamp of the current event
+    uint32_t currentContext;     //!< execution context of the current event
+    int unscheduledEvents;       //!< number of events in the event list
+    uint64_t nextTs;             //!< timestamp of the next event, at the start of a window
+    bool barrierSense;           //!< the sense of the last barrier
+    /** The events sent by each other partition, by source partition. */
+    std::vector<SpscQueue<RemoteEvent> *> inbound;
+    /** Run the partition; the body of its thread. */
+    void Run (void);
+  };
+
+  virtual void DoDispose (void);
+
+  /**
+   * \param id the partition index
+   * \return the partition, created if needed (before Run only)
+   */
+  Partition * GetPartition (uint32_t id);
+  /**
+   * \return the partition of the calling thread; partition 0 outside Run
+   */
+  Partition * GetCurrent (void) const;
+  /**
+   * \param context an event context
+   * \return the partition of the node with the given id, or 0 if the
+   *         context is not a node id
+   */
+  Partition * GetPartitionOf (uint32_t context) const;
+  /**
+   * \param id an event
+   * \return the partition which holds the event
+   */
+  Partition * GetPartitionOf (const EventId &id) const;
+  /**
+   * Insert an event in the event list of a partition.
+   *
+   * \param p the partition
+   * \param ts the event timestamp
+   * \param context the event context
+   * \param event the event
+   * \return the event unique id
+   */
+  uint32_t Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event);
+  /** Compute m_nodePartition and m_lookahead from the nodes and channels. */
+  void CalculateLookahead (void);
+  /**
+   * Run the windows of a partition until the end of the simulation.
+   * \param p the partition
+   */
+  void RunPartition (Partition *p);
+  /**
+   * Process the next event of a partition.
+   * \param p the partition
+   */
+  void ProcessOneEvent (Partition *p);
+  /**
+   * Wait until all the threads reach the barrier.
+   * \param p the partition of the calling thread
+   */
+  void Barrier (Partition *p);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;     //!< the events to run at Destroy
+  SystemMutex m_destroyEventsMutex;  //!< protects m_destroyEvents
+  std::vector<Partition *> m_partitions; //!< the partitions
+  std::vector<uint32_t> m_nodePartition; //!< the partition of each node, during Run
+  ObjectFactory m_schedulerFactory;  //!< the factory of the event lists
+  uint64_t m_lookahead;              //!< the lookahead, in time steps
+  bool m_running;                    //!< true during Run
+  bool m_stop;                       //!< Stop was called; atomic
+  uint64_t m_stopTs;                 //!< the stop time; atomic
+  uint32_t m_barrierCount;           //!< number of threads at the barrier; atomic
+  bool m_barrierSense;               //!< flipped when all threads reach the barrier; atomic
+
+  /** The partition run by the calling thread, during Run. */
+  static __thread Partition *m_current;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -32,6 +32,7 @@
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -40,6 +41,7 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <string.h>
 
 namespace ns3 {
 
@@ -47,11 +49,14 @@ NS_LOG_COMPONENT_DEFINE ("NullMessageMpiInterface");
 
 /**
  * maximum MPI message size for easy
- * buffer creation
+ * buffer creation: a Null Message with a batch of packets
  */
-#ifdef NS3_MPI
-const uint32_t NULL_MESSAGE_MAX_MPI_MSG_SIZE = 2000;
-#endif
+const uint32_t NULL_MESSAGE_MAX_MPI_MSG_SIZE = 65536;
+
+/**
+ * size of the guarantee time at the start of each message
+ */
+const uint32_t NULL_MESSAGE_HEADER_SIZE = sizeof (uint64_t);
 
 NullMessageSentBuffer::NullMessageSentBuffer ()
 {
@@ -88,6 +93,8 @@ uint32_t              NullMessageMpiInterface::g_numNeighbors = 0;
 bool                  NullMessageMpiInterface::g_initialized = false;
 bool                  NullMessageMpiInterface::g_enabled = false;
 std::list<NullMessageSentBuffer> NullMessageMpiInterface::g_pendingTx;
+MpiPacketBatch*       NullMessageMpiInterface::g_batches = 0;
+MpiFlushPolicy        NullMessageMpiInterface::g_flushPolicy (NULL_MESSAGE_MAX_MPI_MSG_SIZE);
 
 MPI_Request* NullMessageMpiInterface::g_requests;
 char**       NullMessageMpiInterface::g_pRxBuffers;
@@ -190,6 +197,12 @@ NullMessageMpiInterface::InitializeSendReceiveBuffers(void)
           ++index;
         }
     }
+
+  g_batches = new MpiPacketBatch[g_size];
+  for (uint32_t rank = 0; rank < g_size; ++rank)
+    {
+      g_batches[rank].SetHeaderSize (NULL_MESSAGE_HEADER_SIZE);
+    }
 #endif
 }
 
@@ -206,32 +219,23 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  NullMessageSentBuffer sendBuf;
-  g_pendingTx.push_back (sendBuf);
-  std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
-
-  uint32_t serializedSize = p->GetSerializedSize ();
-  uint32_t bufferSize = serializedSize + ( 2 * sizeof (uint64_t) ) + ( 2 * sizeof (uint32_t) );
-  uint8_t* buffer =  new uint8_t[bufferSize];
-  iter->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t t = rxTime.GetInteger ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-
-  Time guarantee_update = NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId);
-  *pTime++ = guarantee_update.GetTimeStep ();
-
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
-
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (iter->GetRequest ()));
-
-  NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
+  uint32_t recordSize = MpiPacketBatch::GetRecordSize (p);
+  NS_ABORT_MSG_IF (NULL_MESSAGE_HEADER_SIZE + recordSize > NULL_MESSAGE_MAX_MPI_MSG_SIZE,
+                   "Packet too large for an MPI message: " << recordSize);
+  MpiPacketBatch &batch = g_batches[nodeSysId];
+  if (batch.GetSize () + recordSize > NULL_MESSAGE_MAX_MPI_MSG_SIZE)
+    {
+      Flush (nodeSysId, NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId));
+      NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
+      g_flushPolicy.NotifyEarlyFlush ();
+    }
+  batch.Add (p, rxTime.GetInteger (), node, dev);
+  if (batch.GetSize () >= g_flushPolicy.GetFlushSize ())
+    {
+      Flush (nodeSysId, NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId));
+      NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
+      g_flushPolicy.NotifyEarlyFlush ();
+    }
 
 #endif
 }
@@ -244,30 +248,53 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
   NS_ASSERT (g_enabled);
 
 #ifdef NS3_MPI
+  Flush (bundle->GetSystemId (), guarantee_update);
+#endif
+}
+
+void
+NullMessageMpiInterface::Flush (uint32_t rank, const Time& guarantee_update)
+{
+  NS_LOG_FUNCTION (rank << guarantee_update.GetTimeStep ());
 
+#ifdef NS3_MPI
   NullMessageSentBuffer sendBuf;
   g_pendingTx.push_back (sendBuf);
   std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
 
-  uint32_t bufferSize = 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t);
-  uint8_t* buffer =  new uint8_t[bufferSize];
+  uint32_t bufferSize;
+  uint8_t* buffer = g_batches[rank].Detach (bufferSize);
   iter->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = 0;
-  *pTime++ = guarantee_update.GetInteger ();
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = 0;
-  *pData++ = 0;
-
-  // Find the system id for the destination MPI rank
-  uint32_t nodeSysId = bundle->GetSystemId ();
-
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
+  // Add the guarantee time
+  uint64_t guarantee = guarantee_update.GetInteger ();
+  memcpy (buffer, &guarantee, sizeof (guarantee));
+
+  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, rank,
              0, MPI_COMM_WORLD, (iter->GetRequest ()));
 #endif
 }
 
+void
+NullMessageMpiInterface::FlushSendBuffers ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  NS_ASSERT (g_enabled);
+
+#ifdef NS3_MPI
+  for (uint32_t rank = 0; rank < g_size; ++rank)
+    {
+      if (g_batches[rank].GetNPackets () > 0)
+        {
+          g_flushPolicy.NotifySyncFlush (g_batches[rank].GetSize ());
+          Flush (rank, NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (rank));
+          NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (rank);
+        }
+    }
+  g_flushPolicy.NotifySync ();
+#endif
+}
+
 void
 NullMessageMpiInterface::ReceiveMessagesBlocking ()
 {
@@ -327,23 +354,22 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
           int count;
           MPI_Get_count (&status, MPI_CHAR, &count);
 
-          // Get the meta data first
-          uint64_t* pTime = reinterpret_cast<uint64_t *> (g_pRxBuffers[index]);
-          uint64_t time = *pTime++;
-          uint64_t guaranteeUpdate = *pTime++;
+          // Get the guarantee time first
+          uint64_t guaranteeUpdate;
+          memcpy (&guaranteeUpdate, g_pRxBuffers[index], sizeof (guaranteeUpdate));
 
-          uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-          uint32_t node = *pData++;
-          uint32_t dev  = *pData++;
-
-          Time rxTime (time);
-
-          // rxtime == 0 means this is a Null Message
-          if (rxTime > Time (0))
+          // Schedule the rx event of each packet of the batch
+          const uint8_t* pData = reinterpret_cast<uint8_t *> (g_pRxBuffers[index]) + sizeof (guaranteeUpdate);
+          const uint8_t* pEnd = reinterpret_cast<uint8_t *> (g_pRxBuffers[index]) + count;
+          while (pData < pEnd)
             {
-              count -= sizeof (time) + sizeof (guaranteeUpdate) + sizeof (node) + sizeof (dev);
+              uint64_t time;
+              uint32_t node;
+              uint32_t dev;
+              Ptr<Packet> p;
+              pData = MpiPacketBatch::Read (pData, pEnd, time, node, dev, p);
 
-              Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+              Time rxTime (time);
 
               // Find the correct node/device to schedule receive event
               Ptr<Node> pNode = NodeList::GetNode (node);
@@ -363,7 +389,6 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
               // Schedule the rx event
               Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
                                               &MpiReceiver::Receive, pMpiRec, p);
-
             }
 
           // Update guarantee time for both packet receives and Null Messages.
@@ -444,6 +469,8 @@ NullMessageMpiInterface::Disable ()
         }
       delete [] g_pRxBuffers;
       delete [] g_requests;
+      delete [] g_batches;
+      g_batches = 0;
 
       g_pendingTx.clear ();
 
@@ -23,6 +23,7 @@
 #define NS3_NULLMESSAGE_MPI_INTERFACE_H
 
 #include "parallel-communication-interface.h"
+#include "mpi-packet-batch.h"
 
 #include <ns3/nstime.h>
 #include <ns3/buffer.h>
@@ -128,16 +129,14 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device.
+   * Serialize a packet for the specified node and net device, in the
+   * batch of the rank of the node.  The batch is sent with the next
+   * Null Message to that rank, when it reaches the flush size of the
+   * MpiFlushPolicy, or by FlushSendBuffers.
    *
    * \internal
-   * The MPI buffer format packs a delivery information and the serialized packet.
-   *
-   * uint64_t time the packed should be delivered
-   * uint64_t guarantee time for the Null Message algorithm.
-   * uint32_t node id of destination
-   * unit32_t dev id on destination
-   * uint8_t[] serialized packet
+   * The MPI buffer format is the guarantee time for the Null Message
+   * algorithm, followed by the records of the batch (see MpiPacketBatch).
    */
   virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
   /**
@@ -152,17 +151,13 @@ public:
    *
    * Null Messages are sent when a packet has not been sent across
    * this bundle in order to allow time advancement on the remote
-   * MPI task.
+   * MPI task.  The packets batched for the remote task are sent
+   * with the Null Message.
    *
    * \internal
-   * The Null Message MPI buffer format is based on the format for sending a packet with
-   * several fields set to 0 to signal that it is a Null Message.  Overloading the normal packet
-   * format simplifies receive logic.
+   * A Null Message is a packet message without any packet record:
    *
-   * uint64_t 0 must be zero for Null Message
    * uint64_t guarantee time
-   * uint32_t 0 must be zero for Null Message
-   * uint32_t 0 must be zero for Null Message
    */
   static void SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle);
   /**
@@ -175,6 +170,11 @@ public:
    * has been received.
    */
   static void ReceiveMessagesBlocking ();
+  /**
+   * Send the batches of all the ranks, with a guarantee time; called
+   * before blocking for messages from the other ranks.
+   */
+  static void FlushSendBuffers ();
   /**
    * Check for completed sends
    */
@@ -198,6 +198,13 @@ private:
    * receive all messages that are queued up locally.
    */
   static void ReceiveMessages (bool blocking = false);
+  /**
+   * Send the batch of a rank, with a guarantee time.
+   *
+   * \param rank the destination rank
+   * \param guaranteeUpdate the guarantee time
+   */
+  static void Flush (uint32_t rank, const Time& guaranteeUpdate);
 
   // System ID (rank) for this task
   static uint32_t g_sid;
@@ -219,6 +226,12 @@ private:
 
   // List of pending non-blocking sends
   static std::list<NullMessageSentBuffer> g_pendingTx;
+
+  // Packets not yet sent, by destination rank
+  static MpiPacketBatch* g_batches;
+
+  // When to send the batches
+  static MpiFlushPolicy g_flushPolicy;
 };
 
 } // namespace ns3
@@ -342,6 +342,9 @@ NullMessageSimulatorImpl::HandleArrivingMessagesBlocking (void)
 {
   NS_LOG_FUNCTION (this);
 
+  // Send the batched packets, which the other tasks may be waiting for
+  NullMessageMpiInterface::FlushSendBuffers ();
+
   NullMessageMpiInterface::ReceiveMessagesBlocking ();
 
   CalculateSafeTime ();
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_SPSC_QUEUE_H
+#define NS3_SPSC_QUEUE_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief An unbounded lock-free queue with a single producer thread and
+ * a single consumer thread
+ *
+ * Items are stored in blocks of BLOCK_SIZE items, linked in a list.
+ * The producer fills the last block and publishes each item with a
+ * release store of the number of items written in the block; the
+ * consumer reads that number with an acquire load, and frees each block
+ * once it has read all its items and the producer has linked the next
+ * one.  Push never blocks, so a producer cannot deadlock with a
+ * consumer which waits for it elsewhere (e.g. at a barrier).
+ *
+ * The producer and consumer indexes are kept on separate cache lines.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  SpscQueue ();
+  ~SpscQueue ();
+
+  /**
+   * Append an item; called by the producer thread only.
+   *
+   * \param item the item
+   */
+  void Push (const T &item);
+  /**
+   * Remove the first item; called by the consumer thread only.
+   *
+   * \param item the item, if any
+   * \return true if an item was removed, false if the queue was empty
+   */
+  bool Pop (T &item);
+
+private:
+  /** Number of items in a block. */
+  static const uint32_t BLOCK_SIZE = 254;
+
+  /** A block of items. */
+  struct Block
+  {
+    Block ();
+    T items[BLOCK_SIZE];   //!< the items
+    uint32_t written;      //!< number of items published by the producer
+    Block *next;           //!< the next block, linked by the producer
+  };
+
+  Block *m_head;           //!< the block read by the consumer
+  uint32_t m_headIndex;    //!< the index of the next item to read in m_head
+  char m_pad[64];          //!< keep the producer fields on another cache line
+  Block *m_tail;           //!< the block filled by the producer
+  uint32_t m_tailIndex;    //!< the number of items written in m_tail
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+SpscQueue<T>::Block::Block ()
+  : written (0),
+    next (0)
+{
+}
+
+template <typename T>
+SpscQueue<T>::SpscQueue ()
+  : m_headIndex (0),
+    m_tailIndex (0)
+{
+  m_head = new Block ();
+  m_tail = m_head;
+}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue ()
+{
+  while (m_head != 0)
+    {
+      Block *next = m_head->next;
+      delete m_head;
+      m_head = next;
+    }
+}
+
+template <typename T>
+void
+SpscQueue<T>::Push (const T &item)
+{
+  if (m_tailIndex == BLOCK_SIZE)
+    {
+      Block *block = new Block ();
+      __atomic_store_n (&m_tail->next, block, __ATOMIC_RELEASE);
+      m_tail = block;
+      m_tailIndex = 0;
+    }
+  m_tail->items[m_tailIndex] = item;
+  m_tailIndex++;
+  __atomic_store_n (&m_tail->written, m_tailIndex, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+bool
+SpscQueue<T>::Pop (T &item)
+{
+  while (true)
+    {
+      uint32_t written = __atomic_load_n (&m_head->written, __ATOMIC_ACQUIRE);
+      if (m_headIndex < written)
+        {
+          item = m_head->items[m_headIndex];
+          m_headIndex++;
+          return true;
+        }
+      if (m_headIndex < BLOCK_SIZE)
+        {
+          return false;
+        }
+      Block *next = __atomic_load_n (&m_head->next, __ATOMIC_ACQUIRE);
+      if (next == 0)
+        {
+          return false;
+        }
+      delete m_head;
+      m_head = next;
+      m_headIndex = 0;
+    }
+}
+
+} // namespace ns3
+
+#endif /* NS3_SPSC_QUEUE_H */
@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/mpi-packet-batch.h"
+#include "ns3/packet.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace ns3;
+
+class MpiPacketBatchTestCase : public TestCase
+{
+public:
+  MpiPacketBatchTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MpiPacketBatchTestCase::MpiPacketBatchTestCase ()
+  : TestCase ("Check that a batch of packets is read back from its message")
+{
+}
+
+void
+MpiPacketBatchTestCase::DoRun (void)
+{
+  MpiPacketBatch batch;
+  batch.SetHeaderSize (8);
+  NS_TEST_EXPECT_MSG_EQ (batch.GetSize (), 8, "an empty batch holds the header");
+
+  // Packets of increasing sizes, filled with their index, so that the
+  // batch grows its buffer several times
+  std::vector<Ptr<Packet> > packets;
+  uint32_t size = 8;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      std::vector<uint8_t> data (100 * i + 1, i);
+      Ptr<Packet> p = Create<Packet> (&data[0], data.size ());
+      packets.push_back (p);
+      size += MpiPacketBatch::GetRecordSize (p);
+      batch.Add (p, 1000000 + i, i, 2 * i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (batch.GetNPackets (), 20, "wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (batch.GetSize (), size, "wrong message size");
+
+  uint32_t messageSize;
+  uint8_t *message = batch.Detach (messageSize);
+  NS_TEST_EXPECT_MSG_EQ (messageSize, size, "wrong message size");
+  NS_TEST_EXPECT_MSG_EQ (batch.GetNPackets (), 0, "the batch should be empty");
+  NS_TEST_EXPECT_MSG_EQ (batch.GetSize (), 8, "an empty batch holds the header");
+
+  const uint8_t *record = message + 8;
+  const uint8_t *end = message + messageSize;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      NS_TEST_ASSERT_MSG_LT (record, end, "missing record " << i);
+      uint64_t rxTime;
+      uint32_t node;
+      uint32_t dev;
+      Ptr<Packet> p;
+      record = MpiPacketBatch::Read (record, end, rxTime, node, dev, p);
+      NS_TEST_EXPECT_MSG_EQ (rxTime, 1000000 + i, "wrong time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (node, i, "wrong node of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (dev, 2 * i, "wrong device of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), packets[i]->GetSize (), "wrong size of record " << i);
+      std::vector<uint8_t> data (p->GetSize ());
+      p->CopyData (&data[0], data.size ());
+      NS_TEST_EXPECT_MSG_EQ ((data == std::vector<uint8_t> (data.size (), i)), true, "wrong data of record " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ ((record == end), true, "extra bytes in the message");
+  delete [] message;
+
+  // A header-only message, e.g. a Null Message
+  message = batch.Detach (messageSize);
+  NS_TEST_EXPECT_MSG_EQ (messageSize, 8, "wrong message size");
+  delete [] message;
+}
+
+class MpiFlushPolicyTestCase : public TestCase
+{
+public:
+  MpiFlushPolicyTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MpiFlushPolicyTestCase::MpiFlushPolicyTestCase ()
+  : TestCase ("Check the adaptation of the flush size")
+{
+}
+
+void
+MpiFlushPolicyTestCase::DoRun (void)
+{
+  MpiFlushPolicy policy (65536);
+  NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), 16384, "wrong initial flush size");
+
+  // Mostly early flushes: larger batches, up to the maximum
+  for (uint32_t size = 32768; size <= 65536; size *= 2)
+    {
+      policy.NotifyEarlyFlush ();
+      policy.NotifyEarlyFlush ();
+      policy.NotifySyncFlush (1000);
+      policy.NotifySync ();
+      NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), size, "the flush size should grow");
+    }
+  policy.NotifyEarlyFlush ();
+  policy.NotifyEarlyFlush ();
+  policy.NotifySync ();
+  NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), 65536, "the flush size should stay at the maximum");
+
+  // As many early flushes as flushes at the synchronization point
+  policy.NotifyEarlyFlush ();
+  policy.NotifySyncFlush (60000);
+  policy.NotifySync ();
+  NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), 65536, "the flush size should not change");
+
+  // Nothing sent: no information
+  policy.NotifySync ();
+  NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), 65536, "the flush size should not change");
+
+  // Small batches at the synchronization points: smaller batches, down
+  // to the minimum
+  for (uint32_t size = 32768; size >= MpiFlushPolicy::MIN_FLUSH_SIZE; size /= 2)
+    {
+      policy.NotifySyncFlush (100);
+      policy.NotifySync ();
+      NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), size, "the flush size should shrink");
+    }
+  policy.NotifySyncFlush (100);
+  policy.NotifySync ();
+  NS_TEST_EXPECT_MSG_EQ (policy.GetFlushSize (), 4096, "the flush size should stay at the minimum");
+}
+
+class MpiPacketBatchTestSuite : public TestSuite
+{
+public:
+  MpiPacketBatchTestSuite ()
+    : TestSuite ("mpi-packet-batch", UNIT)
+  {
+    AddTestCase (new MpiPacketBatchTestCase (), TestCase::QUICK);
+    AddTestCase (new MpiFlushPolicyTestCase (), TestCase::QUICK);
+  }
+} g_mpiPacketBatchTestSuite;
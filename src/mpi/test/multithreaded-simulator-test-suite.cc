@@ -0,0 +1,270 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/spsc-queue.h"
+#include "ns3/simulator.h"
+#include "ns3/system-thread.h"
+#include "ns3/node.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+class SpscQueueTestCase : public TestCase
+{
+public:
+  SpscQueueTestCase ();
+private:
+  virtual void DoRun (void);
+  void Produce (void);
+
+  SpscQueue<uint32_t> m_queue;
+};
+
+SpscQueueTestCase::SpscQueueTestCase ()
+  : TestCase ("Check the order of the items of a SpscQueue shared by two threads")
+{
+}
+
+void
+SpscQueueTestCase::Produce (void)
+{
+  for (uint32_t i = 0; i < 1000000; i++)
+    {
+      m_queue.Push (i);
+    }
+}
+
+void
+SpscQueueTestCase::DoRun (void)
+{
+  uint32_t item;
+  NS_TEST_ASSERT_MSG_EQ (m_queue.Pop (item), false, "the queue should be empty");
+
+  Ptr<SystemThread> producer = Create<SystemThread> (MakeCallback (&SpscQueueTestCase::Produce, this));
+  producer->Start ();
+  uint32_t expected = 0;
+  uint32_t errors = 0;
+  while (expected < 1000000)
+    {
+      if (m_queue.Pop (item))
+        {
+          if (item != expected)
+            {
+              errors++;
+            }
+          expected++;
+        }
+    }
+  producer->Join ();
+  NS_TEST_EXPECT_MSG_EQ (errors, 0, "items popped out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Pop (item), false, "the queue should be empty");
+}
+
+
+/**
+ * Tokens hop between the nodes of a ring partitioned over several
+ * threads; each hop also schedules, and sometimes cancels, a local
+ * timer.  The times of the events of each node must be the same as with
+ * the DefaultSimulatorImpl.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase ();
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Run the scenario with a simulator implementation.
+   * \param type the SimulatorImplementationType
+   */
+  void RunScenario (std::string type);
+  /**
+   * Receive a token, and send it to another node.
+   * \param node the node id
+   */
+  void Hop (uint32_t node);
+  /**
+   * A local timer expires.
+   * \param node the node id
+   */
+  void Timer (uint32_t node);
+  /**
+   * \param node the node id
+   * \return the next pseudo-random number of the node
+   */
+  uint32_t Rand (uint32_t node);
+
+  static const uint32_t N_NODES = 8;
+  static const uint32_t N_PARTITIONS = 4;
+
+  std::vector<std::vector<uint64_t> > m_hops;    //!< hop times, by node
+  std::vector<std::vector<uint64_t> > m_timers;  //!< timer times, by node
+  std::vector<uint32_t> m_seed;                  //!< random state, by node
+  std::vector<uint32_t> m_errors;                //!< context errors, by node
+  bool m_multithreaded;                          //!< checks the partitions if true
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase ()
+  : TestCase ("Check that MultithreadedSimulatorImpl runs the events of the default simulator")
+{
+}
+
+uint32_t
+MultithreadedSimulatorTestCase::Rand (uint32_t node)
+{
+  m_seed[node] = m_seed[node] * 1103515245 + 12345;
+  return m_seed[node] >> 8;
+}
+
+void
+MultithreadedSimulatorTestCase::Hop (uint32_t node)
+{
+  // Each vector element is only accessed by the thread of its node
+  m_hops[node].push_back (Simulator::Now ().GetTimeStep ());
+  if (Simulator::GetContext () != node
+      || (m_multithreaded && Simulator::GetSystemId () != node % N_PARTITIONS))
+    {
+      m_errors[node]++;
+    }
+  uint32_t r = Rand (node);
+  uint32_t dst = (node + 1 + r % (N_NODES - 1)) % N_NODES;
+  Time delay = MilliSeconds (1) + NanoSeconds (r % 1000000);
+  Simulator::ScheduleWithContext (dst, delay, &MultithreadedSimulatorTestCase::Hop, this, dst);
+
+  EventId timer = Simulator::Schedule (NanoSeconds (r % 5000), &MultithreadedSimulatorTestCase::Timer, this, node);
+  if (r & 1)
+    {
+      Simulator::Cancel (timer);
+      if (!Simulator::IsExpired (timer))
+        {
+          m_errors[node]++;
+        }
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::Timer (uint32_t node)
+{
+  m_timers[node].push_back (Simulator::Now ().GetTimeStep ());
+  if (Simulator::GetContext () != node)
+    {
+      m_errors[node]++;
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::RunScenario (std::string type)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (type));
+  m_multithreaded = type == "ns3::MultithreadedSimulatorImpl";
+  m_hops.assign (N_NODES, std::vector<uint64_t> ());
+  m_timers.assign (N_NODES, std::vector<uint64_t> ());
+  m_errors.assign (N_NODES, 0);
+  m_seed.clear ();
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      m_seed.push_back (i + 1);
+    }
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> (i % N_PARTITIONS));
+    }
+  // A ring, whose every link crosses partitions
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+      for (uint32_t j = i; j <= i + 1; j++)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          nodes[j % N_NODES]->AddDevice (device);
+          device->SetChannel (channel);
+        }
+    }
+
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i), &MultithreadedSimulatorTestCase::Hop, this, i);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  if (m_multithreaded)
+    {
+      Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+      NS_TEST_ASSERT_MSG_NE (impl, 0, "wrong simulator implementation");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), N_PARTITIONS, "wrong number of partitions");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MilliSeconds (1), "wrong lookahead");
+    }
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0, "wrong context of the events of node " << i);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  RunScenario ("ns3::DefaultSimulatorImpl");
+  std::vector<std::vector<uint64_t> > hops = m_hops;
+  std::vector<std::vector<uint64_t> > timers = m_timers;
+
+  RunScenario ("ns3::MultithreadedSimulatorImpl");
+  uint32_t nHops = 0;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nHops += hops[i].size ();
+      NS_TEST_EXPECT_MSG_EQ (m_hops[i].size (), hops[i].size (), "wrong number of hops at node " << i);
+      NS_TEST_EXPECT_MSG_EQ ((m_hops[i] == hops[i]), true, "wrong hop times at node " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_timers[i].size (), timers[i].size (), "wrong number of timers at node " << i);
+      NS_TEST_EXPECT_MSG_EQ ((m_timers[i] == timers[i]), true, "wrong timer times at node " << i);
+    }
+  NS_TEST_EXPECT_MSG_GT (nHops, 4000, "too few hops to test anything");
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator", UNIT)
+  {
+    AddTestCase (new SpscQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/partition-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Link two nodes with a SimpleChannel.
+ * \param a the first node
+ * \param b the second node
+ * \param delay the delay of the channel
+ */
+static void
+Connect (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (delay));
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  a->AddDevice (device);
+  device->SetChannel (channel);
+  device = CreateObject<SimpleNetDevice> ();
+  b->AddDevice (device);
+  device->SetChannel (channel);
+}
+
+class PartitionHelperClustersTestCase : public TestCase
+{
+public:
+  PartitionHelperClustersTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PartitionHelperClustersTestCase::PartitionHelperClustersTestCase ()
+  : TestCase ("Check that the partition cuts the links of largest delay")
+{
+}
+
+void
+PartitionHelperClustersTestCase::DoRun (void)
+{
+  // Two rings of four nodes, with short links (one of them without any
+  // delay), joined by two long links.
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Connect (nodes[i], nodes[(i + 1) % 4], i == 2 ? Seconds (0) : MicroSeconds (10));
+      Connect (nodes[4 + i], nodes[4 + (i + 1) % 4], MicroSeconds (20));
+    }
+  Connect (nodes[0], nodes[4], MilliSeconds (10));
+  Connect (nodes[2], nodes[6], MilliSeconds (5));
+
+  PartitionHelper helper;
+  helper.Assign (2);
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookahead (), MilliSeconds (5), "wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetCutSize (), 2, "wrong number of cut links");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetImbalance (), 0, "the partitions should have the same load");
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (nodes[i]->GetSystemId (), nodes[i / 4 * 4]->GetSystemId (),
+                             "node " << i << " is not with its ring");
+    }
+  NS_TEST_EXPECT_MSG_NE (nodes[0]->GetSystemId (), nodes[4]->GetSystemId (), "the rings are not split");
+
+  // Only the short links can be cut into four balanced partitions
+  std::vector<uint32_t> part = helper.Partition (4);
+  NS_TEST_EXPECT_MSG_EQ (part.size (), 8, "wrong number of nodes");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookahead (), MicroSeconds (10), "wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ ((part[2] == part[3]), true, "a link without delay is cut");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (helper.GetImbalance (), 0.1, "the partitions are not balanced");
+
+  Simulator::Destroy ();
+}
+
+class PartitionHelperRingTestCase : public TestCase
+{
+public:
+  PartitionHelperRingTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PartitionHelperRingTestCase::PartitionHelperRingTestCase ()
+  : TestCase ("Check that a uniform ring is split into contiguous balanced partitions")
+{
+}
+
+void
+PartitionHelperRingTestCase::DoRun (void)
+{
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+    }
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      Connect (nodes[i], nodes[(i + 1) % 16], MilliSeconds (1));
+    }
+
+  PartitionHelper helper;
+  std::vector<uint32_t> part = helper.Partition (4);
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookahead (), MilliSeconds (1), "wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetCutSize (), 4, "the partitions are not contiguous");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetImbalance (), 0, "the partitions should have the same load");
+  std::vector<uint32_t> count (4, 0);
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      NS_TEST_ASSERT_MSG_LT (part[i], 4, "wrong partition");
+      count[part[i]]++;
+    }
+  for (uint32_t k = 0; k < 4; k++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (count[k], 4, "wrong number of nodes in partition " << k);
+    }
+
+  // Nothing to cut in a single partition
+  part = helper.Partition (1);
+  NS_TEST_EXPECT_MSG_EQ (helper.GetCutSize (), 0, "no link should be cut");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLookahead (), Time::Max (), "wrong lookahead");
+
+  Simulator::Destroy ();
+}
+
+class PartitionHelperTestSuite : public TestSuite
+{
+public:
+  PartitionHelperTestSuite ()
+    : TestSuite ("partition-helper", UNIT)
+  {
+    AddTestCase (new PartitionHelperClustersTestCase (), TestCase::QUICK);
+    AddTestCase (new PartitionHelperRingTestCase (), TestCase::QUICK);
+  }
+} g_partitionHelperTestSuite;
@@ -28,10 +28,20 @@
 
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <map>
 
 using namespace ns3;
 
+static std::ofstream g_arrivalTrace;
+
+// Write the packets offered to the bottleneck queue, for utils/red-replay.cc
+static void
+TraceArrival (Ptr<const Packet> p)
+{
+  g_arrivalTrace << Simulator::Now ().GetSeconds () << " " << p->GetSize () << std::endl;
+}
+
 int main (int argc, char *argv[])
 {
   uint32_t    nLeaf = 10;
@@ -45,6 +55,7 @@ int main (int argc, char *argv[])
   uint16_t port = 5001;
   std::string bottleNeckLinkBw = "1Mbps";
   std::string bottleNeckLinkDelay = "50ms";
+  std::string arrivalTrace;
 
   CommandLine cmd;
   cmd.AddValue ("nLeaf",     "Number of left and right side leaf nodes", nLeaf);
@@ -56,6 +67,7 @@ int main (int argc, char *argv[])
 
   cmd.AddValue ("redMinTh", "RED queue minimum threshold", minTh);
   cmd.AddValue ("redMaxTh", "RED queue maximum threshold", maxTh);
+  cmd.AddValue ("arrivalTrace", "File to write the packets offered to the bottleneck queue to", arrivalTrace);
   cmd.Parse (argc,argv);
 
   if ((queueType != "RED") && (queueType != "ARED"))
@@ -143,6 +155,17 @@ int main (int argc, char *argv[])
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
+  if (!arrivalTrace.empty ())
+    {
+      // The data packets flow from the right to the left router; every
+      // packet is either enqueued or dropped by the queue
+      g_arrivalTrace.open (arrivalTrace.c_str ());
+      g_arrivalTrace << std::setprecision (12);
+      Ptr<PointToPointNetDevice> dev = DynamicCast<PointToPointNetDevice> (d.GetRight ()->GetDevice (0));
+      dev->GetQueue ()->TraceConnectWithoutContext ("Enqueue", MakeCallback (&TraceArrival));
+      dev->GetQueue ()->TraceConnectWithoutContext ("Drop", MakeCallback (&TraceArrival));
+    }
+
   std::cout << "Running the simulation" << std::endl;
   Simulator::Run ();
 
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "thread-free-list.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -51,47 +52,15 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+bool Buffer::g_scatterGather = false;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
 uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
+  Buffer::FreeList::Clear ();
 }
 
 void
@@ -99,19 +68,16 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  // g_maxSize only grows: a lost update among threads is harmless
+  uint32_t maxSize = __atomic_load_n (&g_maxSize, __ATOMIC_RELAXED);
+  if (data->m_size > maxSize)
     {
-      Buffer::Deallocate (data);
+      __atomic_store_n (&g_maxSize, data->m_size, __ATOMIC_RELAXED);
     }
-  else
+  /* feed into free list */
+  if (data->m_size < maxSize || !FreeList::Push (data))
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      Buffer::Deallocate (data);
     }
 }
 
@@ -120,25 +86,17 @@ Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
   /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
+  struct Buffer::Data *data;
+  while ((data = FreeList::Pop ()) != 0)
     {
-      while (!g_freeList->empty ()) 
+      if (data->m_size >= dataSize) 
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
+          data->m_count = 1;
+          return data;
         }
+      Buffer::Deallocate (data);
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
+  data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
@@ -185,19 +143,259 @@ Buffer::Deallocate (struct Buffer::Data *data)
   delete [] buf;
 }
 
+void
+Buffer::EnableScatterGather (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_scatterGather = true;
+}
+
+void
+Buffer::DisableScatterGather (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_scatterGather = false;
+}
+
+struct Buffer::Segments *
+Buffer::CreateSegments (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (capacity);
+  NS_ASSERT (capacity >= 1);
+  uint32_t size = sizeof (struct Buffer::Segments) + (capacity - 1) * sizeof (struct Buffer::Segment);
+  uint8_t *b = new uint8_t [size];
+  struct Buffer::Segments *segments = reinterpret_cast<struct Buffer::Segments *> (b);
+  segments->m_count = 1;
+  segments->m_n = 0;
+  segments->m_capacity = capacity;
+  return segments;
+}
+
+void
+Buffer::DeallocateSegments (struct Buffer::Segments *segments)
+{
+  NS_LOG_FUNCTION (segments);
+  NS_ASSERT (segments->m_count == 0);
+  for (uint32_t i = 0; i < segments->m_n; i++)
+    {
+      struct Buffer::Data *data = segments->m_segments[i].m_data;
+      if (data != 0)
+        {
+          data->m_count--;
+          if (data->m_count == 0)
+            {
+              Recycle (data);
+            }
+        }
+    }
+  uint8_t *buf = reinterpret_cast<uint8_t *> (segments);
+  delete [] buf;
+}
+
+void
+Buffer::AppendSegment (struct Buffer::Segments **segments,
+                       struct Buffer::Data *data, uint32_t start, uint32_t size)
+{
+  NS_LOG_FUNCTION (segments << data << start << size);
+  struct Buffer::Segments *list = *segments;
+  NS_ASSERT (list->m_count == 1);
+  if (size == 0)
+    {
+      return;
+    }
+  uint32_t end = 0;
+  if (list->m_n != 0)
+    {
+      struct Buffer::Segment *last = &list->m_segments[list->m_n - 1];
+      uint32_t lastStart = list->m_n == 1 ? 0 : list->m_segments[list->m_n - 2].m_end;
+      if (last->m_data == data
+          && (data == 0 || last->m_start + last->m_end - lastStart == start))
+        {
+          // The new segment follows the last one: merge them
+          last->m_end += size;
+          return;
+        }
+      end = last->m_end;
+    }
+  if (list->m_n == list->m_capacity)
+    {
+      struct Buffer::Segments *bigger = CreateSegments (2 * list->m_capacity);
+      memcpy (bigger->m_segments, list->m_segments, list->m_n * sizeof (struct Buffer::Segment));
+      bigger->m_n = list->m_n;
+      uint8_t *buf = reinterpret_cast<uint8_t *> (list);
+      delete [] buf;
+      list = bigger;
+      *segments = list;
+    }
+  struct Buffer::Segment *segment = &list->m_segments[list->m_n];
+  segment->m_data = data;
+  segment->m_start = start;
+  segment->m_end = end + size;
+  list->m_n++;
+  if (data != 0)
+    {
+      data->m_count++;
+    }
+}
+
+uint32_t
+Buffer::FindSegment (const struct Buffer::Segments *segments, uint32_t offset)
+{
+  NS_LOG_FUNCTION (segments << offset);
+  // find the first segment which ends after offset
+  uint32_t low = 0;
+  uint32_t high = segments->m_n - 1;
+  while (low < high)
+    {
+      uint32_t middle = (low + high) / 2;
+      if (segments->m_segments[middle].m_end > offset)
+        {
+          high = middle;
+        }
+      else
+        {
+          low = middle + 1;
+        }
+    }
+  NS_ASSERT (offset < segments->m_segments[low].m_end);
+  return low;
+}
+
+const uint8_t *
+Buffer::PeekSegments (const struct Buffer::Segments *segments,
+                      uint32_t offset, uint32_t *size)
+{
+  NS_LOG_FUNCTION (segments << offset << size);
+  uint32_t i = FindSegment (segments, offset);
+  const struct Buffer::Segment *segment = &segments->m_segments[i];
+  *size = std::min (*size, segment->m_end - offset);
+  if (segment->m_data == 0)
+    {
+      *size = std::min (*size, g_zeroes.size);
+      return reinterpret_cast<const uint8_t *> (g_zeroes.buffer);
+    }
+  uint32_t segmentStart = i == 0 ? 0 : segments->m_segments[i - 1].m_end;
+  return segment->m_data->m_data + segment->m_start + (offset - segmentStart);
+}
+
+void
+Buffer::CopySegments (const struct Buffer::Segments *segments,
+                      uint32_t offset, uint8_t *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (segments << offset << &buffer << size);
+  if (segments == 0)
+    {
+      memset (buffer, 0, size);
+      return;
+    }
+  while (size > 0)
+    {
+      uint32_t n = size;
+      const uint8_t *from = PeekSegments (segments, offset, &n);
+      memcpy (buffer, from, n);
+      offset += n;
+      buffer += n;
+      size -= n;
+    }
+}
+
+void
+Buffer::AppendTo (struct Buffer::Segments **segments, uint32_t start, uint32_t end) const
+{
+  NS_LOG_FUNCTION (this << segments << start << end);
+  NS_ASSERT (start <= end && end <= GetSize ());
+  uint32_t zeroStart = m_zeroAreaStart - m_start;
+  uint32_t zeroEnd = m_zeroAreaEnd - m_start;
+  if (start < zeroStart && start < end)
+    {
+      // bytes before the virtual area
+      uint32_t n = std::min (end, zeroStart) - start;
+      AppendSegment (segments, m_data, m_start + start, n);
+      start += n;
+    }
+  if (start < zeroEnd && start < end)
+    {
+      // bytes of the virtual area
+      uint32_t n = std::min (end, zeroEnd) - start;
+      if (m_segments == 0)
+        {
+          AppendSegment (segments, 0, 0, n);
+        }
+      else
+        {
+          uint32_t offset = m_segmentsStart + start - zeroStart;
+          uint32_t left = n;
+          for (uint32_t i = FindSegment (m_segments, offset); left > 0; i++)
+            {
+              const struct Buffer::Segment *segment = &m_segments->m_segments[i];
+              uint32_t segmentStart = i == 0 ? 0 : m_segments->m_segments[i - 1].m_end;
+              uint32_t size = std::min (left, segment->m_end - offset);
+              uint32_t dataStart = segment->m_data == 0 ? 0 : segment->m_start + offset - segmentStart;
+              AppendSegment (segments, segment->m_data, dataStart, size);
+              offset += size;
+              left -= size;
+            }
+        }
+      start += n;
+    }
+  if (start < end)
+    {
+      // bytes after the virtual area
+      AppendSegment (segments, m_data, m_zeroAreaStart + start - zeroEnd, end - start);
+    }
+}
+
+Buffer
+Buffer::CreateFromSegments (struct Buffer::Segments *segments)
+{
+  NS_LOG_FUNCTION (segments);
+  uint32_t size = segments->m_n == 0 ? 0 : segments->m_segments[segments->m_n - 1].m_end;
+  Buffer tmp (size);
+  if (size == 0)
+    {
+      segments->m_count--;
+      DeallocateSegments (segments);
+      return tmp;
+    }
+  tmp.m_segments = segments;
+  tmp.m_segmentsStart = 0;
+  return tmp;
+}
+
+void
+Buffer::ReleaseSegments (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_segments != 0)
+    {
+      m_segments->m_count--;
+      if (m_segments->m_count == 0)
+        {
+          DeallocateSegments (m_segments);
+        }
+      m_segments = 0;
+    }
+}
+
 Buffer::Buffer ()
+  : m_segments (0),
+    m_segmentsStart (0)
 {
   NS_LOG_FUNCTION (this);
   Initialize (0);
 }
 
 Buffer::Buffer (uint32_t dataSize)
+  : m_segments (0),
+    m_segmentsStart (0)
 {
   NS_LOG_FUNCTION (this << dataSize);
   Initialize (dataSize);
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_segments (0),
+    m_segmentsStart (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -225,8 +423,12 @@ Buffer::CheckInternalState (void) const
   bool internalSizeOk = m_end - (m_zeroAreaEnd - m_zeroAreaStart) <= m_data->m_size &&
     m_start <= m_data->m_size &&
     m_zeroAreaStart <= m_data->m_size;
+  bool segmentsOk = m_segments == 0 ||
+    (m_segments->m_count > 0 &&
+     m_segments->m_n > 0 &&
+     m_segmentsStart + m_zeroAreaEnd - m_zeroAreaStart <= m_segments->m_segments[m_segments->m_n - 1].m_end);
 
-  bool ok = m_data->m_count > 0 && offsetsOk && dirtyOk && internalSizeOk;
+  bool ok = m_data->m_count > 0 && offsetsOk && dirtyOk && internalSizeOk && segmentsOk;
   if (!ok)
     {
       LOG_INTERNAL_STATE ("check " << this << 
@@ -245,7 +447,28 @@ Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
   m_data = Buffer::Create (0);
-  m_start = std::min (m_data->m_size, g_recommendedStart);
+  m_start = std::min (m_data->m_size, __atomic_load_n (&g_recommendedStart, __ATOMIC_RELAXED));
+  m_maxZeroAreaStart = m_start;
+  m_zeroAreaStart = m_start;
+  m_zeroAreaEnd = m_zeroAreaStart + zeroSize;
+  m_end = m_zeroAreaEnd;
+  m_data->m_dirtyStart = m_start;
+  m_data->m_dirtyEnd = m_end;
+  NS_ASSERT (CheckInternalState ());
+}
+
+void
+Buffer::Reset (uint32_t zeroSize)
+{
+  NS_LOG_FUNCTION (this << zeroSize);
+  ReleaseSegments ();
+  if (m_data->m_count != 1)
+    {
+      // The other buffers keep the shared data
+      m_data->m_count--;
+      m_data = Buffer::Create (0);
+    }
+  m_start = std::min (m_data->m_size, __atomic_load_n (&g_recommendedStart, __ATOMIC_RELAXED));
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
   m_zeroAreaEnd = m_zeroAreaStart + zeroSize;
@@ -270,7 +493,20 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (m_segments != o.m_segments)
+    {
+      ReleaseSegments ();
+      m_segments = o.m_segments;
+      if (m_segments != 0)
+        {
+          m_segments->m_count++;
+        }
+    }
+  m_segmentsStart = o.m_segmentsStart;
+  if (m_maxZeroAreaStart > __atomic_load_n (&g_recommendedStart, __ATOMIC_RELAXED))
+    {
+      __atomic_store_n (&g_recommendedStart, m_maxZeroAreaStart, __ATOMIC_RELAXED);
+    }
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -284,12 +520,16 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (m_maxZeroAreaStart > __atomic_load_n (&g_recommendedStart, __ATOMIC_RELAXED))
+    {
+      __atomic_store_n (&g_recommendedStart, m_maxZeroAreaStart, __ATOMIC_RELAXED);
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
       Recycle (m_data);
     }
+  ReleaseSegments ();
 }
 
 uint32_t
@@ -400,11 +640,51 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
+  if (g_scatterGather &&
+      (m_segments != 0 || o.m_segments != 0 ||
+       o.GetInternalSize () >= SCATTER_GATHER_MIN_SIZE))
+    {
+      if (m_start == m_zeroAreaStart &&
+          m_end == m_zeroAreaEnd &&
+          m_data->m_count == 1 &&
+          m_segments != 0 &&
+          m_segments->m_count == 1 &&
+          m_segmentsStart + m_zeroAreaEnd - m_zeroAreaStart == m_segments->m_segments[m_segments->m_n - 1].m_end &&
+          &o != this)
+        {
+          /**
+           * This buffer is made of the segments of its own list: 
+           * append the segments of the other buffer to it.
+           */
+          uint32_t size = o.GetSize ();
+          o.AppendTo (&m_segments, 0, size);
+          m_zeroAreaEnd += size;
+          m_end = m_zeroAreaEnd;
+          m_data->m_dirtyEnd = m_zeroAreaEnd;
+          NS_ASSERT (CheckInternalState ());
+          return;
+        }
+      /**
+       * Refer to the bytes of both buffers from a new buffer,
+       * instead of copying them.
+       */
+      uint32_t n = 4;
+      n += m_segments == 0 ? 0 : m_segments->m_n;
+      n += o.m_segments == 0 ? 0 : o.m_segments->m_n;
+      struct Buffer::Segments *segments = CreateSegments (n);
+      AppendTo (&segments, 0, GetSize ());
+      o.AppendTo (&segments, 0, o.GetSize ());
+      *this = CreateFromSegments (segments);
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
   if (m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
+      m_segments == 0 &&
       o.m_start == o.m_zeroAreaStart &&
-      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
+      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0 &&
+      o.m_segments == 0)
     {
       /**
        * This is an optimization which kicks in when
@@ -457,6 +737,7 @@ Buffer::RemoveAtStart (uint32_t start)
       m_start = m_zeroAreaStart;
       m_zeroAreaEnd -= delta;
       m_end -= delta;
+      m_segmentsStart += delta;
     } 
   else if (newStart <= m_end)
     {
@@ -478,6 +759,10 @@ Buffer::RemoveAtStart (uint32_t start)
       m_zeroAreaEnd = m_end;
       m_zeroAreaStart = m_end;
     }
+  if (m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ReleaseSegments ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem start=" << start << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -513,6 +798,10 @@ Buffer::RemoveAtEnd (uint32_t end)
       m_zeroAreaEnd = m_start;
       m_zeroAreaStart = m_start;
     }
+  if (m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ReleaseSegments ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem end=" << end << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -523,6 +812,30 @@ Buffer::CreateFragment (uint32_t start, uint32_t length) const
 {
   NS_LOG_FUNCTION (this << start << length);
   NS_ASSERT (CheckInternalState ());
+  if (g_scatterGather)
+    {
+      // The bytes of the fragment which are not in the virtual area
+      // would be copied when a header is added to it.
+      uint32_t end = start + length;
+      uint32_t zeroStart = m_zeroAreaStart - m_start;
+      uint32_t zeroEnd = m_zeroAreaEnd - m_start;
+      uint32_t realSize = 0;
+      if (start < zeroStart)
+        {
+          realSize += std::min (end, zeroStart) - start;
+        }
+      if (end > zeroEnd)
+        {
+          realSize += end - std::max (start, zeroEnd);
+        }
+      if (realSize >= SCATTER_GATHER_MIN_SIZE)
+        {
+          uint32_t n = 2 + (m_segments == 0 ? 1 : m_segments->m_n);
+          struct Buffer::Segments *segments = CreateSegments (n);
+          AppendTo (&segments, start, end);
+          return CreateFromSegments (segments);
+        }
+    }
   Buffer tmp = *this;
   tmp.RemoveAtStart (start);
   tmp.RemoveAtEnd (GetSize () - (start + length));
@@ -539,7 +852,15 @@ Buffer::CreateFullCopy (void) const
     {
       Buffer tmp;
       tmp.AddAtStart (m_zeroAreaEnd - m_zeroAreaStart);
-      tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+      if (m_segments == 0)
+        {
+          tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+        }
+      else
+        {
+          CopySegments (m_segments, m_segmentsStart,
+                        tmp.m_data->m_data + tmp.m_start, m_zeroAreaEnd - m_zeroAreaStart);
+        }
       uint32_t dataStart = m_zeroAreaStart - m_start;
       tmp.AddAtStart (dataStart);
       tmp.Begin ().Write (m_data->m_data+m_start, dataStart);
@@ -559,6 +880,11 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_segments != 0)
+    {
+      // Only the size of a virtual area of zeroes is serialized
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,6 +905,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_segments != 0)
+    {
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -711,6 +1041,32 @@ Buffer::PeekData (void) const
   return m_data->m_data + m_start;
 }
 
+uint8_t *
+Buffer::PeekWritableData (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (CheckInternalState ());
+  NS_ASSERT (m_start + size <= m_zeroAreaStart);
+  if (m_data->m_count > 1)
+    {
+      /* The data is shared: detach from the other buffers. 
+       * Only the bytes which are really stored are copied;
+       * the zero area stays virtual.
+       */
+      struct Buffer::Data *newData = Buffer::Create (m_data->m_size);
+      memcpy (newData->m_data + m_start, m_data->m_data + m_start, GetInternalEnd () - m_start);
+      m_data->m_count--;
+      m_data = newData;
+
+      // update dirty area
+      m_data->m_dirtyStart = m_start;
+      m_data->m_dirtyEnd = m_end;
+    }
+  LOG_INTERNAL_STATE ("peek writable size=" << size << ", ");
+  NS_ASSERT (CheckInternalState ());
+  return m_data->m_data + m_start;
+}
+
 void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
@@ -724,10 +1080,17 @@ Buffer::CopyData (std::ostream *os, uint32_t size) const
           size -= m_zeroAreaStart-m_start;
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
           uint32_t left = tmpsize;
+          uint32_t offset = m_segmentsStart;
           while (left > 0)
             {
               uint32_t toWrite = std::min (left, g_zeroes.size);
-              os->write (g_zeroes.buffer, toWrite);
+              const char *from = g_zeroes.buffer;
+              if (m_segments != 0)
+                {
+                  from = reinterpret_cast<const char *> (PeekSegments (m_segments, offset, &toWrite));
+                  offset += toWrite;
+                }
+              os->write (from, toWrite);
               left -= toWrite;
             }
           if (size > tmpsize)
@@ -754,14 +1117,8 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
       if (size > 0) 
         { 
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              memcpy (buffer, g_zeroes.buffer, toWrite);
-              left -= toWrite;
-              buffer += toWrite;
-            }
+          CopySegments (m_segments, m_segmentsStart, buffer, tmpsize);
+          buffer += tmpsize;
           size -= tmpsize;
           if (size > 0)
             {
@@ -854,7 +1211,8 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      CopySegments (start.m_segments, start.m_segmentsStart + start.m_current - start.m_zeroStart,
+                    &m_data[m_current], toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
@@ -1015,6 +1373,13 @@ Buffer::Iterator::ReadU64 (void)
 
   return data;
 }
+uint8_t
+Buffer::Iterator::SlowPeekU8 (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = 1;
+  return *PeekSegments (m_segments, m_segmentsStart + m_current - m_zeroStart, &size);
+}
 uint16_t 
 Buffer::Iterator::SlowReadNtohU16 (void)
 {
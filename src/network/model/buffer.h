@@ -29,6 +29,9 @@
 
 namespace ns3 {
 
+template <typename T, void (*Deallocate)(T *)>
+class ThreadFreeList;
+
 /**
  * \ingroup packet
  *
@@ -88,9 +91,22 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * When the scatter-gather mode is enabled (see EnableScatterGather),
+ * the virtual area can hold the bytes of other buffers instead of
+ * zeroes: it then refers to a list of Buffer::Segment, each of which
+ * is a range of the bytes written in a BufferData, or a range of
+ * zeroes.  The list, and the BufferData it refers to, are shared by
+ * reference counting.  The bytes of the virtual area cannot be
+ * written, so the segments never change: AddAtEnd (Buffer const &)
+ * and CreateFragment build such a list instead of copying the bytes
+ * of large payloads, and the new buffer gets a BufferData of its own,
+ * in which the headers and trailers added later are written.
  */
 class Buffer 
 {
+private:
+  struct Segments;
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -432,6 +448,14 @@ private:
      * \warning this is the slow version, please use ReadNtohU32 (void)
      */
     uint32_t SlowReadNtohU32 (void);
+    /**
+     * \return the byte of the segments of the "virtual zero area"
+     * at the current position.
+     *
+     * \warning this is the slow version of PeekU8 (void), for the
+     * buffers whose virtual area refers to segments.
+     */
+    uint8_t SlowPeekU8 (void);
     /**
      * \brief Returns an appropriate message indicating a read error
      * \returns the error message
@@ -476,6 +500,14 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the segments of the "virtual zero area", or 0 if it holds zeroes.
+     */
+    const struct Segments *m_segments;
+    /**
+     * offset in the segments of the start of the "virtual zero area".
+     */
+    uint32_t m_segmentsStart;
   };
 
   /**
@@ -494,6 +526,37 @@ private:
    */
   uint8_t const*PeekData (void) const;
 
+  /**
+   * \param size the number of bytes, counted from the start of the
+   *        buffer, which the caller intends to modify.
+   * \return a pointer to the start of the internal byte buffer, which
+   *         may be written to for at most \p size bytes.
+   *
+   * This allows a field of an already-serialized header to be changed
+   * in place.  If the internal byte buffer is shared with other
+   * buffers, it is first copied so that the modification is not
+   * visible from them.  The modified bytes must not overlap the
+   * virtual zero area, i.e., they must have been written by a header.
+   */
+  uint8_t *PeekWritableData (uint32_t size);
+
+  /**
+   * \param zeroSize the size of the new virtual zero area
+   *
+   * Make this Buffer equivalent to Buffer (zeroSize), but keep its
+   * internal byte buffer if it is not shared with other buffers,
+   * instead of releasing it and taking another one.  Any Iterator
+   * pointing to this Buffer is invalidated.
+   */
+  void Reset (uint32_t zeroSize);
+
+  /**
+   * \return true if the internal byte buffer of this Buffer is shared
+   *         with other buffers, e.g., with the buffers of the copies
+   *         of a packet.
+   */
+  inline bool IsShared (void) const;
+
   /**
    * \param start size to reserve
    *
@@ -504,6 +567,24 @@ private:
    * pointing to this Buffer.
    */
   void AddAtStart (uint32_t start);
+  /**
+   * \param start size to reserve
+   * \return a pointer to the bytes added at the start of the Buffer.
+   *
+   * Same as AddAtStart, but return a pointer through which the
+   * \p start new bytes can be written directly, e.g., to serialize a
+   * header without an Iterator.
+   */
+  inline uint8_t *AddAtStartRaw (uint32_t start);
+  /**
+   * \param size the number of bytes to peek at
+   * \return a pointer to the first \p size bytes of the Buffer, or 0
+   *         if they are not all stored contiguously.
+   *
+   * Unlike PeekData, this never copies the Buffer: the bytes of the
+   * virtual zero area are not stored, hence the 0.
+   */
+  inline const uint8_t *PeekStart (uint32_t size) const;
   /**
    * \param end size to reserve
    *
@@ -636,6 +717,25 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief Enable the scatter-gather mode.
+   *
+   * In this mode, AddAtEnd (Buffer const &) and CreateFragment refer
+   * to the bytes of the original buffers, which are shared by reference
+   * counting, instead of copying them, when there are at least
+   * SCATTER_GATHER_MIN_SIZE of them.  This saves the copies of real
+   * payloads through fragmentation and reassembly, at the cost of
+   * slower reads of these payloads by the Iterator.
+   */
+  static void EnableScatterGather (void);
+  /**
+   * \brief Disable the scatter-gather mode.
+   *
+   * The buffers built in scatter-gather mode keep referring to the
+   * bytes of other buffers, but new ones will not.
+   */
+  static void DisableScatterGather (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -679,6 +779,63 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * A range of the bytes written in a BufferData, or of zeroes,
+   * which is part of the "virtual zero area" of a buffer.
+   */
+  struct Segment
+  {
+    /**
+     * the BufferData which holds the bytes, or 0 for zeroes.
+     * The segment holds a reference to the BufferData.
+     */
+    struct Data *m_data;
+    /**
+     * offset from the start of m_data->m_data to the first byte
+     * of the segment.
+     */
+    uint32_t m_start;
+    /**
+     * offset from the start of the list to the end of the segment,
+     * i.e., the sum of the sizes of this segment and of the segments
+     * which come before it.
+     */
+    uint32_t m_end;
+  };
+
+  /**
+   * A list of segments, shared by the buffers which refer to it.
+   * This data structure is variable-sized through its last member
+   * whose size is determined at allocation time and stored in the
+   * m_capacity field.
+   */
+  struct Segments
+  {
+    /**
+     * The reference count of an instance of this data structure.
+     * Each buffer which references an instance holds a count.
+     */
+    uint32_t m_count;
+    /**
+     * the number of segments in the m_segments field below.
+     */
+    uint32_t m_n;
+    /**
+     * the size of the m_segments field below.
+     */
+    uint32_t m_capacity;
+    /**
+     * The segments, in order.
+     */
+    struct Segment m_segments[1];
+  };
+
+  /**
+   * The smallest number of bytes which a scatter-gather buffer refers
+   * to instead of copying them.
+   */
+  static const uint32_t SCATTER_GATHER_MIN_SIZE = 256;
+
   /**
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
@@ -743,6 +900,74 @@ private:
    */
   static void Deallocate (struct Buffer::Data *data);
 
+  /**
+   * \brief Create an empty list of segments
+   * \param capacity the number of segments the list can hold
+   * \returns a list referenced once
+   */
+  static struct Buffer::Segments *CreateSegments (uint32_t capacity);
+  /**
+   * \brief Release the data of a list of segments and delete it
+   * \param segments the list, which is not referenced anymore
+   */
+  static void DeallocateSegments (struct Buffer::Segments *segments);
+  /**
+   * \brief Append a segment to a list
+   *
+   * The segment is merged into the last one when it follows it.
+   *
+   * \param [in,out] segments the list, referenced only by the caller,
+   *        which is reallocated when it is full
+   * \param data the data of the segment, or 0 for zeroes
+   * \param start the offset of the segment in the data
+   * \param size the size of the segment
+   */
+  static void AppendSegment (struct Buffer::Segments **segments,
+                             struct Buffer::Data *data, uint32_t start, uint32_t size);
+  /**
+   * \brief Find the segment of a list which holds the byte at an offset
+   * \param segments the list
+   * \param offset the offset of the byte in the list
+   * \returns the index of the segment
+   */
+  static uint32_t FindSegment (const struct Buffer::Segments *segments, uint32_t offset);
+  /**
+   * \brief Find the bytes of a list of segments at an offset
+   * \param segments the list
+   * \param offset the offset of the first byte in the list
+   * \param [in,out] size the number of bytes wanted, reduced to the
+   *        number of bytes available at the returned address
+   * \returns the address of the bytes
+   */
+  static const uint8_t *PeekSegments (const struct Buffer::Segments *segments,
+                                      uint32_t offset, uint32_t *size);
+  /**
+   * \brief Copy bytes of a list of segments
+   * \param segments the list, or 0 for zeroes
+   * \param offset the offset of the first byte in the list
+   * \param buffer the output buffer
+   * \param size the number of bytes to copy
+   */
+  static void CopySegments (const struct Buffer::Segments *segments,
+                            uint32_t offset, uint8_t *buffer, uint32_t size);
+  /**
+   * \brief Append the segments which refer to a range of this buffer
+   * \param [in,out] segments the list, referenced only by the caller
+   * \param start the offset of the range from the start of the buffer
+   * \param end the offset of the end of the range
+   */
+  void AppendTo (struct Buffer::Segments **segments, uint32_t start, uint32_t end) const;
+  /**
+   * \brief Create a buffer whose "virtual zero area" refers to segments
+   * \param segments the list, whose reference goes to the buffer
+   * \returns the buffer
+   */
+  static Buffer CreateFromSegments (struct Buffer::Segments *segments);
+  /**
+   * \brief Release the segments of the "virtual zero area", if any
+   */
+  void ReleaseSegments (void);
+
   struct Data *m_data; //!< the buffer data storage
 
   /**
@@ -759,7 +984,8 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. It is shared by all the threads, which access it with
+   * relaxed atomic operations.
    */
   static uint32_t g_recommendedStart;
 
@@ -783,17 +1009,28 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
+  /**
+   * the segments of the virtual zero area, or 0 if it holds zeroes
+   */
+  struct Segments *m_segments;
+  /**
+   * offset in m_segments of the start of the virtual zero area
+   */
+  uint32_t m_segmentsStart;
+  /**
+   * true if the scatter-gather mode is enabled
+   */
+  static bool g_scatterGather;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
+  /// Free buffer data, cached by thread
+  typedef ThreadFreeList<struct Buffer::Data, &Buffer::Deallocate> FreeList;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
   static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
@@ -811,7 +1048,9 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_segments (0),
+    m_segmentsStart (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -833,6 +1072,8 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_segments = buffer->m_segments;
+  m_segmentsStart = buffer->m_segmentsStart;
 }
 
 void 
@@ -1002,7 +1243,11 @@ Buffer::Iterator::PeekU8 (void)
     }
   else if (m_current < m_zeroEnd)
     {
-      return 0;
+      if (m_segments == 0)
+        {
+          return 0;
+        }
+      return SlowPeekU8 ();
     }
   else
     {
@@ -1047,18 +1292,47 @@ Buffer::Buffer (Buffer const&o)
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
     m_start (o.m_start),
-    m_end (o.m_end)
+    m_end (o.m_end),
+    m_segments (o.m_segments),
+    m_segmentsStart (o.m_segmentsStart)
 {
   m_data->m_count++;
+  if (m_segments != 0)
+    {
+      m_segments->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
+uint8_t *
+Buffer::AddAtStartRaw (uint32_t start)
+{
+  AddAtStart (start);
+  return m_data->m_data + m_start;
+}
+
+const uint8_t *
+Buffer::PeekStart (uint32_t size) const
+{
+  if (m_start + size <= m_zeroAreaStart)
+    {
+      return m_data->m_data + m_start;
+    }
+  return 0;
+}
+
 uint32_t 
 Buffer::GetSize (void) const
 {
   return m_end - m_start;
 }
 
+bool
+Buffer::IsShared (void) const
+{
+  return m_data->m_count != 1;
+}
+
 Buffer::Iterator 
 Buffer::Begin (void) const
 {
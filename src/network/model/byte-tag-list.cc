@@ -18,12 +18,12 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "thread-free-list.h"
 #include "ns3/log.h"
 #include <vector>
 #include <cstring>
 
 #define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
 namespace ns3 {
@@ -45,30 +45,40 @@ struct ByteTagListData {
 };
 
 #ifdef USE_FREE_LIST
+namespace {
+
+/**
+ * \ingroup packet
+ * \brief Release the memory of a ByteTagListData
+ * \param data the ByteTagListData
+ */
+void
+DeleteByteTagListData (struct ByteTagListData *data)
+{
+  uint8_t *buffer = (uint8_t *)data;
+  delete [] buffer;
+}
+
+} // anonymous namespace
+
+/// Free ByteTagListData, cached by thread
+typedef ThreadFreeList<struct ByteTagListData, &DeleteByteTagListData> ByteTagListDataFreeList;
+
 /**
  * \ingroup packet
  *
- * \brief Container class for struct ByteTagListData
+ * \brief Release the free ByteTagListData at the end of the program
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static struct ByteTagListDataFreeListDestructor
 {
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
+  ~ByteTagListDataFreeListDestructor ()
+  {
+    ByteTagListDataFreeList::Clear ();
+  }
+} g_freeListDestructor; //!< Release the free ByteTagListData
 static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
-
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
-}
 #endif /* USE_FREE_LIST */
 
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
@@ -344,22 +354,20 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  struct ByteTagListData *data;
+  while ((data = ByteTagListDataFreeList::Pop ()) != 0)
     {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
       if (data->size >= size)
         {
           data->count = 1;
           data->dirty = 0;
           return data;
         }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+      DeleteByteTagListData (data);
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  uint32_t maxSize = __atomic_load_n (&g_maxSize, __ATOMIC_RELAXED);
+  uint8_t *buffer = new uint8_t [std::max (size, maxSize) + sizeof (struct ByteTagListData) - 4];
+  data = (struct ByteTagListData *)buffer;
   data->count = 1;
   data->size = size;
   data->dirty = 0;
@@ -374,19 +382,19 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
+  // g_maxSize only grows: a lost update among threads is harmless
+  uint32_t maxSize = __atomic_load_n (&g_maxSize, __ATOMIC_RELAXED);
+  if (data->size > maxSize)
+    {
+      __atomic_store_n (&g_maxSize, data->size, __ATOMIC_RELAXED);
+    }
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
-        {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
-        }
-      else
+      if (data->size < maxSize ||
+          !ByteTagListDataFreeList::Push (data))
         {
-          g_freeList.push_back (data);
+          DeleteByteTagListData (data);
         }
     }
 }
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FIXED_SIZE_HEADER_H
+#define FIXED_SIZE_HEADER_H
+
+#include "header.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::FixedSizeHeader declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Base class of the headers whose serialized size is known at
+ *        compile time
+ *
+ * Packet::AddHeader, Packet::RemoveHeader and Packet::PeekHeader have
+ * overloads for the subclasses of this class, which are selected when
+ * they are called with the type of the header itself, rather than with
+ * a Header reference.  These overloads call the non-virtual SerializeTo
+ * and DeserializeFrom methods of the header on the bytes of the packet
+ * directly, instead of going through a Buffer::Iterator.
+ *
+ * A subclass T passes itself and its serialized size N as template
+ * arguments, and implements:
+ * \code
+ *   void SerializeTo (uint8_t *buffer) const;
+ *   uint32_t DeserializeFrom (const uint8_t *buffer);
+ * \endcode
+ * SerializeTo writes exactly N bytes.  DeserializeFrom reads at most N
+ * bytes and returns the number of bytes of the header, or 0 if the
+ * header needs more than the N bytes, in which case the packet uses
+ * the virtual Deserialize method instead.  The virtual methods of
+ * Header are implemented here on top of these two methods; a subclass
+ * may override them, as long as they serialize the same bytes.
+ *
+ * The static methods below store and load the fields in network byte
+ * order with unaligned word accesses.
+ *
+ * \tparam T The type of the header.
+ * \tparam N The serialized size of the header.
+ */
+template <typename T, uint32_t N>
+class FixedSizeHeader : public Header
+{
+public:
+  /** The serialized size of the header. */
+  static const uint32_t SERIALIZED_SIZE = N;
+
+  // Inherited from Header
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+protected:
+  /**
+   * \param [out] buffer Where to write.
+   * \param [in] data The value to write in network byte order.
+   */
+  static void WriteHtonU16 (uint8_t *buffer, uint16_t data);
+  /**
+   * \param [out] buffer Where to write.
+   * \param [in] data The value to write in network byte order.
+   */
+  static void WriteHtonU32 (uint8_t *buffer, uint32_t data);
+  /**
+   * \param [in] buffer Where to read.
+   * \returns The value read in network byte order.
+   */
+  static uint16_t ReadNtohU16 (const uint8_t *buffer);
+  /**
+   * \param [in] buffer Where to read.
+   * \returns The value read in network byte order.
+   */
+  static uint32_t ReadNtohU32 (const uint8_t *buffer);
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T, uint32_t N>
+const uint32_t FixedSizeHeader<T, N>::SERIALIZED_SIZE;
+
+template <typename T, uint32_t N>
+uint32_t
+FixedSizeHeader<T, N>::GetSerializedSize (void) const
+{
+  return N;
+}
+
+template <typename T, uint32_t N>
+void
+FixedSizeHeader<T, N>::Serialize (Buffer::Iterator start) const
+{
+  uint8_t buffer[N];
+  static_cast<const T *> (this)->SerializeTo (buffer);
+  start.Write (buffer, N);
+}
+
+template <typename T, uint32_t N>
+uint32_t
+FixedSizeHeader<T, N>::Deserialize (Buffer::Iterator start)
+{
+  uint8_t buffer[N];
+  start.Read (buffer, N);
+  return static_cast<T *> (this)->DeserializeFrom (buffer);
+}
+
+template <typename T, uint32_t N>
+void
+FixedSizeHeader<T, N>::WriteHtonU16 (uint8_t *buffer, uint16_t data)
+{
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  data = __builtin_bswap16 (data);
+  memcpy (buffer, &data, 2);
+#else
+  buffer[0] = (data >> 8) & 0xff;
+  buffer[1] = data & 0xff;
+#endif
+}
+
+template <typename T, uint32_t N>
+void
+FixedSizeHeader<T, N>::WriteHtonU32 (uint8_t *buffer, uint32_t data)
+{
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  data = __builtin_bswap32 (data);
+  memcpy (buffer, &data, 4);
+#else
+  buffer[0] = (data >> 24) & 0xff;
+  buffer[1] = (data >> 16) & 0xff;
+  buffer[2] = (data >> 8) & 0xff;
+  buffer[3] = data & 0xff;
+#endif
+}
+
+template <typename T, uint32_t N>
+uint16_t
+FixedSizeHeader<T, N>::ReadNtohU16 (const uint8_t *buffer)
+{
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint16_t data;
+  memcpy (&data, buffer, 2);
+  return __builtin_bswap16 (data);
+#else
+  return (buffer[0] << 8) | buffer[1];
+#endif
+}
+
+template <typename T, uint32_t N>
+uint32_t
+FixedSizeHeader<T, N>::ReadNtohU32 (const uint8_t *buffer)
+{
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint32_t data;
+  memcpy (&data, buffer, 4);
+  return __builtin_bswap32 (data);
+#else
+  return (static_cast<uint32_t> (buffer[0]) << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+#endif
+}
+
+} // namespace ns3
+
+#endif /* FIXED_SIZE_HEADER_H */
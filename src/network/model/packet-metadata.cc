@@ -23,6 +23,7 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "packet-metadata.h"
+#include "thread-free-list.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -36,15 +37,12 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+struct PacketMetadata::LocalStaticDestructor PacketMetadata::m_localStaticDestructor;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
+PacketMetadata::LocalStaticDestructor::~LocalStaticDestructor ()
 {
   NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
+  PacketMetadata::DataFreeList::Clear ();
   PacketMetadata::m_enable = false;
 }
 
@@ -571,26 +569,28 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
+  // m_maxSize only grows: a lost update among threads is harmless
+  uint32_t maxSize = __atomic_load_n (&m_maxSize, __ATOMIC_RELAXED);
+  NS_LOG_LOGIC ("create size="<<size<<", max="<<maxSize);
+  if (size > maxSize)
     {
-      m_maxSize = size;
+      maxSize = size;
+      __atomic_store_n (&m_maxSize, maxSize, __ATOMIC_RELAXED);
     }
-  while (!m_freeList.empty ()) 
+  struct PacketMetadata::Data *data;
+  while ((data = DataFreeList::Pop ()) != 0)
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
       if (data->m_size >= size) 
         {
           NS_LOG_LOGIC ("create found size="<<data->m_size);
           data->m_count = 1;
           return data;
         }
-      PacketMetadata::Deallocate (data);
       NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
+      PacketMetadata::Deallocate (data);
     }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  NS_LOG_LOGIC ("create alloc size="<<maxSize);
+  return PacketMetadata::Allocate (maxSize);
 }
 
 void
@@ -602,16 +602,12 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
       PacketMetadata::Deallocate (data);
       return;
     } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+  if (data->m_size < __atomic_load_n (&m_maxSize, __ATOMIC_RELAXED) ||
+      !DataFreeList::Push (data))
     {
       PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
     }
 }
 
@@ -655,8 +651,14 @@ void
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
+  AddHeader (header.GetInstanceTypeId (), size);
+}
+void
+PacketMetadata::AddHeader (TypeId tid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << tid << size);
   NS_ASSERT (IsStateOk ());
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  uint32_t uid = tid.GetUid () << 1;
   DoAddHeader (uid, size);
   NS_ASSERT (IsStateOk ());
 }
@@ -675,16 +677,21 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
+  RemoveHeader (header.GetInstanceTypeId (), size);
+}
+void 
+PacketMetadata::RemoveHeader (TypeId tid, uint32_t size)
+{
+  uint32_t uid = tid.GetUid () << 1;
+  NS_LOG_FUNCTION (this << tid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -744,8 +751,7 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
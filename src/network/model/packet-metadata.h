@@ -30,6 +30,9 @@
 
 namespace ns3 {
 
+template <typename T, void (*Deallocate)(T *)>
+class ThreadFreeList;
+
 class Chunk;
 class Buffer;
 class Header;
@@ -185,12 +188,24 @@ private:
    * \param size header serialized size
    */
   void AddHeader (Header const &header, uint32_t size);
+  /**
+   * \brief Add an header
+   * \param tid the TypeId of the header to add
+   * \param size header serialized size
+   */
+  void AddHeader (TypeId tid, uint32_t size);
   /**
    * \brief Remove an header
    * \param header header to remove
    * \param size header serialized size
    */
   void RemoveHeader (Header const &header, uint32_t size);
+  /**
+   * \brief Remove an header
+   * \param tid the TypeId of the header to remove
+   * \param size header serialized size
+   */
+  void RemoveHeader (TypeId tid, uint32_t size);
 
   /**
    * Add a trailer
@@ -492,15 +507,13 @@ private:
   };
 
   /**
-   * \brief Class to hold all the metadata
+   * \brief Release the free metadata storage at the end of the program
    */
-  class DataFreeList : public std::vector<struct Data *>
+  struct LocalStaticDestructor
   {
-public:
-    ~DataFreeList ();
+    ~LocalStaticDestructor ();
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -656,7 +669,9 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  /// Free metadata storage, cached by thread
+  typedef ThreadFreeList<struct PacketMetadata::Data, &PacketMetadata::Deallocate> DataFreeList;
+  static struct LocalStaticDestructor m_localStaticDestructor; //!< Local static destructor
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -26,6 +26,7 @@
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "thread-free-list.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
@@ -34,6 +35,44 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+struct PacketTagList::LocalStaticDestructor PacketTagList::g_localStaticDestructor;
+
+PacketTagList::LocalStaticDestructor::~LocalStaticDestructor (void)
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList::FreeList::Clear ();
+}
+
+struct PacketTagList::TagData *
+PacketTagList::CreateTagData (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  struct TagData *data = FreeList::Pop ();
+  if (data == 0)
+    {
+      data = new struct TagData ();
+    }
+  return data;
+}
+
+void
+PacketTagList::RecycleTagData (struct TagData *data)
+{
+  NS_LOG_FUNCTION (data);
+  NS_ASSERT (data->count == 0);
+  if (!FreeList::Push (data))
+    {
+      DeallocateTagData (data);
+    }
+}
+
+void
+PacketTagList::DeallocateTagData (struct TagData *data)
+{
+  NS_LOG_FUNCTION (data);
+  delete data;
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -133,7 +172,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
       NS_ASSERT (cur != 0);
       NS_ASSERT (cur->count > 1);
       cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
+      struct TagData * copy = CreateTagData ();
       copy->tid = cur->tid;
       copy->count = 1;
       memcpy (copy->data, cur->data, TagData::MAX_SIZE);
@@ -157,6 +196,20 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < m_nInline)
+    {
+      NS_LOG_INFO ("found tid in inline tags");
+      tag.Deserialize (TagBuffer (m_inline[i].data,
+                                  m_inline[i].data + TagData::MAX_SIZE));
+      // move the newer inline tags down, to keep them in order
+      m_nInline--;
+      for (; i < m_nInline; i++)
+        {
+          m_inline[i] = m_inline[i + 1];
+        }
+      return true;
+    }
   return COWTraverse (tag, &PacketTagList::RemoveWriter);
 }
 
@@ -176,8 +229,9 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 
   if (preMerge)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      // found tid before first merge, so release cur
+      cur->count = 0;
+      RecycleTagData (cur);
     }
   else
     {
@@ -196,6 +250,14 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < m_nInline)
+    {
+      NS_LOG_INFO ("found tid in inline tags");
+      tag.Serialize (TagBuffer (m_inline[i].data,
+                                m_inline[i].data + tag.GetSerializedSize ()));
+      return true;
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
@@ -225,7 +287,7 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
       // cur is always a merge at this point
       // need to copy, replace, and link past cur
       cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
+      struct TagData * copy = CreateTagData ();
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
       tag.Serialize (TagBuffer (copy->data,
@@ -243,28 +305,50 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
   // ensure this id was not yet added
+  NS_ASSERT (FindInline (tid) == m_nInline);
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
+      NS_ASSERT (cur->tid != tid);
+    }
+  uint32_t size = tag.GetSerializedSize ();
+  NS_ASSERT (size <= TagData::MAX_SIZE);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+
+  // the inline tags are all older than the other tags
+  if (m_nInline < INLINE_SIZE && m_next == 0)
+    {
+      struct InlineTag *inl = &self->m_inline[m_nInline];
+      inl->tid = tid;
+      tag.Serialize (TagBuffer (inl->data, inl->data + size));
+      self->m_nInline++;
+      return;
     }
-  struct TagData * head = new struct TagData ();
+
+  struct TagData * head = CreateTagData ();
   head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
+  tag.Serialize (TagBuffer (head->data, head->data + size));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = FindInline (tid);
+  if (i < m_nInline)
+    {
+      /* found tag */
+      tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inline[i].data),
+                                  const_cast<uint8_t *> (m_inline[i].data) + TagData::MAX_SIZE));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
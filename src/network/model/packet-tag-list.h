@@ -27,12 +27,16 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <cstring>
 #include "ns3/type-id.h"
 
 namespace ns3 {
 
 class Tag;
 
+template <typename T, void (*Deallocate)(T *)>
+class ThreadFreeList;
+
 /**
  * \ingroup packet
  *
@@ -43,7 +47,18 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
+ * The first INLINE_SIZE tags added to a list are stored in the list
+ * itself, as InlineTag's, so that the few tags most packets carry need
+ * no allocation.  The copy constructor and assignment copy them, and
+ * #Remove and #Replace deal with them in place.  The InlineTag's are
+ * kept in the order they were added, oldest first, and are all older
+ * than the other tags: a tag only goes inline when the list holds no
+ * other tag.
+ *
+ * The tags added to a list which already holds INLINE_SIZE tags, or
+ * other tags, are shared by copy-on-write between the copies of the
+ * list.  The
+ * implementation of this sharing is a bit tricky.  Refer to this
  * diagram in the discussion that follows.
  *
  * \dot
@@ -122,7 +137,9 @@ class Tag;
  *
  * \par <b> Memory Management: </b>
  * \n
- * Packet tags must serialize to a finite maximum size, see TagData
+ * Packet tags must serialize to a finite maximum size, see TagData.
+ * The TagData of the released lists are kept in a free list, to be
+ * reused by the next tags.
  *
  * This documentation entitles the original author to a free beer.
  */
@@ -167,6 +184,21 @@ public:
     uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  /**
+   * A tag stored in the PacketTagList itself.
+   */
+  struct InlineTag
+  {
+    uint8_t data[TagData::MAX_SIZE];  /**< Serialization buffer */
+    TypeId tid;                       /**< Type of the tag serialized into #data */
+  };  /* struct InlineTag */
+
+  /** The number of tags stored in the PacketTagList itself. */
+  enum InlineSize_e
+  {
+    INLINE_SIZE = 4           /**< Size of #m_inline */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -176,8 +208,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the InlineTag's of \pname{o}, then points
+   * to the same \ref TagData as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -186,8 +218,10 @@ public:
    * \param [in] o The PacketTagList to copy.
    * \returns the copied object
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the InlineTag's of \pname{o}, then, unless
+   * this list already points to the same \ref TagData as \pname{o},
+   * makes a light-weight copy by #RemoveAll, then pointing to the same
+   * \ref TagData as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
@@ -234,11 +268,49 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to head of the list of TagData
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns the number of InlineTag's
+   */
+  inline uint32_t GetNInlineTags (void) const;
+  /**
+   * \returns pointer to the first of the #GetNInlineTags InlineTag's,
+   *          the oldest one
+   */
+  inline const struct PacketTagList::InlineTag *GetInlineTags (void) const;
 
 private:
+  /**
+   * Find an InlineTag.
+   *
+   * \param [in] tid The type of the tag to find.
+   * \returns The index of the InlineTag of type \pname{tid},
+   *          or #m_nInline if there is none.
+   */
+  inline uint32_t FindInline (TypeId tid) const;
+  /**
+   * Release the TagData up to the first merge.
+   */
+  inline void RemoveAllTagData (void);
+  /**
+   * \returns A TagData from the free list, or a new one.
+   */
+  static struct TagData *CreateTagData (void);
+  /**
+   * Give a TagData to the free list, or delete it if the list is full.
+   *
+   * \param [in] data The TagData, which has no more incoming links.
+   */
+  static void RecycleTagData (struct TagData *data);
+  /**
+   * Delete a TagData.
+   *
+   * \param [in] data The TagData.
+   */
+  static void DeallocateTagData (struct TagData *data);
+
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -291,6 +363,17 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  uint32_t m_nInline;                          //!< Number of #m_inline in use
+  struct InlineTag m_inline[INLINE_SIZE];      //!< The InlineTag's
+
+  /// Free TagData, cached by thread
+  typedef ThreadFreeList<struct TagData, &PacketTagList::DeallocateTagData> FreeList;
+  /// Local static destructor structure
+  struct LocalStaticDestructor
+  {
+    ~LocalStaticDestructor ();
+  };
+  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 };
 
 } // namespace ns3
@@ -302,13 +385,17 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_nInline (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_nInline (o.m_nInline)
 {
+  // A TypeId is a plain 16-bit id, so the InlineTag's are copied as bytes
+  std::memcpy (static_cast<void *> (m_inline), o.m_inline, m_nInline * sizeof (struct InlineTag));
   if (m_next != 0)
     {
       m_next->count++;
@@ -319,11 +406,18 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
+  if (this == &o)
+    {
+      return *this;
+    }
+  m_nInline = o.m_nInline;
+  // A TypeId is a plain 16-bit id, so the InlineTag's are copied as bytes
+  std::memcpy (static_cast<void *> (m_inline), o.m_inline, m_nInline * sizeof (struct InlineTag));
   if (m_next == o.m_next) 
     {
       return *this;
     }
-  RemoveAll ();
+  RemoveAllTagData ();
   m_next = o.m_next;
   if (m_next != 0) 
     {
@@ -334,11 +428,18 @@ PacketTagList::operator = (PacketTagList const &o)
 
 PacketTagList::~PacketTagList ()
 {
-  RemoveAll ();
+  RemoveAllTagData ();
 }
 
 void
 PacketTagList::RemoveAll (void)
+{
+  m_nInline = 0;
+  RemoveAllTagData ();
+}
+
+void
+PacketTagList::RemoveAllTagData (void)
 {
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
@@ -350,17 +451,40 @@ PacketTagList::RemoveAll (void)
         }
       if (prev != 0) 
         {
-	  delete prev;
+          RecycleTagData (prev);
         }
       prev = cur;
     }
   if (prev != 0) 
     {
-      delete prev;
+      RecycleTagData (prev);
     }
   m_next = 0;
 }
 
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  uint32_t i = 0;
+  while (i < m_nInline && m_inline[i].tid != tid)
+    {
+      i++;
+    }
+  return i;
+}
+
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
+const struct PacketTagList::InlineTag *
+PacketTagList::GetInlineTags (void) const
+{
+  return m_inline;
+}
+
 } // namespace ns3
 
 #endif /* PACKET_TAG_LIST_H */
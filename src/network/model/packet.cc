@@ -28,7 +28,45 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+namespace {
+
+/**
+ * The number of uid counters.  The system ids which are equal modulo
+ * UID_COUNTERS share a counter.
+ */
+const uint32_t UID_COUNTERS = 256;
+/** The number of uids which a thread takes at a time from a counter. */
+const uint32_t UID_BLOCK_SIZE = 1024;
+/** The uid counters, by system id: the end of the blocks taken. */
+uint32_t g_uidCounters[UID_COUNTERS];
+/** The system id of the block of uids of the thread. */
+__thread uint32_t t_uidSystemId __attribute__ ((tls_model ("initial-exec"))) = 0;
+/** The next uid of the block of the thread. */
+__thread uint32_t t_nextUid __attribute__ ((tls_model ("initial-exec"))) = 0;
+/** The end of the block of uids of the thread. */
+__thread uint32_t t_endUid __attribute__ ((tls_model ("initial-exec"))) = 0;
+
+} // anonymous namespace
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  /* The upper 32 bits of the packet id in 
+   * metadata is for the system id. For non-
+   * distributed simulations, this is simply 
+   * zero.  The lower 32 bits are for the 
+   * uid counted for this system id.
+   */
+  uint32_t systemId = Simulator::GetSystemId ();
+  if (t_nextUid == t_endUid || systemId != t_uidSystemId)
+    {
+      t_uidSystemId = systemId;
+      t_nextUid = __atomic_fetch_add (&g_uidCounters[systemId % UID_COUNTERS],
+                                      UID_BLOCK_SIZE, __ATOMIC_RELAXED);
+      t_endUid = t_nextUid + UID_BLOCK_SIZE;
+    }
+  return static_cast<uint64_t> (systemId) << 32 | t_nextUid++;
+}
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,39 +119,48 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList &list)
+  : m_inlineBegin (list.GetInlineTags ()),
+    m_inline (list.GetInlineTags () + list.GetNInlineTags ()),
+    m_current (list.Head ())
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != 0 || m_inline != m_inlineBegin;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  // the other tags are newer than the inline tags
+  if (m_current != 0)
+    {
+      const struct PacketTagList::TagData *prev = m_current;
+      m_current = m_current->next;
+      return PacketTagIterator::Item (prev->tid, prev->data);
+    }
+  m_inline--;
+  return PacketTagIterator::Item (m_inline->tid, m_inline->data);
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (TypeId tid, const uint8_t *data)
+  : m_tid (tid),
+    m_data (data)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data
+  NS_ASSERT (tag.GetInstanceTypeId () == m_tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data,
+                              (uint8_t*)m_data
                               + PacketTagList::TagData::MAX_SIZE));
 }
 
@@ -131,16 +178,9 @@ Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -173,16 +213,24 @@ Packet::Packet (uint32_t size)
   : m_buffer (size),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
+}
+void
+Packet::Reset (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_buffer.Reset (size);
+  m_byteTagList.RemoveAll ();
+  m_packetTagList.RemoveAll ();
+  m_metadata = PacketMetadata (AllocateUid (), size);
+  m_nixVector = 0;
+}
+bool
+Packet::IsBufferShared (void) const
+{
+  return m_buffer.IsShared ();
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -199,16 +247,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -362,6 +403,14 @@ Packet::CopyData (std::ostream *os, uint32_t size) const
   return m_buffer.CopyData (os, size);
 }
 
+uint8_t *
+Packet::PeekWritableData (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size <= GetSize ());
+  return m_buffer.PeekWritableData (size);
+}
+
 uint64_t 
 Packet::GetUid (void) const
 {
@@ -543,6 +592,13 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnableScatterGather (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Buffer::EnableScatterGather ();
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
@@ -879,7 +935,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include "buffer.h"
 #include "header.h"
+#include "fixed-size-header.h"
 #include "trailer.h"
 #include "packet-metadata.h"
 #include "tag.h"
@@ -124,7 +125,8 @@ private:
  * \ingroup packet
  * \brief Iterator over the set of packet tags in a packet
  *
- * This is a java-style iterator.
+ * This is a java-style iterator, which returns the most recently
+ * added tags first.
  */
 class PacketTagIterator
 {
@@ -152,10 +154,12 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the ns3::TypeId of the tag.
+     * \param data the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data);
+    TypeId m_tid;                 //!< the ns3::TypeId of the tag
+    const uint8_t *m_data;        //!< the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -169,10 +173,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the list of the items
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList &list);
+  const struct PacketTagList::InlineTag *m_inlineBegin;  //!< first, oldest, inline tag of a packet
+  const struct PacketTagList::InlineTag *m_inline;  //!< end of the inline tags not yet returned
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the other tags of a packet
 };
 
 /**
@@ -327,6 +333,49 @@ public:
    * \returns the number of bytes read from the packet.
    */
   uint32_t PeekHeader (Header &header) const;
+  /**
+   * \brief Add a fixed-size header to this packet.
+   *
+   * This overload is selected for the subclasses of FixedSizeHeader:
+   * it calls FixedSizeHeader::SerializeTo on the bytes of the packet
+   * directly, instead of the virtual Header::Serialize.
+   *
+   * \tparam T The type of the header.
+   * \tparam N The serialized size of the header.
+   * \param header a reference to the header to add to this packet.
+   */
+  template <typename T, uint32_t N>
+  void AddHeader (const FixedSizeHeader<T, N> &header);
+  /**
+   * \brief Deserialize and remove a fixed-size header from the internal buffer.
+   *
+   * This overload is selected for the subclasses of FixedSizeHeader,
+   * see PeekHeader (FixedSizeHeader<T, N> &).
+   *
+   * \tparam T The type of the header.
+   * \tparam N The serialized size of the header.
+   * \param header a reference to the header to remove from the internal buffer.
+   * \returns the number of bytes removed from the packet.
+   */
+  template <typename T, uint32_t N>
+  uint32_t RemoveHeader (FixedSizeHeader<T, N> &header);
+  /**
+   * \brief Deserialize but does _not_ remove a fixed-size header from
+   * the internal buffer.
+   *
+   * This overload is selected for the subclasses of FixedSizeHeader:
+   * it calls FixedSizeHeader::DeserializeFrom on the bytes of the
+   * packet directly.  It falls back to the virtual Header::Deserialize
+   * if these bytes are in the zero-filled area of the packet, or if
+   * the header needs more bytes than its fixed size.
+   *
+   * \tparam T The type of the header.
+   * \tparam N The serialized size of the header.
+   * \param header a reference to the header to read from the internal buffer.
+   * \returns the number of bytes read from the packet.
+   */
+  template <typename T, uint32_t N>
+  uint32_t PeekHeader (FixedSizeHeader<T, N> &header) const;
   /**
    * \brief Add trailer to this packet.
    *
@@ -413,6 +462,22 @@ public:
    */
   void CopyData (std::ostream *os, uint32_t size) const;
 
+  /**
+   * \brief Get a pointer to the start of the packet for modifying it in place.
+   *
+   * \param size the number of bytes, counted from the start of the packet,
+   *        which the caller intends to modify.
+   * \returns a pointer to the first byte of the packet.
+   *
+   * This is meant for changing a field of a header which has already
+   * been added to the packet, such as the ECN bits of an IP header,
+   * without removing and re-adding the header.  The modified bytes
+   * must belong to headers (not to the zero-filled payload), and the
+   * packet metadata is not updated.  Other packets sharing the same
+   * buffer are not affected by the modification.
+   */
+  uint8_t *PeekWritableData (uint32_t size);
+
   /**
    * \brief performs a COW copy of the packet.
    *
@@ -501,6 +566,19 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable scatter-gather packet buffers.
+   *
+   * By default, Packet::AddAtEnd and Packet::CreateFragment copy
+   * the bytes of the packets.  Once this method is called, the
+   * packets created by them refer to the bytes of large packets
+   * instead, which makes the fragmentation and the reassembly of
+   * large packets much cheaper.  Call it during the simulation
+   * setup, before any packet is created.
+   *
+   * \sa Buffer::EnableScatterGather
+   */
+  static void EnableScatterGather (void);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -713,6 +791,24 @@ private:
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  friend class PacketPool;
+  /**
+   * \brief Turn this packet into a new packet with a zero-filled payload.
+   *
+   * The packet gets a new uid and loses its tags and metadata, as if
+   * it was created by Packet (size), but it keeps its byte buffer if
+   * it is not shared.  Only the PacketPool calls this, on the packets
+   * which nobody else refers to.
+   *
+   * \param size the size of the zero-filled payload
+   */
+  void Reset (uint32_t size);
+  /**
+   * \return true if the byte buffer of this packet is shared with
+   *         other packets, e.g., with the copies sent down a stack.
+   */
+  bool IsBufferShared (void) const;
+
   Buffer m_buffer;                //!< the packet buffer (it's actual contents)
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
@@ -721,7 +817,22 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * \brief Allocate the uid of a new packet.
+   *
+   * The upper 32 bits of the uid are the system id, and the lower 32
+   * bits are counted separately for each system id: each partition of
+   * a MultithreadedSimulatorImpl counts its own uids, in the order of
+   * its events, so that the uids are the same from one run to the next.
+   * Each thread takes the uids by blocks from the counter of its system
+   * id, so that threads which create packets with the same system id
+   * get different uids without any lock, in an order which then depends
+   * on the scheduling of the threads; in a single thread, the uids
+   * follow each other.
+   *
+   * \returns the uid
+   */
+  static uint64_t AllocateUid (void);
 };
 
 /**
@@ -788,6 +899,45 @@ Packet::GetSize (void) const
   return m_buffer.GetSize ();
 }
 
+template <typename T, uint32_t N>
+void
+Packet::AddHeader (const FixedSizeHeader<T, N> &header)
+{
+  uint8_t *start = m_buffer.AddAtStartRaw (N);
+  m_byteTagList.Adjust (N);
+  m_byteTagList.AddAtStart (N);
+  static_cast<const T &> (header).SerializeTo (start);
+  m_metadata.AddHeader (T::GetTypeId (), N);
+}
+
+template <typename T, uint32_t N>
+uint32_t
+Packet::RemoveHeader (FixedSizeHeader<T, N> &header)
+{
+  uint32_t deserialized = PeekHeader (header);
+  m_buffer.RemoveAtStart (deserialized);
+  m_byteTagList.Adjust (-deserialized);
+  m_metadata.RemoveHeader (T::GetTypeId (), deserialized);
+  return deserialized;
+}
+
+template <typename T, uint32_t N>
+uint32_t
+Packet::PeekHeader (FixedSizeHeader<T, N> &header) const
+{
+  const uint8_t *start = m_buffer.PeekStart (N);
+  uint32_t deserialized = 0;
+  if (start != 0)
+    {
+      deserialized = static_cast<T &> (header).DeserializeFrom (start);
+    }
+  if (deserialized == 0)
+    {
+      deserialized = header.Deserialize (m_buffer.Begin ());
+    }
+  return deserialized;
+}
+
 } // namespace ns3
 
 #endif /* PACKET_H */
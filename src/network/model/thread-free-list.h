@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef THREAD_FREE_LIST_H
+#define THREAD_FREE_LIST_H
+
+#include "ns3/core-config.h"
+#include <stdint.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#include <sched.h>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::ThreadFreeList declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief A free list of memory blocks with a cache in each thread
+ *
+ * The packets keep the blocks of their buffers, metadata and byte tags
+ * in free lists when they are released, to reuse them for the next
+ * packets.  Each thread has a cache of up to CACHE_SIZE free blocks,
+ * which Push and Pop access without any lock.  When its cache is full
+ * or empty, a thread moves half a cache of blocks to or from a depot
+ * shared by all the threads, under a spin lock; the depot holds up to
+ * DEPOT_SIZE blocks.  When both are full, Push refuses the block,
+ * which the caller releases.
+ *
+ * The blocks in the cache of a thread go to the depot when the thread
+ * exits, and Clear releases all the blocks at the end of the program,
+ * after which the free list refuses the blocks.  The state is made of
+ * plain static variables, so that the free list can be used by the
+ * constructors and destructors of other static variables.
+ *
+ * \tparam T The type of the blocks.
+ * \tparam Deallocate The function which releases a block.
+ */
+template <typename T, void (*Deallocate)(T *)>
+class ThreadFreeList
+{
+public:
+  /**
+   * Take a block from the free list.
+   *
+   * \returns A free block, or 0 if the free list is empty.
+   */
+  static T * Pop (void);
+  /**
+   * Give a block to the free list.
+   *
+   * \param [in] block The block.
+   * \returns false if the free list is full, in which case the caller
+   *          must release the block.
+   */
+  static bool Push (T *block);
+  /**
+   * Release the blocks of the depot and of the cache of the calling
+   * thread, and refuse the blocks from now on.
+   */
+  static void Clear (void);
+
+private:
+  /** The number of blocks in the cache of a thread. */
+  static const uint32_t CACHE_SIZE = 64;
+  /** The number of blocks in the depot. */
+  static const uint32_t DEPOT_SIZE = 1024;
+
+  /** The cache of a thread. */
+  struct Cache
+  {
+    T *blocks[CACHE_SIZE];   //!< the free blocks
+    uint32_t size;           //!< the number of free blocks
+  };
+
+  /**
+   * \returns The cache of the calling thread, created on the first call.
+   */
+  static Cache * GetCache (void);
+  /**
+   * Move blocks from the depot to a cache.
+   *
+   * \param [in] cache The cache of the calling thread.
+   */
+  static void Refill (Cache *cache);
+  /**
+   * Move blocks from a cache to the depot.
+   *
+   * \param [in] cache The cache of the calling thread.
+   * \param [in] n The number of blocks to move.
+   */
+  static void Drain (Cache *cache, uint32_t n);
+  /**
+   * Move the blocks of the cache of the calling thread, when it exits,
+   * to the depot, release the others, and delete the cache.
+   *
+   * \param [in] cache The cache.
+   */
+  static void ReleaseCache (void *cache);
+  /** Take the lock of the depot. */
+  static void Lock (void);
+  /** Release the lock of the depot. */
+  static void Unlock (void);
+
+  /** The cache of the thread. */
+  static __thread Cache *t_cache;
+  static T *g_depot[DEPOT_SIZE];   //!< the blocks of the depot
+  static uint32_t g_depotSize;     //!< the number of blocks in the depot
+  static bool g_locked;            //!< the lock of the depot
+  static bool g_cleared;           //!< true once Clear was called
+#ifdef HAVE_PTHREAD_H
+  static pthread_once_t g_once;    //!< create g_key once
+  static pthread_key_t g_key;      //!< calls ReleaseCache when a thread exits
+  /** Create g_key. */
+  static void CreateKey (void);
+#endif
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T, void (*Deallocate)(T *)>
+__thread typename ThreadFreeList<T, Deallocate>::Cache *ThreadFreeList<T, Deallocate>::t_cache
+  __attribute__ ((tls_model ("initial-exec"))) = 0;
+template <typename T, void (*Deallocate)(T *)>
+T *ThreadFreeList<T, Deallocate>::g_depot[DEPOT_SIZE];
+template <typename T, void (*Deallocate)(T *)>
+uint32_t ThreadFreeList<T, Deallocate>::g_depotSize = 0;
+template <typename T, void (*Deallocate)(T *)>
+bool ThreadFreeList<T, Deallocate>::g_locked = false;
+template <typename T, void (*Deallocate)(T *)>
+bool ThreadFreeList<T, Deallocate>::g_cleared = false;
+#ifdef HAVE_PTHREAD_H
+template <typename T, void (*Deallocate)(T *)>
+pthread_once_t ThreadFreeList<T, Deallocate>::g_once = PTHREAD_ONCE_INIT;
+template <typename T, void (*Deallocate)(T *)>
+pthread_key_t ThreadFreeList<T, Deallocate>::g_key;
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::CreateKey (void)
+{
+  pthread_key_create (&g_key, &ThreadFreeList::ReleaseCache);
+}
+#endif
+
+template <typename T, void (*Deallocate)(T *)>
+T *
+ThreadFreeList<T, Deallocate>::Pop (void)
+{
+  Cache *cache = t_cache;
+  if (cache == 0)
+    {
+      if (__atomic_load_n (&g_cleared, __ATOMIC_RELAXED))
+        {
+          return 0;
+        }
+      cache = GetCache ();
+    }
+  if (cache->size == 0)
+    {
+      Refill (cache);
+      if (cache->size == 0)
+        {
+          return 0;
+        }
+    }
+  cache->size--;
+  return cache->blocks[cache->size];
+}
+
+template <typename T, void (*Deallocate)(T *)>
+bool
+ThreadFreeList<T, Deallocate>::Push (T *block)
+{
+  Cache *cache = t_cache;
+  if (cache == 0)
+    {
+      if (__atomic_load_n (&g_cleared, __ATOMIC_RELAXED))
+        {
+          return false;
+        }
+      cache = GetCache ();
+    }
+  if (cache->size == CACHE_SIZE)
+    {
+      Drain (cache, CACHE_SIZE / 2);
+      if (cache->size == CACHE_SIZE)
+        {
+          return false;
+        }
+    }
+  cache->blocks[cache->size] = block;
+  cache->size++;
+  return true;
+}
+
+template <typename T, void (*Deallocate)(T *)>
+typename ThreadFreeList<T, Deallocate>::Cache *
+ThreadFreeList<T, Deallocate>::GetCache (void)
+{
+  Cache *cache = new Cache;
+  cache->size = 0;
+  t_cache = cache;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_once, &ThreadFreeList::CreateKey);
+  pthread_setspecific (g_key, cache);
+#endif
+  return cache;
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::Lock (void)
+{
+  while (__atomic_exchange_n (&g_locked, true, __ATOMIC_ACQUIRE))
+    {
+      // The holder moves a few pointers: let it run if it was preempted
+      sched_yield ();
+    }
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::Unlock (void)
+{
+  __atomic_store_n (&g_locked, false, __ATOMIC_RELEASE);
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::Refill (Cache *cache)
+{
+  Lock ();
+  while (g_depotSize != 0 && cache->size < CACHE_SIZE / 2)
+    {
+      g_depotSize--;
+      cache->blocks[cache->size] = g_depot[g_depotSize];
+      cache->size++;
+    }
+  Unlock ();
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::Drain (Cache *cache, uint32_t n)
+{
+  Lock ();
+  while (n != 0 && cache->size != 0 && g_depotSize < DEPOT_SIZE && !g_cleared)
+    {
+      cache->size--;
+      g_depot[g_depotSize] = cache->blocks[cache->size];
+      g_depotSize++;
+      n--;
+    }
+  Unlock ();
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::ReleaseCache (void *p)
+{
+  Cache *cache = static_cast<Cache *> (p);
+  t_cache = 0;
+  Drain (cache, CACHE_SIZE);
+  for (uint32_t i = 0; i < cache->size; i++)
+    {
+      Deallocate (cache->blocks[i]);
+    }
+  delete cache;
+}
+
+template <typename T, void (*Deallocate)(T *)>
+void
+ThreadFreeList<T, Deallocate>::Clear (void)
+{
+  Lock ();
+  __atomic_store_n (&g_cleared, true, __ATOMIC_RELAXED);
+  for (uint32_t i = 0; i < g_depotSize; i++)
+    {
+      Deallocate (g_depot[i]);
+    }
+  g_depotSize = 0;
+  Unlock ();
+  Cache *cache = t_cache;
+  if (cache != 0)
+    {
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (g_key, 0);
+#endif
+      ReleaseCache (cache);
+    }
+}
+
+} // namespace ns3
+
+#endif /* THREAD_FREE_LIST_H */
@@ -33,6 +33,8 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/point-to-point-layout-module.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -452,6 +454,286 @@ AdaptiveRedQueueTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+// Tests to verify the closed-form idle-period decay of the average queue size
+class IdleDecayRedQueueTestCase : public TestCase
+{
+public:
+  IdleDecayRedQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<RedQueue> queue, uint32_t size, uint32_t nPkt);
+  void Drain (Ptr<RedQueue> queue);
+  void CheckDecay (Ptr<RedQueue> queue, double qAvg, double m, double qW);
+  void RunIdleDecayTest (DataRate bw, Time idle);
+};
+
+IdleDecayRedQueueTestCase::IdleDecayRedQueueTestCase ()
+  : TestCase ("Check the idle-period decay of the RED average against the ns-2 loop")
+{
+}
+
+void
+IdleDecayRedQueueTestCase::Enqueue (Ptr<RedQueue> queue, uint32_t size, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<Packet> (size));
+    }
+}
+
+void
+IdleDecayRedQueueTestCase::Drain (Ptr<RedQueue> queue)
+{
+  // The extra dequeue on the empty queue starts the idle period
+  while (queue->Dequeue ())
+    {
+    }
+}
+
+void
+IdleDecayRedQueueTestCase::CheckDecay (Ptr<RedQueue> queue, double qAvg, double m, double qW)
+{
+  // Reference: the per-packet loop of ns-2 (and of earlier versions of RedQueue)
+  uint32_t count = uint32_t (m) + 1;
+  double expected = qAvg;
+  while (--count >= 1)
+    {
+      expected *= 1.0 - qW;
+    }
+  expected *= 1.0 - qW;
+
+  queue->Enqueue (Create<Packet> (500));
+  NS_TEST_EXPECT_MSG_EQ_TOL (queue->GetAverageQueueSize (), expected, 1e-9 * qAvg + 1e-12,
+                             "Closed-form decay should match the per-packet loop");
+}
+
+void
+IdleDecayRedQueueTestCase::RunIdleDecayTest (DataRate bw, Time idle)
+{
+  double qW = 0.002;
+  uint32_t meanPktSize = 500;
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (qW)), true,
+                         "Verify that we can actually set the attribute QW");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MeanPktSize", UintegerValue (meanPktSize)), true,
+                         "Verify that we can actually set the attribute MeanPktSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (1000)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (2000)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (5000)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("LinkBandwidth", DataRateValue (bw)), true,
+                         "Verify that we can actually set the attribute LinkBandwidth");
+
+  // Build up a non-trivial average, then let the queue go idle
+  Enqueue (queue, meanPktSize, 3000);
+  Simulator::Schedule (Seconds (1.0), &IdleDecayRedQueueTestCase::Drain, this, queue);
+  Simulator::Run ();
+  double qAvg = queue->GetAverageQueueSize ();
+  NS_TEST_EXPECT_MSG_GT (qAvg, 0, "The average queue size should have grown");
+
+  double ptc = bw.GetBitRate () / (8.0 * meanPktSize);
+  double m = uint32_t (ptc * idle.GetSeconds ());
+  Simulator::Schedule (idle, &IdleDecayRedQueueTestCase::CheckDecay, this, queue, qAvg, m, qW);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+IdleDecayRedQueueTestCase::DoRun (void)
+{
+  RunIdleDecayTest (DataRate ("1.5Mbps"), MilliSeconds (0));
+  RunIdleDecayTest (DataRate ("1.5Mbps"), MilliSeconds (1));
+  RunIdleDecayTest (DataRate ("1.5Mbps"), MilliSeconds (100));
+  RunIdleDecayTest (DataRate ("10Gbps"), MicroSeconds (10));
+  RunIdleDecayTest (DataRate ("10Gbps"), MilliSeconds (200));
+}
+
+// Tests to verify that the link bandwidth dependent parameters follow a change of the link rate
+class RateChangeRedQueueTestCase : public TestCase
+{
+public:
+  RateChangeRedQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  void CheckParams (Ptr<RedQueue> queue, DataRate bw);
+};
+
+RateChangeRedQueueTestCase::RateChangeRedQueueTestCase ()
+  : TestCase ("Check that the RED parameters follow a change of the device data rate")
+{
+}
+
+void
+RateChangeRedQueueTestCase::CheckParams (Ptr<RedQueue> queue, DataRate bw)
+{
+  double ptc = bw.GetBitRate () / (8.0 * 500);
+  double minTh = std::max (5.0, 0.005 * ptc / 2.0);
+  double bottom = std::min (0.01, 8.0 * 500 * 0.1 / bw.GetBitRate ());
+
+  DataRateValue rate;
+  DoubleValue value;
+  queue->GetAttribute ("LinkBandwidth", rate);
+  NS_TEST_EXPECT_MSG_EQ (rate.Get (), bw, "The link bandwidth should follow the device");
+  queue->GetAttribute ("QW", value);
+  NS_TEST_EXPECT_MSG_EQ_TOL (value.Get (), 1.0 - std::exp (-1.0 / ptc), 1e-12, "Wrong automatic queue weight");
+  queue->GetAttribute ("MinTh", value);
+  NS_TEST_EXPECT_MSG_EQ_TOL (value.Get (), minTh, 1e-9, "Wrong automatic MinTh");
+  queue->GetAttribute ("MaxTh", value);
+  NS_TEST_EXPECT_MSG_EQ_TOL (value.Get (), 3 * minTh, 1e-9, "Wrong automatic MaxTh");
+  queue->GetAttribute ("Bottom", value);
+  NS_TEST_EXPECT_MSG_EQ_TOL (value.Get (), bottom, 1e-12, "Wrong automatic Bottom");
+}
+
+void
+RateChangeRedQueueTestCase::DoRun (void)
+{
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.0)), true,
+                         "Verify that we can actually set the attribute QW");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (0)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (0)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (1000)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("LinkBandwidth", DataRateValue (DataRate ("10Mbps"))), true,
+                         "Verify that we can actually set the attribute LinkBandwidth");
+
+  Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+  device->SetAttribute ("QueueFollowsDataRate", BooleanValue (true));
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+  device->SetQueue (queue);
+
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      queue->Enqueue (Create<Packet> (500));
+    }
+  CheckParams (queue, DataRate ("10Mbps"));
+  double qAvg = queue->GetAverageQueueSize ();
+  NS_TEST_EXPECT_MSG_GT (qAvg, 0, "The average queue size should have grown");
+
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
+  CheckParams (queue, DataRate ("100Mbps"));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetAverageQueueSize (), qAvg, "The average queue size should be kept");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 50, "The queued packets should be kept");
+
+  device->SetDataRate (DataRate ("1Mbps"));
+  CheckParams (queue, DataRate ("1Mbps"));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetAverageQueueSize (), qAvg, "The average queue size should be kept");
+  Simulator::Destroy ();
+}
+
+// A RedQueue drained at a fixed rate, fed with packets at a fixed rate
+class SojournRedQueueTestCase : public TestCase
+{
+public:
+  SojournRedQueueTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Run the queue
+   * \param useSojournTime the UseSojournTime attribute
+   * \return the average number of packets found by the arrivals
+   */
+  double RunQueue (bool useSojournTime);
+  void Arrive (void);
+  void Depart (void);
+  Ptr<RedQueue> m_queue;
+  Time m_arrivalInterval;
+  Time m_serviceTime;
+  uint64_t m_arrivals;
+  uint64_t m_queued;
+};
+
+SojournRedQueueTestCase::SojournRedQueueTestCase ()
+  : TestCase ("Check Adaptive RED driven by the sojourn time")
+{
+}
+
+void
+SojournRedQueueTestCase::Arrive (void)
+{
+  m_arrivals++;
+  m_queued += m_queue->GetNPackets ();
+  m_queue->Enqueue (Create<Packet> (500));
+  Simulator::Schedule (m_arrivalInterval, &SojournRedQueueTestCase::Arrive, this);
+}
+
+void
+SojournRedQueueTestCase::Depart (void)
+{
+  m_queue->Dequeue ();
+  Simulator::Schedule (m_serviceTime, &SojournRedQueueTestCase::Depart, this);
+}
+
+double
+SojournRedQueueTestCase::RunQueue (bool useSojournTime)
+{
+  // The queue believes the link is 1.5 times faster than it is, so
+  // that the thresholds derived from the target delay are too large
+  m_queue = CreateObject<RedQueue> ();
+  m_queue->SetAttribute ("Adaptive", BooleanValue (true));
+  m_queue->SetAttribute ("QW", DoubleValue (0.0));
+  m_queue->SetAttribute ("MinTh", DoubleValue (0));
+  m_queue->SetAttribute ("MaxTh", DoubleValue (0));
+  m_queue->SetAttribute ("QueueLimit", UintegerValue (1000));
+  m_queue->SetAttribute ("TargetDelay", TimeValue (MilliSeconds (40)));
+  m_queue->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("1.5Mbps")));
+  m_queue->SetAttribute ("UseSojournTime", BooleanValue (useSojournTime));
+  m_queue->AssignStreams (1);
+  m_arrivalInterval = MicroSeconds (3400);
+  m_serviceTime = MilliSeconds (4);
+  m_arrivals = 0;
+  m_queued = 0;
+  Simulator::Schedule (Seconds (0), &SojournRedQueueTestCase::Arrive, this);
+  Simulator::Schedule (m_serviceTime, &SojournRedQueueTestCase::Depart, this);
+  Simulator::Stop (Seconds (300));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return double (m_queued) / m_arrivals;
+}
+
+void
+SojournRedQueueTestCase::DoRun (void)
+{
+  // Packets dequeued 1 ms apart after being queued at once wait 1, 2, 3 ms...
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  queue->SetAttribute ("QW", DoubleValue (0.1));
+  queue->SetAttribute ("QueueLimit", UintegerValue (100));
+  queue->SetAttribute ("MinTh", DoubleValue (50));
+  queue->SetAttribute ("MaxTh", DoubleValue (80));
+  queue->SetAttribute ("UseSojournTime", BooleanValue (true));
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      queue->Enqueue (Create<Packet> (500));
+    }
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &RedQueue::Dequeue, queue);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  double expected = 0;
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      expected = 0.9 * expected + 0.1 * 0.001 * i;
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (queue->GetAverageSojournTime ().GetSeconds (), expected, 1e-9,
+                             "The average sojourn time is not the EWMA of the waits");
+
+  // With the thresholds derived for a 1.5 Mbps link (7.5 and 22.5
+  // packets), Adaptive RED aims at 15 packets, i.e. 60 ms at the actual
+  // 1 Mbps.  Adapting to the 40 ms target delay aims at 10 packets.
+  double queued = RunQueue (false);
+  double queuedSojourn = RunQueue (true);
+  NS_TEST_EXPECT_MSG_GT (queued, 12, "The average queue should follow the thresholds");
+  NS_TEST_EXPECT_MSG_LT (queuedSojourn, 11, "The average queue should follow the target delay");
+  NS_TEST_EXPECT_MSG_GT (queuedSojourn, 8, "The average queue should follow the target delay");
+}
+
 static class AredQueueTestSuite : public TestSuite
 {
 public:
@@ -460,5 +742,8 @@ public:
   {
     AddTestCase (new AutoRedQueueTestCase (), TestCase::QUICK);         // Tests for automatically set parameters of ARED
     AddTestCase (new AdaptiveRedQueueTestCase (), TestCase::QUICK);     // Tests for adaptive parameter of ARED
+    AddTestCase (new IdleDecayRedQueueTestCase (), TestCase::QUICK);    // Tests for idle-period decay of the average
+    AddTestCase (new RateChangeRedQueueTestCase (), TestCase::QUICK);   // Tests for link rate changes
+    AddTestCase (new SojournRedQueueTestCase (), TestCase::QUICK);      // Tests for the sojourn time mode
   }
 } g_aredQueueTestSuite;
@@ -23,6 +23,8 @@
 #include "ns3/double.h"
 #include "ns3/test.h"
 
+#include <vector>
+
 using namespace ns3;
 
 //-----------------------------------------------------------------------------
@@ -361,6 +363,112 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+class BufferScatterGatherTest : public TestCase {
+private:
+  bool IsEqual (const Buffer &b, uint32_t offset);
+  std::vector<uint8_t> m_expected;
+public:
+  virtual void DoRun (void);
+  BufferScatterGatherTest ();
+};
+
+BufferScatterGatherTest::BufferScatterGatherTest ()
+  : TestCase ("Check the buffers which refer to the bytes of other buffers")
+{
+}
+
+bool
+BufferScatterGatherTest::IsEqual (const Buffer &b, uint32_t offset)
+{
+  std::vector<uint8_t> got (b.GetSize ());
+  bool ok = b.CopyData (&got[0], b.GetSize ()) == b.GetSize ();
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < got.size (); j++)
+    {
+      ok = ok && got[j] == m_expected[offset + j] && i.ReadU8 () == got[j];
+    }
+  return ok;
+}
+
+void
+BufferScatterGatherTest::DoRun (void)
+{
+  const uint32_t size = 5000;
+  const uint32_t fragmentSize = 1000;
+  m_expected.resize (size);
+  for (uint32_t j = 0; j < size; j++)
+    {
+      m_expected[j] = (j * 7 + j / 256) & 0xff;
+    }
+  Buffer original;
+  original.AddAtStart (size);
+  original.Begin ().Write (&m_expected[0], size);
+
+  Buffer::EnableScatterGather ();
+
+  // Fragment, with a header on each fragment, and reassemble.
+  std::vector<Buffer> fragments;
+  for (uint32_t offset = 0; offset < size; offset += fragmentSize)
+    {
+      Buffer fragment = original.CreateFragment (offset, fragmentSize);
+      fragment.AddAtStart (4);
+      fragment.Begin ().WriteHtonU32 (offset);
+      fragments.push_back (fragment);
+    }
+  Buffer reassembled;
+  for (uint32_t j = 0; j < fragments.size (); j++)
+    {
+      Buffer fragment = fragments[j];
+      NS_TEST_EXPECT_MSG_EQ (fragment.Begin ().ReadNtohU32 (), j * fragmentSize, "Bad header");
+      fragment.RemoveAtStart (4);
+      NS_TEST_EXPECT_MSG_EQ (IsEqual (fragment, j * fragmentSize), true, "Bad fragment " << j);
+      reassembled.AddAtEnd (fragment);
+    }
+  NS_TEST_ASSERT_MSG_EQ (reassembled.GetSize (), size, "Bad size");
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (reassembled, 0), true, "Bad reassembled buffer");
+  Buffer::Iterator i = reassembled.Begin ();
+  i.Next (fragmentSize - 2);
+  uint32_t value = (m_expected[fragmentSize - 2] << 24) | (m_expected[fragmentSize - 1] << 16) |
+    (m_expected[fragmentSize] << 8) | m_expected[fragmentSize + 1];
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU32 (), value, "Bad read across fragments");
+
+  // The other operations on the reassembled buffer
+  bool ok = memcmp (Buffer (reassembled).PeekData (), &m_expected[0], size) == 0;
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Bad PeekData");
+  std::vector<uint8_t> serialized (reassembled.GetSerializedSize ());
+  NS_TEST_ASSERT_MSG_EQ (reassembled.Serialize (&serialized[0], serialized.size ()), 1, "Serialize failed");
+  Buffer deserialized;
+  // The size counts the length field which Packet puts before the buffer
+  deserialized.Deserialize (&serialized[0], serialized.size () + 4);
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (deserialized, 0), true, "Bad deserialized buffer");
+  Buffer fragment = reassembled.CreateFragment (fragmentSize / 2, 2 * fragmentSize);
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (fragment, fragmentSize / 2), true, "Bad fragment across fragments");
+
+  // Copies are independent
+  Buffer trimmed = reassembled;
+  trimmed.RemoveAtStart (100);
+  trimmed.RemoveAtEnd (100);
+  NS_TEST_EXPECT_MSG_EQ ((int)trimmed.GetSize (), (int)(size - 200), "Bad size");
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (trimmed, 100), true, "Bad trimmed buffer");
+  trimmed.AddAtStart (1);
+  trimmed.Begin ().WriteU8 (0xaa);
+  trimmed.AddAtEnd (1);
+  i = trimmed.End ();
+  i.Prev ();
+  i.WriteU8 (0xbb);
+  NS_TEST_EXPECT_MSG_EQ ((int)trimmed.Begin ().PeekU8 (), 0xaa, "Bad byte at start");
+  i = trimmed.End ();
+  i.Prev ();
+  NS_TEST_EXPECT_MSG_EQ ((int)i.PeekU8 (), 0xbb, "Bad byte at end");
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (reassembled, 0), true, "A copy changed the reassembled buffer");
+  reassembled.AddAtEnd (reassembled);
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (original, 0), true, "The original buffer changed");
+  reassembled.RemoveAtStart (size);
+  NS_TEST_EXPECT_MSG_EQ (IsEqual (reassembled, 0), true, "Bad buffer appended to itself");
+
+  Buffer::DisableScatterGather ();
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +479,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferScatterGatherTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
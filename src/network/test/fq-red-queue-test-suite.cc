@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/fq-red-queue.h"
+#include "ns3/flow-utils.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include <algorithm>
+
+using namespace ns3;
+
+// Packets are IPv4/UDP datagrams with no link layer header in front
+static uint32_t
+GetIpv4FlowKey (Ptr<const Packet> p, uint8_t *key)
+{
+  return flowUtils::GetIpFlowKey (p, 0, 0x0800, key);
+}
+
+static Ptr<Packet>
+CreateUdpPacket (uint16_t sourcePort, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  UdpHeader udp;
+  udp.SetSourcePort (sourcePort);
+  udp.SetDestinationPort (9);
+  p->AddHeader (udp);
+  Ipv4Header ip;
+  ip.SetSource (Ipv4Address ("10.1.1.1"));
+  ip.SetDestination (Ipv4Address ("10.1.2.1"));
+  ip.SetProtocol (17);
+  ip.SetPayloadSize (p->GetSize ());
+  p->AddHeader (ip);
+  return p;
+}
+
+static Ptr<FqRedQueue>
+CreateFqRedQueue (uint32_t queueLimit)
+{
+  Ptr<FqRedQueue> queue = CreateObjectWithAttributes<FqRedQueue> ("Flows", UintegerValue (64));
+  queue->SetFlowKeyCallback (MakeCallback (&GetIpv4FlowKey));
+  for (uint32_t i = 0; i < queue->GetNFlows (); i++)
+    {
+      queue->GetFlowQueue (i)->SetQueueLimit (queueLimit);
+    }
+  return queue;
+}
+
+// Tests to verify that the flows are served in deficit round robin
+class FqRedQueueDrrTestCase : public TestCase
+{
+public:
+  FqRedQueueDrrTestCase ();
+  virtual void DoRun (void);
+};
+
+FqRedQueueDrrTestCase::FqRedQueueDrrTestCase ()
+  : TestCase ("Check the deficit round robin service of the flows")
+{
+}
+
+void
+FqRedQueueDrrTestCase::DoRun (void)
+{
+  Ptr<FqRedQueue> queue = CreateFqRedQueue (100);
+
+  // Flow A sends large packets, flow B small ones
+  uint32_t sizeA = CreateUdpPacket (1000, 1000)->GetSize ();
+  uint32_t sizeB = CreateUdpPacket (2000, 400)->GetSize ();
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      queue->Enqueue (CreateUdpPacket (1000, 1000));
+    }
+  for (uint32_t i = 0; i < 60; i++)
+    {
+      queue->Enqueue (CreateUdpPacket (2000, 400));
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 90, "There should be no drops");
+
+  uint32_t nBacklogged = 0;
+  for (uint32_t i = 0; i < queue->GetNFlows (); i++)
+    {
+      if (!queue->GetFlowQueue (i)->IsEmpty ())
+        {
+          nBacklogged++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (nBacklogged, 2, "The two flows should be in distinct sub-queues");
+
+  // While both flows are backlogged, they get the same share of bytes
+  uint32_t bytesA = 0;
+  uint32_t bytesB = 0;
+  uint32_t nA = 0;
+  uint32_t nB = 0;
+  while (nA < 30 && nB < 60)
+    {
+      Ptr<const Packet> head = queue->Peek ();
+      Ptr<Packet> p = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (p, head, "Peek should return the next packet");
+      if (p->GetSize () == sizeA)
+        {
+          bytesA += sizeA;
+          nA++;
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_EQ (p->GetSize (), sizeB, "Unexpected packet");
+          bytesB += sizeB;
+          nB++;
+        }
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (std::max (bytesA, bytesB) - std::min (bytesA, bytesB), 1514 + sizeA,
+                                   "The flows should get the same number of bytes");
+    }
+  while (queue->Dequeue ())
+    {
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "The queue should be empty");
+  Simulator::Destroy ();
+}
+
+// Tests to verify that each flow has its own RED state
+class FqRedQueueIsolationTestCase : public TestCase
+{
+public:
+  FqRedQueueIsolationTestCase ();
+  virtual void DoRun (void);
+};
+
+FqRedQueueIsolationTestCase::FqRedQueueIsolationTestCase ()
+  : TestCase ("Check that a heavy flow does not cause drops in a light flow")
+{
+}
+
+void
+FqRedQueueIsolationTestCase::DoRun (void)
+{
+  Ptr<FqRedQueue> queue = CreateFqRedQueue (25);
+  uint32_t heavy = queue->Classify (CreateUdpPacket (1000, 1000));
+  uint32_t light = queue->Classify (CreateUdpPacket (2000, 1000));
+  NS_TEST_ASSERT_MSG_NE (heavy, light, "The two flows should be in distinct sub-queues");
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      queue->Enqueue (CreateUdpPacket (1000, 1000));
+      if (i % 20 == 0)
+        {
+          queue->Enqueue (CreateUdpPacket (2000, 1000));
+        }
+    }
+
+  RedQueue::Stats st = queue->GetFlowQueue (heavy)->GetStats ();
+  uint32_t heavyDrops = st.unforcedDrop + st.forcedDrop;
+  st = queue->GetFlowQueue (light)->GetStats ();
+  uint32_t lightDrops = st.unforcedDrop + st.forcedDrop;
+  NS_TEST_EXPECT_MSG_EQ (queue->GetFlowQueue (light)->GetTotalReceivedPackets (), 10,
+                         "The light flow should be in its own sub-queue");
+  NS_TEST_EXPECT_MSG_GT (heavyDrops, 0, "The heavy flow should see drops");
+  NS_TEST_EXPECT_MSG_EQ (lightDrops, 0, "The light flow should not see drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), heavyDrops, "Every drop should be counted");
+  Simulator::Destroy ();
+}
+
+// Tests to verify the attributes and callbacks set after the sub-queues exist
+class FqRedQueueConfigTestCase : public TestCase
+{
+public:
+  FqRedQueueConfigTestCase ();
+  virtual void DoRun (void);
+private:
+  static bool CountMark (Ptr<Packet> p);
+  static uint32_t m_nMarks;
+};
+
+uint32_t FqRedQueueConfigTestCase::m_nMarks = 0;
+
+FqRedQueueConfigTestCase::FqRedQueueConfigTestCase ()
+  : TestCase ("Check the configuration of the sub-queues after their creation")
+{
+}
+
+bool
+FqRedQueueConfigTestCase::CountMark (Ptr<Packet> p)
+{
+  m_nMarks++;
+  return true;
+}
+
+void
+FqRedQueueConfigTestCase::DoRun (void)
+{
+  Ptr<FqRedQueue> queue = CreateFqRedQueue (100);
+  bool set = queue->SetAttributeFailSafe ("Flows", UintegerValue (128));
+  NS_TEST_EXPECT_MSG_EQ (set, false, "Flows should only be set at construction");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNFlows (), 64, "The number of sub-queues should not change");
+
+  Ptr<Packet> p = CreateUdpPacket (1000, 1000);
+  Ptr<RedQueue> flow = queue->GetFlowQueue (queue->Classify (p));
+  flow->SetAttribute ("UseEcn", BooleanValue (true));
+  flow->SetAttribute ("MinTh", DoubleValue (2));
+  flow->SetAttribute ("MaxTh", DoubleValue (5));
+  flow->SetAttribute ("QW", DoubleValue (0.5));
+
+  // The callback set after the sub-queues exist reaches them
+  m_nMarks = 0;
+  queue->SetMarkCallback (MakeCallback (&FqRedQueueConfigTestCase::CountMark));
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      queue->Enqueue (CreateUdpPacket (1000, 1000));
+    }
+  RedQueue::Stats st = flow->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (m_nMarks, 0, "The sub-queue should have marked packets");
+  NS_TEST_EXPECT_MSG_EQ (m_nMarks, st.unforcedMark, "Every mark should go through the callback");
+  Simulator::Destroy ();
+}
+
+static class FqRedQueueTestSuite : public TestSuite
+{
+public:
+  FqRedQueueTestSuite ()
+    : TestSuite ("fq-red-queue", UNIT)
+  {
+    AddTestCase (new FqRedQueueDrrTestCase (), TestCase::QUICK);
+    AddTestCase (new FqRedQueueIsolationTestCase (), TestCase::QUICK);
+    AddTestCase (new FqRedQueueConfigTestCase (), TestCase::QUICK);
+  }
+} g_fqRedQueueTestSuite;
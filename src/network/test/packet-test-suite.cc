@@ -19,9 +19,12 @@
  */
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
+#include "ns3/packet-pool.h"
+#include "ns3/uinteger.h"
 #include "ns3/test.h"
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
+#include <set>
 #include <string>
 #include <cstdarg>
 #include <iostream>
@@ -257,6 +260,44 @@ public:
 };
 
 
+class AFixedSizeTestHeader : public FixedSizeHeader<AFixedSizeTestHeader, 6>
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("anon::AFixedSizeTestHeader")
+      .SetParent<Header> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<AFixedSizeTestHeader> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual void Print (std::ostream &os) const {
+  }
+  void SerializeTo (uint8_t *buffer) const {
+    WriteHtonU16 (buffer, m_a);
+    WriteHtonU32 (buffer + 2, m_b);
+  }
+  uint32_t DeserializeFrom (const uint8_t *buffer) {
+    m_a = ReadNtohU16 (buffer);
+    m_b = ReadNtohU32 (buffer + 2);
+    return SERIALIZED_SIZE;
+  }
+  AFixedSizeTestHeader ()
+    : m_a (0), m_b (0) {}
+
+  uint16_t m_a;
+  uint32_t m_b;
+};
+
 struct Expected
 {
   Expected (uint32_t n_, uint32_t start_, uint32_t end_)
@@ -805,7 +846,66 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (6);
     ReplaceCheck (7);
   }
-  
+
+  { // Inline tags
+    std::cout << GetName () << "check reuse of inline tags" << std::endl;
+    PacketTagList ptl = ref;
+    ptl.Remove (t2);
+    ATestTag<8> m2 (1);
+    ptl.Add (m2);
+    CheckRefList (ref, "inline reuse orig");
+    CheckRefList (ptl, "inline reuse copy", 2);
+    CheckRef (ptl, m2, "inline reuse copy");
+    CheckRef (ref, m2, "inline reuse orig", true);
+
+    PacketTagList inl;
+    inl.Add (t1);
+    inl.Add (t2);
+    inl.Add (t3);
+    inl.Add (t4);
+    inl.Remove (t2);
+    inl.Add (m2);
+    NS_TEST_EXPECT_MSG_EQ (inl.GetNInlineTags (), 4, "inline reuse, inline tags");
+    NS_TEST_EXPECT_MSG_EQ ((inl.Head () == 0), true, "inline reuse, other tags");
+    CheckRef (inl, m2, "inline reuse, inline only");
+
+    std::cout << GetName () << "check iteration over all tags" << std::endl;
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->AddPacketTag (t7);
+    std::set<TypeId> tids;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        tids.insert (i.Next ().GetTypeId ());
+      }
+    NS_TEST_EXPECT_MSG_EQ (static_cast<int> (tids.size ()), tagLast, "iteration over all tags");
+
+    std::cout << GetName () << "check iteration order" << std::endl;
+    ATestTagBase *newestFirst[] = { &t7, &t6, &t5, &t4, &t3, &t2, &t1 };
+    i = p->GetPacketTagIterator ();
+    for (int j = 0; j < tagLast; j++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (i.Next ().GetTypeId (), newestFirst[j]->GetInstanceTypeId (),
+                               "iteration order, tag " << j);
+      }
+    p->RemovePacketTag (t3);
+    p->RemovePacketTag (t6);
+    ATestTagBase *afterRemove[] = { &t7, &t5, &t4, &t2, &t1 };
+    i = p->GetPacketTagIterator ();
+    for (int j = 0; j < tagLast - 2; j++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (i.Next ().GetTypeId (), afterRemove[j]->GetInstanceTypeId (),
+                               "iteration order after removal, tag " << j);
+      }
+    NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "iteration after removal");
+  }
+
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max ();
@@ -847,6 +947,154 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class PacketFixedSizeHeaderTest : public TestCase
+{
+public:
+  PacketFixedSizeHeaderTest ();
+private:
+  virtual void DoRun (void);
+};
+
+PacketFixedSizeHeaderTest::PacketFixedSizeHeaderTest ()
+  : TestCase ("Check that fixed-size headers are serialized as other headers")
+{
+}
+
+void
+PacketFixedSizeHeaderTest::DoRun (void)
+{
+  AFixedSizeTestHeader header;
+  header.m_a = 0x1234;
+  header.m_b = 0xdeadbeef;
+  const uint8_t expected[] = { 0x12, 0x34, 0xde, 0xad, 0xbe, 0xef };
+
+  // Serialized directly, or through a Buffer::Iterator
+  Ptr<Packet> direct = Create<Packet> (10);
+  direct->AddHeader (header);
+  Ptr<Packet> iterator = Create<Packet> (10);
+  const Header &base = header;
+  iterator->AddHeader (base);
+  NS_TEST_ASSERT_MSG_EQ (direct->GetSize (), 16, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (iterator->GetSize (), 16, "Wrong size");
+  uint8_t bytes[16];
+  direct->CopyData (bytes, 16);
+  bool ok = memcmp (bytes, expected, 6) == 0;
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Wrong bytes from AddHeader");
+  iterator->CopyData (bytes, 16);
+  ok = memcmp (bytes, expected, 6) == 0;
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Wrong bytes from Header::Serialize");
+
+  // Deserialized directly, or through a Buffer::Iterator
+  AFixedSizeTestHeader peeked;
+  Header &peekedBase = peeked;
+  NS_TEST_EXPECT_MSG_EQ (direct->PeekHeader (peekedBase), 6, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (peeked.m_a, header.m_a, "Wrong field from Header::Deserialize");
+  NS_TEST_EXPECT_MSG_EQ (peeked.m_b, header.m_b, "Wrong field from Header::Deserialize");
+  AFixedSizeTestHeader removed;
+  NS_TEST_EXPECT_MSG_EQ (iterator->RemoveHeader (removed), 6, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_a, header.m_a, "Wrong field from RemoveHeader");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_b, header.m_b, "Wrong field from RemoveHeader");
+  NS_TEST_EXPECT_MSG_EQ (iterator->GetSize (), 10, "Wrong size");
+
+  // The header is in the zero-filled area of the packet
+  NS_TEST_EXPECT_MSG_EQ (iterator->RemoveHeader (removed), 6, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_a, 0, "Wrong field from the zero-filled area");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_b, 0, "Wrong field from the zero-filled area");
+  NS_TEST_EXPECT_MSG_EQ (iterator->GetSize (), 4, "Wrong size");
+}
+//-----------------------------------------------------------------------------
+class PacketPoolTest : public TestCase
+{
+public:
+  PacketPoolTest ();
+private:
+  virtual void DoRun (void);
+};
+
+PacketPoolTest::PacketPoolTest ()
+  : TestCase ("Check that the packet pool reuses the packets nobody refers to")
+{
+}
+
+void
+PacketPoolTest::DoRun (void)
+{
+  Ptr<PacketPool> pool = CreateObject<PacketPool> ();
+  AFixedSizeTestHeader header;
+  header.m_a = 0x1234;
+  header.m_b = 0xdeadbeef;
+
+  Ptr<Packet> p = pool->Get (100);
+  Packet *first = PeekPointer (p);
+  uint64_t uid = p->GetUid ();
+  p->AddHeader (header);
+  p->AddPacketTag (ATestTag<1> (1));
+  p->AddByteTag (ATestTag<2> (2));
+  Ptr<Packet> inFlight = p;
+  pool->Release (p);
+  p = 0;
+  NS_TEST_ASSERT_MSG_EQ (pool->GetNPackets (), 1, "Packet not released");
+
+  // Still referenced: a new packet is created
+  p = pool->Get (50);
+  bool reused = PeekPointer (p) == first;
+  NS_TEST_EXPECT_MSG_EQ (reused, false, "Reused a packet in flight");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNRecycled (), 0, "Reused a packet in flight");
+
+  // Delivered: the packet is reset and reused
+  inFlight = 0;
+  p = pool->Get (50);
+  reused = PeekPointer (p) == first;
+  NS_TEST_ASSERT_MSG_EQ (reused, true, "Packet not reused");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNRecycled (), 1, "Packet not reused");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNPackets (), 0, "Packet still in the pool");
+  bool newUid = p->GetUid () != uid;
+  NS_TEST_EXPECT_MSG_EQ (newUid, true, "Same uid");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 50, "Wrong size");
+  uint8_t bytes[50];
+  uint8_t zeroes[50] = { 0 };
+  p->CopyData (bytes, 50);
+  bool zero = memcmp (bytes, zeroes, 50) == 0;
+  NS_TEST_EXPECT_MSG_EQ (zero, true, "Payload not reset");
+  ATestTag<1> packetTag;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (packetTag), false, "Packet tag not removed");
+  ATestTag<2> byteTag;
+  NS_TEST_EXPECT_MSG_EQ (p->FindFirstMatchingByteTag (byteTag), false, "Byte tag not removed");
+
+  // A packet whose bytes a copy still shares is not reused
+  p->AddHeader (header);
+  Ptr<Packet> copy = p->Copy ();
+  pool->Release (p);
+  p = 0;
+  p = pool->Get (20);
+  reused = PeekPointer (p) == first;
+  NS_TEST_EXPECT_MSG_EQ (reused, false, "Reused a packet whose bytes are shared");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNRecycled (), 1, "Reused a packet whose bytes are shared");
+  AFixedSizeTestHeader removed;
+  NS_TEST_EXPECT_MSG_EQ (copy->RemoveHeader (removed), 6, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_a, header.m_a, "Copy modified");
+  NS_TEST_EXPECT_MSG_EQ (removed.m_b, header.m_b, "Copy modified");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 50, "Wrong size");
+
+  // Once the copy is gone, the packet is reused
+  copy = 0;
+  Ptr<Packet> q = pool->Get (20);
+  reused = PeekPointer (q) == first;
+  NS_TEST_ASSERT_MSG_EQ (reused, true, "Packet not reused");
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNRecycled (), 2, "Packet not reused");
+
+  // The pool forgets the packets beyond MaxPackets
+  pool->SetAttribute ("MaxPackets", UintegerValue (1));
+  UintegerValue maxPackets;
+  pool->GetAttribute ("MaxPackets", maxPackets);
+  NS_TEST_EXPECT_MSG_EQ (maxPackets.Get (), 1, "Wrong MaxPackets");
+  pool->Release (p);
+  pool->Release (q);
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNPackets (), 1, "Too many packets in the pool");
+  pool->Dispose ();
+  NS_TEST_EXPECT_MSG_EQ (pool->GetNPackets (), 0, "Packets kept after Dispose");
+}
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +1107,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketFixedSizeHeaderTest, TestCase::QUICK);
+  AddTestCase (new PacketPoolTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
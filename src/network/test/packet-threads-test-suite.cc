@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/tag.h"
+#include "ns3/test.h"
+#include "ns3/system-thread.h"
+#include "ns3/mpsc-queue.h"
+
+#include <algorithm>
+#include <vector>
+#include <sched.h>
+
+using namespace ns3;
+
+namespace {
+
+class ThreadsTestHeader : public Header
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  uint32_t m_value;
+};
+
+TypeId
+ThreadsTestHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("anon::ThreadsTestHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Network")
+    .HideFromDocumentation ()
+    .AddConstructor<ThreadsTestHeader> ()
+  ;
+  return tid;
+}
+TypeId
+ThreadsTestHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+ThreadsTestHeader::GetSerializedSize (void) const
+{
+  return 4;
+}
+void
+ThreadsTestHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU32 (m_value);
+}
+uint32_t
+ThreadsTestHeader::Deserialize (Buffer::Iterator start)
+{
+  m_value = start.ReadU32 ();
+  return 4;
+}
+void
+ThreadsTestHeader::Print (std::ostream &os) const
+{
+  os << m_value;
+}
+
+class ThreadsTestTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  uint32_t m_value;
+};
+
+TypeId
+ThreadsTestTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("anon::ThreadsTestTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .HideFromDocumentation ()
+    .AddConstructor<ThreadsTestTag> ()
+  ;
+  return tid;
+}
+TypeId
+ThreadsTestTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+ThreadsTestTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+void
+ThreadsTestTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU32 (m_value);
+}
+void
+ThreadsTestTag::Deserialize (TagBuffer buf)
+{
+  m_value = buf.ReadU32 ();
+}
+void
+ThreadsTestTag::Print (std::ostream &os) const
+{
+  os << m_value;
+}
+
+} // anonymous namespace
+
+class PacketThreadsTestCase : public TestCase
+{
+public:
+  PacketThreadsTestCase (uint32_t threads, uint32_t packets);
+
+private:
+  virtual void DoRun (void);
+  void Produce (uint32_t thread);
+  static Ptr<Packet> MakePacket (uint32_t value);
+  static bool IsPacketOk (Ptr<Packet> p, uint32_t value);
+
+  uint32_t m_threads;
+  uint32_t m_packets;
+  MpscQueue<Packet *> m_handOver;
+  std::vector<std::vector<uint64_t> > m_uids;
+  std::vector<uint32_t> m_errors;
+};
+
+PacketThreadsTestCase::PacketThreadsTestCase (uint32_t threads, uint32_t packets)
+  : TestCase ("Check that packets can be created and released by many threads"),
+    m_threads (threads),
+    m_packets (packets)
+{
+}
+
+Ptr<Packet>
+PacketThreadsTestCase::MakePacket (uint32_t value)
+{
+  Ptr<Packet> p = Create<Packet> (100 + value % 1000);
+  ThreadsTestHeader header;
+  header.m_value = value;
+  p->AddHeader (header);
+  ThreadsTestTag tag;
+  tag.m_value = value;
+  p->AddByteTag (tag);
+  return p;
+}
+
+bool
+PacketThreadsTestCase::IsPacketOk (Ptr<Packet> p, uint32_t value)
+{
+  ThreadsTestHeader header;
+  p->RemoveHeader (header);
+  ThreadsTestTag tag;
+  return header.m_value == value && p->FindFirstMatchingByteTag (tag)
+         && tag.m_value == value && p->GetSize () == 100 + value % 1000;
+}
+
+void
+PacketThreadsTestCase::Produce (uint32_t thread)
+{
+  const uint32_t window = 32;
+  Ptr<Packet> live[window];
+  uint32_t values[window];
+  for (uint32_t i = 0; i < m_packets; i++)
+    {
+      uint32_t value = thread << 24 | i;
+      Ptr<Packet> p = MakePacket (value);
+      m_uids[thread].push_back (p->GetUid ());
+      if (i % 2 == 0)
+        {
+          // The main thread takes over the reference
+          m_handOver.Push (GetPointer (p));
+          continue;
+        }
+      // Release an older packet in this thread
+      uint32_t slot = (i / 2) % window;
+      if (live[slot] != 0 && !IsPacketOk (live[slot], values[slot]))
+        {
+          m_errors[thread]++;
+        }
+      live[slot] = p;
+      values[slot] = value;
+    }
+}
+
+void
+PacketThreadsTestCase::DoRun (void)
+{
+  // Register the types in this thread first
+  NS_TEST_ASSERT_MSG_EQ (IsPacketOk (MakePacket (0), 0), true, "Wrong packet");
+
+  m_uids.assign (m_threads, std::vector<uint64_t> ());
+  m_errors.assign (m_threads, 0);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&PacketThreadsTestCase::Produce, this).Bind (i)));
+      threads[i]->Start ();
+    }
+
+  uint32_t handedOver = m_threads * ((m_packets + 1) / 2);
+  uint32_t errors = 0;
+  for (uint32_t received = 0; received < handedOver; )
+    {
+      Packet *raw;
+      if (!m_handOver.Pop (raw))
+        {
+          sched_yield ();
+          continue;
+        }
+      Ptr<Packet> p (raw, false);
+      ThreadsTestHeader header;
+      p->PeekHeader (header);
+      errors += !IsPacketOk (p, header.m_value);
+      received++;
+    }
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads[i]->Join ();
+      errors += m_errors[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (errors, 0, "Corrupted packets");
+
+  std::vector<uint64_t> uids;
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_uids[i].size (), m_packets, "Lost uids");
+      uids.insert (uids.end (), m_uids[i].begin (), m_uids[i].end ());
+    }
+  std::sort (uids.begin (), uids.end ());
+  bool unique = std::adjacent_find (uids.begin (), uids.end ()) == uids.end ();
+  NS_TEST_EXPECT_MSG_EQ (unique, true, "Packets with the same uid");
+}
+
+class PacketUidTestCase : public TestCase
+{
+public:
+  PacketUidTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PacketUidTestCase::PacketUidTestCase ()
+  : TestCase ("Check that the packets of a thread get increasing uids")
+{
+}
+
+void
+PacketUidTestCase::DoRun (void)
+{
+  uint64_t uid = Create<Packet> ()->GetUid ();
+  for (uint32_t i = 1; i < 5000; i++)
+    {
+      uint64_t next = Create<Packet> (i)->GetUid ();
+      NS_TEST_ASSERT_MSG_GT (next, uid, "Uids do not increase");
+      uid = next;
+    }
+}
+
+class PacketThreadsTestSuite : public TestSuite
+{
+public:
+  PacketThreadsTestSuite ()
+    : TestSuite ("packet-threads", UNIT)
+  {
+    AddTestCase (new PacketUidTestCase, TestCase::QUICK);
+    AddTestCase (new PacketThreadsTestCase (4, 20000), TestCase::QUICK);
+  }
+} g_packetThreadsTestSuite;
@@ -0,0 +1,302 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/red-batch.h"
+#include "ns3/red-queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+
+using namespace ns3;
+
+class RedBatchProbabilityTestCase : public TestCase
+{
+public:
+  RedBatchProbabilityTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+RedBatchProbabilityTestCase::RedBatchProbabilityTestCase ()
+  : TestCase ("Check the batch drop probabilities against the RED formulas")
+{
+}
+
+void
+RedBatchProbabilityTestCase::DoRun (void)
+{
+  // minTh 5, maxTh 15, max_p 0.1: vA = 0.1, vB = -0.5, vC = 0.06, vD = -0.8
+  double qAvg[4] = { 10.0, 14.0, 20.0, 40.0 };
+  double maxTh[4] = { 15.0, 15.0, 15.0, 15.0 };
+  double vA[4] = { 0.1, 0.1, 0.1, 0.1 };
+  double vB[4] = { -0.5, -0.5, -0.5, -0.5 };
+  double vC[4] = { 0.06, 0.06, 0.06, 0.06 };
+  double vD[4] = { -0.8, -0.8, -0.8, -0.8 };
+  double maxP[4] = { 0.1, 0.1, 0.1, 0.1 };
+  double p[4];
+
+  RedBatch::CalculatePNew (4, qAvg, maxTh, true, vA, vB, vC, vD, maxP, p);
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[0], 0.05, 1e-12, "Linear between the thresholds");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[1], 0.09, 1e-12, "Linear between the thresholds");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[2], 0.4, 1e-12, "Gentle above maxTh");
+  NS_TEST_EXPECT_MSG_EQ (p[3], 1.0, "Capped at 1");
+
+  RedBatch::CalculatePNew (4, qAvg, maxTh, false, vA, vB, vC, vD, maxP, p);
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[0], 0.05, 1e-12, "Linear between the thresholds");
+  NS_TEST_EXPECT_MSG_EQ (p[2], 1.0, "Not gentle above maxTh");
+
+  double pNew[4] = { 0.05, 0.05, 0.05, 0.5 };
+  uint32_t count[4] = { 10, 30, 50, 1 };
+  RedBatch::ModifyP (4, pNew, count, true, p);
+  NS_TEST_EXPECT_MSG_EQ (p[0], 0.0, "No drop before 1 / p packets with Wait");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[1], 0.1, 1e-12, "p / (2 - count * p)");
+  NS_TEST_EXPECT_MSG_EQ (p[2], 1.0, "Drop after 2 / p packets");
+  NS_TEST_EXPECT_MSG_EQ (p[3], 0.0, "count * p below 1");
+
+  RedBatch::ModifyP (4, pNew, count, false, p);
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[0], 0.1, 1e-12, "p / (1 - count * p)");
+  NS_TEST_EXPECT_MSG_EQ (p[1], 1.0, "Drop after 1 / p packets");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p[3], 1.0, 1e-12, "p / (1 - count * p)");
+}
+
+/*
+ * A RedQueue drained by a transmitter at the link bandwidth, as
+ * PointToPointNetDevice does
+ */
+class RedBatchTestLink
+{
+public:
+  RedBatchTestLink (Ptr<RedQueue> queue, DataRate bw)
+    : m_queue (queue),
+      m_bw (bw),
+      m_busy (false)
+  {
+  }
+  void Arrive (uint32_t size)
+  {
+    if (m_queue->Enqueue (Create<Packet> (size)) && !m_busy)
+      {
+        TransmitNext ();
+      }
+  }
+  void TransmitNext (void)
+  {
+    Ptr<Packet> p = m_queue->Dequeue ();
+    m_busy = (p != 0);
+    if (p)
+      {
+        Simulator::Schedule (m_bw.CalculateBytesTxTime (p->GetSize ()),
+                             &RedBatchTestLink::TransmitNext, this);
+      }
+  }
+private:
+  Ptr<RedQueue> m_queue;
+  DataRate m_bw;
+  bool m_busy;
+};
+
+class RedBatchReplayTestCase : public TestCase
+{
+public:
+  RedBatchReplayTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+RedBatchReplayTestCase::RedBatchReplayTestCase ()
+  : TestCase ("Check that a lane replays the arrivals as a RedQueue with the same parameters")
+{
+}
+
+void
+RedBatchReplayTestCase::DoRun (void)
+{
+  // Bursts of 1 to 12 packets every 20 ms, 0.3 ms apart.  With equal
+  // thresholds, and not gentle, RED only has forced drops, so that the
+  // outcome does not depend on random numbers.
+  std::vector<Time> times;
+  std::vector<uint32_t> sizes;
+  for (uint32_t burst = 0; burst < 200; burst++)
+    {
+      for (uint32_t i = 0; i <= burst % 12; i++)
+        {
+          times.push_back (MilliSeconds (20 * burst) + MicroSeconds (300 * i + 1));
+          sizes.push_back (i % 3 == 0 ? 1500 : 400);
+        }
+    }
+
+  RedBatch::Config config;
+  config.linkBandwidth = DataRate ("1.5Mbps");
+  config.queueLimit = 10;
+  config.isGentle = false;
+  RedBatch batch (config);
+  double th[2] = { 3, 6 };
+  double qW[2] = { 0.02, 0.05 };
+  for (uint32_t lane = 0; lane < 2; lane++)
+    {
+      RedBatch::Params params;
+      params.minTh = th[lane];
+      params.maxTh = th[lane];
+      params.qW = qW[lane];
+      batch.AddLane (params);
+    }
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      batch.Enqueue (times[i], sizes[i], 0.5);
+    }
+
+  for (uint32_t lane = 0; lane < 2; lane++)
+    {
+      Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+      queue->SetAttribute ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+      queue->SetAttribute ("QueueLimit", UintegerValue (10));
+      queue->SetAttribute ("Gentle", BooleanValue (false));
+      queue->SetAttribute ("MinTh", DoubleValue (th[lane]));
+      queue->SetAttribute ("MaxTh", DoubleValue (th[lane]));
+      queue->SetAttribute ("QW", DoubleValue (qW[lane]));
+      queue->SetAttribute ("LinkBandwidth", StringValue ("1.5Mbps"));
+      RedBatchTestLink link (queue, DataRate ("1.5Mbps"));
+      for (uint32_t i = 0; i < times.size (); i++)
+        {
+          Simulator::Schedule (times[i], &RedBatchTestLink::Arrive, &link, sizes[i]);
+        }
+      Simulator::Run ();
+      Simulator::Destroy ();
+
+      RedQueue::Stats expected = queue->GetStats ();
+      RedQueue::Stats st = batch.GetStats (lane);
+      NS_TEST_EXPECT_MSG_GT (expected.forcedDrop, 0, "The arrivals should overflow the queue");
+      NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, expected.forcedDrop, "Forced drops differ in lane " << lane);
+      NS_TEST_EXPECT_MSG_EQ (st.qLimDrop, expected.qLimDrop, "Queue limit drops differ in lane " << lane);
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, 0, "There should be no early drop");
+      NS_TEST_EXPECT_MSG_EQ_TOL (batch.GetAverageQueueSize (lane), queue->GetAverageQueueSize (),
+                                 1e-9, "Average queue sizes differ in lane " << lane);
+    }
+}
+
+/*
+ * With minTh < maxTh and Adaptive RED, the lanes also take the early
+ * drop and max_p adaptation paths.  The uniform random variables are
+ * configured to always return the same number, which is also given to
+ * the lanes, so that RedQueue and RedBatch draw the same numbers
+ * whenever RedQueue needs one.
+ */
+class RedBatchEarlyDropTestCase : public TestCase
+{
+public:
+  RedBatchEarlyDropTestCase ();
+private:
+  virtual void DoRun (void);
+  void RunTest (double u);
+};
+
+RedBatchEarlyDropTestCase::RedBatchEarlyDropTestCase ()
+  : TestCase ("Check that a lane replays the early drops of an Adaptive RedQueue")
+{
+}
+
+void
+RedBatchEarlyDropTestCase::RunTest (double u)
+{
+  // Bursts of 1 to 16 packets every 20 ms, 0.3 ms apart
+  std::vector<Time> times;
+  std::vector<uint32_t> sizes;
+  for (uint32_t burst = 0; burst < 300; burst++)
+    {
+      for (uint32_t i = 0; i <= burst % 16; i++)
+        {
+          times.push_back (MilliSeconds (20 * burst) + MicroSeconds (300 * i + 1));
+          sizes.push_back (i % 3 == 0 ? 1500 : 400);
+        }
+    }
+
+  RedBatch::Config config;
+  config.linkBandwidth = DataRate ("1.5Mbps");
+  config.queueLimit = 20;
+  config.isAdaptive = true;
+  RedBatch batch (config);
+  double minTh[2] = { 2, 3 };
+  double maxTh[2] = { 6, 9 };
+  double qW[2] = { 0.02, 0.05 };
+  for (uint32_t lane = 0; lane < 2; lane++)
+    {
+      RedBatch::Params params;
+      params.minTh = minTh[lane];
+      params.maxTh = maxTh[lane];
+      params.qW = qW[lane];
+      batch.AddLane (params);
+    }
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      batch.Enqueue (times[i], sizes[i], u);
+    }
+
+  for (uint32_t lane = 0; lane < 2; lane++)
+    {
+      Config::SetDefault ("ns3::UniformRandomVariable::Min", DoubleValue (u));
+      Config::SetDefault ("ns3::UniformRandomVariable::Max", DoubleValue (u));
+      Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+      Config::SetDefault ("ns3::UniformRandomVariable::Min", DoubleValue (0.0));
+      Config::SetDefault ("ns3::UniformRandomVariable::Max", DoubleValue (1.0));
+      queue->SetAttribute ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+      queue->SetAttribute ("QueueLimit", UintegerValue (20));
+      queue->SetAttribute ("Adaptive", BooleanValue (true));
+      queue->SetAttribute ("MinTh", DoubleValue (minTh[lane]));
+      queue->SetAttribute ("MaxTh", DoubleValue (maxTh[lane]));
+      queue->SetAttribute ("QW", DoubleValue (qW[lane]));
+      queue->SetAttribute ("LinkBandwidth", StringValue ("1.5Mbps"));
+      RedBatchTestLink link (queue, DataRate ("1.5Mbps"));
+      for (uint32_t i = 0; i < times.size (); i++)
+        {
+          Simulator::Schedule (times[i], &RedBatchTestLink::Arrive, &link, sizes[i]);
+        }
+      Simulator::Run ();
+      Simulator::Destroy ();
+
+      RedQueue::Stats expected = queue->GetStats ();
+      RedQueue::Stats st = batch.GetStats (lane);
+      NS_TEST_EXPECT_MSG_GT (expected.unforcedDrop, 0, "The queue should drop packets early");
+      NS_TEST_EXPECT_MSG_NE (batch.GetCurMaxP (lane), 1.0 / config.lInterm, "max_p should have been adapted");
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, expected.unforcedDrop, "Early drops differ in lane " << lane << " with u " << u);
+      NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, expected.forcedDrop, "Forced drops differ in lane " << lane << " with u " << u);
+      NS_TEST_EXPECT_MSG_EQ (st.qLimDrop, expected.qLimDrop, "Queue limit drops differ in lane " << lane << " with u " << u);
+      NS_TEST_EXPECT_MSG_EQ_TOL (batch.GetAverageQueueSize (lane), queue->GetAverageQueueSize (),
+                                 1e-9, "Average queue sizes differ in lane " << lane << " with u " << u);
+    }
+}
+
+void
+RedBatchEarlyDropTestCase::DoRun (void)
+{
+  RunTest (0.02);
+  RunTest (0.1);
+}
+
+static class RedBatchTestSuite : public TestSuite
+{
+public:
+  RedBatchTestSuite ()
+    : TestSuite ("red-batch", UNIT)
+  {
+    AddTestCase (new RedBatchProbabilityTestCase (), TestCase::QUICK);
+    AddTestCase (new RedBatchReplayTestCase (), TestCase::QUICK);
+    AddTestCase (new RedBatchEarlyDropTestCase (), TestCase::QUICK);
+  }
+} g_redBatchTestSuite;
@@ -26,6 +26,9 @@
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/ecn-utils.h"
+#include "ns3/ipv4-header.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -270,6 +273,104 @@ RedQueueTestCase::DoRun (void)
 
 }
 
+// Tests to verify that ECN-capable packets are marked in place instead of being dropped early
+class EcnRedQueueTestCase : public TestCase
+{
+public:
+  EcnRedQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  static bool MarkIpv4 (Ptr<Packet> p);
+  void RunEcnTest (bool useEcn, Ipv4Header::EcnType ecn);
+};
+
+EcnRedQueueTestCase::EcnRedQueueTestCase ()
+  : TestCase ("Sanity check on ECN marking in the red queue")
+{
+}
+
+bool
+EcnRedQueueTestCase::MarkIpv4 (Ptr<Packet> p)
+{
+  return ecnUtils::MarkCe (p, 0, 0x0800);
+}
+
+void
+EcnRedQueueTestCase::RunEcnTest (bool useEcn, Ipv4Header::EcnType ecn)
+{
+  uint32_t pktSize = 1000;
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (70)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (150)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (300)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (0.020)), true,
+                         "Verify that we can actually set the attribute QW");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (useEcn)), true,
+                         "Verify that we can actually set the attribute UseEcn");
+  queue->SetMarkCallback (MakeCallback (&EcnRedQueueTestCase::MarkIpv4));
+
+  std::vector<Ptr<Packet> > copies;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (pktSize);
+      Ipv4Header hdr;
+      hdr.EnableChecksum ();
+      hdr.SetPayloadSize (pktSize);
+      hdr.SetEcn (ecn);
+      p->AddHeader (hdr);
+      // A COW copy must not see the mark
+      copies.push_back (p->Copy ());
+      queue->Enqueue (p);
+    }
+
+  RedQueue::Stats st = queue->GetStats ();
+  if (useEcn && ecn != Ipv4Header::ECN_NotECT)
+    {
+      NS_TEST_EXPECT_MSG_GT (st.unforcedMark, 0, "There should be some packets marked due to probability mark");
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedDrop, 0, "There should be zero dropped packets due to probability mark");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (st.unforcedMark, 0, "There should be zero marked packets");
+      NS_TEST_EXPECT_MSG_GT (st.unforcedDrop, 0, "There should be some dropped packets due to probability mark");
+    }
+
+  uint32_t nMarked = 0;
+  Ptr<Packet> p;
+  while ((p = queue->Dequeue ()))
+    {
+      Ipv4Header hdr;
+      hdr.EnableChecksum ();
+      p->RemoveHeader (hdr);
+      NS_TEST_EXPECT_MSG_EQ (hdr.IsChecksumOk (), true, "The IPv4 checksum should still be valid");
+      if (hdr.GetEcn () == Ipv4Header::ECN_CE)
+        {
+          nMarked++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (nMarked, st.unforcedMark, "Every mark should be visible in the IPv4 header");
+
+  for (std::vector<Ptr<Packet> >::iterator i = copies.begin (); i != copies.end (); ++i)
+    {
+      Ipv4Header hdr;
+      (*i)->PeekHeader (hdr);
+      NS_TEST_EXPECT_MSG_EQ (hdr.GetEcn (), ecn, "Copies of the packets should not be marked");
+    }
+}
+
+void
+EcnRedQueueTestCase::DoRun (void)
+{
+  RunEcnTest (false, Ipv4Header::ECN_ECT0);
+  RunEcnTest (true, Ipv4Header::ECN_ECT0);
+  RunEcnTest (true, Ipv4Header::ECN_ECT1);
+  RunEcnTest (true, Ipv4Header::ECN_NotECT);
+  Simulator::Destroy ();
+}
+
 static class RedQueueTestSuite : public TestSuite
 {
 public:
@@ -277,5 +378,6 @@ public:
     : TestSuite ("red-queue", UNIT)
   {
     AddTestCase (new RedQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new EcnRedQueueTestCase (), TestCase::QUICK);
   }
 } g_redQueueTestSuite;
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ring-buffer.h"
+#include "ns3/packet.h"
+
+using namespace ns3;
+
+class RingBufferTestCase : public TestCase
+{
+public:
+  RingBufferTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferTestCase::RingBufferTestCase ()
+  : TestCase ("Sanity check on the ring buffer used for packet storage")
+{
+}
+
+void
+RingBufferTestCase::DoRun (void)
+{
+  RingBuffer<uint32_t> ring;
+  NS_TEST_EXPECT_MSG_EQ (ring.IsEmpty (), true, "A new ring buffer should be empty");
+  NS_TEST_EXPECT_MSG_EQ (ring.GetCapacity (), 0, "A new ring buffer should not allocate");
+
+  ring.Reserve (100);
+  NS_TEST_EXPECT_MSG_EQ (ring.GetCapacity (), 128, "Capacity should be rounded up to a power of two");
+
+  // Wrap around the end of the array several times
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  for (uint32_t round = 0; round < 5; round++)
+    {
+      for (uint32_t i = 0; i < 50; i++)
+        {
+          ring.Push (next++);
+        }
+      for (uint32_t i = 0; i < 40; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (ring.Front (), expected++, "Elements should come out in FIFO order");
+          ring.Pop ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 50, "There should be 50 elements left");
+  NS_TEST_EXPECT_MSG_EQ (ring.Get (49), next - 1, "The last element should be the last pushed");
+  NS_TEST_EXPECT_MSG_EQ (ring.GetCapacity (), 128, "The capacity should not grow while it is sufficient");
+
+  // Grow while the elements wrap around the end of the array
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ring.Push (next++);
+    }
+  NS_TEST_EXPECT_MSG_EQ (ring.GetCapacity (), 256, "The capacity should double when full");
+  while (!ring.IsEmpty ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (ring.Front (), expected++, "Elements should survive growth in FIFO order");
+      ring.Pop ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (expected, next, "All the elements should have been popped");
+
+  // Popped slots must not keep the packets alive
+  RingBuffer<Ptr<Packet> > packets;
+  Ptr<Packet> p = Create<Packet> (100);
+  packets.Push (p);
+  NS_TEST_EXPECT_MSG_EQ (p->GetReferenceCount (), 2, "The ring buffer should hold a reference");
+  packets.Pop ();
+  NS_TEST_EXPECT_MSG_EQ (p->GetReferenceCount (), 1, "The reference should be released by Pop");
+  packets.Push (p);
+  packets.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (p->GetReferenceCount (), 1, "The reference should be released by Clear");
+}
+
+static class RingBufferTestSuite : public TestSuite
+{
+public:
+  RingBufferTestSuite ()
+    : TestSuite ("ring-buffer", UNIT)
+  {
+    AddTestCase (new RingBufferTestCase (), TestCase::QUICK);
+  }
+} g_ringBufferTestSuite;
@@ -87,7 +87,13 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () >= m_maxPackets))
+  if (m_packets.GetCapacity () == 0 && m_mode == QUEUE_MODE_PACKETS)
+    {
+      // First packet: allocate the storage for a full queue at once
+      m_packets.Reserve (m_maxPackets);
+    }
+
+  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.GetSize () >= m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
@@ -102,9 +108,9 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
     }
 
   m_bytesInQueue += p->GetSize ();
-  m_packets.push (p);
+  m_packets.Push (p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return true;
@@ -115,19 +121,19 @@ DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
-  m_packets.pop ();
+  Ptr<Packet> p = m_packets.Front ();
+  m_packets.Pop ();
   m_bytesInQueue -= p->GetSize ();
 
   NS_LOG_LOGIC ("Popped " << p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
@@ -138,15 +144,15 @@ DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
+  Ptr<Packet> p = m_packets.Front ();
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ecn-utils.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EcnUtils");
+
+namespace ecnUtils {
+
+static const uint8_t ECN_MASK = 0x03;  //!< ECN bits of the IPv4 TOS / IPv6 traffic class
+static const uint8_t ECN_CE = 0x03;    //!< Congestion Experienced codepoint
+
+bool
+MarkCe (Ptr<Packet> p, uint32_t offset, uint16_t protocol)
+{
+  NS_LOG_FUNCTION (p << offset << protocol);
+
+  if (protocol == 0x0800)
+    {
+      // IPv4: the ECN field is in the low bits of the TOS byte (byte 1),
+      // the header checksum is in bytes 10-11.
+      uint8_t hdr[64];
+      uint32_t size = offset + 12;
+      if (size > sizeof (hdr) || p->CopyData (hdr, size) < size)
+        {
+          return false;
+        }
+      uint8_t tos = hdr[offset + 1];
+      if ((tos & ECN_MASK) == 0 || (tos & ECN_MASK) == ECN_CE)
+        {
+          // Not-ECT cannot be marked; CE is already marked
+          return (tos & ECN_MASK) == ECN_CE;
+        }
+      uint8_t *ip = p->PeekWritableData (size) + offset;
+      uint16_t oldWord = (ip[0] << 8) | ip[1];
+      ip[1] = tos | ECN_CE;
+      uint16_t newWord = (ip[0] << 8) | ip[1];
+      uint16_t checksum = (ip[10] << 8) | ip[11];
+      if (checksum != 0)
+        {
+          // HC' = ~(~HC + ~m + m'), in one's complement arithmetic
+          uint32_t sum = static_cast<uint16_t> (~checksum);
+          sum += static_cast<uint16_t> (~oldWord);
+          sum += newWord;
+          sum = (sum & 0xffff) + (sum >> 16);
+          sum = (sum & 0xffff) + (sum >> 16);
+          checksum = ~static_cast<uint16_t> (sum);
+          ip[10] = checksum >> 8;
+          ip[11] = checksum & 0xff;
+        }
+      return true;
+    }
+  else if (protocol == 0x86DD)
+    {
+      // IPv6: the traffic class spans the low nibble of byte 0 and the
+      // high nibble of byte 1; the ECN bits are bits 4-5 of byte 1.
+      uint8_t hdr[64];
+      uint32_t size = offset + 2;
+      if (size > sizeof (hdr) || p->CopyData (hdr, size) < size)
+        {
+          return false;
+        }
+      uint8_t ecn = (hdr[offset + 1] >> 4) & ECN_MASK;
+      if (ecn == 0 || ecn == ECN_CE)
+        {
+          return ecn == ECN_CE;
+        }
+      uint8_t *ip = p->PeekWritableData (size) + offset;
+      ip[1] |= ECN_CE << 4;
+      return true;
+    }
+  return false;
+}
+
+} // namespace ecnUtils
+
+} // namespace ns3
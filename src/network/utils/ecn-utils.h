@@ -0,0 +1,46 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef ECN_UTILS_H
+#define ECN_UTILS_H
+
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+namespace ecnUtils {
+
+/**
+ * \brief Set the ECN field of an IP header to Congestion Experienced (\RFC{3168})
+ *
+ * The header is modified in place in the packet buffer; it is neither
+ * removed nor deserialized.  Only ECN-capable packets (ECT(0) or ECT(1))
+ * are marked.  For IPv4, a non-zero header checksum is updated
+ * incrementally (\RFC{1624}).
+ *
+ * \param p the packet
+ * \param offset the offset of the IP header from the start of the packet,
+ *        i.e., the size of the link layer headers in front of it
+ * \param protocol the EtherType of the IP header (0x0800 or 0x86DD)
+ * \returns true if the packet was ECN-capable and is now marked CE,
+ *          false if it was left untouched
+ */
+bool MarkCe (Ptr<Packet> p, uint32_t offset, uint16_t protocol);
+
+} // namespace ecnUtils
+
+} // namespace ns3
+
+#endif /* ECN_UTILS_H */
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "flow-utils.h"
+#include "ns3/log.h"
+#include <cstring>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowUtils");
+
+namespace flowUtils {
+
+static const uint8_t PROT_TCP = 6;   //!< TCP protocol number
+static const uint8_t PROT_UDP = 17;  //!< UDP protocol number
+
+uint32_t
+GetIpFlowKey (Ptr<const Packet> p, uint32_t offset, uint16_t protocol, uint8_t *key)
+{
+  NS_LOG_FUNCTION (p << offset << protocol);
+
+  // Enough for the largest IPv4 header followed by the ports
+  uint8_t hdr[128];
+  if (offset > sizeof (hdr) - 64)
+    {
+      return 0;
+    }
+  uint32_t size = p->CopyData (hdr, std::min<uint32_t> (offset + 64, p->GetSize ()));
+  const uint8_t *ip = hdr + offset;
+
+  if (protocol == 0x0800)
+    {
+      // IPv4: protocol in byte 9, addresses in bytes 12-19, flags and
+      // fragment offset in bytes 6-7
+      if (size < offset + 20)
+        {
+          return 0;
+        }
+      uint32_t ihl = (ip[0] & 0x0f) * 4;
+      std::memcpy (key, ip + 12, 8);
+      key[8] = ip[9];
+      bool isFragment = (ip[6] & 0x3f) != 0 || ip[7] != 0;
+      if ((ip[9] == PROT_TCP || ip[9] == PROT_UDP) && !isFragment && size >= offset + ihl + 4)
+        {
+          std::memcpy (key + 9, ip + ihl, 4);
+          return 13;
+        }
+      return 9;
+    }
+  else if (protocol == 0x86DD)
+    {
+      // IPv6: next header in byte 6, addresses in bytes 8-39
+      if (size < offset + 40)
+        {
+          return 0;
+        }
+      std::memcpy (key, ip + 8, 32);
+      key[32] = ip[6];
+      if ((ip[6] == PROT_TCP || ip[6] == PROT_UDP) && size >= offset + 44)
+        {
+          std::memcpy (key + 33, ip + 40, 4);
+          return 37;
+        }
+      return 33;
+    }
+  return 0;
+}
+
+} // namespace flowUtils
+
+} // namespace ns3
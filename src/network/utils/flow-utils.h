@@ -0,0 +1,51 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef FLOW_UTILS_H
+#define FLOW_UTILS_H
+
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+namespace flowUtils {
+
+/// Largest size of a flow key (IPv6 addresses, next header and ports)
+static const uint32_t MAX_KEY_SIZE = 37;
+
+/**
+ * \brief Get the fields which identify the flow of an IP packet
+ *
+ * The key is made of the source and destination addresses and the
+ * protocol of the IP header and, for TCP and UDP, of the source and
+ * destination ports.  The ports are left out of IPv4 fragments, so that
+ * all the fragments of a datagram belong to the same flow, and of IPv6
+ * packets with extension headers.  The header is read from the packet
+ * buffer; it is neither removed nor deserialized.
+ *
+ * \param p the packet
+ * \param offset the offset of the IP header from the start of the packet,
+ *        i.e., the size of the link layer headers in front of it
+ * \param protocol the EtherType of the IP header (0x0800 or 0x86DD)
+ * \param key a buffer of at least MAX_KEY_SIZE bytes receiving the key
+ * \returns the size of the key, or 0 if the packet is not an IP packet
+ */
+uint32_t GetIpFlowKey (Ptr<const Packet> p, uint32_t offset, uint16_t protocol, uint8_t *key);
+
+} // namespace flowUtils
+
+} // namespace ns3
+
+#endif /* FLOW_UTILS_H */
@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/abort.h"
+#include "flow-utils.h"
+#include "fq-red-queue.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqRedQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (FqRedQueue);
+
+TypeId FqRedQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqRedQueue")
+    .SetParent<Queue> ()
+    .SetGroupName("Network")
+    .AddConstructor<FqRedQueue> ()
+    .AddAttribute ("Flows",
+                   "The number of sub-queues into which flows are hashed",
+                   TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&FqRedQueue::m_nFlows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Quantum",
+                   "The deficit round robin quantum in bytes, at least the largest packet size",
+                   UintegerValue (1514),
+                   MakeUintegerAccessor (&FqRedQueue::m_quantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("LinkBandwidth",
+                   "The RED link bandwidth of the sub-queues",
+                   DataRateValue (DataRate ("1.5Mbps")),
+                   MakeDataRateAccessor (&FqRedQueue::SetLinkBandwidth,
+                                         &FqRedQueue::GetLinkBandwidth),
+                   MakeDataRateChecker ())
+  ;
+
+  return tid;
+}
+
+FqRedQueue::FqRedQueue ()
+  : Queue (),
+    m_hasher (Create<Hash::Function::Murmur3> ())
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqRedQueue::~FqRedQueue ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqRedQueue::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      m_flows[i]->Dispose ();
+    }
+  m_flows.clear ();
+  m_active.Clear ();
+  Queue::DoDispose ();
+}
+
+uint32_t
+FqRedQueue::GetNFlows (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nFlows;
+}
+
+Ptr<RedQueue>
+FqRedQueue::GetFlowQueue (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_nFlows);
+  if (m_flows.empty ())
+    {
+      CreateFlowQueues ();
+    }
+  return m_flows[i];
+}
+
+void
+FqRedQueue::SetLinkBandwidth (DataRate bw)
+{
+  NS_LOG_FUNCTION (this << bw);
+  m_linkBandwidth = bw;
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      m_flows[i]->SetLinkBandwidth (bw);
+    }
+}
+
+DataRate
+FqRedQueue::GetLinkBandwidth (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_linkBandwidth;
+}
+
+void
+FqRedQueue::SetMarkCallback (MarkCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  Queue::SetMarkCallback (cb);
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      m_flows[i]->SetMarkCallback (cb);
+    }
+}
+
+int64_t
+FqRedQueue::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  if (m_flows.empty ())
+    {
+      CreateFlowQueues ();
+    }
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      m_flows[i]->AssignStreams (stream + i);
+    }
+  return m_flows.size ();
+}
+
+void
+FqRedQueue::CreateFlowQueues (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_flows.empty ());
+
+  m_flows.reserve (m_nFlows);
+  for (uint32_t i = 0; i < m_nFlows; i++)
+    {
+      Ptr<RedQueue> flow = CreateObject<RedQueue> ();
+      flow->SetLinkBandwidth (m_linkBandwidth);
+      flow->SetMarkCallback (m_markCallback);
+      m_flows.push_back (flow);
+    }
+  m_deficits.assign (m_nFlows, 0);
+  m_isActive.assign (m_nFlows, false);
+  m_active.Reserve (m_nFlows);
+}
+
+uint32_t
+FqRedQueue::Classify (Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  uint8_t key[flowUtils::MAX_KEY_SIZE];
+  uint32_t size = GetFlowKey (p, key);
+  if (size == 0)
+    {
+      return 0;
+    }
+  uint32_t hash = m_hasher.clear ().GetHash32 (reinterpret_cast<const char *> (key), size);
+  return hash % m_nFlows;
+}
+
+bool
+FqRedQueue::DoEnqueue (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  if (m_flows.empty ())
+    {
+      NS_LOG_INFO ("Creating the sub-queues.");
+      CreateFlowQueues ();
+    }
+
+  uint32_t i = Classify (p);
+  NS_LOG_DEBUG ("Packet " << p << " goes to sub-queue " << i);
+
+  if (!m_flows[i]->Enqueue (p))
+    {
+      NS_LOG_DEBUG ("\t Dropped by sub-queue " << i);
+      Drop (p);
+      return false;
+    }
+
+  if (!m_isActive[i])
+    {
+      // A new backlogged flow joins the round at the tail
+      m_isActive[i] = true;
+      m_deficits[i] = m_quantum;
+      m_active.Push (i);
+    }
+  return true;
+}
+
+void
+FqRedQueue::NextRound (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t i = m_active.Front ();
+  m_active.Pop ();
+  m_deficits[i] += m_quantum;
+  m_active.Push (i);
+}
+
+Ptr<Packet>
+FqRedQueue::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_active.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  /*
+   * The sub-queue at the head of the round got a quantum, at least the
+   * size of the largest packet, when it joined the tail, so its deficit
+   * covers its head packet.
+   */
+  uint32_t i = m_active.Front ();
+  Ptr<RedQueue> flow = m_flows[i];
+  Ptr<Packet> p = flow->Dequeue ();
+  NS_ASSERT (p != 0);
+  m_deficits[i] -= std::min (m_deficits[i], p->GetSize ());
+  if (flow->IsEmpty ())
+    {
+      m_active.Pop ();
+      m_isActive[i] = false;
+      m_deficits[i] = 0;
+      // Polling the empty queue starts its RED idle period, as
+      // a net device does when its transmit queue runs empty
+      flow->Dequeue ();
+    }
+  else if (m_deficits[i] < flow->Peek ()->GetSize ())
+    {
+      NextRound ();
+    }
+  NS_LOG_LOGIC ("Popped " << p << " from sub-queue " << i);
+  return p;
+}
+
+Ptr<const Packet>
+FqRedQueue::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_active.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+  return m_flows[m_active.Front ()]->Peek ();
+}
+
+} // namespace ns3
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef FQ_RED_QUEUE_H
+#define FQ_RED_QUEUE_H
+
+#include <vector>
+#include "ns3/queue.h"
+#include "ns3/red-queue.h"
+#include "ns3/ring-buffer.h"
+#include "ns3/data-rate.h"
+#include "ns3/hash.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief A fair-queueing packet queue with one (Adaptive) RED queue per flow
+ *
+ * Packets are classified into a fixed number of sub-queues by hashing
+ * their flow key (see Queue::SetFlowKeyCallback) with Murmur3.  Each
+ * sub-queue is a RedQueue with its own average queue size, drop
+ * probability and, in Adaptive RED mode, max_p; the sub-queues are
+ * served by deficit round robin.  Packets whose flow cannot be
+ * identified all go to the first sub-queue.
+ *
+ * The sub-queues are created when the first packet arrives, with the
+ * default attribute values of ns3::RedQueue, which can be changed with
+ * Config::SetDefault, except LinkBandwidth and the mark callback, which
+ * are taken from this queue.  Their limit (QueueLimit) applies per
+ * flow.  The number of sub-queues (Flows) can only be set when the
+ * queue is constructed.  While a flow has
+ * no packet queued, its RED queue is idle and its average queue size
+ * decays as if the whole link bandwidth were available to it.
+ *
+ * Enqueue and Dequeue take constant time and do not allocate memory:
+ * a sub-queue gets its quantum when it joins the tail of the round, and
+ * keeps the head of the round until its deficit no longer covers its
+ * next packet.  Packets larger than Quantum are still sent, without
+ * carrying a negative deficit over to the next round.
+ */
+class FqRedQueue : public Queue
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqRedQueue Constructor
+   */
+  FqRedQueue ();
+  virtual ~FqRedQueue ();
+
+  /**
+   * \brief Get the number of sub-queues.
+   *
+   * \returns The number of sub-queues.
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \brief Get a sub-queue, e.g. to read its statistics.
+   *
+   * \param i The index of the sub-queue, less than GetNFlows ().
+   * \returns The sub-queue.
+   */
+  Ptr<RedQueue> GetFlowQueue (uint32_t i);
+
+  /**
+   * \brief Get the sub-queue of a packet.
+   *
+   * \param p The packet.
+   * \returns The index of the sub-queue.
+   */
+  uint32_t Classify (Ptr<const Packet> p);
+
+  /**
+   * \brief Set the link bandwidth of all the sub-queues.
+   *
+   * \param bw The link bandwidth.
+   */
+  void SetLinkBandwidth (DataRate bw);
+
+  /**
+   * \brief Get the link bandwidth.
+   *
+   * \returns The link bandwidth.
+   */
+  DataRate GetLinkBandwidth (void) const;
+
+  // Inherited from Queue, to pass the callback on to the sub-queues
+  virtual void SetMarkCallback (MarkCallback cb);
+
+ /**
+  * Assign a fixed random variable stream number to the random variables
+  * used by this model.  Return the number of streams (possibly zero) that
+  * have been assigned.
+  *
+  * \param stream first stream index to use
+  * \return the number of stream indices assigned by this model
+  */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<Packet> p);
+  virtual Ptr<Packet> DoDequeue (void);
+  virtual Ptr<const Packet> DoPeek (void) const;
+
+  /**
+   * \brief Create the sub-queues.
+   */
+  void CreateFlowQueues (void);
+
+  /**
+   * \brief Move the sub-queue at the head of the round to its tail, with
+   *        a new quantum.
+   */
+  void NextRound (void);
+
+  uint32_t m_nFlows;                  //!< Number of sub-queues
+  uint32_t m_quantum;                 //!< Deficit round robin quantum, in bytes
+  DataRate m_linkBandwidth;           //!< Link bandwidth
+  Hasher m_hasher;                    //!< Flow key hash function
+  std::vector<Ptr<RedQueue> > m_flows; //!< The sub-queues
+  std::vector<uint32_t> m_deficits;   //!< Deficit counter of each sub-queue
+  std::vector<bool> m_isActive;       //!< True if the sub-queue is in m_active
+  RingBuffer<uint32_t> m_active;      //!< Indexes of the backlogged sub-queues, in service order
+};
+
+} // namespace ns3
+
+#endif /* FQ_RED_QUEUE_H */
@@ -22,6 +22,7 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include <string>
+#include <cstring>
 
 namespace ns3 {
 
@@ -47,13 +48,6 @@ LlcSnapHeader::GetType (void)
   return m_etherType;
 }
 
-uint32_t 
-LlcSnapHeader::GetSerializedSize (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return LLC_SNAP_HEADER_LENGTH;
-}
-
 TypeId 
 LlcSnapHeader::GetTypeId (void)
 {
@@ -80,22 +74,19 @@ LlcSnapHeader::Print (std::ostream &os) const
 }
 
 void
-LlcSnapHeader::Serialize (Buffer::Iterator start) const
+LlcSnapHeader::SerializeTo (uint8_t *buffer) const
 {
-  NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
-  uint8_t buf[] = { 0xaa, 0xaa, 0x03, 0, 0, 0};
-  i.Write (buf, 6);
-  i.WriteHtonU16 (m_etherType);
+  NS_LOG_FUNCTION (this << &buffer);
+  static const uint8_t buf[] = { 0xaa, 0xaa, 0x03, 0, 0, 0};
+  memcpy (buffer, buf, 6);
+  WriteHtonU16 (buffer + 6, m_etherType);
 }
 uint32_t
-LlcSnapHeader::Deserialize (Buffer::Iterator start)
+LlcSnapHeader::DeserializeFrom (const uint8_t *buffer)
 {
-  NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
-  i.Next (5+1);
-  m_etherType = i.ReadNtohU16 ();
-  return GetSerializedSize ();
+  NS_LOG_FUNCTION (this << &buffer);
+  m_etherType = ReadNtohU16 (buffer + 6);
+  return LLC_SNAP_HEADER_LENGTH;
 }
 
 
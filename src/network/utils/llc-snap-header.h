@@ -23,7 +23,7 @@
 
 #include <stdint.h>
 #include <string>
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 
 namespace ns3 {
 
@@ -39,7 +39,7 @@ static const uint16_t LLC_SNAP_HEADER_LENGTH = 8;
  *
  * For a list of EtherTypes, see http://www.iana.org/assignments/ieee-802-numbers/ieee-802-numbers.xhtml
  */
-class LlcSnapHeader : public Header 
+class LlcSnapHeader : public FixedSizeHeader<LlcSnapHeader, LLC_SNAP_HEADER_LENGTH>
 {
 public:
   LlcSnapHeader ();
@@ -62,9 +62,15 @@ public:
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
-  virtual uint32_t GetSerializedSize (void) const;
-  virtual void Serialize (Buffer::Iterator start) const;
-  virtual uint32_t Deserialize (Buffer::Iterator start);
+  /**
+   * \param buffer where to write the LLC_SNAP_HEADER_LENGTH bytes of the header
+   */
+  void SerializeTo (uint8_t *buffer) const;
+  /**
+   * \param buffer where to read the LLC_SNAP_HEADER_LENGTH bytes of the header
+   * \return the number of bytes read
+   */
+  uint32_t DeserializeFrom (const uint8_t *buffer);
 private:
   uint16_t m_etherType; //!< the Ethertype
 };
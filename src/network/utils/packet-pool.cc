@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-pool.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketPool");
+
+NS_OBJECT_ENSURE_REGISTERED (PacketPool);
+
+TypeId
+PacketPool::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PacketPool")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<PacketPool> ()
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets held by the pool.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&PacketPool::SetMaxPackets,
+                                         &PacketPool::GetMaxPackets),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+PacketPool::PacketPool ()
+  : m_maxPackets (0),
+    m_recycled (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PacketPool::~PacketPool ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PacketPool::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_packets.Clear ();
+  Object::DoDispose ();
+}
+
+void
+PacketPool::SetMaxPackets (uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << maxPackets);
+  m_maxPackets = maxPackets;
+  while (m_packets.GetSize () > m_maxPackets)
+    {
+      m_packets.Pop ();
+    }
+  m_packets.Reserve (m_maxPackets);
+}
+
+uint32_t
+PacketPool::GetMaxPackets (void) const
+{
+  return m_maxPackets;
+}
+
+Ptr<Packet>
+PacketPool::Get (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  if (!m_packets.IsEmpty ())
+    {
+      Ptr<Packet> packet = m_packets.Front ();
+      m_packets.Pop ();
+      // The copies of the packet sent down the stack share its
+      // bytes until they are delivered or dropped too
+      if (packet->GetReferenceCount () == 1 && !packet->IsBufferShared ())
+        {
+          packet->Reset (size);
+          m_recycled++;
+          return packet;
+        }
+      // Still in use: check it again after the packets released later,
+      // rather than letting it block the pool
+      m_packets.Push (packet);
+    }
+  return Create<Packet> (size);
+}
+
+void
+PacketPool::Release (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  if (m_packets.GetSize () < m_maxPackets)
+    {
+      m_packets.Push (packet);
+    }
+}
+
+uint32_t
+PacketPool::GetNPackets (void) const
+{
+  return m_packets.GetSize ();
+}
+
+uint64_t
+PacketPool::GetNRecycled (void) const
+{
+  return m_recycled;
+}
+
+} // namespace ns3
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ring-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief A pool of packets which are reused once nobody refers to them
+ *
+ * Traffic generators create a new packet for each send.  Instead, they
+ * can take their packets from a PacketPool with Get, and give them back
+ * with Release right after handing them to a socket or a net device.
+ * The pool keeps the released packets in the order of their release,
+ * and Get reuses the oldest one once the pool holds its last reference
+ * and no copy of the packet shares its byte buffer any more, that is
+ * once the packet and its copies have been delivered or dropped by all
+ * the layers they went through.  The reused packet gets a new uid,
+ * loses its tags and metadata, and keeps its byte buffer, so that a
+ * steady flow of sends allocates neither packets nor buffers.
+ *
+ * The pool holds up to MaxPackets packets: Release forgets the packets
+ * which do not fit.  A packet given to Release must not be modified
+ * afterwards by its caller.
+ */
+class PacketPool : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  PacketPool ();
+  virtual ~PacketPool ();
+
+  /**
+   * \brief Get a packet with a zero-filled payload.
+   *
+   * \param size the size of the payload
+   * \return a released packet which nobody else refers to, reset as if
+   *         it was created by Create<Packet> (size), or a new packet
+   */
+  Ptr<Packet> Get (uint32_t size);
+  /**
+   * \brief Give a packet back to the pool.
+   *
+   * The packet is reused by Get once the other references to it are
+   * gone.
+   *
+   * \param packet the packet
+   */
+  void Release (Ptr<Packet> packet);
+  /**
+   * \return the number of packets held by the pool
+   */
+  uint32_t GetNPackets (void) const;
+  /**
+   * \return the number of packets reused by Get so far
+   */
+  uint64_t GetNRecycled (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Set the maximum number of packets held by the pool.
+   * \param maxPackets the maximum number of packets
+   */
+  void SetMaxPackets (uint32_t maxPackets);
+  /**
+   * \brief Get the maximum number of packets held by the pool.
+   * \return the maximum number of packets
+   */
+  uint32_t GetMaxPackets (void) const;
+
+  RingBuffer<Ptr<Packet> > m_packets; //!< the released packets, oldest first
+  uint32_t m_maxPackets;              //!< the maximum number of packets
+  uint64_t m_recycled;                //!< the number of reused packets
+};
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_H */
@@ -203,4 +203,42 @@ Queue::Drop (Ptr<Packet> p)
   m_traceDrop (p);
 }
 
+void
+Queue::SetMarkCallback (MarkCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_markCallback = cb;
+}
+
+bool
+Queue::Mark (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  if (m_markCallback.IsNull ())
+    {
+      return false;
+    }
+  return m_markCallback (p);
+}
+
+void
+Queue::SetFlowKeyCallback (FlowKeyCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_flowKeyCallback = cb;
+}
+
+uint32_t
+Queue::GetFlowKey (Ptr<const Packet> p, uint8_t *key)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  if (m_flowKeyCallback.IsNull ())
+    {
+      return 0;
+    }
+  return m_flowKeyCallback (p, key);
+}
+
 } // namespace ns3
@@ -119,6 +119,47 @@ public:
    */
   void ResetStatistics (void);
 
+  /**
+   * \brief Callback to set the ECN Congestion Experienced codepoint of a packet.
+   *
+   * The callback returns true if the packet was ECN-capable and has
+   * been marked, false otherwise.
+   */
+  typedef Callback<bool, Ptr<Packet> > MarkCallback;
+
+  /**
+   * \brief Set the callback used by active queue management to mark
+   *        packets instead of dropping them.
+   *
+   * Only the owner of the queue (usually a NetDevice) knows the link
+   * layer framing in front of the IP header, so it is expected to
+   * install this callback.  Queues made of other queues override
+   * this method to pass the callback on to them.
+   *
+   * \param cb the mark callback
+   */
+  virtual void SetMarkCallback (MarkCallback cb);
+
+  /**
+   * \brief Callback to get the fields which identify the flow of a packet.
+   *
+   * The callback writes the key of the flow into the buffer, which holds
+   * flowUtils::MAX_KEY_SIZE bytes, and returns its size, or 0 if the
+   * flow of the packet cannot be identified.
+   */
+  typedef Callback<uint32_t, Ptr<const Packet>, uint8_t *> FlowKeyCallback;
+
+  /**
+   * \brief Set the callback used by multi-queue disciplines to classify
+   *        packets into flows.
+   *
+   * As for the mark callback, the owner of the queue is expected to
+   * install this callback.
+   *
+   * \param cb the flow key callback
+   */
+  void SetFlowKeyCallback (FlowKeyCallback cb);
+
   /**
    * \brief Enumeration of the modes supported in the class.
    *
@@ -180,6 +221,23 @@ protected:
    */
   void Drop (Ptr<Packet> packet);
 
+  /**
+   *  \brief Mark a packet with ECN Congestion Experienced
+   *  \param packet packet to mark
+   *  \return true if the packet has been marked, false if it is not
+   *  ECN-capable or no mark callback has been set
+   */
+  bool Mark (Ptr<Packet> packet);
+
+  /**
+   *  \brief Get the key of the flow of a packet
+   *  \param packet the packet
+   *  \param key buffer of flowUtils::MAX_KEY_SIZE bytes receiving the key
+   *  \return the size of the key, 0 if the flow cannot be identified or
+   *  no flow key callback has been set
+   */
+  uint32_t GetFlowKey (Ptr<const Packet> packet, uint8_t *key);
+
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const Packet> > m_traceEnqueue;
   /// Traced callback: fired when a packet is dequeued
@@ -193,6 +251,8 @@ protected:
   uint32_t m_nTotalReceivedPackets; //!< Total received packets
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalDroppedPackets;  //!< Total dropped packets
+  MarkCallback m_markCallback;      //!< ECN mark callback
+  FlowKeyCallback m_flowKeyCallback; //!< flow key callback
 };
 
 } // namespace ns3
@@ -0,0 +1,389 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "red-batch.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RedBatch");
+
+RedBatch::Params::Params ()
+  : minTh (5),
+    maxTh (15),
+    qW (0.002),
+    alpha (0.01),
+    beta (0.9),
+    targetDelay (Seconds (0.005))
+{
+}
+
+RedBatch::Config::Config ()
+  : linkBandwidth (DataRate ("1.5Mbps")),
+    linkDelay (MilliSeconds (20)),
+    meanPktSize (500),
+    queueLimit (25),
+    lInterm (50),
+    isWait (true),
+    isGentle (true),
+    isAdaptive (false),
+    interval (Seconds (0.5)),
+    top (0.5),
+    bottom (0.0),
+    rtt (Seconds (0.1))
+{
+}
+
+RedBatch::RedBatch (const Config &config)
+  : m_config (config)
+{
+  NS_LOG_FUNCTION (this);
+  m_ptc = m_config.linkBandwidth.GetBitRate () / (8.0 * m_config.meanPktSize);
+  m_stepsPerSecond = Seconds (1).GetTimeStep ();
+  m_interval = m_config.interval.GetTimeStep ();
+
+  m_bottom = m_config.bottom;
+  if (m_bottom == 0)
+    {
+      m_bottom = 0.01;
+      double bottom1 = (8.0 * m_config.meanPktSize * m_config.rtt.GetSeconds ())
+        / m_config.linkBandwidth.GetBitRate ();
+      if (bottom1 < m_bottom)
+        {
+          m_bottom = bottom1;
+        }
+    }
+}
+
+uint32_t
+RedBatch::AddLane (const Params &params)
+{
+  NS_LOG_FUNCTION (this << params.minTh << params.maxTh << params.qW
+                        << params.alpha << params.beta << params.targetDelay);
+  NS_ASSERT (params.minTh <= params.maxTh);
+
+  double minTh = params.minTh;
+  double maxTh = params.maxTh;
+
+  // vA, vB, vC and vD come from the configured thresholds, as in
+  // RedQueue::InitializeParams
+  double thDiff = maxTh - minTh;
+  if (thDiff == 0)
+    {
+      thDiff = 1.0;
+    }
+  double curMaxP = 1.0 / m_config.lInterm;
+  m_vA.push_back (1.0 / thDiff);
+  m_vB.push_back (-minTh / thDiff);
+  m_vC.push_back (m_config.isGentle ? (1.0 - curMaxP) / maxTh : 0.0);
+  m_vD.push_back (m_config.isGentle ? 2.0 * curMaxP - 1.0 : 0.0);
+
+  // Derive the other parameters as RedQueue::UpdateLinkParams does
+  double qW = params.qW;
+  if (qW == 0.0)
+    {
+      qW = 1.0 - std::exp (-1.0 / m_ptc);
+    }
+  else if (qW == -1.0)
+    {
+      double rtt = 3.0 * (m_config.linkDelay.GetSeconds () + 1.0 / m_ptc);
+      if (rtt < 0.1)
+        {
+          rtt = 0.1;
+        }
+      qW = 1.0 - std::exp (-1.0 / (10 * rtt * m_ptc));
+    }
+  else if (qW == -2.0)
+    {
+      qW = 1.0 - std::exp (-10.0 / m_ptc);
+    }
+
+  if (minTh == 0 && maxTh == 0)
+    {
+      minTh = 5.0;
+      double targetqueue = params.targetDelay.GetSeconds () * m_ptc;
+      if (minTh < targetqueue / 2.0)
+        {
+          minTh = targetqueue / 2.0;
+        }
+      maxTh = 3 * minTh;
+    }
+
+  m_minTh.push_back (minTh);
+  m_maxTh.push_back (maxTh);
+  m_qW.push_back (qW);
+  m_alpha.push_back (params.alpha);
+  m_beta.push_back (params.beta);
+  m_targetDelay.push_back (params.targetDelay);
+
+  RedQueue::Stats stats = { 0, 0, 0, 0 };
+  m_qAvg.push_back (0.0);
+  m_curMaxP.push_back (curMaxP);
+  m_count.push_back (0);
+  m_old.push_back (0);
+  m_lastSet.push_back (0);
+  m_starts.push_back (RingBuffer<int64_t> ());
+  m_starts.back ().Reserve (m_config.queueLimit);
+  m_lastFinish.push_back (0);
+  m_stats.push_back (stats);
+  m_accepted.push_back (0);
+  m_delaySum.push_back (0.0);
+
+  m_nQueued.push_back (0.0);
+  m_decay.push_back (0.0);
+  m_prob.push_back (0.0);
+
+  return m_qAvg.size () - 1;
+}
+
+uint32_t
+RedBatch::GetNLanes (void) const
+{
+  return m_qAvg.size ();
+}
+
+void
+RedBatch::Enqueue (Time time, uint32_t size, double u)
+{
+  NS_LOG_FUNCTION (this << time << size << u);
+  uint32_t n = GetNLanes ();
+  int64_t now = time.GetTimeStep ();
+
+  /*
+   * Drain the queues up to the arrival time.  The packets whose
+   * transmission has started have left the queue; a queue which is
+   * empty once the transmitter is done has been idle since then.  The
+   * average decays once more per packet which could have been sent
+   * while idle, as in RedQueue::DoEnqueue.
+   */
+  for (uint32_t i = 0; i < n; i++)
+    {
+      RingBuffer<int64_t> &starts = m_starts[i];
+      while (!starts.IsEmpty () && starts.Front () <= now)
+        {
+          starts.Pop ();
+        }
+      m_nQueued[i] = starts.GetSize ();
+      uint32_t m = 0;
+      if (starts.IsEmpty () && m_lastFinish[i] <= now)
+        {
+          m = uint32_t (m_ptc * ((now - m_lastFinish[i]) / m_stepsPerSecond));
+        }
+      m_decay[i] = m + 1.0;
+    }
+
+  // Average queue size, as RedQueue::Estimator
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double decay = m_decay[i] > 1 ? std::pow (1.0 - m_qW[i], m_decay[i]) : 1.0 - m_qW[i];
+      m_qAvg[i] = m_qAvg[i] * decay + m_qW[i] * m_nQueued[i];
+    }
+
+  if (m_config.isAdaptive)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (now > m_lastSet[i] + m_interval)
+            {
+              UpdateMaxP (i, now);
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_count[i]++;
+    }
+
+  // Early drop probability of all the lanes, used by those which need it
+  CalculatePNew (n, &m_qAvg[0], &m_maxTh[0], m_config.isGentle, &m_vA[0], &m_vB[0],
+                 &m_vC[0], &m_vD[0], &m_curMaxP[0], &m_prob[0]);
+  ModifyP (n, &m_prob[0], &m_count[0], m_config.isWait, &m_prob[0]);
+
+  int64_t txTime = m_config.linkBandwidth.CalculateBytesTxTime (size).GetTimeStep ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double qAvg = m_qAvg[i];
+      uint32_t dropType = RedQueue::DTYPE_NONE;
+      if (qAvg >= m_minTh[i] && m_nQueued[i] > 1)
+        {
+          if ((!m_config.isGentle && qAvg >= m_maxTh[i])
+              || (m_config.isGentle && qAvg >= 2 * m_maxTh[i]))
+            {
+              dropType = RedQueue::DTYPE_FORCED;
+            }
+          else if (m_old[i] == 0)
+            {
+              m_count[i] = 1;
+              m_old[i] = 1;
+            }
+          else if (u <= m_prob[i])
+            {
+              m_count[i] = 0;
+              dropType = RedQueue::DTYPE_UNFORCED;
+            }
+        }
+      else
+        {
+          m_old[i] = 0;
+        }
+
+      if (m_nQueued[i] >= m_config.queueLimit)
+        {
+          dropType = RedQueue::DTYPE_FORCED;
+          m_stats[i].qLimDrop++;
+        }
+
+      if (dropType == RedQueue::DTYPE_UNFORCED)
+        {
+          m_stats[i].unforcedDrop++;
+        }
+      else if (dropType == RedQueue::DTYPE_FORCED)
+        {
+          m_stats[i].forcedDrop++;
+        }
+      else
+        {
+          // The packet is sent when the transmitter is done with the
+          // packets ahead of it, at once if it is idle
+          int64_t start = std::max (now, m_lastFinish[i]);
+          if (start > now)
+            {
+              m_starts[i].Push (start);
+            }
+          m_lastFinish[i] = start + txTime;
+          m_accepted[i]++;
+          m_delaySum[i] += (start - now) / m_stepsPerSecond;
+        }
+    }
+}
+
+void
+RedBatch::UpdateMaxP (uint32_t i, int64_t now)
+{
+  double part = 0.4 * (m_maxTh[i] - m_minTh[i]);
+  if (m_qAvg[i] < m_minTh[i] + part && m_curMaxP[i] > m_bottom)
+    {
+      m_curMaxP[i] = m_curMaxP[i] * m_beta[i];
+      m_lastSet[i] = now;
+    }
+  else if (m_qAvg[i] > m_maxTh[i] - part && m_config.top > m_curMaxP[i])
+    {
+      double alpha = m_alpha[i];
+      if (alpha > 0.25 * m_curMaxP[i])
+        {
+          alpha = 0.25 * m_curMaxP[i];
+        }
+      m_curMaxP[i] = m_curMaxP[i] + alpha;
+      m_lastSet[i] = now;
+    }
+}
+
+RedBatch::Params
+RedBatch::GetParams (uint32_t lane) const
+{
+  NS_ASSERT (lane < GetNLanes ());
+  Params params;
+  params.minTh = m_minTh[lane];
+  params.maxTh = m_maxTh[lane];
+  params.qW = m_qW[lane];
+  params.alpha = m_alpha[lane];
+  params.beta = m_beta[lane];
+  params.targetDelay = m_targetDelay[lane];
+  return params;
+}
+
+RedQueue::Stats
+RedBatch::GetStats (uint32_t lane) const
+{
+  NS_ASSERT (lane < GetNLanes ());
+  return m_stats[lane];
+}
+
+double
+RedBatch::GetAverageQueueSize (uint32_t lane) const
+{
+  NS_ASSERT (lane < GetNLanes ());
+  return m_qAvg[lane];
+}
+
+double
+RedBatch::GetCurMaxP (uint32_t lane) const
+{
+  NS_ASSERT (lane < GetNLanes ());
+  return m_curMaxP[lane];
+}
+
+Time
+RedBatch::GetAverageDelay (uint32_t lane) const
+{
+  NS_ASSERT (lane < GetNLanes ());
+  if (m_accepted[lane] == 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (m_delaySum[lane] / m_accepted[lane]);
+}
+
+/*
+ * The batch functions compute every branch of their scalar counterparts
+ * and select the result, so that the loops have no data-dependent
+ * control flow and can be vectorized.
+ */
+void
+RedBatch::CalculatePNew (uint32_t n, const double *qAvg, const double *maxTh,
+                         bool isGentle, const double *vA, const double *vB,
+                         const double *vC, const double *vD,
+                         const double *maxP, double *p)
+{
+  double above = 1.0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double linear = (vA[i] * qAvg[i] + vB[i]) * maxP[i];
+      if (isGentle)
+        {
+          above = vC[i] * qAvg[i] + vD[i];
+        }
+      double pi = qAvg[i] >= maxTh[i] ? above : linear;
+      p[i] = pi > 1.0 ? 1.0 : pi;
+    }
+}
+
+void
+RedBatch::ModifyP (uint32_t n, const double *pNew, const uint32_t *count,
+                   bool isWait, double *p)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double pi = pNew[i];
+      double cp = count[i] * pi;
+      double result;
+      if (isWait)
+        {
+          result = cp < 1.0 ? 0.0 : (cp < 2.0 ? pi / (2.0 - cp) : 1.0);
+        }
+      else
+        {
+          result = cp < 1.0 ? pi / (1.0 - cp) : 1.0;
+        }
+      p[i] = result > 1.0 ? 1.0 : result;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef RED_BATCH_H
+#define RED_BATCH_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/red-queue.h"
+#include "ns3/ring-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief Many (Adaptive) RED queues, with different parameters, fed
+ * with the same packet arrivals
+ *
+ * Each RED queue is a "lane" with its own thresholds, queue weight,
+ * Adaptive RED alpha and beta and target delay; the other parameters
+ * are common to all the lanes.  Each lane models a RedQueue in packet
+ * mode in front of a PointToPointNetDevice transmitting at the link
+ * bandwidth: the queue is drained in the background and goes idle when
+ * the transmitter finds it empty, as in a simulation.  The state of
+ * the lanes is stored as arrays, and the average queue size and drop
+ * probability of all the lanes are computed by loops over the arrays
+ * which the compiler can vectorize.
+ *
+ * This is used to replay a trace of the packets offered to a RED queue
+ * (see utils/red-replay.cc) with thousands of parameter combinations
+ * instead of running one simulation per combination.  The replay is
+ * open-loop: the arrivals do not react to the drops, as TCP sources
+ * would.  All the lanes compare their drop probability with the same
+ * random number for a given arrival, which makes the comparison between
+ * lanes more precise (common random numbers).
+ *
+ * Times are stored as integer time steps rather than as Time objects,
+ * so that no Time is constructed per lane and arrival: Time objects
+ * are costly to create before the simulator has run.
+ */
+class RedBatch
+{
+public:
+  /**
+   * \brief The parameters of a lane
+   */
+  struct Params
+  {
+    Params ();
+    double minTh;       //!< Min avg length threshold (packets); 0 with maxTh 0 to derive both from targetDelay
+    double maxTh;       //!< Max avg length threshold (packets)
+    double qW;          //!< Queue weight; 0, -1 or -2 to derive it from the link bandwidth
+    double alpha;       //!< Increment parameter for max_p in Adaptive RED
+    double beta;        //!< Decrement parameter for max_p in Adaptive RED
+    Time targetDelay;   //!< Target average queuing delay in Adaptive RED
+  };
+
+  /**
+   * \brief The parameters common to all the lanes
+   *
+   * The default values are those of the RedQueue attributes.
+   */
+  struct Config
+  {
+    Config ();
+    DataRate linkBandwidth; //!< Link bandwidth
+    Time linkDelay;         //!< Link delay, used when qW is -1
+    uint32_t meanPktSize;   //!< Avg pkt size
+    uint32_t queueLimit;    //!< Queue limit in packets
+    double lInterm;         //!< The initial max_p is 1 / lInterm
+    bool isWait;            //!< True for waiting between dropped packets
+    bool isGentle;          //!< True to increase the drop probability slowly above maxTh
+    bool isAdaptive;        //!< True to enable Adaptive RED
+    Time interval;          //!< Time period to adapt max_p in Adaptive RED
+    double top;             //!< Upper bound for max_p in Adaptive RED
+    double bottom;          //!< Lower bound for max_p in Adaptive RED; 0 to derive it from the link bandwidth
+    Time rtt;               //!< Rtt used to derive bottom
+  };
+
+  /**
+   * \brief Constructor
+   * \param config the parameters common to all the lanes
+   */
+  RedBatch (const Config &config);
+
+  /**
+   * \brief Add a lane.
+   *
+   * The parameters which are to be derived from the link bandwidth are
+   * computed as RedQueue does when it starts.  Lanes should be added
+   * before the first arrival.
+   *
+   * \param params the parameters of the lane
+   * \return the index of the lane
+   */
+  uint32_t AddLane (const Params &params);
+  /**
+   * \return the number of lanes
+   */
+  uint32_t GetNLanes (void) const;
+
+  /**
+   * \brief Offer a packet to all the lanes.
+   *
+   * Arrivals must be offered in time order.
+   *
+   * \param time the arrival time
+   * \param size the size of the packet in bytes, as seen by the device
+   * \param u a random number uniformly distributed in [0, 1), compared
+   *        with the early drop probability of each lane
+   */
+  void Enqueue (Time time, uint32_t size, double u);
+
+  /**
+   * \param lane the index of the lane
+   * \return the parameters of the lane, once derived from the link bandwidth
+   */
+  Params GetParams (uint32_t lane) const;
+  /**
+   * \param lane the index of the lane
+   * \return the drop statistics of the lane
+   */
+  RedQueue::Stats GetStats (uint32_t lane) const;
+  /**
+   * \param lane the index of the lane
+   * \return the average queue size of the lane, in packets
+   */
+  double GetAverageQueueSize (uint32_t lane) const;
+  /**
+   * \param lane the index of the lane
+   * \return the current max_p of the lane
+   */
+  double GetCurMaxP (uint32_t lane) const;
+  /**
+   * \param lane the index of the lane
+   * \return the mean queuing delay of the packets accepted by the lane
+   */
+  Time GetAverageDelay (uint32_t lane) const;
+
+  /**
+   * \brief Compute the drop probability before "count" of a batch of
+   * RED queue states, as RedQueue::CalculatePNew does for one.
+   *
+   * \param n the number of states
+   * \param qAvg the average queue sizes
+   * \param maxTh the max avg length thresholds
+   * \param isGentle "gentle" algorithm
+   * \param vA the vA of each state
+   * \param vB the vB of each state
+   * \param vC the vC of each state
+   * \param vD the vD of each state
+   * \param maxP the current max_p of each state
+   * \param p the n probabilities
+   */
+  static void CalculatePNew (uint32_t n, const double *qAvg, const double *maxTh,
+                             bool isGentle, const double *vA, const double *vB,
+                             const double *vC, const double *vD,
+                             const double *maxP, double *p);
+  /**
+   * \brief Compute the drop probability of a batch of RED queue states in
+   * packet mode, as RedQueue::ModifyP does for one.
+   *
+   * \param n the number of states
+   * \param pNew the probabilities before "count", from CalculatePNew
+   * \param count the number of packets since the last drop of each state
+   * \param isWait True for waiting between dropped packets
+   * \param p the n probabilities; may be the same array as pNew
+   */
+  static void ModifyP (uint32_t n, const double *pNew, const uint32_t *count,
+                       bool isWait, double *p);
+
+private:
+  /**
+   * \brief Adapt max_p of a lane, as RedQueue::UpdateMaxP does.
+   * \param i the index of the lane
+   * \param now the current time, in time steps
+   */
+  void UpdateMaxP (uint32_t i, int64_t now);
+
+  Config m_config;   //!< the parameters common to all the lanes
+  double m_ptc;      //!< packet time constant in packets/second
+  double m_bottom;   //!< Lower bound for max_p in Adaptive RED
+  double m_stepsPerSecond; //!< Number of time steps per second
+  int64_t m_interval;      //!< Time period to adapt max_p, in time steps
+
+  // ** Parameters of the lanes
+  std::vector<double> m_minTh;  //!< Min avg length threshold
+  std::vector<double> m_maxTh;  //!< Max avg length threshold
+  std::vector<double> m_qW;     //!< Queue weight
+  std::vector<double> m_alpha;  //!< Increment parameter for max_p
+  std::vector<double> m_beta;   //!< Decrement parameter for max_p
+  std::vector<Time> m_targetDelay; //!< Target average queuing delay
+  std::vector<double> m_vA;     //!< 1.0 / (maxTh - minTh)
+  std::vector<double> m_vB;     //!< -minTh / (maxTh - minTh)
+  std::vector<double> m_vC;     //!< (1.0 - maxP) / maxTh - used in "gentle" mode
+  std::vector<double> m_vD;     //!< 2.0 * maxP - 1.0 - used in "gentle" mode
+
+  // ** State of the lanes
+  std::vector<double> m_qAvg;      //!< Average queue length
+  std::vector<double> m_curMaxP;   //!< Current max_p
+  std::vector<uint32_t> m_count;   //!< Number of packets since last drop
+  std::vector<uint32_t> m_old;     //!< 0 when average queue first exceeds threshold
+  std::vector<int64_t> m_lastSet;  //!< Last time max_p was adapted
+  std::vector<RingBuffer<int64_t> > m_starts; //!< Transmission start times of the queued packets
+  std::vector<int64_t> m_lastFinish; //!< End of the last transmission
+  std::vector<RedQueue::Stats> m_stats; //!< Drop statistics
+  std::vector<uint64_t> m_accepted; //!< Number of accepted packets
+  std::vector<double> m_delaySum;  //!< Sum of the queuing delays of the accepted packets, in seconds
+
+  // ** Scratch arrays, one element per lane, for the current arrival
+  std::vector<double> m_nQueued;   //!< Queue size
+  std::vector<double> m_decay;     //!< Number of decays of the average
+  std::vector<double> m_prob;      //!< Drop probability
+};
+
+} // namespace ns3
+
+#endif /* RED_BATCH_H */
@@ -178,10 +178,21 @@ TypeId RedQueue::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&RedQueue::m_isNs1Compat),
                    MakeBooleanChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to mark ECN-capable packets with Congestion Experienced instead of dropping them early",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueue::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseSojournTime",
+                   "True to adapt the maximum drop probability of Adaptive RED to the average sojourn time of the packets, rather than to the average queue size",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueue::m_useSojournTime),
+                   MakeBooleanChecker ())
     .AddAttribute ("LinkBandwidth", 
                    "The RED link bandwidth",
                    DataRateValue (DataRate ("1.5Mbps")),
-                   MakeDataRateAccessor (&RedQueue::m_linkBandwidth),
+                   MakeDataRateAccessor (&RedQueue::SetLinkBandwidth,
+                                         &RedQueue::GetLinkBandwidth),
                    MakeDataRateChecker ())
     .AddAttribute ("LinkDelay", 
                    "The RED link delay",
@@ -197,7 +208,9 @@ RedQueue::RedQueue () :
   Queue (),
   m_packets (),
   m_bytesInQueue (0),
-  m_hasRedStarted (false)
+  m_hasRedStarted (false),
+  m_qAvg (0.0),
+  m_sojournAvg (0.0)
 {
   NS_LOG_FUNCTION (this);
   m_uv = CreateObject<UniformRandomVariable> ();
@@ -276,6 +289,39 @@ RedQueue::SetTh (double minTh, double maxTh)
   m_maxTh = maxTh;
 }
 
+void
+RedQueue::SetLinkBandwidth (DataRate bw)
+{
+  NS_LOG_FUNCTION (this << bw);
+  m_linkBandwidth = bw;
+  if (m_hasRedStarted)
+    {
+      NS_LOG_INFO ("Link bandwidth changed, updating RED params.");
+      UpdateLinkParams ();
+    }
+}
+
+DataRate
+RedQueue::GetLinkBandwidth (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_linkBandwidth;
+}
+
+double
+RedQueue::GetAverageQueueSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_qAvg;
+}
+
+Time
+RedQueue::GetAverageSojournTime (void)
+{
+  NS_LOG_FUNCTION (this);
+  return Seconds (m_sojournAvg);
+}
+
 RedQueue::Stats
 RedQueue::GetStats ()
 {
@@ -313,7 +359,7 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
       NS_LOG_DEBUG ("Enqueue in packets mode");
-      nQueued = m_packets.size ();
+      nQueued = m_packets.GetSize ();
     }
 
   // simulate number of packets arrival during idle period
@@ -334,13 +380,19 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
           m = uint32_t (m_ptc * (now - m_idleTime).GetSeconds ());
         }
 
+      if (m_useSojournTime && m > 0)
+        {
+          // The packets which could have been sent while idle did not wait
+          m_sojournAvg *= std::pow (1.0 - m_qW, static_cast<double> (m));
+        }
+
       m_idle = 0;
     }
 
   m_qAvg = Estimator (nQueued, m + 1, m_qAvg, m_qW);
 
   NS_LOG_DEBUG ("\t bytesInQueue  " << m_bytesInQueue << "\tQavg " << m_qAvg);
-  NS_LOG_DEBUG ("\t packetsInQueue  " << m_packets.size () << "\tQavg " << m_qAvg);
+  NS_LOG_DEBUG ("\t packetsInQueue  " << m_packets.GetSize () << "\tQavg " << m_qAvg);
 
   m_count++;
   m_countBytes += p->GetSize ();
@@ -388,10 +440,22 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
 
   if (dropType == DTYPE_UNFORCED)
     {
-      NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
-      m_stats.unforcedDrop++;
-      Drop (p);
-      return false;
+      /*
+       * With ECN, an ECN-capable packet is marked in place and then
+       * queued like any other packet.  Not-ECT packets are dropped.
+       */
+      if (m_useEcn && Mark (p))
+        {
+          NS_LOG_DEBUG ("\t Marking due to Prob Mark " << m_qAvg);
+          m_stats.unforcedMark++;
+        }
+      else
+        {
+          NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
+          m_stats.unforcedDrop++;
+          Drop (p);
+          return false;
+        }
     }
   else if (dropType == DTYPE_FORCED)
     {
@@ -407,20 +471,20 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
     }
 
   m_bytesInQueue += p->GetSize ();
-  m_packets.push_back (p);
+  Item item;
+  item.packet = p;
+  if (m_useSojournTime)
+    {
+      item.tstamp = Simulator::Now ().GetTimeStep ();
+    }
+  m_packets.Push (item);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return true;
 }
 
-/*
- * Note: if the link bandwidth changes in the course of the
- * simulation, the bandwidth-dependent RED parameters do not change.
- * This should be fixed, but it would require some extra parameters,
- * and didn't seem worth the trouble...
- */
 void
 RedQueue::InitializeParams (void)
 {
@@ -430,11 +494,12 @@ RedQueue::InitializeParams (void)
   m_stats.forcedDrop = 0;
   m_stats.unforcedDrop = 0;
   m_stats.qLimDrop = 0;
+  m_stats.unforcedMark = 0;
 
   m_cautious = 0;
-  m_ptc = m_linkBandwidth.GetBitRate () / (8.0 * m_meanPktSize);
 
   m_qAvg = 0.0;
+  m_sojournAvg = 0.0;
   m_count = 0;
   m_countBytes = 0;
   m_old = 0;
@@ -456,6 +521,36 @@ RedQueue::InitializeParams (void)
     }
   m_idleTime = NanoSeconds (0);
 
+  // Remember which parameters are to be derived from the link bandwidth
+  m_qWMode = m_qW;
+  m_isAutoTh = (m_minTh == 0 && m_maxTh == 0);
+  m_isAutoBottom = (m_bottom == 0);
+  UpdateLinkParams ();
+
+  // Allocate the packet storage for a full queue at once
+  if (GetMode () == QUEUE_MODE_BYTES)
+    {
+      m_packets.Reserve (m_queueLimit / m_meanPktSize + 1);
+    }
+  else
+    {
+      m_packets.Reserve (m_queueLimit);
+    }
+}
+
+/*
+ * Compute the parameters which depend on the link bandwidth.  This is
+ * done when RED starts, and again whenever the link bandwidth changes;
+ * the state of the queue (average queue size, count since the last
+ * drop, current max_p of Adaptive RED) is left untouched.
+ */
+void
+RedQueue::UpdateLinkParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_ptc = m_linkBandwidth.GetBitRate () / (8.0 * m_meanPktSize);
+
 /*
  * If m_qW=0, set it to a reasonable value of 1-exp(-1/C)
  * This corresponds to choosing m_qW to be of that value for
@@ -469,11 +564,11 @@ RedQueue::InitializeParams (void)
  *
  * If m_qW=-2, set it to a reasonable value of 1-exp(-10/C).
  */
-  if (m_qW == 0.0)
+  if (m_qWMode == 0.0)
     {
       m_qW = 1.0 - std::exp (-1.0 / m_ptc);
     }
-  else if (m_qW == -1.0)
+  else if (m_qWMode == -1.0)
     {
       double rtt = 3.0 * (m_linkDelay.GetSeconds () + 1.0 / m_ptc);
 
@@ -483,12 +578,12 @@ RedQueue::InitializeParams (void)
         }
       m_qW = 1.0 - std::exp (-1.0 / (10 * rtt * m_ptc));
     }
-  else if (m_qW == -2.0)
+  else if (m_qWMode == -2.0)
     {
       m_qW = 1.0 - std::exp (-10.0 / m_ptc);
     }
 
-  if (m_minTh == 0 && m_maxTh == 0) 
+  if (m_isAutoTh)
     {
       m_minTh = 5.0;
 
@@ -508,7 +603,7 @@ RedQueue::InitializeParams (void)
       m_maxTh = 3 * m_minTh;
     }
 
-  if (m_bottom == 0)
+  if (m_isAutoBottom)
     {
       m_bottom = 0.01;
       // Set bottom to at most 1/W, where W is the delay-bandwidth
@@ -524,7 +619,7 @@ RedQueue::InitializeParams (void)
   NS_LOG_DEBUG ("\tm_delay " << m_linkDelay.GetSeconds () << "; m_isWait " 
                              << m_isWait << "; m_qW " << m_qW << "; m_ptc " << m_ptc
                              << "; m_minTh " << m_minTh << "; m_maxTh " << m_maxTh
-                             << "; m_isGentle " << m_isGentle << "; th_diff " << th_diff
+                             << "; m_isGentle " << m_isGentle
                              << "; lInterm " << m_lInterm << "; va " << m_vA <<  "; cur_max_p "
                              << m_curMaxP << "; v_b " << m_vB <<  "; m_vC "
                              << m_vC << "; m_vD " <<  m_vD);
@@ -535,15 +630,23 @@ RedQueue::InitializeParams (void)
 void
 RedQueue::UpdateMaxP (double newAve, Time now)
 {
-  double m_part = 0.4 * (m_maxTh - m_minTh);
-  // AIMD rule to keep target Q~1/2(m_minTh + m_maxTh)
-  if (newAve < m_minTh + m_part && m_curMaxP > m_bottom)
+  double minTh = m_minTh;
+  double maxTh = m_maxTh;
+  if (m_useSojournTime)
+    {
+      // The thresholds the target delay would give, in seconds
+      minTh = m_targetDelay.GetSeconds () / 2.0;
+      maxTh = 3 * minTh;
+    }
+  double m_part = 0.4 * (maxTh - minTh);
+  // AIMD rule to keep target Q~1/2(minTh + maxTh)
+  if (newAve < minTh + m_part && m_curMaxP > m_bottom)
     {
       // we increase the average queue size, so decrease maximum drop probability
       m_curMaxP = m_curMaxP * m_beta;
       m_lastSet = now;
     } 
-  else if (newAve > m_maxTh - m_part && m_top > m_curMaxP) 
+  else if (newAve > maxTh - m_part && m_top > m_curMaxP) 
     {
       // we decrease the average queue size, so increase maximum drop probability
       double alpha = m_alpha;
@@ -563,18 +666,28 @@ RedQueue::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
   NS_LOG_FUNCTION (this << nQueued << m << qAvg << qW);
   double newAve;
 
+  /*
+   * The average decays once for every packet that could have been
+   * transmitted during the idle period, and once more for the current
+   * arrival.  ns-2 does this with a loop of m multiplications; on fast
+   * links after a long idle period m reaches millions, so the m-fold
+   * decay (1 - qW)^m is computed in closed form instead.
+   */
   newAve = qAvg;
-  while (--m >= 1)
+  if (m > 1)
+    {
+      newAve *= std::pow (1.0 - qW, static_cast<double> (m));
+    }
+  else
     {
       newAve *= 1.0 - qW;
     }
-  newAve *= 1.0 - qW;
   newAve += qW * nQueued;
 
   Time now = Simulator::Now();
   if (m_isAdaptive && now > m_lastSet + m_interval)
     {
-      UpdateMaxP(newAve, now);
+      UpdateMaxP (m_useSojournTime ? m_sojournAvg : newAve, now);
     }
     
   return newAve;
@@ -630,10 +743,9 @@ RedQueue::DropEarly (Ptr<Packet> p, uint32_t qSize)
     {
       NS_LOG_LOGIC ("u <= m_vProb; u " << u << "; m_vProb " << m_vProb);
 
-      // DROP or MARK
+      // DROP or MARK; DoEnqueue marks instead of dropping when ECN is in use
       m_count = 0;
       m_countBytes = 0;
-      /// \todo Implement set bit to mark
 
       return 1; // drop
     }
@@ -745,7 +857,7 @@ RedQueue::GetQueueSize (void)
     }
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
-      return m_packets.size ();
+      return m_packets.GetSize ();
     }
   else
     {
@@ -758,7 +870,7 @@ RedQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       m_idle = 1;
@@ -769,13 +881,19 @@ RedQueue::DoDequeue (void)
   else
     {
       m_idle = 0;
-      Ptr<Packet> p = m_packets.front ();
-      m_packets.pop_front ();
+      Item &item = m_packets.Front ();
+      Ptr<Packet> p = item.packet;
+      if (m_useSojournTime)
+        {
+          Time sojourn = Simulator::Now () - TimeStep (item.tstamp);
+          m_sojournAvg = (1.0 - m_qW) * m_sojournAvg + m_qW * sojourn.GetSeconds ();
+        }
+      m_packets.Pop ();
       m_bytesInQueue -= p->GetSize ();
 
       NS_LOG_LOGIC ("Popped " << p);
 
-      NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+      NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
       NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
       return p;
@@ -786,15 +904,15 @@ Ptr<const Packet>
 RedQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
-  if (m_packets.empty ())
+  if (m_packets.IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
+  Ptr<Packet> p = m_packets.Front ().packet;
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_packets.GetSize ());
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
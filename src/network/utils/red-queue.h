@@ -61,9 +61,9 @@
 #ifndef RED_QUEUE_H
 #define RED_QUEUE_H
 
-#include <queue>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
+#include "ns3/ring-buffer.h"
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
 #include "ns3/data-rate.h"
@@ -109,6 +109,7 @@ public:
     uint32_t unforcedDrop;  //!< Early probability drops
     uint32_t forcedDrop;    //!< Forced drops, qavg > max threshold
     uint32_t qLimDrop;      //!< Drops due to queue limits
+    uint32_t unforcedMark;  //!< Early probability marks (ECN)
   } Stats;
 
   /** 
@@ -187,6 +188,43 @@ public:
    */
   void SetTh (double minTh, double maxTh);
 
+  /**
+   * \brief Set the link bandwidth.
+   *
+   * The packet time constant, and the queue weight, thresholds and
+   * Adaptive RED lower bound when they are set automatically, are
+   * derived from the link bandwidth.  If the queue is already running
+   * they are recomputed at once; the average queue size and the other
+   * state of the queue are kept.  PointToPointNetDevice calls this
+   * (through the LinkBandwidth attribute) when its data rate changes.
+   *
+   * \param bw The link bandwidth.
+   */
+  void SetLinkBandwidth (DataRate bw);
+
+  /**
+   * \brief Get the link bandwidth.
+   *
+   * \returns The link bandwidth.
+   */
+  DataRate GetLinkBandwidth (void) const;
+
+  /**
+   * \brief Get the current average queue size.
+   *
+   * \returns The average queue size in bytes or packets.
+   */
+  double GetAverageQueueSize (void);
+
+  /**
+   * \brief Get the average sojourn time of the dequeued packets.
+   *
+   * This is only measured when the UseSojournTime attribute is set.
+   *
+   * \returns The average sojourn time.
+   */
+  Time GetAverageSojournTime (void);
+
   /**
    * \brief Get the RED statistics after running.
    *
@@ -218,6 +256,10 @@ private:
    * and didn't seem worth the trouble...
    */
   void InitializeParams (void);
+  /**
+   * \brief Compute the parameters which depend on the link bandwidth
+   */
+  void UpdateLinkParams (void);
   /**
    * \brief Compute the average queue size
    * \param nQueued number of queued packets
@@ -229,6 +271,12 @@ private:
   double Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW);
   /**
    * \brief Update the maximum drop probability.
+   *
+   * With UseSojournTime, \p newAve is the average sojourn time, which
+   * is kept between 0.9 and 1.1 times the target delay; this is the
+   * range of the average queue size when the thresholds are derived
+   * from the target delay.
+   *
    * \param newAve new average queue length
    * \param now Current Time
    */
@@ -237,7 +285,7 @@ private:
    * \brief Check if packet p needs to be dropped due to probability mark
    * \param p packet
    * \param qSize queue size
-   * \returns 0 for no drop/mark, 1 for drop
+   * \returns 0 for no drop/mark, 1 for drop/mark
    */
   uint32_t DropEarly (Ptr<Packet> p, uint32_t qSize);
   /**
@@ -267,7 +315,21 @@ private:
   double ModifyP (double p, uint32_t count, uint32_t countBytes,
                   uint32_t meanPktSize, bool wait, uint32_t size);
 
-  std::list<Ptr<Packet> > m_packets; //!< packets in the queue
+  /**
+   * \brief A queued packet and its enqueue time
+   *
+   * The time is stored as an integer number of time steps, since a
+   * Time member would cost a check on every construction, including the
+   * one performed when the ring buffer slot is cleared.
+   */
+  struct Item
+  {
+    Item () : tstamp (0) {}
+    Ptr<Packet> packet; //!< the packet
+    int64_t tstamp;     //!< enqueue time in time steps, set only with UseSojournTime
+  };
+
+  RingBuffer<Item> m_packets; //!< packets in the queue
 
   uint32_t m_bytesInQueue; //!< bytes in the queue
   bool m_hasRedStarted; //!< True if RED has started
@@ -284,15 +346,20 @@ private:
   double m_maxTh;           //!< Max avg length threshold (bytes), should be >= 2*minTh
   uint32_t m_queueLimit;    //!< Queue limit in bytes / packets
   double m_qW;              //!< Queue weight given to cur queue size sample
+  double m_qWMode;          //!< Configured queue weight; 0, -1 or -2 to derive it from the link bandwidth
   double m_lInterm;         //!< The max probability of dropping a packet
   Time m_targetDelay;       //!< Target average queuing delay in Adaptive RED
   Time m_interval;          //!< Time period to calculate maximum drop probability in Adaptive RED
   double m_top;             //!< Upper bound for maximum drop probability in Adaptive RED
   double m_bottom;          //!< Lower bound for maximum drop probability in Adaptive RED
+  bool m_isAutoTh;          //!< True if the thresholds are derived from the link bandwidth
+  bool m_isAutoBottom;      //!< True if m_bottom is derived from the link bandwidth
   double m_alpha;           //!< Increment parameter for maximum drop probability in Adaptive RED
   double m_beta;            //!< Decrement parameter for maximum drop probability in Adaptive RED
   Time m_rtt;               //!< Rtt to be considered while automatically setting m_bottom in Adaptive RED
   bool m_isNs1Compat;       //!< Ns-1 compatibility
+  bool m_useEcn;            //!< True to mark ECN-capable packets instead of early dropping them
+  bool m_useSojournTime;    //!< True to adapt max_p to the average sojourn time in Adaptive RED
   DataRate m_linkBandwidth; //!< Link bandwidth
   Time m_linkDelay;         //!< Link delay
 
@@ -310,6 +377,7 @@ private:
   uint32_t m_idle;          //!< 0/1 idle status
   double m_ptc;             //!< packet time constant in packets/second
   double m_qAvg;            //!< Average queue length
+  double m_sojournAvg;      //!< Average sojourn time of the dequeued packets, in seconds
   uint32_t m_count;         //!< Number of packets since last random number generation
   /**
    * 0 for default RED
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief A FIFO container stored in a circular array
+ *
+ * This is the packet storage of the Queue subclasses.  Unlike std::list
+ * or std::deque, pushing and popping elements does not allocate memory
+ * once the array is large enough: the capacity is a power of two which
+ * is doubled when a push finds the array full, and is never reduced.
+ * Queues whose limit is expressed in packets should call Reserve with
+ * that limit so that the array is allocated once up front.
+ *
+ * A popped slot is reset to a default-constructed T so that, for
+ * instance, a Ptr<Packet> does not keep the packet alive.
+ *
+ * \tparam T the type of the elements
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  RingBuffer ();
+
+  /**
+   * \return true if the container holds no element
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \return the number of elements in the container
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return the number of elements which can be stored without allocating
+   */
+  uint32_t GetCapacity (void) const;
+  /**
+   * \brief Make room for at least \p n elements.
+   *
+   * Queue limits are sometimes set to huge values to mean "unlimited",
+   * so the reservation is capped at MAX_RESERVE elements; beyond that
+   * the array still grows on demand.
+   *
+   * \param n the number of elements
+   */
+  void Reserve (uint32_t n);
+  /**
+   * \brief Append an element at the tail.
+   *
+   * \param item the element
+   */
+  void Push (const T &item);
+  /**
+   * \return the element at the head
+   */
+  T &Front (void);
+  /**
+   * \return the element at the head
+   */
+  const T &Front (void) const;
+  /**
+   * \brief Get the i-th element, counting from the head.
+   *
+   * \param i the index of the element, less than GetSize ()
+   * \return the element
+   */
+  const T &Get (uint32_t i) const;
+  /**
+   * \brief Remove the element at the head.
+   */
+  void Pop (void);
+  /**
+   * \brief Remove all the elements.
+   */
+  void Clear (void);
+
+  /// Largest number of elements allocated by Reserve
+  static const uint32_t MAX_RESERVE = 65536;
+
+private:
+  /**
+   * \brief Move the elements into a new array of the given capacity.
+   * \param capacity the new capacity, a power of two
+   */
+  void Grow (uint32_t capacity);
+
+  std::vector<T> m_items; //!< the circular array
+  uint32_t m_mask;        //!< m_items.size () - 1
+  uint32_t m_head;        //!< index of the head element
+  uint32_t m_size;        //!< number of elements
+};
+
+} // namespace ns3
+
+/****************************************************
+ *  Implementation of inline and template methods.
+ ***************************************************/
+
+namespace ns3 {
+
+template <typename T>
+RingBuffer<T>::RingBuffer ()
+  : m_mask (0),
+    m_head (0),
+    m_size (0)
+{
+}
+
+template <typename T>
+bool
+RingBuffer<T>::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+template <typename T>
+uint32_t
+RingBuffer<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+uint32_t
+RingBuffer<T>::GetCapacity (void) const
+{
+  return m_items.size ();
+}
+
+template <typename T>
+void
+RingBuffer<T>::Reserve (uint32_t n)
+{
+  if (n > MAX_RESERVE)
+    {
+      n = MAX_RESERVE;
+    }
+  uint32_t capacity = m_items.empty () ? 1 : m_items.size ();
+  while (capacity < n)
+    {
+      capacity <<= 1;
+    }
+  if (capacity > m_items.size ())
+    {
+      Grow (capacity);
+    }
+}
+
+template <typename T>
+void
+RingBuffer<T>::Push (const T &item)
+{
+  if (m_size == m_items.size ())
+    {
+      Grow (m_items.empty () ? 16 : 2 * m_items.size ());
+    }
+  m_items[(m_head + m_size) & m_mask] = item;
+  m_size++;
+}
+
+template <typename T>
+T &
+RingBuffer<T>::Front (void)
+{
+  NS_ASSERT (m_size > 0);
+  return m_items[m_head];
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::Front (void) const
+{
+  NS_ASSERT (m_size > 0);
+  return m_items[m_head];
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::Get (uint32_t i) const
+{
+  NS_ASSERT (i < m_size);
+  return m_items[(m_head + i) & m_mask];
+}
+
+template <typename T>
+void
+RingBuffer<T>::Pop (void)
+{
+  NS_ASSERT (m_size > 0);
+  m_items[m_head] = T ();
+  m_head = (m_head + 1) & m_mask;
+  m_size--;
+}
+
+template <typename T>
+void
+RingBuffer<T>::Clear (void)
+{
+  while (m_size > 0)
+    {
+      Pop ();
+    }
+  m_head = 0;
+}
+
+template <typename T>
+void
+RingBuffer<T>::Grow (uint32_t capacity)
+{
+  NS_ASSERT ((capacity & (capacity - 1)) == 0);
+  NS_ASSERT (capacity >= m_size);
+  std::vector<T> items (capacity);
+  for (uint32_t i = 0; i < m_size; i++)
+    {
+      items[i] = m_items[(m_head + i) & m_mask];
+    }
+  m_items.swap (items);
+  m_mask = capacity - 1;
+  m_head = 0;
+}
+
+} // namespace ns3
+
+#endif /* RING_BUFFER_H */
@@ -25,6 +25,9 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/ecn-utils.h"
+#include "ns3/flow-utils.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -55,7 +58,8 @@ PointToPointNetDevice::GetTypeId (void)
     .AddAttribute ("DataRate", 
                    "The default data rate for point to point links",
                    DataRateValue (DataRate ("32768b/s")),
-                   MakeDataRateAccessor (&PointToPointNetDevice::m_bps),
+                   MakeDataRateAccessor (&PointToPointNetDevice::SetDataRate,
+                                         &PointToPointNetDevice::GetDataRate),
                    MakeDataRateChecker ())
     .AddAttribute ("ReceiveErrorModel", 
                    "The receiver error model used to simulate packet loss",
@@ -67,6 +71,14 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("QueueFollowsDataRate",
+                   "If true, the LinkBandwidth attribute of the transmit queue, "
+                   "when it has one (e.g. RedQueue), is set to the DataRate of "
+                   "the device whenever the data rate or the queue changes.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::SetQueueFollowsDataRate,
+                                        &PointToPointNetDevice::GetQueueFollowsDataRate),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -75,7 +87,8 @@ PointToPointNetDevice::GetTypeId (void)
     .AddAttribute ("TxQueue", 
                    "A queue to use as the transmit queue in the device.",
                    PointerValue (),
-                   MakePointerAccessor (&PointToPointNetDevice::m_queue),
+                   MakePointerAccessor (&PointToPointNetDevice::SetQueue,
+                                        &PointToPointNetDevice::GetQueue),
                    MakePointerChecker<Queue> ())
 
     //
@@ -176,6 +189,7 @@ PointToPointNetDevice::PointToPointNetDevice ()
   :
     m_txMachineState (READY),
     m_channel (0),
+    m_queueFollowsDataRate (false),
     m_linkUp (false),
     m_currentPkt (0)
 {
@@ -222,6 +236,41 @@ PointToPointNetDevice::SetDataRate (DataRate bps)
 {
   NS_LOG_FUNCTION (this);
   m_bps = bps;
+  SyncQueueLinkBandwidth ();
+}
+
+DataRate
+PointToPointNetDevice::GetDataRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bps;
+}
+
+void
+PointToPointNetDevice::SetQueueFollowsDataRate (bool follow)
+{
+  NS_LOG_FUNCTION (this << follow);
+  m_queueFollowsDataRate = follow;
+  SyncQueueLinkBandwidth ();
+}
+
+bool
+PointToPointNetDevice::GetQueueFollowsDataRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_queueFollowsDataRate;
+}
+
+void
+PointToPointNetDevice::SyncQueueLinkBandwidth (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queueFollowsDataRate && m_queue != 0)
+    {
+      // Queues whose parameters depend on the link rate, such as
+      // RedQueue, follow the change through this attribute
+      m_queue->SetAttributeFailSafe ("LinkBandwidth", DataRateValue (m_bps));
+    }
 }
 
 void
@@ -320,6 +369,12 @@ PointToPointNetDevice::SetQueue (Ptr<Queue> q)
 {
   NS_LOG_FUNCTION (this << q);
   m_queue = q;
+  if (m_queue)
+    {
+      m_queue->SetMarkCallback (MakeCallback (&PointToPointNetDevice::MarkEcn));
+      m_queue->SetFlowKeyCallback (MakeCallback (&PointToPointNetDevice::GetFlowKey));
+      SyncQueueLinkBandwidth ();
+    }
 }
 
 void
@@ -657,6 +712,42 @@ PointToPointNetDevice::PppToEther (uint16_t proto)
   return 0;
 }
 
+bool
+PointToPointNetDevice::MarkEcn (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  uint8_t ppp[2];
+  if (p->CopyData (ppp, 2) < 2)
+    {
+      return false;
+    }
+  uint16_t proto = (ppp[0] << 8) | ppp[1];
+  switch (proto)
+    {
+    case 0x0021: return ecnUtils::MarkCe (p, 2, 0x0800);   //IPv4
+    case 0x0057: return ecnUtils::MarkCe (p, 2, 0x86DD);   //IPv6
+    default: return false;
+    }
+}
+
+uint32_t
+PointToPointNetDevice::GetFlowKey (Ptr<const Packet> p, uint8_t *key)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  uint8_t ppp[2];
+  if (p->CopyData (ppp, 2) < 2)
+    {
+      return 0;
+    }
+  uint16_t proto = (ppp[0] << 8) | ppp[1];
+  switch (proto)
+    {
+    case 0x0021: return flowUtils::GetIpFlowKey (p, 2, 0x0800, key);   //IPv4
+    case 0x0057: return flowUtils::GetIpFlowKey (p, 2, 0x86DD, key);   //IPv6
+    default: return 0;
+    }
+}
+
 uint16_t
 PointToPointNetDevice::EtherToPpp (uint16_t proto)
 {
@@ -90,10 +90,37 @@ public:
    * set in the Attach () method from the corresponding field in the channel
    * to which the device is attached.  It can be overridden using this method.
    *
+   * If QueueFollowsDataRate is true and a queue with a LinkBandwidth
+   * attribute (e.g. RedQueue) is attached, the attribute is updated to
+   * the new data rate.
+   *
    * \param bps the data rate at which this object operates
    */
   void SetDataRate (DataRate bps);
 
+  /**
+   * Get the Data Rate used for transmission of packets.
+   *
+   * \returns the data rate at which this object operates
+   */
+  DataRate GetDataRate (void) const;
+
+  /**
+   * Make the LinkBandwidth attribute of the transmit queue, when it has
+   * one, follow the data rate of this device.  When enabled, the
+   * attribute is set at once, and again whenever SetDataRate or
+   * SetQueue is called.  It is disabled by default, so that a
+   * LinkBandwidth configured on the queue is kept.
+   *
+   * \param follow true to make the queue follow the data rate
+   */
+  void SetQueueFollowsDataRate (bool follow);
+
+  /**
+   * \returns true if the queue follows the data rate of this device
+   */
+  bool GetQueueFollowsDataRate (void) const;
+
   /**
    * Set the interframe gap used to separate packets.  The interframe gap
    * defines the minimum space required between packets sent by this device.
@@ -321,6 +348,11 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  /**
+   * True if the LinkBandwidth attribute of m_queue follows m_bps.
+   */
+  bool m_queueFollowsDataRate;
+
   /**
    * Error model for receive packet events
    */
@@ -470,6 +502,35 @@ private:
    * \return The corresponding PPP protocol number
    */
   static uint16_t EtherToPpp (uint16_t protocol);
+
+  /**
+   * \brief Mark a queued packet with ECN Congestion Experienced
+   *
+   * Installed as the mark callback of the transmit queue.  The IP
+   * header is found behind the PPP header and modified in place.
+   *
+   * \param p A packet starting with a PPP header
+   * \return true if the packet was ECN-capable and has been marked
+   */
+  static bool MarkEcn (Ptr<Packet> p);
+
+  /**
+   * \brief Get the flow key of a queued packet
+   *
+   * Installed as the flow key callback of the transmit queue.  The IP
+   * header is found behind the PPP header.
+   *
+   * \param p A packet starting with a PPP header
+   * \param key A buffer of flowUtils::MAX_KEY_SIZE bytes receiving the key
+   * \return the size of the key, 0 for packets which are not IP
+   */
+  static uint32_t GetFlowKey (Ptr<const Packet> p, uint8_t *key);
+
+  /**
+   * \brief Set the LinkBandwidth attribute of the queue to the data rate,
+   * if the queue follows the data rate
+   */
+  void SyncQueueLinkBandwidth (void);
 };
 
 } // namespace ns3
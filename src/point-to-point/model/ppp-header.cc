@@ -73,23 +73,17 @@ PppHeader::Print (std::ostream &os) const
   os << "Point-to-Point Protocol: " << proto; 
 }
 
-uint32_t
-PppHeader::GetSerializedSize (void) const
-{
-  return 2;
-}
-
 void
-PppHeader::Serialize (Buffer::Iterator start) const
+PppHeader::SerializeTo (uint8_t *buffer) const
 {
-  start.WriteHtonU16 (m_protocol);
+  WriteHtonU16 (buffer, m_protocol);
 }
 
 uint32_t
-PppHeader::Deserialize (Buffer::Iterator start)
+PppHeader::DeserializeFrom (const uint8_t *buffer)
 {
-  m_protocol = start.ReadNtohU16 ();
-  return GetSerializedSize ();
+  m_protocol = ReadNtohU16 (buffer);
+  return SERIALIZED_SIZE;
 }
 
 void
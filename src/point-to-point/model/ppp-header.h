@@ -19,7 +19,7 @@
 #ifndef PPP_HEADER_H
 #define PPP_HEADER_H
 
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 
 namespace ns3 {
 
@@ -43,9 +43,9 @@ namespace ns3 {
  * and we need to add a PPP header to each packet.  Since we are not using
  * framed PPP, this just means prepending the sixteen bit PPP protocol number
  * to the packet.  The ns-3 way to do this is via a class that inherits from
- * class Header.
+ * class Header; its size is fixed, so it inherits from FixedSizeHeader.
  */
-class PppHeader : public Header
+class PppHeader : public FixedSizeHeader<PppHeader, 2>
 {
 public:
 
@@ -75,9 +75,16 @@ public:
 
 
   virtual void Print (std::ostream &os) const;
-  virtual void Serialize (Buffer::Iterator start) const;
-  virtual uint32_t Deserialize (Buffer::Iterator start);
-  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \param buffer where to write the 2 bytes of the header
+   */
+  void SerializeTo (uint8_t *buffer) const;
+  /**
+   * \param buffer where to read the 2 bytes of the header
+   * \return the number of bytes read
+   */
+  uint32_t DeserializeFrom (const uint8_t *buffer);
 
   /**
    * \brief Set the protocol type carried by this PPP packet
@@ -20,9 +20,20 @@
 
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/red-queue.h"
+#include "ns3/data-rate.h"
+#include "ns3/boolean.h"
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+#include <map>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -93,6 +104,308 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the QueueFollowsDataRate attribute
+ *
+ * It checks that the LinkBandwidth of a RedQueue is left alone by
+ * default, and follows the data rate of the device when enabled,
+ * whichever of the queue and the data rate is set first.
+ */
+class PointToPointQueueBandwidthTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointQueueBandwidthTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param queue a queue
+   * \return the LinkBandwidth of the queue
+   */
+  static DataRate GetLinkBandwidth (Ptr<Queue> queue);
+};
+
+PointToPointQueueBandwidthTest::PointToPointQueueBandwidthTest ()
+  : TestCase ("PointToPoint queue LinkBandwidth")
+{
+}
+
+DataRate
+PointToPointQueueBandwidthTest::GetLinkBandwidth (Ptr<Queue> queue)
+{
+  DataRateValue rate;
+  queue->GetAttribute ("LinkBandwidth", rate);
+  return rate.Get ();
+}
+
+void
+PointToPointQueueBandwidthTest::DoRun (void)
+{
+  // Disabled: the configured LinkBandwidth is kept
+  Ptr<PointToPointNetDevice> dev = CreateObject<PointToPointNetDevice> ();
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  queue->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("3Mbps")));
+  dev->SetDataRate (DataRate ("10Mbps"));
+  dev->SetQueue (queue);
+  dev->SetDataRate (DataRate ("20Mbps"));
+  NS_TEST_EXPECT_MSG_EQ (GetLinkBandwidth (queue), DataRate ("3Mbps"), "LinkBandwidth overwritten");
+
+  // Enabled after the queue is attached
+  dev->SetAttribute ("QueueFollowsDataRate", BooleanValue (true));
+  NS_TEST_EXPECT_MSG_EQ (GetLinkBandwidth (queue), DataRate ("20Mbps"), "LinkBandwidth not synchronized");
+  dev->SetDataRate (DataRate ("5Mbps"));
+  NS_TEST_EXPECT_MSG_EQ (GetLinkBandwidth (queue), DataRate ("5Mbps"), "LinkBandwidth not updated");
+
+  // Enabled, and the queue attached after the data rate is set
+  dev = CreateObject<PointToPointNetDevice> ();
+  dev->SetAttribute ("QueueFollowsDataRate", BooleanValue (true));
+  dev->SetDataRate (DataRate ("7Mbps"));
+  queue = CreateObject<RedQueue> ();
+  dev->SetQueue (queue);
+  NS_TEST_EXPECT_MSG_EQ (GetLinkBandwidth (queue), DataRate ("7Mbps"), "New queue not synchronized");
+  BooleanValue follow;
+  dev->GetAttribute ("QueueFollowsDataRate", follow);
+  NS_TEST_EXPECT_MSG_EQ (follow.Get (), true, "Wrong attribute value");
+
+  // Queues without a LinkBandwidth attribute are accepted
+  dev->SetQueue (CreateObject<DropTailQueue> ());
+  dev->SetDataRate (DataRate ("1Mbps"));
+}
+
+/**
+ * \brief Test class for point-to-point links between partitions
+ *
+ * Packets go around a ring of nodes whose every link connects two
+ * partitions of a MultithreadedSimulatorImpl: each node forwards the
+ * packets it receives, one byte shorter, to its other neighbor.  The
+ * receptions of each node must be the same as with the
+ * DefaultSimulatorImpl, and the packets must get the same uids from
+ * one multithreaded run to the next.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Restore the default simulator implementation
+   */
+  virtual void DoTeardown (void);
+
+private:
+  /**
+   * \brief Run the scenario with a simulator implementation
+   *
+   * \param type the SimulatorImplementationType
+   */
+  void RunScenario (std::string type);
+
+  /**
+   * \brief Send a packet on a device
+   *
+   * \param device the device
+   * \param size the size of the packet
+   */
+  void Send (Ptr<NetDevice> device, uint32_t size);
+
+  /**
+   * \brief Record a packet, and forward it on the other device of the node
+   *
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Make the uids received relative to the first uid of their system id
+   *
+   * The uid counters are not reset between the runs, so only the uids
+   * relative to the first one of each system id can be compared.
+   */
+  void MakeUidsRelative (void);
+
+  static const uint32_t N_NODES = 6;       //!< the nodes of the ring
+  static const uint32_t N_PARTITIONS = 2;  //!< the partitions
+
+  typedef std::vector<std::pair<int64_t, uint32_t> > Receptions;  //!< reception times and sizes
+  std::vector<Receptions> m_rx;   //!< the receptions, by node
+  std::vector<std::vector<uint64_t> > m_uids; //!< the uids of the packets received, by node
+  std::vector<uint32_t> m_errors; //!< the receptions in the wrong partition, by node
+  uint32_t m_firstNode;           //!< the id of the first node of the ring
+  bool m_multithreaded;           //!< checks the partitions if true
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint links between the partitions of a MultithreadedSimulatorImpl")
+{
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<NetDevice> device, uint32_t size)
+{
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  // Each vector element is only accessed by the thread of its node
+  Ptr<Node> node = device->GetNode ();
+  uint32_t i = node->GetId () - m_firstNode;
+  m_rx[i].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), packet->GetSize ()));
+  m_uids[i].push_back (packet->GetUid ());
+  if (m_multithreaded && Simulator::GetSystemId () != node->GetSystemId ())
+    {
+      m_errors[i]++;
+    }
+  if (packet->GetSize () > 100)
+    {
+      Ptr<Packet> copy = packet->Copy ();
+      copy->RemoveAtEnd (1);
+      Ptr<NetDevice> other = node->GetDevice (device->GetIfIndex () == 0 ? 1 : 0);
+      other->Send (copy, other->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::RunScenario (std::string type)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (type));
+  m_multithreaded = type == "ns3::MultithreadedSimulatorImpl";
+  m_rx.assign (N_NODES, Receptions ());
+  m_uids.assign (N_NODES, std::vector<uint64_t> ());
+  m_errors.assign (N_NODES, 0);
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> (i % N_PARTITIONS));
+    }
+  m_firstNode = nodes[0]->GetId ();
+  std::vector<Ptr<PointToPointNetDevice> > devices;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (100 + 50 * i)));
+      for (uint32_t j = i; j <= i + 1; j++)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetDataRate (DataRate ("10Mbps"));
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          nodes[j % N_NODES]->AddDevice (device);
+          device->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+          device->Attach (channel);
+          devices.push_back (device);
+        }
+    }
+
+  // Bursts of packets, in both directions, which overflow the queues
+  for (uint32_t i = 0; i < devices.size (); i++)
+    {
+      for (uint32_t k = 0; k < 50; k++)
+        {
+          Time t = MicroSeconds (1000 * (k / 10) + 7 * i + k);
+          Simulator::ScheduleWithContext (devices[i]->GetNode ()->GetId (), t,
+                                          &PointToPointMultithreadedTest::Send, this,
+                                          devices[i], 100 + (i * 37 + k * 11) % 400);
+        }
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  if (m_multithreaded)
+    {
+      Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+      NS_TEST_ASSERT_MSG_NE (impl, 0, "wrong simulator implementation");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), N_PARTITIONS, "wrong number of partitions");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MicroSeconds (100), "wrong lookahead");
+    }
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0, "packets received in the wrong partition by node " << i);
+    }
+}
+
+void
+PointToPointMultithreadedTest::MakeUidsRelative (void)
+{
+  std::map<uint32_t, uint64_t> first;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < m_uids[i].size (); j++)
+        {
+          uint32_t systemId = m_uids[i][j] >> 32;
+          if (first.find (systemId) == first.end () || m_uids[i][j] < first[systemId])
+            {
+              first[systemId] = m_uids[i][j];
+            }
+        }
+    }
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < m_uids[i].size (); j++)
+        {
+          m_uids[i][j] -= first[m_uids[i][j] >> 32];
+        }
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Simulator::Destroy ();
+  RunScenario ("ns3::DefaultSimulatorImpl");
+  std::vector<Receptions> rx = m_rx;
+
+  RunScenario ("ns3::MultithreadedSimulatorImpl");
+  MakeUidsRelative ();
+  std::vector<std::vector<uint64_t> > uids = m_uids;
+  uint32_t nRx = 0;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nRx += rx[i].size ();
+      NS_TEST_EXPECT_MSG_EQ (m_rx[i].size (), rx[i].size (), "wrong number of packets received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ ((m_rx[i] == rx[i]), true, "wrong receptions at node " << i);
+    }
+
+  RunScenario ("ns3::MultithreadedSimulatorImpl");
+  MakeUidsRelative ();
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_uids[i] == uids[i]), true, "different uids received by node " << i);
+    }
+  NS_TEST_EXPECT_MSG_GT (nRx, 10000, "too few packets to test anything");
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -109,6 +422,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointQueueBandwidthTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
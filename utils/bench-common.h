@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+/*
+ * The allocation counting and the reporting of the results shared by
+ * the benchmark programs.  This header replaces the global operator
+ * new and delete, so it must be included by a single source file of a
+ * program, the one with its main function.
+ */
+
+#include <iostream>
+#include <string>
+#include <new>
+#include <stdint.h>
+#include <stdlib.h> // for malloc () and free ()
+
+/*
+ * Every heap allocation made by the process goes through these two
+ * operators, so that the benchmarks can report how many allocations
+ * they perform per packet.
+ */
+static uint64_t g_allocations = 0;
+
+void *
+operator new (size_t size)
+{
+  g_allocations++;
+  void *p = malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+// GCC does not see that this delete matches the new above
+#if defined (__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void
+operator delete (void *p) throw ()
+{
+  free (p);
+}
+
+/*
+ * Results are printed either as text, one "value unit<TAB>description"
+ * line per result, or as comma-separated "bench,subject,config,metric,value"
+ * records which are easy to compare from one run to the next.
+ */
+static bool g_csv = false;
+
+/**
+ * Print the first line of the results.
+ *
+ * \param program the name of the benchmark program
+ * \param parameters the main parameters of the run, for the text output
+ */
+static void
+ReportStart (std::string const &program, std::string const &parameters)
+{
+  if (g_csv)
+    {
+      std::cout << "bench,subject,config,metric,value" << std::endl;
+    }
+  else
+    {
+      std::cout << "Running " << program << " with " << parameters << std::endl;
+    }
+}
+
+/**
+ * Print a result.
+ *
+ * \param bench the benchmark
+ * \param subject what the benchmark measures, e.g., a queue type
+ * \param config the configuration of the benchmark
+ * \param metric the unit of the result
+ * \param value the result
+ */
+static void
+Report (std::string const &bench, std::string const &subject, std::string const &config,
+        std::string const &metric, double value)
+{
+  if (g_csv)
+    {
+      std::cout << bench << "," << subject << "," << config << ","
+                << metric << "," << value << std::endl;
+    }
+  else
+    {
+      std::cout << value << " " << metric << "\t"
+                << bench << " " << subject << " " << config << std::endl;
+    }
+}
+
+#endif /* BENCH_COMMON_H */
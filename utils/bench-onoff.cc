@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <stdlib.h> // for exit ()
+#include <algorithm>
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+struct OnOffResult
+{
+  uint64_t ms;          //!< the wall-clock time of Simulator::Run
+  uint64_t allocations; //!< the heap allocations made by Simulator::Run
+  uint64_t packets;     //!< the packets received by the sink
+};
+
+/*
+ * The flows go from one node to another over a point-to-point link
+ * fast enough, and with a queue long enough, to carry them all, so
+ * that the simulation time is spent creating, forwarding and
+ * delivering the packets of the applications.
+ */
+static OnOffResult
+RunOnOff (uint32_t flows, double seconds, bool usePacketPool)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Gbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  pointToPoint.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (100000));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  uint16_t port = 9;
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (1));
+
+  OnOffHelper onoff ("ns3::UdpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), port));
+  onoff.SetConstantRate (DataRate ("1Mbps"), 512);
+  onoff.SetAttribute ("UsePacketPool", BooleanValue (usePacketPool));
+  ApplicationContainer sources;
+  for (uint32_t i = 0; i < flows; i++)
+    {
+      sources.Add (onoff.Install (nodes.Get (0)));
+    }
+  sources.Start (Seconds (0.0));
+  sources.Stop (Seconds (seconds));
+  Simulator::Stop (Seconds (seconds + 0.1));
+
+  OnOffResult result;
+  uint64_t allocations = g_allocations;
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  result.ms = clock.End ();
+  result.allocations = g_allocations - allocations;
+  result.packets = DynamicCast<PacketSink> (sinkApps.Get (0))->GetTotalRx () / 512;
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+  return result;
+}
+
+static void
+runOnOffBench (uint32_t flows, double seconds, uint32_t minIterations, bool usePacketPool)
+{
+  OnOffResult best;
+  best.ms = ~0ULL;
+  best.allocations = 0;
+  best.packets = 0;
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      OnOffResult result = RunOnOff (flows, seconds, usePacketPool);
+      if (result.ms < best.ms)
+        {
+          best = result;
+        }
+    }
+  std::string config = usePacketPool ? "pool" : "create";
+  Report ("onoff", "OnOffApplication", config, "packets", best.packets);
+  Report ("onoff", "OnOffApplication", config, "ms", best.ms);
+  Report ("onoff", "OnOffApplication", config, "packets/s",
+          best.packets * 1000.0 / std::max<uint64_t> (best.ms, 1));
+  Report ("onoff", "OnOffApplication", config, "allocs/packet",
+          double (best.allocations) / std::max<uint64_t> (best.packets, 1));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t flows = 1000;
+  double seconds = 1.0;
+  uint32_t minIterations = 1;
+  std::string mode = "both";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark many OnOffApplication flows, with and without a PacketPool");
+  cmd.AddValue ("flows", "number of OnOffApplication flows", flows);
+  cmd.AddValue ("time", "simulated time of each run, in seconds", seconds);
+  cmd.AddValue ("min-iterations", "number of runs to minimize the run time over", minIterations);
+  cmd.AddValue ("mode", "how the applications get their packets: create, pool or both", mode);
+  cmd.AddValue ("csv", "print the results as comma-separated values", g_csv);
+  cmd.Parse (argc, argv);
+
+  if (flows == 0)
+    {
+      std::cerr << "Error-- number of flows must be positive" << std::endl;
+      exit (1);
+    }
+  std::ostringstream parameters;
+  parameters << "flows=" << flows;
+  ReportStart ("bench-onoff", parameters.str ());
+
+  if (mode == "create" || mode == "both")
+    {
+      runOnOffBench (flows, seconds, minIterations, false);
+    }
+  if (mode == "pool" || mode == "both")
+    {
+      runOnOffBench (flows, seconds, minIterations, true);
+    }
+
+  return 0;
+}
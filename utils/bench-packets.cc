@@ -21,12 +21,19 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/mpsc-queue.h"
+#include <sched.h>
+#endif
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 using namespace ns3;
 
@@ -125,6 +132,78 @@ BenchHeader<N>::Deserialize (Buffer::Iterator start)
   return N;
 }
 
+/**
+ * A header of N 32-bit fields, which Packet serializes directly, but
+ * which also implements the Buffer::Iterator methods field by field,
+ * as most headers do.
+ */
+template <int N>
+class BenchFieldsHeader : public FixedSizeHeader<BenchFieldsHeader<N>, 4 * N>
+{
+public:
+  BenchFieldsHeader () {
+    for (int i = 0; i < N; i++)
+      {
+        m_fields[i] = 0x01020304 * (i + 1);
+      }
+  }
+  /**
+   * \return The name of this type.
+   */
+  static std::string GetTypeName (void) {
+    std::ostringstream oss;
+    oss << "ns3::BenchFieldsHeader<" << N << ">";
+    return oss.str ();
+  }
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId (GetTypeName ().c_str ())
+      .SetParent<Header> ()
+      .SetGroupName ("Utils")
+      .HideFromDocumentation ()
+      .AddConstructor<BenchFieldsHeader <N> > ()
+      ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual void Print (std::ostream &os) const {
+    NS_ASSERT (false);
+  }
+  virtual void Serialize (Buffer::Iterator start) const {
+    for (int i = 0; i < N; i++)
+      {
+        start.WriteHtonU32 (m_fields[i]);
+      }
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator start) {
+    for (int i = 0; i < N; i++)
+      {
+        m_fields[i] = start.ReadNtohU32 ();
+      }
+    return 4 * N;
+  }
+  void SerializeTo (uint8_t *buffer) const {
+    for (int i = 0; i < N; i++)
+      {
+        this->WriteHtonU32 (buffer + 4 * i, m_fields[i]);
+      }
+  }
+  uint32_t DeserializeFrom (const uint8_t *buffer) {
+    for (int i = 0; i < N; i++)
+      {
+        m_fields[i] = this->ReadNtohU32 (buffer + 4 * i);
+      }
+    return 4 * N;
+  }
+private:
+  uint32_t m_fields[N];
+};
+
 template <int N>
 class BenchTag : public Tag
 {
@@ -284,6 +363,72 @@ benchFragment (uint32_t n)
   }
 }
 
+static void
+benchLargeFragment (uint32_t n)
+{
+  const uint32_t size = 65000;
+  const uint32_t fragmentSize = 1400;
+  std::vector<uint8_t> payload (size, 0x5a);
+  BenchHeader<20> ipv4;
+
+  // Each fragment counts as a packet
+  for (uint32_t i = 0; i < n; i += (size + fragmentSize - 1) / fragmentSize)
+    {
+      Ptr<Packet> p = Create<Packet> (&payload[0], size);
+      Ptr<Packet> reassembled = Create<Packet> ();
+      for (uint32_t offset = 0; offset < size; offset += fragmentSize)
+        {
+          Ptr<Packet> fragment = p->CreateFragment (offset, std::min (fragmentSize, size - offset));
+          fragment->AddHeader (ipv4);
+          fragment->RemoveHeader (ipv4);
+          reassembled->AddAtEnd (fragment);
+        }
+    }
+}
+
+static void
+benchLargeFragmentScatterGather (uint32_t n)
+{
+  Buffer::EnableScatterGather ();
+  benchLargeFragment (n);
+  Buffer::DisableScatterGather ();
+}
+
+static void
+benchHeadersIterator (uint32_t n)
+{
+  BenchFieldsHeader<5> ipv4;
+  BenchFieldsHeader<2> udp;
+  // Through Header, the virtual methods are called
+  Header &ipv4Base = ipv4;
+  Header &udpBase = udp;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->AddHeader (udpBase);
+      p->AddHeader (ipv4Base);
+      p->RemoveHeader (ipv4Base);
+      p->RemoveHeader (udpBase);
+    }
+}
+
+static void
+benchHeadersFixedSize (uint32_t n)
+{
+  BenchFieldsHeader<5> ipv4;
+  BenchFieldsHeader<2> udp;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      p->RemoveHeader (ipv4);
+      p->RemoveHeader (udp);
+    }
+}
+
 static void
 benchByteTags (uint32_t n)
 {
@@ -302,6 +447,215 @@ benchByteTags (uint32_t n)
     }
 }
 
+/**
+ * Add five packet tags, with the sizes of the flow id, QoS, SNR,
+ * packet info and TX vector tags a Wi-Fi packet carries.
+ */
+static void
+addPacketTags (Ptr<Packet> p)
+{
+  p->AddPacketTag (BenchTag<4> ());
+  p->AddPacketTag (BenchTag<1> ());
+  p->AddPacketTag (BenchTag<8> ());
+  p->AddPacketTag (BenchTag<12> ());
+  p->AddPacketTag (BenchTag<20> ());
+}
+
+static void
+benchPacketTagsAdd (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      addPacketTags (p);
+    }
+}
+
+static void
+benchPacketTagsPeek (uint32_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  addPacketTags (p);
+  BenchTag<4> tag1;
+  BenchTag<1> tag2;
+  BenchTag<8> tag3;
+  BenchTag<12> tag4;
+  BenchTag<20> tag5;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->PeekPacketTag (tag1);
+      p->PeekPacketTag (tag2);
+      p->PeekPacketTag (tag3);
+      p->PeekPacketTag (tag4);
+      p->PeekPacketTag (tag5);
+    }
+}
+
+static void
+benchPacketTagsRemove (uint32_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  addPacketTags (p);
+  BenchTag<4> tag1;
+  BenchTag<1> tag2;
+  BenchTag<8> tag3;
+  BenchTag<12> tag4;
+  BenchTag<20> tag5;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // The copy shares the tags of p until it removes them
+      Ptr<Packet> q = p->Copy ();
+      q->RemovePacketTag (tag1);
+      q->RemovePacketTag (tag2);
+      q->RemovePacketTag (tag3);
+      q->RemovePacketTag (tag4);
+      q->RemovePacketTag (tag5);
+    }
+}
+
+static void
+benchCopy (uint32_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddHeader (BenchHeader<8> ());
+  p->AddHeader (BenchHeader<25> ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> q = p->Copy ();
+    }
+}
+
+static void
+benchCopyPacketTags (uint32_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddHeader (BenchHeader<8> ());
+  p->AddHeader (BenchHeader<25> ());
+  p->AddPacketTag (BenchTag<4> ());
+  p->AddPacketTag (BenchTag<8> ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> q = p->Copy ();
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/** The number of threads of the threaded benchmarks. */
+static uint32_t g_threads = 4;
+
+/**
+ * Create and release packets, keeping the last ones alive, as a
+ * traffic generator and a queue would.
+ *
+ * \param n the number of packets
+ */
+static void
+churn (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  BenchTag<16> tag;
+  const uint32_t window = 64;
+  Ptr<Packet> live[window];
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      p->AddByteTag (tag);
+      live[i % window] = p;
+    }
+}
+
+static void
+benchThreadedChurn (uint32_t n)
+{
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < g_threads; i++)
+    {
+      uint32_t share = n / g_threads + (i < n % g_threads ? 1 : 0);
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&churn, share)));
+    }
+  for (uint32_t i = 0; i < g_threads; i++)
+    {
+      threads[i]->Start ();
+    }
+  for (uint32_t i = 0; i < g_threads; i++)
+    {
+      threads[i]->Join ();
+    }
+}
+
+/** The packets handed over from the producers to the consumer. */
+static MpscQueue<Packet *> *g_handOver;
+/** The number of packets handed over but not yet released. */
+static uint32_t g_inFlight;
+
+/**
+ * Create packets and hand them over to the consumer.
+ *
+ * \param n the number of packets
+ */
+static void
+produce (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      while (__atomic_load_n (&g_inFlight, __ATOMIC_RELAXED) > 4096)
+        {
+          sched_yield ();
+        }
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      __atomic_fetch_add (&g_inFlight, 1, __ATOMIC_RELAXED);
+      // The consumer takes over the reference
+      g_handOver->Push (GetPointer (p));
+    }
+}
+
+static void
+benchThreadedHandOver (uint32_t n)
+{
+  MpscQueue<Packet *> handOver;
+  g_handOver = &handOver;
+  g_inFlight = 0;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < g_threads; i++)
+    {
+      uint32_t share = n / g_threads + (i < n % g_threads ? 1 : 0);
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&produce, share)));
+      threads[i]->Start ();
+    }
+  // Release the packets in this thread, so that their memory goes back
+  // to the free lists of another thread than the one which allocated it.
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  for (uint32_t received = 0; received < n; )
+    {
+      Packet *raw;
+      if (!handOver.Pop (raw))
+        {
+          sched_yield ();
+          continue;
+        }
+      Ptr<Packet> p (raw, false);
+      p->RemoveHeader (ipv4);
+      p->RemoveHeader (udp);
+      __atomic_fetch_sub (&g_inFlight, 1, __ATOMIC_RELAXED);
+      received++;
+    }
+  for (uint32_t i = 0; i < g_threads; i++)
+    {
+      threads[i]->Join ();
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -342,6 +696,9 @@ int main (int argc, char *argv[])
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+#ifdef HAVE_PTHREAD_H
+  cmd.AddValue ("threads", "number of threads of the threaded benchmarks, 0 to skip them", g_threads);
+#endif
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -358,7 +715,30 @@ int main (int argc, char *argv[])
   runBench (&benchC, n, minIterations, "Remove by func call");
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
+  runBench (&benchLargeFragment, n, minIterations, "Fragment and reassemble 65000-byte packets");
+  runBench (&benchLargeFragmentScatterGather, n, minIterations,
+            "Fragment and reassemble 65000-byte packets, scatter-gather");
+  runBench (&benchHeadersIterator, n, minIterations, "Push and pop 2 headers with Buffer::Iterator");
+  runBench (&benchHeadersFixedSize, n, minIterations, "Push and pop 2 fixed-size headers");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchPacketTagsAdd, n, minIterations, "Create packets with 5 packet tags");
+  runBench (&benchPacketTagsPeek, n, minIterations, "Peek 5 packet tags");
+  runBench (&benchPacketTagsRemove, n, minIterations, "Copy packets, remove 5 packet tags");
+  runBench (&benchCopy, n, minIterations, "Copy packets");
+  runBench (&benchCopyPacketTags, n, minIterations, "Copy packets with 2 packet tags");
+#ifdef HAVE_PTHREAD_H
+  if (g_threads != 0)
+    {
+      // Register the types and create the simulator in this thread first
+      churn (1);
+      std::ostringstream churnName;
+      churnName << "Create and release packets in " << g_threads << " thread(s)";
+      runBench (&benchThreadedChurn, n, minIterations, churnName.str ().c_str ());
+      std::ostringstream handOverName;
+      handOverName << "Hand over packets from " << g_threads << " thread(s) to another";
+      runBench (&benchThreadedHandOver, n, minIterations, handOverName.str ().c_str ());
+    }
+#endif
 
   return 0;
 }
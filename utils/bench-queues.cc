@@ -0,0 +1,645 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/packet.h"
+#include "ns3/red-queue.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/abort.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h> // for exit ()
+#include <time.h>   // for clock_gettime ()
+#include <limits>
+#include <algorithm>
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+/*
+ * Each iteration enqueues a packet into an idle RedQueue after a gap of
+ * m_idle simulated seconds, then empties the queue again so that the
+ * next arrival also sees an idle period.  The cost per iteration should
+ * not depend on the length of the idle gap.
+ */
+class RedIdleBench
+{
+public:
+  RedIdleBench (Ptr<RedQueue> queue, Time idle, uint32_t n);
+  void Run (void);
+private:
+  void Arrival (void);
+
+  Ptr<RedQueue> m_queue;
+  Ptr<Packet> m_packet;
+  Time m_idle;
+  uint32_t m_n;
+  uint32_t m_count;
+};
+
+RedIdleBench::RedIdleBench (Ptr<RedQueue> queue, Time idle, uint32_t n)
+  : m_queue (queue),
+    m_packet (Create<Packet> (500)),
+    m_idle (idle),
+    m_n (n),
+    m_count (0)
+{
+}
+
+void
+RedIdleBench::Run (void)
+{
+  Simulator::Schedule (m_idle, &RedIdleBench::Arrival, this);
+  Simulator::Run ();
+}
+
+void
+RedIdleBench::Arrival (void)
+{
+  m_queue->Enqueue (m_packet);
+  m_queue->Dequeue ();
+  m_queue->Dequeue ();
+  if (++m_count < m_n)
+    {
+      Simulator::Schedule (m_idle, &RedIdleBench::Arrival, this);
+    }
+}
+
+static uint64_t
+runRedIdleOneIteration (DataRate bw, Time idle, uint32_t n)
+{
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  queue->SetAttribute ("LinkBandwidth", DataRateValue (bw));
+  queue->SetAttribute ("QW", DoubleValue (0.002));
+  RedIdleBench bench (queue, idle, n);
+
+  SystemWallClockMs time;
+  time.Start ();
+  bench.Run ();
+  uint64_t deltaMs = time.End ();
+  Simulator::Destroy ();
+  return deltaMs;
+}
+
+static void
+runRedIdleBench (DataRate bw, Time idle, uint32_t n, uint32_t minIterations)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runRedIdleOneIteration (bw, idle, n);
+      minDelay = std::min (minDelay, delay);
+    }
+  double ns = minDelay;
+  ns *= 1000000;
+  ns /= n;
+  std::ostringstream config;
+  config << "idle=" << idle.GetSeconds () << "s,rate=" << bw.GetBitRate () << "bps";
+  Report ("red-idle", "RedQueue", config.str (), "ns/enqueue", ns);
+}
+
+/*
+ * Keep m_depth packets in the queue and move packets through it: each
+ * operation dequeues the head packet and enqueues it again at the tail.
+ * The packets are allocated once so that only the cost of the queue
+ * itself is measured.
+ */
+static uint64_t
+runThroughputOneIteration (ObjectFactory factory, uint32_t depth, uint32_t n)
+{
+  Ptr<Queue> queue = factory.Create<Queue> ();
+  for (uint32_t i = 0; i < depth; i++)
+    {
+      queue->Enqueue (Create<Packet> (1000));
+    }
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = queue->Dequeue ();
+      queue->Enqueue (p);
+    }
+  uint64_t deltaMs = time.End ();
+  NS_ABORT_MSG_UNLESS (queue->GetNPackets () == depth, "Packets were dropped");
+  Simulator::Destroy ();
+  return deltaMs;
+}
+
+static void
+runThroughputBench (ObjectFactory factory, uint32_t depth, uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runThroughputOneIteration (factory, depth, n);
+      minDelay = std::min (minDelay, delay);
+    }
+  double ns = minDelay;
+  ns *= 1000000;
+  ns /= n;
+  std::ostringstream config;
+  config << "depth=" << depth;
+  Report ("throughput", name, config.str (), "ns/op", ns);
+}
+
+/*
+ * A bottleneck link fed by a synthetic arrival process.  Time is cut
+ * into slots: at the start of each slot the arrivals of the slot are
+ * enqueued, then the link dequeues as many bytes as it can send during
+ * the slot.  There are no devices and no per-packet events; the
+ * simulator only advances the clock once per slot so that the queues
+ * which look at Simulator::Now (RED idle periods, adaptive RED, CoDel
+ * sojourn times) behave as they would on a real link.
+ *
+ * Each Enqueue and Dequeue call is timed separately, and the heap
+ * allocations made during the calls are counted.  The packets are
+ * recycled through a pool so that neither the packets nor the arrival
+ * process contribute to the measurements.
+ */
+class ArrivalBench
+{
+public:
+  enum Arrivals
+  {
+    CBR,      //!< a constant number of packets per slot, on average
+    POISSON,  //!< exponential inter-arrival times
+    ON_OFF    //!< exponential on and off periods, twice the load while on
+  };
+
+  struct Results
+  {
+    uint64_t arrivals;     //!< packets offered to Enqueue
+    uint64_t drops;        //!< packets rejected by Enqueue
+    uint64_t totalDrops;   //!< packets dropped, at enqueue or dequeue time
+    uint64_t departures;   //!< packets returned by Dequeue
+    uint64_t allocations;  //!< allocations made within Enqueue and Dequeue
+    uint64_t enqueueNs;    //!< time spent in Enqueue
+    uint64_t acceptNs;     //!< time spent in the Enqueue calls which succeeded
+    uint64_t dropNs;       //!< time spent in the Enqueue calls which dropped
+    uint64_t dequeueNs;    //!< time spent in Dequeue
+  };
+
+  ArrivalBench (Ptr<Queue> queue, Arrivals arrivals, DataRate rate, Time slot, double load, uint64_t n);
+  Results Run (void);
+
+  static uint32_t GetMeanPacketSize (void);
+  static uint64_t GetTimerOverhead (void);
+
+private:
+  void Slot (void);
+  uint32_t GetNArrivals (void);
+  Ptr<Packet> GetPacket (void);
+  void PutPacket (Ptr<Packet> p);
+
+  static uint64_t Now (void);
+
+  Ptr<Queue> m_queue;
+  Arrivals m_arrivals;
+  Time m_slot;
+  double m_bytesPerSlot;
+  double m_packetsPerSlot;
+  uint64_t m_n;
+  double m_credit;
+  double m_nextArrival;
+  double m_slotIndex;
+  uint32_t m_stateSlots;
+  bool m_on;
+  double m_budget;
+  Ptr<ExponentialRandomVariable> m_interArrival;
+  Ptr<ExponentialRandomVariable> m_period;
+  std::vector<Ptr<Packet> > m_pools[3];
+  Results m_results;
+};
+
+/*
+ * The sizes of the arriving packets cycle through a trimodal mix (40,
+ * 576 and 1500 bytes) typical of Internet traffic, so that byte-mode
+ * queues see packets of different sizes.  g_sizeMix holds indexes in
+ * g_packetSizes; there is one pool of packets per size.
+ */
+static const uint32_t g_packetSizes[] = { 40, 576, 1500 };
+static const uint32_t g_sizeMix[] = { 2, 0, 1, 0, 2, 0, 2, 0, 1, 0, 2, 0 };
+static const uint32_t g_nSizeMix = sizeof (g_sizeMix) / sizeof (g_sizeMix[0]);
+
+ArrivalBench::ArrivalBench (Ptr<Queue> queue, Arrivals arrivals, DataRate rate, Time slot, double load, uint64_t n)
+  : m_queue (queue),
+    m_arrivals (arrivals),
+    m_slot (slot),
+    m_n (n),
+    m_credit (0.0),
+    m_nextArrival (0.0),
+    m_slotIndex (0.0),
+    m_stateSlots (0),
+    m_on (false),
+    m_budget (0.0)
+{
+  m_bytesPerSlot = rate.GetBitRate () * slot.GetSeconds () / 8;
+  m_packetsPerSlot = load * m_bytesPerSlot / GetMeanPacketSize ();
+  m_interArrival = CreateObject<ExponentialRandomVariable> ();
+  m_interArrival->SetStream (1);
+  m_period = CreateObject<ExponentialRandomVariable> ();
+  m_period->SetAttribute ("Mean", DoubleValue (10));
+  m_period->SetStream (2);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_pools[i].reserve (4096);
+    }
+  m_results.arrivals = 0;
+  m_results.drops = 0;
+  m_results.totalDrops = 0;
+  m_results.departures = 0;
+  m_results.allocations = 0;
+  m_results.enqueueNs = 0;
+  m_results.acceptNs = 0;
+  m_results.dropNs = 0;
+  m_results.dequeueNs = 0;
+}
+
+uint32_t
+ArrivalBench::GetMeanPacketSize (void)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < g_nSizeMix; i++)
+    {
+      sum += g_packetSizes[g_sizeMix[i]];
+    }
+  return sum / g_nSizeMix;
+}
+
+uint64_t
+ArrivalBench::Now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t
+ArrivalBench::GetTimerOverhead (void)
+{
+  const uint32_t n = 1000000;
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint64_t start = Now ();
+      total += Now () - start;
+    }
+  return total / n;
+}
+
+Ptr<Packet>
+ArrivalBench::GetPacket (void)
+{
+  uint32_t i = g_sizeMix[m_results.arrivals % g_nSizeMix];
+  if (m_pools[i].empty ())
+    {
+      return Create<Packet> (g_packetSizes[i]);
+    }
+  Ptr<Packet> p = m_pools[i].back ();
+  m_pools[i].pop_back ();
+  return p;
+}
+
+void
+ArrivalBench::PutPacket (Ptr<Packet> p)
+{
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      if (p->GetSize () == g_packetSizes[i])
+        {
+          m_pools[i].push_back (p);
+        }
+    }
+}
+
+uint32_t
+ArrivalBench::GetNArrivals (void)
+{
+  uint32_t k = 0;
+  switch (m_arrivals)
+    {
+    case CBR:
+      m_credit += m_packetsPerSlot;
+      k = static_cast<uint32_t> (m_credit);
+      m_credit -= k;
+      break;
+    case POISSON:
+      while (m_nextArrival < m_slotIndex + 1)
+        {
+          k++;
+          m_nextArrival += m_interArrival->GetValue (1 / m_packetsPerSlot, 0);
+        }
+      break;
+    case ON_OFF:
+      while (m_stateSlots == 0)
+        {
+          m_on = !m_on;
+          m_stateSlots = static_cast<uint32_t> (m_period->GetValue () + 0.5);
+        }
+      m_stateSlots--;
+      if (m_on)
+        {
+          m_credit += 2 * m_packetsPerSlot;
+          k = static_cast<uint32_t> (m_credit);
+          m_credit -= k;
+        }
+      break;
+    }
+  m_slotIndex++;
+  return k;
+}
+
+void
+ArrivalBench::Slot (void)
+{
+  uint32_t k = GetNArrivals ();
+  for (uint32_t i = 0; i < k; i++)
+    {
+      Ptr<Packet> p = GetPacket ();
+
+      uint64_t allocations = g_allocations;
+      uint64_t start = Now ();
+      bool accepted = m_queue->Enqueue (p);
+      uint64_t delta = Now () - start;
+      m_results.allocations += g_allocations - allocations;
+
+      m_results.enqueueNs += delta;
+      if (accepted)
+        {
+          m_results.acceptNs += delta;
+        }
+      else
+        {
+          m_results.dropNs += delta;
+          m_results.drops++;
+          PutPacket (p);
+        }
+      m_results.arrivals++;
+    }
+
+  // The link sends whole packets; the bytes sent beyond the budget of
+  // this slot are taken from the budget of the next one.
+  m_budget += m_bytesPerSlot;
+  while (m_budget > 0)
+    {
+      uint64_t allocations = g_allocations;
+      uint64_t start = Now ();
+      Ptr<Packet> p = m_queue->Dequeue ();
+      uint64_t delta = Now () - start;
+      m_results.allocations += g_allocations - allocations;
+      if (p == 0)
+        {
+          m_budget = 0;
+          break;
+        }
+      m_results.dequeueNs += delta;
+      m_results.departures++;
+      m_budget -= p->GetSize ();
+      PutPacket (p);
+    }
+
+  if (m_results.arrivals < m_n)
+    {
+      Simulator::Schedule (m_slot, &ArrivalBench::Slot, this);
+    }
+}
+
+ArrivalBench::Results
+ArrivalBench::Run (void)
+{
+  Simulator::ScheduleNow (&ArrivalBench::Slot, this);
+  Simulator::Run ();
+  m_results.totalDrops = m_queue->GetTotalDroppedPackets ();
+  return m_results;
+}
+
+static void
+runArrivalBench (ObjectFactory factory, ArrivalBench::Arrivals arrivals, DataRate rate, Time slot,
+                 double load, uint64_t n, uint32_t minIterations, uint64_t overhead,
+                 char const *name, char const *arrivalsName)
+{
+  ArrivalBench::Results best = ArrivalBench::Results ();
+  double enqueueNs = std::numeric_limits<double>::max ();
+  double acceptNs = std::numeric_limits<double>::max ();
+  double dropNs = std::numeric_limits<double>::max ();
+  double dequeueNs = std::numeric_limits<double>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      ArrivalBench bench (factory.Create<Queue> (), arrivals, rate, slot, load, n);
+      best = bench.Run ();
+      Simulator::Destroy ();
+
+      uint64_t accepted = best.arrivals - best.drops;
+      enqueueNs = std::min (enqueueNs, double (best.enqueueNs) / best.arrivals);
+      if (accepted > 0)
+        {
+          acceptNs = std::min (acceptNs, double (best.acceptNs) / accepted);
+        }
+      if (best.drops > 0)
+        {
+          dropNs = std::min (dropNs, double (best.dropNs) / best.drops);
+        }
+      if (best.departures > 0)
+        {
+          dequeueNs = std::min (dequeueNs, double (best.dequeueNs) / best.departures);
+        }
+    }
+
+  std::ostringstream oss;
+  oss << "arrivals=" << arrivalsName << ",load=" << load;
+  std::string config = oss.str ();
+  Report ("arrivals", name, config, "ns/enqueue", std::max (0.0, enqueueNs - overhead));
+  if (best.arrivals > best.drops)
+    {
+      Report ("arrivals", name, config, "ns/accept", std::max (0.0, acceptNs - overhead));
+    }
+  if (best.drops > 0)
+    {
+      Report ("arrivals", name, config, "ns/drop", std::max (0.0, dropNs - overhead));
+    }
+  if (best.departures > 0)
+    {
+      Report ("arrivals", name, config, "ns/dequeue", std::max (0.0, dequeueNs - overhead));
+    }
+  Report ("arrivals", name, config, "allocs/packet", double (best.allocations) / best.arrivals);
+  Report ("arrivals", name, config, "drop-ratio", double (best.totalDrops) / best.arrivals);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+  double load = 1.2;
+  std::string arrivals = "all";
+  TypeId tid;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark Queue classes");
+  cmd.AddValue ("n", "number of iterations", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("load", "offered load of the arrival processes, relative to the link rate", load);
+  cmd.AddValue ("arrivals", "arrival process: cbr, poisson, onoff or all", arrivals);
+  cmd.AddValue ("csv", "print the results as comma-separated values", g_csv);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::ostringstream parameters;
+  parameters << "n=" << n;
+  ReportStart ("bench-queues", parameters.str ());
+
+  uint32_t depth = 100;
+  ObjectFactory factory;
+
+  factory.SetTypeId ("ns3::DropTailQueue");
+  factory.Set ("MaxPackets", UintegerValue (2 * depth));
+  runThroughputBench (factory, depth, n, minIterations, "DropTailQueue");
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::RedQueue");
+  factory.Set ("MinTh", DoubleValue (4 * depth));
+  factory.Set ("MaxTh", DoubleValue (8 * depth));
+  factory.Set ("QueueLimit", UintegerValue (16 * depth));
+  runThroughputBench (factory, depth, n, minIterations, "RedQueue");
+
+  bool haveCoDel = TypeId::LookupByNameFailSafe ("ns3::CoDelQueue", &tid);
+  if (haveCoDel)
+    {
+      factory = ObjectFactory ();
+      factory.SetTypeId (tid);
+      factory.Set ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+      factory.Set ("MaxPackets", UintegerValue (2 * depth));
+      runThroughputBench (factory, depth, n, minIterations, "CoDelQueue");
+    }
+
+  DataRate bw ("10Gbps");
+  runRedIdleBench (bw, MicroSeconds (1), n, minIterations);
+  runRedIdleBench (bw, MilliSeconds (1), n, minIterations);
+  runRedIdleBench (bw, MilliSeconds (100), n, minIterations);
+  runRedIdleBench (bw, Seconds (1), n, minIterations);
+
+  /*
+   * A 100Mbps link served in 1ms slots carries about 20 packets of the
+   * mean size per slot.  The thresholds below are those of the RED
+   * examples scaled to that rate; with a load above 1 the queues spend
+   * most of the time between the thresholds.
+   */
+  DataRate rate ("100Mbps");
+  Time slot = MilliSeconds (1);
+  uint32_t limit = 300;
+  uint32_t meanPktSize = ArrivalBench::GetMeanPacketSize ();
+
+  std::vector<ObjectFactory> factories;
+  std::vector<std::string> names;
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::DropTailQueue");
+  factory.Set ("MaxPackets", UintegerValue (limit));
+  factories.push_back (factory);
+  names.push_back ("DropTailQueue");
+
+  ObjectFactory red;
+  red.SetTypeId ("ns3::RedQueue");
+  red.Set ("MinTh", DoubleValue (limit / 10));
+  red.Set ("MaxTh", DoubleValue (3 * limit / 10));
+  red.Set ("QueueLimit", UintegerValue (limit));
+  red.Set ("LinkBandwidth", DataRateValue (rate));
+  red.Set ("MeanPktSize", UintegerValue (meanPktSize));
+
+  factory = red;
+  factory.Set ("Gentle", BooleanValue (false));
+  factories.push_back (factory);
+  names.push_back ("RedQueue/classic");
+
+  factory = red;
+  factory.Set ("Gentle", BooleanValue (true));
+  factories.push_back (factory);
+  names.push_back ("RedQueue/gentle");
+
+  factory = red;
+  factory.Set ("Gentle", BooleanValue (true));
+  factory.Set ("Adaptive", BooleanValue (true));
+  factories.push_back (factory);
+  names.push_back ("RedQueue/adaptive");
+
+  factory = red;
+  factory.Set ("Gentle", BooleanValue (true));
+  factory.Set ("Adaptive", BooleanValue (true));
+  factory.Set ("UseSojournTime", BooleanValue (true));
+  factories.push_back (factory);
+  names.push_back ("RedQueue/sojourn");
+
+  factory = red;
+  factory.Set ("Gentle", BooleanValue (false));
+  factory.Set ("Mode", StringValue ("QUEUE_MODE_BYTES"));
+  factory.Set ("MinTh", DoubleValue (limit / 10 * meanPktSize));
+  factory.Set ("MaxTh", DoubleValue (3 * limit / 10 * meanPktSize));
+  factory.Set ("QueueLimit", UintegerValue (limit * meanPktSize));
+  factories.push_back (factory);
+  names.push_back ("RedQueue/bytes");
+
+  if (haveCoDel)
+    {
+      factory = ObjectFactory ();
+      factory.SetTypeId (tid);
+      factory.Set ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+      factory.Set ("MaxPackets", UintegerValue (limit));
+      factories.push_back (factory);
+      names.push_back ("CoDelQueue");
+    }
+
+  uint64_t overhead = ArrivalBench::GetTimerOverhead ();
+  Report ("arrivals", "-", "-", "ns/timer", overhead);
+
+  for (uint32_t i = 0; i < factories.size (); i++)
+    {
+      if (arrivals == "all" || arrivals == "cbr")
+        {
+          runArrivalBench (factories[i], ArrivalBench::CBR, rate, slot, load, n, minIterations,
+                           overhead, names[i].c_str (), "cbr");
+        }
+      if (arrivals == "all" || arrivals == "poisson")
+        {
+          runArrivalBench (factories[i], ArrivalBench::POISSON, rate, slot, load, n, minIterations,
+                           overhead, names[i].c_str (), "poisson");
+        }
+      if (arrivals == "all" || arrivals == "onoff")
+        {
+          runArrivalBench (factories[i], ArrivalBench::ON_OFF, rate, slot, load, n, minIterations,
+                           overhead, names[i].c_str (), "onoff");
+        }
+    }
+
+  return 0;
+}
@@ -24,6 +24,13 @@
 #include <vector>
 #include <string.h>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "ns3/core-module.h"
 
 using namespace ns3;
@@ -39,6 +46,109 @@ std::string g_me;
 // Output field width
 int g_fwidth = 6;
 
+/**
+ * Hardware cache miss counters of the calling thread, where the kernel
+ * gives access to them (see /proc/sys/kernel/perf_event_paranoid); they
+ * are usually not available in virtual machines.
+ */
+class CacheMissCounters
+{
+public:
+  /** The counted cache levels. */
+  enum Level
+  {
+    L1D = 0,  //!< level 1 data cache read misses
+    LL,       //!< last level cache misses
+    N_LEVELS
+  };
+
+  CacheMissCounters ()
+  {
+    for (uint32_t i = 0; i < N_LEVELS; i++)
+      {
+        m_fd[i] = -1;
+      }
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D |
+      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    m_fd[L1D] = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    m_fd[LL] = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~CacheMissCounters ()
+  {
+#ifdef __linux__
+    for (uint32_t i = 0; i < N_LEVELS; i++)
+      {
+        if (m_fd[i] >= 0)
+          {
+            close (m_fd[i]);
+          }
+      }
+#endif
+  }
+
+  /** Reset and start the counters. */
+  void Start (void)
+  {
+#ifdef __linux__
+    for (uint32_t i = 0; i < N_LEVELS; i++)
+      {
+        if (m_fd[i] >= 0)
+          {
+            ioctl (m_fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl (m_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+          }
+      }
+#endif
+  }
+
+  /** Stop the counters. */
+  void Stop (void)
+  {
+#ifdef __linux__
+    for (uint32_t i = 0; i < N_LEVELS; i++)
+      {
+        if (m_fd[i] >= 0)
+          {
+            ioctl (m_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+          }
+      }
+#endif
+  }
+
+  /**
+   * \param level the cache level
+   * \param count the number of misses since Start, if available
+   * \return true if the counter is available
+   */
+  bool Get (Level level, uint64_t &count) const
+  {
+#ifdef __linux__
+    if (m_fd[level] >= 0
+        && read (m_fd[level], &count, sizeof (count)) == sizeof (count))
+      {
+        return true;
+      }
+#endif
+    return false;
+  }
+
+private:
+  int m_fd[N_LEVELS];  //!< the counter file descriptors, -1 if not available
+};
+
 class Bench 
 {
 public:
@@ -71,6 +181,7 @@ private:
   uint32_t m_population;
   uint32_t m_total;
   uint32_t m_count;
+  CacheMissCounters m_misses;
 };
 
 void
@@ -95,17 +206,32 @@ Bench::RunBench (void)
 
   DEB ("running");
   time.Start ();
+  m_misses.Start ();
   Simulator::Run ();
+  m_misses.Stop ();
   simu = time.End ();
   simu /= 1000;
   DEB ("run took " << simu << "s");
 
-  LOG (std::setw (g_fwidth) << init <<
-       std::setw (g_fwidth) << (m_population / init) <<
-       std::setw (g_fwidth) << (init / m_population) <<
-       std::setw (g_fwidth) << simu <<
-       std::setw (g_fwidth) << (m_count / simu) <<
-       std::setw (g_fwidth) << (simu / m_count));
+  std::cout << std::setw (g_fwidth) << init <<
+    std::setw (g_fwidth) << (m_population / init) <<
+    std::setw (g_fwidth) << (init / m_population) <<
+    std::setw (g_fwidth) << simu <<
+    std::setw (g_fwidth) << (m_count / simu) <<
+    std::setw (g_fwidth) << (simu / m_count);
+  for (uint32_t i = 0; i < CacheMissCounters::N_LEVELS; i++)
+    {
+      uint64_t misses;
+      if (m_misses.Get (CacheMissCounters::Level (i), misses))
+        {
+          std::cout << std::setw (g_fwidth) << (double (misses) / m_count);
+        }
+      else
+        {
+          std::cout << std::setw (g_fwidth) << "n/a";
+        }
+    }
+  std::cout << std::endl;
 
 }
 
@@ -124,12 +250,81 @@ Bench::Cb (void)
 }
 
 
+/**
+ * Bimodal event intervals: mostly short intervals, such as packet
+ * serialization and propagation delays, mixed with a fraction of long
+ * ones, such as protocol timers.
+ */
+class BimodalRandomVariable : public RandomVariableStream
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("BimodalRandomVariable")
+      .SetParent<RandomVariableStream> ()
+      .AddConstructor<BimodalRandomVariable> ()
+    ;
+    return tid;
+  }
+
+  BimodalRandomVariable ()
+    : m_short (CreateObject<ExponentialRandomVariable> ()),
+      m_long (CreateObject<UniformRandomVariable> ()),
+      m_choice (CreateObject<UniformRandomVariable> ()),
+      m_longFraction (0)
+  { };
+
+  /**
+   * \param shortMean mean of the exponentially distributed short intervals
+   * \param longMean mean of the long intervals, uniform in [0.5, 1.5] times the mean
+   * \param longFraction fraction of long intervals
+   */
+  void SetParameters (double shortMean, double longMean, double longFraction)
+  {
+    m_short->SetAttribute ("Mean", DoubleValue (shortMean));
+    m_long->SetAttribute ("Min", DoubleValue (0.5 * longMean));
+    m_long->SetAttribute ("Max", DoubleValue (1.5 * longMean));
+    m_longFraction = longFraction;
+  }
+
+  virtual double GetValue (void)
+  {
+    if (m_choice->GetValue () < m_longFraction)
+      {
+        return m_long->GetValue ();
+      }
+    return m_short->GetValue ();
+  }
+
+  virtual uint32_t GetInteger (void)
+  {
+    return (uint32_t) GetValue ();
+  }
+
+private:
+  Ptr<ExponentialRandomVariable> m_short;
+  Ptr<UniformRandomVariable> m_long;
+  Ptr<UniformRandomVariable> m_choice;
+  double m_longFraction;
+};
+
+
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, bool bimodal,
+                 double shortMean, double longMean, double longFraction)
 {
   Ptr<RandomVariableStream> stream = 0;
   
-  if (filename == "")
+  if (bimodal)
+    {
+      LOGME ("using bimodal distribution: exponential, with mean "
+             << shortMean << " ns, and " << longFraction
+             << " uniform around " << longMean << " ns");
+      Ptr<BimodalRandomVariable> brv = CreateObject<BimodalRandomVariable> ();
+      brv->SetParameters (shortMean, longMean, longFraction);
+      stream = brv;
+    }
+  else if (filename == "")
     {
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
@@ -183,7 +378,10 @@ int main (int argc, char *argv[])
 {
 
   bool schedCal  = false;
+  bool schedCompact = false;
+  uint32_t arity = 4;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
 
@@ -191,18 +389,35 @@ int main (int argc, char *argv[])
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  bool bimodal = false;
+  double shortMean = 100;
+  double longMean = 1e9;
+  double longFraction = 0.01;
   
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
              "\n"
              "Event intervals are taken from one of:\n"
              "  an exponential distribution, with mean 100 ns,\n"
+             "  a bimodal distribution, given by the --bimodal argument:\n"
+             "    exponential intervals with mean --short ns, mixed with\n"
+             "    a fraction --longFraction of intervals uniform between\n"
+             "    0.5 and 1.5 times --long ns,\n"
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "The cache columns give the level 1 data cache read misses and\n"
+             "the last level cache misses per event, when the hardware\n"
+             "counters are available.  Populations of 1E6 to 1E8 pending\n"
+             "events show the effect of the size of the event list on the\n"
+             "caches; 1E8 events take about 10 GB.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
+  cmd.AddValue ("compact", "use CompactHeapScheduler",    schedCompact);
+  cmd.AddValue ("arity", "arity of the CompactHeapScheduler (default 4)", arity);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
@@ -210,6 +425,10 @@ int main (int argc, char *argv[])
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("bimodal", "use the bimodal distribution", bimodal);
+  cmd.AddValue ("short", "mean short interval, in ns (default 100)", shortMean);
+  cmd.AddValue ("long",  "mean long interval, in ns (default 1E9)",  longMean);
+  cmd.AddValue ("longFraction", "fraction of long intervals (default 0.01)", longFraction);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
@@ -217,7 +436,13 @@ int main (int argc, char *argv[])
 
   ObjectFactory factory ("ns3::MapScheduler");
   if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
+  if (schedCompact)
+    {
+      factory.SetTypeId ("ns3::CompactHeapScheduler");
+      factory.Set ("Arity", UintegerValue (arity));
+    }
   if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
+  if (schedLadder) { factory.SetTypeId ("ns3::LadderScheduler"); }
   if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
   Simulator::SetScheduler (factory);
 
@@ -230,20 +455,24 @@ int main (int argc, char *argv[])
   LOGME ("runs: " << runs);
   
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetRandomStream (GetRandomStream (filename, bimodal, shortMean,
+                                             longMean, longFraction));
 
   // table header
   LOG ("");
   LOG (std::left << std::setw (g_fwidth) << "Run #" <<
        std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+       std::left << std::setw (3 * g_fwidth) << "Simulation:" <<
+       std::left << std::setw (2 * g_fwidth) << "Cache misses:");
   LOG (std::left << std::setw (g_fwidth) << "" <<
        std::left << std::setw (g_fwidth) << "Time (s)" <<
        std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
        std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
        std::left << std::setw (g_fwidth) << "Time (s)" <<
        std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "L1d (/ev)" <<
+       std::left << std::setw (g_fwidth) << "LL (/ev)" );
   LOG (std::setfill ('-') <<
        std::right << std::setw (g_fwidth) << " " <<
        std::right << std::setw (g_fwidth) << " " <<       
@@ -252,6 +481,8 @@ int main (int argc, char *argv[])
        std::right << std::setw (g_fwidth) << " " <<       
        std::right << std::setw (g_fwidth) << " " <<       
        std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
        std::setfill (' ')
        );
        
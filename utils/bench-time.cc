@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/int64x64.h"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+using namespace ns3;
+
+/**
+ * Compare the Time conversions with their int64x64_t equivalents:
+ * GetSeconds () with To (Time::S).GetDouble (), Seconds (double) with
+ * From (int64x64_t (double), Time::S), and GetMicroSeconds () with an
+ * integer division.  Build with the different int64x64_t implementations
+ * (./waf configure --int64x64=int128|cairo|double) to compare them.
+ */
+
+/** The operands of the conversions. */
+struct Operands
+{
+  std::vector<Time> times;       //!< times, for the conversions to numbers
+  std::vector<double> seconds;   //!< numbers of seconds, for the conversions to times
+};
+
+/** Volatile, so that the compiler does not see the divisor. */
+volatile int64_t g_nsPerUs = 1000;
+
+/** The result of a conversion over all the operands. */
+struct Result
+{
+  double ns;        //!< the time of a conversion, in ns
+  double sum;       //!< the sum of the results, to check and keep them alive
+};
+
+/**
+ * Time a conversion over all the operands.
+ *
+ * \param operands the operands
+ * \param which the conversion
+ * \param fast true for the Time conversion, false for the reference
+ * \param repeat the number of passes over the operands
+ * \return the time and sum of the conversions
+ */
+static Result
+Run (const Operands &operands, int which, bool fast, uint32_t repeat)
+{
+  SystemWallClockMs clock;
+  double sum = 0;
+  uint32_t n = 0;
+  clock.Start ();
+  for (uint32_t r = 0; r < repeat; r++)
+    {
+      switch (which)
+        {
+        case 0:
+          n += operands.times.size ();
+          for (std::vector<Time>::const_iterator i = operands.times.begin (); i != operands.times.end (); ++i)
+            {
+              sum += fast ? i->GetSeconds () : i->To (Time::S).GetDouble ();
+            }
+          break;
+        case 1:
+          n += operands.seconds.size ();
+          for (std::vector<double>::const_iterator i = operands.seconds.begin (); i != operands.seconds.end (); ++i)
+            {
+              Time t = fast ? Seconds (*i) : Time::From (int64x64_t (*i), Time::S);
+              sum += t.GetTimeStep ();
+            }
+          break;
+        default:
+          n += operands.times.size ();
+          for (std::vector<Time>::const_iterator i = operands.times.begin (); i != operands.times.end (); ++i)
+            {
+              sum += fast ? i->GetMicroSeconds () : i->GetTimeStep () / g_nsPerUs;
+            }
+          break;
+        }
+    }
+  Result result;
+  result.ns = clock.End () * 1e6 / n;
+  result.sum = sum;
+  return result;
+}
+
+/**
+ * Count the operands for which a conversion and its reference differ.
+ *
+ * \param operands the operands
+ * \param which the conversion
+ * \return the number of different results
+ */
+static uint32_t
+Compare (const Operands &operands, int which)
+{
+  uint32_t differ = 0;
+  switch (which)
+    {
+    case 0:
+      for (std::vector<Time>::const_iterator i = operands.times.begin (); i != operands.times.end (); ++i)
+        {
+          differ += i->GetSeconds () != i->To (Time::S).GetDouble ();
+        }
+      break;
+    case 1:
+      for (std::vector<double>::const_iterator i = operands.seconds.begin (); i != operands.seconds.end (); ++i)
+        {
+          differ += Seconds (*i) != Time::From (int64x64_t (*i), Time::S);
+        }
+      break;
+    default:
+      for (std::vector<Time>::const_iterator i = operands.times.begin (); i != operands.times.end (); ++i)
+        {
+          differ += i->GetMicroSeconds () != i->GetTimeStep () / g_nsPerUs;
+        }
+      break;
+    }
+  return differ;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t count = 1000000;
+  uint32_t repeat = 10;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the Time conversions against int64x64_t.\n"
+             "\n"
+             "The times are uniform between 0 and 1000 s, with one in\n"
+             "four below 1 ms; the numbers of seconds are packet\n"
+             "transmission times (8 * bytes / rate) and uniform between\n"
+             "0 and 100 s.  The last column counts the operands for which\n"
+             "the results differ: GetSeconds () is rounded once, where\n"
+             "the int64x64_t path rounds twice, so the last bit may differ.");
+  cmd.AddValue ("count", "number of operands (default 1E6)", count);
+  cmd.AddValue ("repeat", "number of passes over the operands (default 10)", repeat);
+  cmd.Parse (argc, argv);
+
+  // Until the simulation starts, each Time is recorded, in case the
+  // resolution changes: start it, so that only the conversions are timed.
+  Simulator::Run ();
+
+  Operands operands;
+  srand (1);
+  for (uint32_t i = 0; i < count; i++)
+    {
+      int64_t ts = (static_cast<int64_t> (rand ()) << 31 | rand ()) % 1000000000000LL;
+      if (i % 4 == 0)
+        {
+          ts %= 1000000;
+        }
+      operands.times.push_back (TimeStep (ts));
+      if (i % 2 == 0)
+        {
+          uint32_t bytes = 40 + rand () % 1460;
+          double bps = (1 + rand () % 1000) * 1e6;
+          operands.seconds.push_back (bytes * 8 / bps);
+        }
+      else
+        {
+          operands.seconds.push_back (rand () * 100.0 / RAND_MAX);
+        }
+    }
+
+  const char *implementation[] = { "int128", "cairo", "long double" };
+  std::cout << "int64x64_t implementation: "
+            << implementation[int64x64_t::implementation] << std::endl;
+  std::cout << std::left << std::setw (20) << "conversion" << std::right
+            << std::setw (14) << "reference (ns)" << std::setw (12) << "Time (ns)"
+            << std::setw (10) << "speedup" << std::setw (10) << "differ" << std::endl;
+  const char *names[] = { "GetSeconds ()", "Seconds (double)", "GetMicroSeconds ()" };
+  const char *references[] = { "To (S)", "From (int64x64_t)", "int64 division" };
+  for (int which = 0; which < 3; which++)
+    {
+      Result reference = Run (operands, which, false, repeat);
+      Result fast = Run (operands, which, true, repeat);
+      std::cout << std::left << std::setw (20) << names[which] << std::right << std::fixed
+                << std::setprecision (2)
+                << std::setw (14) << reference.ns << std::setw (12) << fast.ns
+                << std::setw (10) << reference.ns / fast.ns
+                << std::setw (10) << Compare (operands, which)
+                << "  vs " << references[which] << std::endl;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Replay a trace of the packets offered to a RED queue with many
+ * combinations of RED parameters, and print the drops, average queue
+ * size and queuing delay of each combination as comma-separated values.
+ *
+ * The trace has one "time size" line per packet, with the time in
+ * seconds and the size in bytes, as written by the arrivalTrace option
+ * of src/network/examples/red_vs_ared.cc; lines starting with '#' are
+ * ignored.  The parameters to sweep are given as comma-separated lists,
+ * e.g.
+ *
+ *   ./waf --run "red-replay --trace=arrivals.txt --linkBandwidth=1Mbps
+ *                --adaptive=1 --minTh=0 --maxTh=0 --qW=0
+ *                --targetDelay=0.005,0.01,0.02 --alpha=0.005,0.01
+ *                --beta=0.8,0.9"
+ *
+ * and every combination is replayed (see ns3::RedBatch).  A
+ * combination whose minTh is larger than its maxTh is skipped.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/red-batch.h"
+#include "ns3/abort.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Parse a comma-separated list of numbers.
+ */
+static std::vector<double>
+ParseList (const std::string &name, const std::string &list)
+{
+  std::vector<double> values;
+  std::istringstream iss (list);
+  std::string item;
+  while (std::getline (iss, item, ','))
+    {
+      std::istringstream itemStream (item);
+      double value;
+      if (!(itemStream >> value))
+        {
+          NS_ABORT_MSG ("Invalid value \"" << item << "\" in --" << name);
+        }
+      values.push_back (value);
+    }
+  NS_ABORT_MSG_IF (values.empty (), "Empty list in --" << name);
+  return values;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string traceFile;
+  std::string minThList = "5";
+  std::string maxThList = "15";
+  std::string qWList = "0.002";
+  std::string alphaList = "0.01";
+  std::string betaList = "0.9";
+  std::string targetDelayList = "0.005";
+  RedBatch::Config config;
+  std::string linkBandwidth = "1.5Mbps";
+  double linkDelay = config.linkDelay.GetSeconds ();
+  double interval = config.interval.GetSeconds ();
+
+  CommandLine cmd;
+  cmd.Usage ("Replay a trace of packet arrivals with many RED parameter combinations");
+  cmd.AddValue ("trace", "file with one \"time size\" line per packet offered to the queue", traceFile);
+  cmd.AddValue ("minTh", "list of minimum thresholds (packets)", minThList);
+  cmd.AddValue ("maxTh", "list of maximum thresholds (packets)", maxThList);
+  cmd.AddValue ("qW", "list of queue weights", qWList);
+  cmd.AddValue ("alpha", "list of Adaptive RED alpha values", alphaList);
+  cmd.AddValue ("beta", "list of Adaptive RED beta values", betaList);
+  cmd.AddValue ("targetDelay", "list of Adaptive RED target delays (seconds)", targetDelayList);
+  cmd.AddValue ("linkBandwidth", "link bandwidth", linkBandwidth);
+  cmd.AddValue ("linkDelay", "link delay (seconds)", linkDelay);
+  cmd.AddValue ("meanPktSize", "average packet size", config.meanPktSize);
+  cmd.AddValue ("queueLimit", "queue limit in packets", config.queueLimit);
+  cmd.AddValue ("lInterm", "the initial max_p is 1 / lInterm", config.lInterm);
+  cmd.AddValue ("wait", "wait between dropped packets", config.isWait);
+  cmd.AddValue ("gentle", "gentle RED", config.isGentle);
+  cmd.AddValue ("adaptive", "Adaptive RED", config.isAdaptive);
+  cmd.AddValue ("interval", "Adaptive RED interval (seconds)", interval);
+  cmd.AddValue ("top", "Adaptive RED upper bound of max_p", config.top);
+  cmd.AddValue ("bottom", "Adaptive RED lower bound of max_p, 0 for automatic", config.bottom);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (traceFile.empty (), "The trace must be given with --trace");
+  config.linkBandwidth = DataRate (linkBandwidth);
+  config.linkDelay = Seconds (linkDelay);
+  config.interval = Seconds (interval);
+
+  std::ifstream in (traceFile.c_str ());
+  NS_ABORT_MSG_IF (!in, "Cannot open " << traceFile);
+  std::vector<Time> times;
+  std::vector<uint32_t> sizes;
+  std::string line;
+  while (std::getline (in, line))
+    {
+      if (line.empty () || line[0] == '#')
+        {
+          continue;
+        }
+      std::istringstream iss (line);
+      double time;
+      uint32_t size;
+      NS_ABORT_MSG_IF (!(iss >> time >> size), "Invalid line in " << traceFile << ": " << line);
+      times.push_back (Seconds (time));
+      sizes.push_back (size);
+    }
+
+  RedBatch batch (config);
+  std::vector<double> minTh = ParseList ("minTh", minThList);
+  std::vector<double> maxTh = ParseList ("maxTh", maxThList);
+  std::vector<double> qW = ParseList ("qW", qWList);
+  std::vector<double> alpha = ParseList ("alpha", alphaList);
+  std::vector<double> beta = ParseList ("beta", betaList);
+  std::vector<double> targetDelay = ParseList ("targetDelay", targetDelayList);
+  RedBatch::Params params;
+  for (uint32_t a = 0; a < minTh.size (); a++)
+    for (uint32_t b = 0; b < maxTh.size (); b++)
+      for (uint32_t c = 0; c < qW.size (); c++)
+        for (uint32_t d = 0; d < alpha.size (); d++)
+          for (uint32_t e = 0; e < beta.size (); e++)
+            for (uint32_t f = 0; f < targetDelay.size (); f++)
+              {
+                if (minTh[a] > maxTh[b])
+                  {
+                    continue;
+                  }
+                params.minTh = minTh[a];
+                params.maxTh = maxTh[b];
+                params.qW = qW[c];
+                params.alpha = alpha[d];
+                params.beta = beta[e];
+                params.targetDelay = Seconds (targetDelay[f]);
+                batch.AddLane (params);
+              }
+
+  Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable> ();
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < times.size (); i++)
+    {
+      batch.Enqueue (times[i], sizes[i], uv->GetValue ());
+    }
+  int64_t ms = clock.End ();
+  std::cerr << "Replayed " << times.size () << " packets with " << batch.GetNLanes ()
+            << " parameter combinations in " << ms << " ms" << std::endl;
+
+  std::cout << "minTh,maxTh,qW,alpha,beta,targetDelay,"
+            << "arrivals,unforcedDrop,forcedDrop,qLimDrop,dropRatio,qAvg,curMaxP,delay" << std::endl;
+  for (uint32_t lane = 0; lane < batch.GetNLanes (); lane++)
+    {
+      RedBatch::Params p = batch.GetParams (lane);
+      RedQueue::Stats st = batch.GetStats (lane);
+      uint32_t drops = st.unforcedDrop + st.forcedDrop;
+      std::cout << p.minTh << "," << p.maxTh << "," << p.qW << ","
+                << p.alpha << "," << p.beta << "," << p.targetDelay.GetSeconds () << ","
+                << times.size () << "," << st.unforcedDrop << ","
+                << st.forcedDrop << "," << st.qLimDrop << ","
+                << (times.empty () ? 0.0 : double (drops) / times.size ()) << ","
+                << batch.GetAverageQueueSize (lane) << ","
+                << batch.GetCurMaxP (lane) << ","
+                << batch.GetAverageDelay (lane).GetSeconds () << std::endl;
+    }
+
+  return 0;
+}